@@ -0,0 +1,116 @@
+/*************************************************************************
+  FILE:  applybench.cxx
+  DESCR: Microbenchmark of the cost of each recursive step of apply.
+	 Runs every operator on all pairs of a pool of random operands
+	 and reports the time per lookup in the apply cache, which is
+	 one per recursive call that is not a terminal case.
+	 Each operator is timed in several runs, starting from empty
+	 caches, and the median is reported, since single runs vary
+	 widely on a loaded machine.
+	 The package must be compiled with CACHESTATS.
+	 Usage: applybench [rounds [runs]]
+*************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <algorithm>
+#include <vector>
+#include "tbdd.h"
+
+static int N = 24;        /* Variables */
+static int K = 16;        /* Operands */
+static int CUBES = 12;    /* Cubes in each operand */
+static int WIDTH = 4;     /* Literals in each cube */
+
+static const struct { const char *name; int op; } ops[] =
+{
+   { "and", bddop_and },
+   { "or",  bddop_or },
+   { "xor", bddop_xor },
+   { "imp", bddop_imp },
+   { "diff", bddop_diff }
+};
+
+
+static bdd random_operand(void)
+{
+   bdd f = bddfalse;
+
+   for (int c=0 ; c<CUBES ; c++)
+   {
+      bdd cube = bddtrue;
+      for (int i=0 ; i<WIDTH ; i++)
+      {
+	 int v = rand() % N;
+	 cube &= (rand() & 1) ? bdd_ithvar(v) : bdd_nithvar(v);
+      }
+      f |= cube;
+   }
+   return f;
+}
+
+
+static double seconds(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+
+int main(int argc, char **argv)
+{
+   int rounds = argc > 1 ? atoi(argv[1]) : 1;
+   int runs = argc > 2 ? atoi(argv[2]) : 5;
+   if (runs < 1)
+      runs = 1;
+   bdd *pool = new bdd[K];
+
+   tbdd_init_noproof(N);
+   bdd_gbc_hook(NULL);
+   srand(1);
+
+   for (int i=0 ; i<K ; i++)
+      pool[i] = random_operand();
+
+   for (unsigned n=0 ; n<sizeof(ops)/sizeof(ops[0]) ; n++)
+   {
+      std::vector<double> nsstep;
+      long calls = 0, miss = 0;
+
+      for (int t=0 ; t<runs ; t++)
+      {
+	 bddCacheStat before, after;
+
+	    /* Every run does the same steps from empty caches */
+	 bdd_gbc();
+	 bdd_cachestats(&before);
+	 double start = seconds();
+	 for (int r=0 ; r<rounds ; r++)
+	    for (int i=0 ; i<K ; i++)
+	       for (int j=0 ; j<K ; j++)
+		  bdd_apply(pool[i], pool[j], ops[n].op);
+	 double elapsed = seconds() - start;
+	 bdd_cachestats(&after);
+
+	 calls = (after.opHit - before.opHit) + (after.opMiss - before.opMiss);
+	 miss = after.opMiss - before.opMiss;
+	 if (calls == 0)
+	 {
+	    printf("No cache statistics, compile with CACHESTATS\n");
+	    return 1;
+	 }
+	 nsstep.push_back(1e9 * elapsed / calls);
+      }
+
+      std::sort(nsstep.begin(), nsstep.end());
+      printf("%-5s %10ld steps %10ld misses  median %7.1f ns/step  (%.1f - %.1f)\n",
+	     ops[n].name, calls, miss, nsstep[nsstep.size()/2],
+	     nsstep.front(), nsstep.back());
+      fflush(stdout);
+   }
+
+   delete[] pool;
+   bdd_done();
+   return 0;
+}
@@ -0,0 +1,107 @@
+/*************************************************************************
+  FILE:  parbench.cxx
+  DESCR: Scaling benchmark of the multi-threaded apply. Builds the
+	 N-queens BDD with each of the given numbers of apply threads
+	 and reports the median time of a few runs.
+	 The package must be compiled with ENABLE_PARAPPLY, otherwise
+	 all thread counts run sequentially.
+	 Usage: parbench [N [threads ...]]
+*************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+#include <algorithm>
+#include "tbdd.h"
+
+static const int RUNS = 5;   /* Runs for each thread count */
+
+
+static double seconds(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+
+   /* Build the N-queens constraint, as in the BuDDy examples */
+static bdd queens(int N)
+{
+   bdd queen = bddtrue;
+
+   for (int i=0 ; i<N ; i++)
+   {
+      bdd e = bddfalse;
+      for (int j=0 ; j<N ; j++)
+	 e |= bdd_ithvar(i*N+j);
+      queen &= e;
+   }
+
+   for (int i=0 ; i<N ; i++)
+      for (int j=0 ; j<N ; j++)
+      {
+	 bdd x = bdd_ithvar(i*N+j);
+	 bdd a = bddtrue;
+
+	 for (int k=0 ; k<N ; k++)
+	 {
+	    int ll;
+	    if (k != j)
+	       a &= bdd_imp(x, bdd_nithvar(i*N+k));
+	    if (k != i)
+	       a &= bdd_imp(x, bdd_nithvar(k*N+j));
+	    ll = k-i+j;
+	    if (ll >= 0  &&  ll < N  &&  k != i)
+	       a &= bdd_imp(x, bdd_nithvar(k*N+ll));
+	    ll = i+j-k;
+	    if (ll >= 0  &&  ll < N  &&  k != i)
+	       a &= bdd_imp(x, bdd_nithvar(k*N+ll));
+	 }
+	 queen &= a;
+      }
+
+   return queen;
+}
+
+
+int main(int argc, char **argv)
+{
+   int N = argc > 1 ? atoi(argv[1]) : 10;
+   static const int defthreads[] = { 1, 4, 8 };
+   int nthreads = argc > 2 ? argc-2 : 3;
+   double base = 0;
+
+   tbdd_init_noproof(N*N);
+   bdd_gbc_hook(NULL);
+
+   for (int t=0 ; t<nthreads ; t++)
+   {
+      int threads = argc > 2 ? atoi(argv[t+2]) : defthreads[t];
+      double times[RUNS];
+      double count = 0;
+
+      bdd_setapplythreads(threads);
+      for (int r=0 ; r<RUNS ; r++)
+      {
+	    /* Start every run from empty caches */
+	 bdd_gbc();
+	 double start = seconds();
+	 bdd q = queens(N);
+	 times[r] = seconds() - start;
+	    /* The package may have more variables than the board */
+	 count = ldexp(bdd_satcount(q), N*N - bdd_varnum());
+      }
+
+      std::sort(times, times+RUNS);
+      double median = times[RUNS/2];
+      if (t == 0)
+	 base = median;
+      printf("%d-queens %2d threads %6.0f solutions  median %7.3f s  (%.3f - %.3f)  speedup %.2f\n",
+	     N, threads, count, median, times[0], times[RUNS-1], base / median);
+      fflush(stdout);
+   }
+
+   bdd_done();
+   return 0;
+}
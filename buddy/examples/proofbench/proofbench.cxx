@@ -0,0 +1,172 @@
+/*************************************************************************
+  FILE:  proofbench.cxx
+  DESCR: Benchmark of LRAT proof output.
+	 Emits a generated proof of 3-literal clauses with 4 hints each,
+	 in text and in binary.  Each is written first the way the
+	 prover used to write it: text with one stdio call per field,
+	 and binary by encoding one byte at a time.  Then it is written
+	 through generate_clause, which formats each line with the
+	 batched encoders and writes it in one call.  Only the proof variable
+	 needed by the prover is declared, so the clauses refer to
+	 variables that are never defined; the proof is not checkable.
+	 Usage: proofbench [CLAUSES [FILE]].  Default is 10^8 clauses
+	 written to /dev/null.
+*************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "tbdd.h"
+#include "prover.h"
+
+static int N = 1000000;   /* Range of clause variables */
+static int SPAN = 10000;  /* Range of hint distances */
+
+
+static double seconds(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+
+/* Deterministic clause and hints for clause id */
+static void make_clause(int cid, ilist *lits, ilist *hints)
+{
+   unsigned h = (unsigned) cid * 2654435761u;
+   int v = 1 + (int) (h % (unsigned) (N-2));
+
+   *lits = ilist_fill3(*lits, h & 1 ? v : -v, h & 2 ? v+1 : -(v+1),
+		       h & 4 ? v+2 : -(v+2));
+   *hints = ilist_fill4(*hints, cid > 1 ? cid - 1 : 1,
+			1 + (int) ((h >> 3) % (unsigned) SPAN),
+			cid > SPAN ? cid - SPAN : 1,
+			1 + (int) ((h >> 7) % (unsigned) cid));
+}
+
+
+/* Previous text path: one stdio call per field */
+static void stdio_clause(FILE *out, int cid, ilist clause, ilist hints)
+{
+   fprintf(out, "%d ", cid);
+   ilist_print(clause, out, " ");
+   fprintf(out, " 0 ");
+   ilist_print(hints, out, " ");
+   fprintf(out, " 0\n");
+}
+
+
+/* Previous binary path: encode one byte at a time */
+static int bytewise_pack(int x, unsigned char *dest)
+{
+   unsigned char *d = dest;
+   unsigned u = x < 0 ? 2*(-x)+1 : 2*x;
+   while (u >= 128)
+   {
+      *d++ = (u & 0x7F) + 128;
+      u >>= 7;
+   }
+   *d++ = u;
+   return d - dest;
+}
+
+
+static void bytewise_clause(FILE *out, int cid, ilist clause, ilist hints)
+{
+   unsigned char buf[5*(3+4+4)];
+   unsigned char *d = buf;
+
+   *d++ = 'a';
+   d += bytewise_pack(cid, d);
+   for (int i=0 ; i<ilist_length(clause) ; i++)
+      d += bytewise_pack(clause[i], d);
+   d += bytewise_pack(0, d);
+   for (int i=0 ; i<ilist_length(hints) ; i++)
+      d += bytewise_pack(hints[i], d);
+   d += bytewise_pack(0, d);
+   fwrite(buf, 1, d - buf, out);
+}
+
+
+/* Time count clauses written the previous way */
+static double run_baseline(const char *fname, long count, bool binary)
+{
+   clause_id_t lbuf[3+ILIST_OVHD], hbuf[4+ILIST_OVHD];
+   ilist lits = ilist_make(lbuf, 3);
+   ilist hints = ilist_make(hbuf, 4);
+   FILE *out = fopen(fname, "w");
+
+   if (out == NULL)
+   {
+      fprintf(stderr, "Couldn't open '%s'\n", fname);
+      exit(1);
+   }
+   double start = seconds();
+   for (int cid=1 ; cid<=count ; cid++)
+   {
+      make_clause(cid, &lits, &hints);
+      if (binary)
+	 bytewise_clause(out, cid, clean_clause(lits), hints);
+      else
+	 stdio_clause(out, cid, clean_clause(lits), hints);
+   }
+   fflush(out);
+   double elapsed = seconds() - start;
+   fclose(out);
+   return elapsed;
+}
+
+
+/* Time count clauses written by the prover */
+static double run_prover(const char *fname, long count, bool binary)
+{
+   clause_id_t lbuf[3+ILIST_OVHD], hbuf[4+ILIST_OVHD];
+   ilist lits = ilist_make(lbuf, 3);
+   ilist hints = ilist_make(hbuf, 4);
+   FILE *out = fopen(fname, "w");
+
+   if (out == NULL)
+   {
+      fprintf(stderr, "Couldn't open '%s'\n", fname);
+      exit(1);
+   }
+   if (binary)
+      tbdd_init_lrat_binary(out, 1, 0, NULL, NULL);
+   else
+      tbdd_init_lrat(out, 1, 0, NULL, NULL);
+   double start = seconds();
+   for (int cid=1 ; cid<=count ; cid++)
+   {
+      make_clause(cid, &lits, &hints);
+      generate_clause(lits, hints);
+   }
+   fflush(out);
+   double elapsed = seconds() - start;
+   tbdd_done();
+   fclose(out);
+   return elapsed;
+}
+
+
+int main(int argc, char **argv)
+{
+   long count = argc > 1 ? atol(argv[1]) : 100000000L;
+   const char *fname = argc > 2 ? argv[2] : "/dev/null";
+   static const char *names[4] = { "stdio", "text", "bytewise", "binary" };
+   double elapsed[4];
+
+   if (count <= 0 || count >= 0x7fffffff)
+   {
+      fprintf(stderr, "Clause count must be between 1 and %d\n", 0x7ffffffe);
+      return 1;
+   }
+
+   elapsed[0] = run_baseline(fname, count, false);
+   elapsed[1] = run_prover(fname, count, false);
+   elapsed[2] = run_baseline(fname, count, true);
+   elapsed[3] = run_prover(fname, count, true);
+   for (int i=0 ; i<4 ; i++)
+      printf("%-8s %10ld clauses %8.2f s %7.1f ns/clause\n",
+	     names[i], count, elapsed[i], 1e9 * elapsed[i] / count);
+   return 0;
+}
@@ -0,0 +1,139 @@
+/*************************************************************************
+  FILE:  proofcat.cxx
+  DESCR: Decompress a proof written with PROOF_COMPRESS_LZ.
+	 The file is a sequence of independent frames, each with a
+	 12-byte header: 'T' 'B' 'L' 'Z', the decompressed length, and
+	 the length of the frame data (bit 31 set if stored), both
+	 little-endian.  A checker can find the frames from the headers
+	 alone and decompress them in parallel; this program does them
+	 in order.  Usage: proofcat [FILE] > PROOF
+*************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+static uint32_t get_le32(const unsigned char *s)
+{
+   return s[0] | s[1] << 8 | s[2] << 16 | (uint32_t) s[3] << 24;
+}
+
+
+/* Read an extended length.  Return false if the data ends first */
+static bool get_length(const unsigned char **ip, const unsigned char *end, size_t *len)
+{
+   unsigned char b;
+   do
+   {
+      if (*ip >= end)
+	 return false;
+      b = *(*ip)++;
+      *len += b;
+   } while (b == 255);
+   return true;
+}
+
+
+/* Decompress one frame.  Return false if it is corrupt */
+static bool lz_decompress(const unsigned char *src, size_t zlen, unsigned char *dest, size_t len)
+{
+   const unsigned char *ip = src;
+   const unsigned char *end = src + zlen;
+   unsigned char *d = dest;
+   unsigned char *dend = dest + len;
+
+   while (ip < end)
+   {
+      unsigned token = *ip++;
+      size_t nlit = token >> 4;
+      if (nlit == 15 && !get_length(&ip, end, &nlit))
+	 return false;
+      if (nlit > (size_t) (end - ip) || nlit > (size_t) (dend - d))
+	 return false;
+      memcpy(d, ip, nlit);
+      d += nlit;
+      ip += nlit;
+      if (ip == end)
+	 break;
+      if (end - ip < 2)
+	 return false;
+      size_t offset = ip[0] | ip[1] << 8;
+      ip += 2;
+      size_t mlen = token & 0xF;
+      if (mlen == 15 && !get_length(&ip, end, &mlen))
+	 return false;
+      mlen += 4;
+      if (offset == 0 || offset > (size_t) (d - dest) || mlen > (size_t) (dend - d))
+	 return false;
+      /* Matches can overlap the bytes they produce */
+      const unsigned char *rp = d - offset;
+      while (mlen-- > 0)
+	 *d++ = *rp++;
+   }
+   return d == dend;
+}
+
+
+int main(int argc, char **argv)
+{
+   FILE *in = stdin;
+   unsigned char header[12];
+   unsigned char *zbuf = NULL, *buf = NULL;
+   size_t zalloc = 0, alloc = 0;
+   long frames = 0;
+
+   if (argc > 1 && (in = fopen(argv[1], "rb")) == NULL)
+   {
+      fprintf(stderr, "Couldn't open '%s'\n", argv[1]);
+      return 1;
+   }
+   while (true)
+   {
+      size_t got = fread(header, 1, sizeof(header), in);
+      if (got == 0)
+	 break;
+      if (got < sizeof(header) || memcmp(header, "TBLZ", 4) != 0)
+      {
+	 fprintf(stderr, "Bad frame header at frame %ld\n", frames);
+	 return 1;
+      }
+      size_t len = get_le32(header+4);
+      uint32_t zword = get_le32(header+8);
+      bool stored = (zword & 0x80000000u) != 0;
+      size_t zlen = zword & 0x7FFFFFFFu;
+      if (zlen > zalloc)
+      {
+	 zalloc = zlen;
+	 zbuf = (unsigned char *) realloc(zbuf, zalloc);
+      }
+      if (len > alloc)
+      {
+	 alloc = len;
+	 buf = (unsigned char *) realloc(buf, alloc);
+      }
+      if ((zlen > 0 && zbuf == NULL) || (len > 0 && buf == NULL))
+      {
+	 fprintf(stderr, "Out of memory\n");
+	 return 1;
+      }
+      if (fread(zbuf, 1, zlen, in) != zlen)
+      {
+	 fprintf(stderr, "Truncated frame %ld\n", frames);
+	 return 1;
+      }
+      if (stored ? zlen != len : !lz_decompress(zbuf, zlen, buf, len))
+      {
+	 fprintf(stderr, "Corrupt frame %ld\n", frames);
+	 return 1;
+      }
+      if (fwrite(stored ? zbuf : buf, 1, len, stdout) != len)
+      {
+	 fprintf(stderr, "Couldn't write output\n");
+	 return 1;
+      }
+      frames++;
+   }
+   free(zbuf);
+   free(buf);
+   return 0;
+}
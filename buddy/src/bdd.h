@@ -82,8 +82,30 @@
 #define ENABLE_BTRACE 0
 #endif
 
+/** Enabling large mode (64 bit node references and clause IDs) **/
+#ifndef ENABLE_LARGE
+#define ENABLE_LARGE 0
+#endif
+
+/** Enabling one independent package per thread **/
+#ifndef ENABLE_REENTRANT
+#define ENABLE_REENTRANT 0
+#endif
+
+   /* Storage class of the scratch buffers and C++ output settings. In
+      reentrant mode they belong to the thread, while the package state
+      belongs to the thread's current manager (see bdd_set_manager). */
+#if ENABLE_REENTRANT
+#define BDD_TLS __thread
+#else
+#define BDD_TLS
+#endif
+
 #include <stdio.h>
 #include <stdbool.h>
+#if ENABLE_TBDD
+#include "ilist.h"
+#endif
 
 /*=== Defined operators for apply calls, and for op field in cache ====*/
 
@@ -114,6 +136,7 @@
 #define bddop_andj     18
 #define bddop_imptstj  19
 #define bddop_andimptstj  20
+#define bddop_andexj   21
 #endif
 
 /*=== Defining clauses ===================================================*/
@@ -125,7 +148,16 @@ typedef enum { DEF_HU, DEF_LU, DEF_HD, DEF_LD } dclause_t;
 
 /*=== User BDD types ===================================================*/
 
+   /* A BDD is a reference to a node, and node counts have the same
+      type.  In large mode both are 64 bits wide.  PRIbdd is the printf
+      conversion for them, as in "%" PRIbdd. */
+#if ENABLE_LARGE
+typedef long long BDD;
+#define PRIbdd "lld"
+#else
 typedef int BDD;
+#define PRIbdd "d"
+#endif
 
 #ifndef CPLUSPLUS
 typedef BDD bdd;
@@ -139,6 +171,11 @@ typedef struct s_bddPair
    struct s_bddPair *next;
 } bddPair;
 
+#if ENABLE_REENTRANT
+   /* All the state of one package, see bdd_set_manager() */
+typedef struct s_bdd_manager bdd_manager;
+#endif
+
 
 /*=== Status information ===============================================*/
 
@@ -149,9 +186,9 @@ SHORT   {* Status information about the bdd package *}
 PROTO   {* typedef struct s_bddStat
 {
    long int produced;
-   int nodenum;
-   int maxnodenum;
-   int freenodes;
+   BDD nodenum;
+   BDD maxnodenum;
+   BDD freenodes;
    int minfreenodes;
    int varnum;
    int cachesize;
@@ -173,9 +210,9 @@ ALSO    {* bdd\_stats *}
 typedef struct s_bddStat
 {
    long int produced;
-   int nodenum;
-   int maxnodenum;
-   int freenodes;
+   BDD nodenum;
+   BDD maxnodenum;
+   BDD freenodes;
    int minfreenodes;
    int varnum;
    int cachesize;
@@ -189,12 +226,13 @@ SECTION {* kernel *}
 SHORT   {* Status information about garbage collections *}
 PROTO   {* typedef struct s_bddGbcStat
 {
-   int nodes;
-   int freenodes;
-   int prevfreednodes;
+   BDD nodes;
+   BDD freenodes;
+   BDD prevfreednodes;
    long time;
    long sumtime;
    int num;
+   int young;
 } bddGbcStat;  *}
 DESCR   {* The fields are \\[\baselineskip] \begin{tabular}{ll}
   {\tt nodes}     & Total number of allocated nodes in the nodetable \\
@@ -202,21 +240,59 @@ DESCR   {* The fields are \\[\baselineskip] \begin{tabular}{ll}
   {\tt prevfreednodes} & number of bdd nodes that were freed during the preceding garbage collection \\
   {\tt time}      & Time used for garbage collection this time \\
   {\tt sumtime}   & Total time used for garbage collection \\
-  {\tt num}       & number of garbage collections done until now
+  {\tt num}       & number of garbage collections done until now \\
+  {\tt young}     & true if only the nodes made since the previous collection
+                    were collected ({\tt ENABLE\_GENGC})
   \end{tabular} *}
 ALSO    {* bdd\_gbc\_hook *}
 */
 typedef struct s_bddGbcStat
 {
-   int nodes;
-   int freenodes;
-   int prevfreednodes;
+   BDD nodes;
+   BDD freenodes;
+   BDD prevfreednodes;
    long time;
    long sumtime;
    int num;
+   int young;
 } bddGbcStat;
 
 
+/*
+NAME    {* bddReorderStat *}
+SECTION {* reorder *}
+SHORT   {* Status information about the sifting passes of a reordering *}
+PROTO   {* typedef struct s_bddReorderStat
+{
+   int passnum;
+   BDD passbefore;
+   BDD passafter;
+   int passgain;
+   long passtime;
+   long time;
+} bddReorderStat;  *}
+DESCR   {* The fields are \\[\baselineskip] \begin{tabular}{lp{10cm}}
+  {\tt passnum}    & number of sifting passes done in this reordering \\
+  {\tt passbefore} & number of nodes before the last pass \\
+  {\tt passafter}  & number of nodes after the last pass \\
+  {\tt passgain}   & gain of the last pass in percent \\
+  {\tt passtime}   & wall-clock time used by the last pass in milliseconds \\
+  {\tt time}       & wall-clock time used by this reordering until now
+                      in milliseconds
+  \end{tabular} *}
+ALSO    {* bdd\_reorder\_stats, bdd\_reorder\_passhook *}
+*/
+typedef struct s_bddReorderStat
+{
+   int passnum;
+   BDD passbefore;
+   BDD passafter;
+   int passgain;
+   long passtime;
+   long time;
+} bddReorderStat;
+
+
 /*
 NAME    {* bddCacheStat *}
 SECTION {* kernel *}
@@ -227,8 +303,12 @@ PROTO   {* typedef struct s_bddCacheStat
    long unsigned int uniqueChain;
    long unsigned int uniqueHit;
    long unsigned int uniqueMiss;
+   long unsigned int uniqueMaxChain;
+   long unsigned int uniqueSize;
+   long unsigned int uniqueNodes;
    long unsigned int opHit;
    long unsigned int opMiss;
+   long unsigned int opResize;
    long unsigned int swapCount;
 } bddCacheStat; *}
 DESCR   {* The fields are \\[\baselineskip] \begin{tabular}{ll}
@@ -237,10 +317,17 @@ DESCR   {* The fields are \\[\baselineskip] \begin{tabular}{ll}
   uniqueChain  & iterations through the cache chains in the unique node table\\
   uniqueHit    & entries actually found in the the unique node table \\
   uniqueMiss   & entries not found in the the unique node table \\
+  uniqueMaxChain & iterations in the longest search of the unique node table \\
+  uniqueSize   & slots in the unique node table \\
+  uniqueNodes  & nodes currently stored in the unique node table \\
   opHit        & entries found in the operator caches \\
   opMiss       & entries not found in the operator caches \\
+  opResize     & operator caches resized because of their miss rate \\
   swapCount    & number of variable swaps in reordering \\
-\end{tabular} *}
+\end{tabular} \\[\baselineskip]
+  The unique table counters are only maintained when the package is
+  compiled with {\tt UNIQUESTATS} or {\tt CACHESTATS}, the operator
+  cache counters only with {\tt CACHESTATS}. *}
 ALSO    {* bdd\_cachestats *}
 */
 typedef struct s_bddCacheStat
@@ -249,8 +336,12 @@ typedef struct s_bddCacheStat
    long unsigned int uniqueChain;
    long unsigned int uniqueHit;
    long unsigned int uniqueMiss;
+   long unsigned int uniqueMaxChain;
+   long unsigned int uniqueSize;
+   long unsigned int uniqueNodes;
    long unsigned int opHit;
    long unsigned int opMiss;
+   long unsigned int opResize;
    long unsigned int swapCount;
 } bddCacheStat;
 
@@ -279,27 +370,43 @@ extern "C" {
 typedef void (*bddinthandler)(int);
 typedef void (*bddgbchandler)(int,bddGbcStat*);
 typedef void (*bdd2inthandler)(int,int);
-typedef int  (*bddsizehandler)(void);
+typedef void (*bddresizehandler)(BDD,BDD);
+typedef BDD  (*bddsizehandler)(void);
 typedef void (*bddfilehandler)(FILE *, int);
 typedef void (*bddallsathandler)(char*, int);
+typedef int  (*bddbudgethandler)(int);
+
+#if ENABLE_REENTRANT
+   /* The current manager of the thread. Use bdd_get_manager() */
+extern BDD_TLS bdd_manager *bddmanager;
+#endif
 
 extern bddinthandler  bdd_error_hook(bddinthandler);
 extern bddgbchandler  bdd_gbc_hook(bddgbchandler);
-extern bdd2inthandler bdd_resize_hook(bdd2inthandler);
+extern bddresizehandler bdd_resize_hook(bddresizehandler);
 extern bddinthandler  bdd_reorder_hook(bddinthandler);
+extern bddinthandler  bdd_reorder_passhook(bddinthandler);
 extern bddfilehandler bdd_file_hook(bddfilehandler);
+extern bddbudgethandler bdd_budget_hook(bddbudgethandler);
 
-extern int      bdd_init(int, int);
+extern int      bdd_init(BDD, int);
 extern void     bdd_done(void);
+#if ENABLE_REENTRANT
+extern bdd_manager* bdd_get_manager(void);
+extern bdd_manager* bdd_set_manager(bdd_manager *);
+extern int      bdd_free_manager(bdd_manager *);
+#endif
 extern int      bdd_setvarnum(int);
 extern int      bdd_setvarnum_ordered(int, int*);
 extern int      bdd_extvarnum(int);
 extern int      bdd_isrunning(void);
-extern int      bdd_setmaxnodenum(int);
+extern BDD      bdd_setmaxnodenum(BDD);
 extern int      bdd_setmaxincrease(int);
 extern int      bdd_setminfreenodes(int);
-extern int      bdd_getnodenum(void);
-extern int      bdd_getallocnum(void);
+extern int      bdd_setgbcthreads(int);
+extern int      bdd_setapplythreads(int);
+extern BDD      bdd_getnodenum(void);
+extern BDD      bdd_getallocnum(void);
 extern char*    bdd_versionstr(void);
 extern int      bdd_versionnum(void);
 extern void     bdd_stats(bddStat *);
@@ -334,9 +441,9 @@ extern void     bdd_resetpair(bddPair *);
 extern void     bdd_freepair(bddPair*);
 
 #if ENABLE_TBDD
-extern int      bdd_xvar(BDD);
-extern int      bdd_nameid(BDD);
-extern int      bdd_dclause(BDD, dclause_t);
+extern clause_id_t bdd_xvar(BDD);
+extern clause_id_t bdd_nameid(BDD);
+extern clause_id_t bdd_dclause(BDD, dclause_t);
 #endif
 
 #if ENABLE_BTRACE
@@ -346,11 +453,14 @@ extern void   bdd_start_trace(FILE *tfile);
   /* In bddop.c */
 
 extern int      bdd_setcacheratio(int);
+extern int      bdd_setcachemissrate(int, int);
+extern int      bdd_setnodebudget(int);
 extern BDD      bdd_buildcube(int, int, BDD *);
 extern BDD      bdd_ibuildcube(int, int, int *);
 extern BDD      bdd_not(BDD);
 extern BDD      bdd_apply(BDD, BDD, int);
 extern BDD      bdd_and(BDD, BDD);
+extern BDD      bdd_and_multi(BDD *, int);
 extern BDD      bdd_or(BDD, BDD);
 extern BDD      bdd_xor(BDD, BDD);
 extern BDD      bdd_imp(BDD, BDD);
@@ -359,7 +469,7 @@ extern BDD      bdd_ite(BDD, BDD, BDD);
 extern BDD      bdd_restrict(BDD, BDD);
 extern BDD      bdd_constrain(BDD, BDD);
 extern BDD      bdd_replace(BDD, bddPair*);
-extern BDD      bdd_compose(BDD, BDD, BDD);
+extern BDD      bdd_compose(BDD, BDD, int);
 extern BDD      bdd_veccompose(BDD, bddPair*);
 extern BDD      bdd_simplify(BDD, BDD);
 extern BDD      bdd_exist(BDD, BDD);
@@ -377,8 +487,8 @@ extern double   bdd_satcount(BDD);
 extern double   bdd_satcountset(BDD, BDD);
 extern double   bdd_satcountln(BDD);
 extern double   bdd_satcountlnset(BDD, BDD);
-extern int      bdd_nodecount(BDD);
-extern int      bdd_anodecount(BDD *, int);
+extern BDD      bdd_nodecount(BDD);
+extern BDD      bdd_anodecount(BDD *, int);
 extern int*     bdd_varprofile(BDD);
 extern double   bdd_pathcount(BDD);
 
@@ -412,6 +522,8 @@ extern void     bdd_varblockall(void);
 extern bddfilehandler bdd_blockfile_hook(bddfilehandler);
 extern int      bdd_autoreorder(int);
 extern int      bdd_autoreorder_times(int, int);
+extern int      bdd_autoreorder_limits(int, int, int);
+extern void     bdd_reorder_stats(bddReorderStat *);
 extern int      bdd_var2level(int);
 extern int      bdd_level2var(int);
 extern int      bdd_getreorder_times(void);
@@ -522,7 +634,7 @@ class bdd
    bdd(const bdd &r) { bdd_addref(root=r.root); }
    ~bdd(void)        { bdd_delref(root); }
 
-   int id(void) const;
+   BDD id(void) const;
 
    bdd operator=(const bdd &r);
 
@@ -564,7 +676,9 @@ private:
    friend int      bdd_var(const bdd &);
    friend bdd      bdd_low(const bdd &);
    friend bdd      bdd_high(const bdd &);
-   friend int      bdd_nameid(const bdd &);
+#if ENABLE_TBDD
+   friend clause_id_t bdd_nameid(const bdd &);
+#endif
    friend int      bdd_scanset(const bdd &, int *&, int &);
    friend bdd      bdd_makesetpp(int *, int);
    friend int      bdd_setbddpair(bddPair*, int, const bdd &);
@@ -575,6 +689,7 @@ private:
    friend bdd      bdd_simplify(const bdd &, const bdd &);
    friend bdd      bdd_apply(const bdd &, const bdd &, int);
    friend bdd      bdd_and(const bdd &, const bdd &);
+   friend bdd      bdd_and_multi(const bdd *, int);
    friend bdd      bdd_or(const bdd &, const bdd &);
    friend bdd      bdd_xor(const bdd &, const bdd &);
    friend bdd      bdd_imp(const bdd &, const bdd &);
@@ -600,8 +715,8 @@ private:
    friend double   bdd_satcountset(const bdd &, const bdd &);
    friend double   bdd_satcountln(const bdd &);
    friend double   bdd_satcountlnset(const bdd &, const bdd &);
-   friend int      bdd_nodecount(const bdd &);
-   friend int      bdd_anodecountpp(const bdd *, int);
+   friend BDD      bdd_nodecount(const bdd &);
+   friend BDD      bdd_anodecountpp(const bdd *, int);
    friend int*     bdd_varprofile(const bdd &);
    friend double   bdd_pathcount(const bdd &);
    friend void   bdd_fprinttable(FILE *, const bdd &);
@@ -660,6 +775,9 @@ extern int bdd_cpp_init(int, int);
 inline void bdd_stats(bddStat& s)
 { bdd_stats(&s); }
 
+inline void bdd_reorder_stats(bddReorderStat& s)
+{ bdd_reorder_stats(&s); }
+
 inline bdd bdd_ithvarpp(int v)
 { return BDD_ithvar(v); }
 
@@ -675,8 +793,10 @@ inline bdd bdd_low(const bdd &r)
 inline bdd bdd_high(const bdd &r)
 { return bdd_high(r.root); }
 
-inline int bdd_nameid(const bdd &r)
+#if ENABLE_TBDD
+inline clause_id_t bdd_nameid(const bdd &r)
 { return bdd_nameid(r.root); }
+#endif
 
 inline int bdd_scanset(const bdd &r, int *&v, int &n)
 { return bdd_scanset(r.root, &v, &n); }
@@ -779,7 +899,7 @@ inline double bdd_satcountln(const bdd &r)
 inline double bdd_satcountlnset(const bdd &r, const bdd &varset)
 { return bdd_satcountlnset(r.root, varset.root); }
 
-inline int bdd_nodecount(const bdd &r)
+inline BDD bdd_nodecount(const bdd &r)
 { return bdd_nodecount(r.root); }
 
 inline int* bdd_varprofile(const bdd &r)
@@ -818,10 +938,10 @@ inline int bdd_save(FILE *ofile, const bdd &r)
 { return bdd_save(ofile, r.root); }
 
 inline int bdd_fnload(char *fname, bdd &r)
-{ int lr,e; e=bdd_fnload(fname, &lr); r=bdd(lr); return e; }
+{ BDD lr; int e; e=bdd_fnload(fname, &lr); r=bdd(lr); return e; }
 
 inline int bdd_load(FILE *ifile, bdd &r)
-{ int lr,e; e=bdd_load(ifile, &lr); r=bdd(lr); return e; }
+{ BDD lr; int e; e=bdd_load(ifile, &lr); r=bdd(lr); return e; }
 
 inline int bdd_addvarblock(const bdd &v, int f)
 { return bdd_addvarblock(v.root, f); }
@@ -836,7 +956,7 @@ inline int bdd_addvarblock(const bdd &v, int f)
 
 /*=== Inline C++ functions =============================================*/
 
-inline int bdd::id(void) const
+inline BDD bdd::id(void) const
 { return root; }
 
 inline bdd bdd::operator&(const bdd &r) const
@@ -906,7 +1026,7 @@ class bdd_ioformat
  private:
    bdd_ioformat(void)  { }
    int format;
-   static int curformat;
+   static BDD_TLS int curformat;
 
    friend std::ostream &operator<<(std::ostream &, const bdd_ioformat &);
    friend std::ostream &operator<<(std::ostream &, const bdd &);
@@ -41,27 +41,45 @@
 #include <sys/stat.h>
 #include "kernel.h"
 
-static void bdd_printset_rec(FILE *, int, int *);
+static void bdd_printset_rec(FILE *, BDD, int *);
 static void bdd_fprintdot_rec(FILE*, BDD);
-static int  bdd_save_rec(FILE*, int);
-static int  bdd_loaddata(FILE *);
-static int  loadhash_get(int);
-static void loadhash_add(int, int);
-
-static bddfilehandler filehandler;
+static int  bdd_save_rec(FILE*, BDD);
+static BDD  bdd_loaddata(FILE *);
+static BDD  loadhash_get(BDD);
+static void loadhash_add(BDD, BDD);
 
 typedef struct s_LoadHash
 {
-   int key;
-   int data;
-   int first;
-   int next;
+   BDD key;
+   BDD data;
+   BDD first;
+   BDD next;
 } LoadHash;
 
-static LoadHash *lh_table;
-static int       lh_freepos;
-static int       lh_nodenum;
-static int      *loadvar2level;
+typedef struct s_IoState
+{
+   bddfilehandler filehandler;
+   LoadHash *lh_table;
+   BDD       lh_freepos;
+   BDD       lh_nodenum;
+   int      *loadvar2level;
+} IoState;
+
+#if ENABLE_REENTRANT
+void *bdd_io_newstate(void)
+{
+   return bdd_newstate(NULL, sizeof(IoState));
+}
+#else
+static IoState iostate;
+#endif
+
+#define IOSTATE BDDSTATE(IoState, BDDMOD_IO, iostate)
+#define filehandler   (IOSTATE->filehandler)
+#define lh_table      (IOSTATE->lh_table)
+#define lh_freepos    (IOSTATE->lh_freepos)
+#define lh_nodenum    (IOSTATE->lh_nodenum)
+#define loadvar2level (IOSTATE->loadvar2level)
 
 /*=== PRINTING ========================================================*/
 
@@ -94,7 +112,10 @@ ALSO    {* bdd\_printset, bdd\_strm\_hook, fdd\_file\_hook *}
 */
 bddfilehandler bdd_file_hook(bddfilehandler handler)
 {
-   bddfilehandler old = filehandler;
+   bddfilehandler old;
+
+   CHECKMANAGER;
+   old = filehandler;
    filehandler = handler;
    return old;
 }
@@ -124,20 +145,22 @@ void bdd_printall(void)
 
 void bdd_fprintall(FILE *ofile)
 {
-   int n;
+   BDD n;
    
-   for (n=0 ; n<bddnodesize ; n++)
+   for (n=0 ; n<bddnodeinit ; n++)
    {
-      if (LOW(n) != -1)
+      BddNode *node = &bddnodes[n];
+
+      if (LOWp(node) != -1)
       {
-	 fprintf(ofile, "[%5d - %2d] ", n, bddnodes[n].refcou);
+	 fprintf(ofile, "[%5" PRIbdd " - %2d] ", NODEREF(n), node->refcou);
 	 if (filehandler)
-	    filehandler(ofile, bddlevel2var[LEVEL(n)]);
+	    filehandler(ofile, bddlevel2var[LEVELp(node)]);
 	 else
-	    fprintf(ofile, "%3d", bddlevel2var[LEVEL(n)]);
+	    fprintf(ofile, "%3d", bddlevel2var[LEVELp(node)]);
 
-	 fprintf(ofile, ": %3d", LOW(n));
-	 fprintf(ofile, " %3d", HIGH(n));
+	 fprintf(ofile, ": %3" PRIbdd, LOWp(node));
+	 fprintf(ofile, " %3" PRIbdd, HIGHp(node));
 	 fprintf(ofile, "\n");
       }
    }
@@ -169,9 +192,9 @@ void bdd_printtable(BDD r)
 void bdd_fprinttable(FILE *ofile, BDD r)
 {
    BddNode *node;
-   int n;
+   BDD n;
    
-   fprintf(ofile, "ROOT: %d\n", r);
+   fprintf(ofile, "ROOT: %" PRIbdd "\n", r);
    if (r < 2)
       return;
 
@@ -179,20 +202,20 @@ void bdd_fprinttable(FILE *ofile, BDD r)
    
    for (n=0 ; n<bddnodesize ; n++)
    {
-      if (LEVEL(n) & MARKON)
+      node = &bddnodes[n];
+
+      if (MARKEDp(node))
       {
-	 node = &bddnodes[n];
-	 
 	 LEVELp(node) &= MARKOFF;
 
-	 fprintf(ofile, "[%5d] ", n);
+	 fprintf(ofile, "[%5" PRIbdd "] ", NODEREF(n));
 	 if (filehandler)
 	    filehandler(ofile, bddlevel2var[LEVELp(node)]);
 	 else
 	    fprintf(ofile, "%3d", bddlevel2var[LEVELp(node)]);
 
-	 fprintf(ofile, ": %3d", LOWp(node));
-	 fprintf(ofile, " %3d", HIGHp(node));
+	 fprintf(ofile, ": %3" PRIbdd, LOWp(node));
+	 fprintf(ofile, " %3" PRIbdd, HIGHp(node));
 	 fprintf(ofile, "\n");
       }
    }
@@ -251,7 +274,7 @@ void bdd_fprintset(FILE *ofile, BDD r)
 }
 
 
-static void bdd_printset_rec(FILE *ofile, int r, int *set)
+static void bdd_printset_rec(FILE *ofile, BDD r, int *set)
 {
    int n;
    int first;
@@ -332,6 +355,10 @@ void bdd_fprintdot(FILE* ofile, BDD r)
    fprintf(ofile, "0 [shape=box, label=\"0\", style=filled, shape=box, height=0.3, width=0.3];\n");
    fprintf(ofile, "1 [shape=box, label=\"1\", style=filled, shape=box, height=0.3, width=0.3];\n");
 
+   if (ISCOMPL(r))
+      fprintf(ofile, "root [shape=plaintext, label=\"\"];\n"
+	      "root -> %" PRIbdd " [arrowhead=odot];\n", REGULAR(r));
+
    bdd_fprintdot_rec(ofile, r);
 
    fprintf(ofile, "}\n");
@@ -345,15 +372,19 @@ static void bdd_fprintdot_rec(FILE* ofile, BDD r)
    if (ISCONST(r) || MARKED(r))
       return;
 
-   fprintf(ofile, "%d [label=\"", r);
+      /* Complemented edges are drawn with a circle at the arrow head */
+   r = REGULAR(r);
+   fprintf(ofile, "%" PRIbdd " [label=\"", r);
    if (filehandler)
       filehandler(ofile, bddlevel2var[LEVEL(r)]);
    else
       fprintf(ofile, "%d", bddlevel2var[LEVEL(r)]);
    fprintf(ofile, "\"];\n");
 
-   fprintf(ofile, "%d -> %d [style=dotted];\n", r, LOW(r));
-   fprintf(ofile, "%d -> %d [style=filled];\n", r, HIGH(r));
+   fprintf(ofile, "%" PRIbdd " -> %" PRIbdd " [style=dotted%s];\n", r, REGULAR(LOW(r)),
+	   ISCOMPL(LOW(r)) ? ", arrowhead=odot" : "");
+   fprintf(ofile, "%" PRIbdd " -> %" PRIbdd " [style=filled%s];\n", r, REGULAR(HIGH(r)),
+	   ISCOMPL(HIGH(r)) ? ", arrowhead=odot" : "");
 
    SETMARK(r);
    
@@ -394,32 +425,42 @@ int bdd_fnsave(char *fname, BDD r)
 
 int bdd_save(FILE *ofile, BDD r)
 {
-   int err, n=0;
+   int err, n;
+   BDD num=0;
 
    if (r < 2)
    {
-      fprintf(ofile, "0 0 %d\n", r);
+      fprintf(ofile, "0 0 %" PRIbdd "\n", r);
       return 0;
    }
    
-   bdd_markcount(r, &n);
+   bdd_markcount(r, &num);
    bdd_unmark(r);
-   fprintf(ofile, "%d %d\n", n, bddvarnum);
+
+      /* A complemented root is saved as an extra node on top of the
+	 regular one */
+   if (ISCOMPL(r))
+      num++;
+   fprintf(ofile, "%" PRIbdd " %d\n", num, bddvarnum);
 
    for (n=0 ; n<bddvarnum ; n++)
       fprintf(ofile, "%d ", bddvar2level[n]);
    fprintf(ofile, "\n");
    
-   err = bdd_save_rec(ofile, r);
+   err = bdd_save_rec(ofile, REGULAR(r));
    bdd_unmark(r);
 
+   if (err == 0  &&  ISCOMPL(r))
+      fprintf(ofile, "%" PRIbdd " %d %" PRIbdd " %" PRIbdd "\n",
+	      r, bddlevel2var[LEVEL(r)], LOW(r), HIGH(r));
+
    return err;
 }
 
 
-static int bdd_save_rec(FILE *ofile, int root)
+static int bdd_save_rec(FILE *ofile, BDD root)
 {
-   BddNode *node = &bddnodes[root];
+   BddNode *node = &bddnodes[NODEIDX(root)];
    int err;
    
    if (root < 2)
@@ -434,8 +475,8 @@ static int bdd_save_rec(FILE *ofile, int root)
    if ((err=bdd_save_rec(ofile, HIGHp(node))) < 0)
       return err;
 
-   fprintf(ofile, "%d %d %d %d\n",
-	   root, bddlevel2var[LEVELp(node) & MARKHIDE],
+   fprintf(ofile, "%" PRIbdd " %d %" PRIbdd " %" PRIbdd "\n",
+	   REGULAR(root), bddlevel2var[LEVELp(node) & MARKHIDE],
 	   LOWp(node), HIGHp(node));
 
    return 0;
@@ -488,15 +529,16 @@ int bdd_fnload(char *fname, BDD *root)
 
 int bdd_load(FILE *ifile, BDD *root)
 {
-   int n, vnum, tmproot;
+   int vnum;
+   BDD n, tmproot;
 
-   if (fscanf(ifile, "%d %d", &lh_nodenum, &vnum) != 2)
+   if (fscanf(ifile, "%" PRIbdd " %d", &lh_nodenum, &vnum) != 2)
       return bdd_error(BDD_FORMAT);
 
       /* Check for constant true / false */
    if (lh_nodenum==0  &&  vnum==0)
    {
-      fscanf(ifile, "%d", root);
+      fscanf(ifile, "%" PRIbdd, root);
       return 0;
    }
 
@@ -529,7 +571,7 @@ int bdd_load(FILE *ifile, BDD *root)
    
    *root = 0;
    if (tmproot < 0)
-      return tmproot;
+      return (int) tmproot;
    else
       *root = tmproot;
    
@@ -537,13 +579,14 @@ int bdd_load(FILE *ifile, BDD *root)
 }
 
 
-static int bdd_loaddata(FILE *ifile)
+static BDD bdd_loaddata(FILE *ifile)
 {
-   int key,var,low,high,root=0,n;
+   BDD key,low,high,root=0,n;
+   int var;
    
    for (n=0 ; n<lh_nodenum ; n++)
    {
-      if (fscanf(ifile,"%d %d %d %d", &key, &var, &low, &high) != 4)
+      if (fscanf(ifile,"%" PRIbdd " %d %" PRIbdd " %" PRIbdd, &key, &var, &low, &high) != 4)
 	 return bdd_error(BDD_FORMAT);
 
       if (low >= 2)
@@ -563,10 +606,10 @@ static int bdd_loaddata(FILE *ifile)
 }
 
 
-static void loadhash_add(int key, int data)
+static void loadhash_add(BDD key, BDD data)
 {
-   int hash = key % lh_nodenum;
-   int pos = lh_freepos;
+   BDD hash = key % lh_nodenum;
+   BDD pos = lh_freepos;
 
    lh_freepos = lh_table[pos].next;
    lh_table[pos].next = lh_table[hash].first;
@@ -577,9 +620,18 @@ static void loadhash_add(int key, int data)
 }
 
 
-static int loadhash_get(int key)
+static BDD loadhash_get(BDD key)
 {
-   int hash = lh_table[key % lh_nodenum].first;
+   BDD hash;
+
+      /* Complemented references are looked up through their node */
+   if (ISCOMPL(key))
+   {
+      BDD data = loadhash_get(REGULAR(key));
+      return data < 0 ? data : bdd_not(data);
+   }
+
+   hash = lh_table[key % lh_nodenum].first;
 
    while (hash != -1  &&  lh_table[hash].key != key)
       hash = lh_table[hash].next;
@@ -77,6 +77,11 @@
 #include "kernel.h"
 #include "cache.h"
 
+#if ENABLE_PARAPPLY
+#include <pthread.h>
+#include <sched.h>
+#endif
+
    /* Hash value modifiers to distinguish between misc operations */
 #define CACHEID_CONSTRAIN   0x0
 #define CACHEID_RESTRICT    0x1
@@ -117,61 +122,254 @@ static int oprres[OPERATOR_NUM][4] =
 };
 
 
-   /* Variables needed for the operators */
-static int applyop;                 /* Current operator for apply */
-static int appexop;                 /* Current operator for appex */
-static int appexid;                 /* Current cache id for appex */
-static int quantid;                 /* Current cache id for quantifications */
-static int *quantvarset;            /* Current variable set for quant. */
-static int quantvarsetID;           /* Current id used in quantvarset */
-static int quantlast;               /* Current last variable to be quant. */
-static int replaceid;               /* Current cache id for replace */
-static int *replacepair;            /* Current replace pair */
-static int replacelast;             /* Current last var. level to replace */
-static int composelevel;            /* Current variable used for compose */
-static int miscid;                  /* Current cache id for other results */
-static int *varprofile;             /* Current variable profile */
-static int supportID;               /* Current ID (true value) for support */
-static int supportMin;              /* Min. used level in support calc. */
-static int supportMax;              /* Max. used level in support calc. */
-static int* supportSet;             /* The found support set */
-static int supportSize;             /* Number of int's allocated for supportSet */
-static BddCache opcache;            /* Cache for all operations */
-static int cacheratio;
-static BDD satPolarity;
-static int firstReorder;            /* Used instead of local variable in order
-				       to avoid compiler warning about 'first'
-				       being clobbered by setjmp */
-
-static int this_apply_counter;    /* Keep track of number of calls to current apply operation */
 #define THIS_APPLY_REPORT 1000000   /* How often should program report apply operations */
 
-static char*            allsatProfile; /* Variable profile for bdd_allsat() */
-static bddallsathandler allsatHandler; /* Callback handler for bdd_allsat() */
+#if ENABLE_ITERAPPLY
+   /* Kinds of calls run by the iterative engine */
+#define ITER_APPLY  0
+#define ITER_QUANT  1
+#define ITER_APPLYJ 2
+
+static BDD    bdd_iter_run(int, int, BDD, BDD);
+static void   bdd_iter_done(void);
+#endif
+
+#if ENABLE_PARAPPLY
+   /* Max. number of threads for apply and quantification */
+#define PARAPPLYMAXTHREADS 64
+   /* Number of task slots of each thread */
+#define PARDEQUESIZE       (1 << 14)
+   /* Tasks spawned by the caller before sleeping threads are woken */
+#define PARWAKESPAWNS      256
+   /* Number of lock words shared by the cache entries */
+#define PARCACHELOCKS      (1 << 12)
+
+#define PARTASK_APPLY 0
+#define PARTASK_QUANT 1
+
+typedef struct s_ParTask /* A recursive call that other threads may steal */
+{
+   int op;        /* PARTASK_APPLY or PARTASK_QUANT */
+   BDD a, b;      /* Operands (b unused for quantification) */
+   BDD res;
+   int done;      /* Set when a thief has stored the result */
+} ParTask;
+
+typedef struct s_ParWorker /* State of one apply thread */
+{
+   ParTask *deque;      /* Spawned tasks, the owner works at the bottom */
+   int top;             /* Oldest task, where thieves steal */
+   int bottom;          /* First free slot */
+   int lock;            /* Protects top and bottom */
+   unsigned int seed;   /* For picking victims */
+   BddNodeBatch nodes;  /* Private free nodes */
+   pthread_t thread;
+#if ENABLE_REENTRANT
+   bdd_manager *manager; /* Manager of the calling thread */
+#endif
+} ParWorker;
+
+static BDD    bdd_par_apply(BDD, BDD);
+static BDD    bdd_par_quant(BDD);
+static void   bdd_par_stop(void);
+#endif
+
+typedef struct s_OpState
+{
+      /* Variables needed for the operators */
+   int applyop;                 /* Operator for quant. and par. apply */
+   int appexop;                 /* Current operator for appex */
+   BDD appexid;                 /* Current cache id for appex */
+   BDD quantid;                 /* Current cache id for quantifications */
+   int *quantvarset;            /* Current variable set for quant. */
+   int quantvarsetID;           /* Current id used in quantvarset */
+   int quantlast;               /* Current last variable to be quant. */
+#if ENABLE_TBDD
+   BDD andexvar;                /* Current variable set for and-exist. */
+#endif
+   int replaceid;               /* Current cache id for replace */
+   BDD *replacepair;            /* Current replace pair */
+   int replacelast;             /* Current last var. level to replace */
+   int composelevel;            /* Current variable used for compose */
+   BDD miscid;                  /* Current cache id for other results */
+   int *varprofile;             /* Current variable profile */
+   int supportID;               /* Current ID (true value) for support */
+   int supportMin;              /* Min. used level in support calc. */
+   int supportMax;              /* Max. used level in support calc. */
+   int* supportSet;             /* The found support set */
+   int supportSize;             /* Number of int's allocated for supportSet */
+   BddCache applycache;         /* Cache for apply, not and simplify */
+   BddCache itecache;           /* Cache for ite */
+   BddCache quantcache;         /* Cache for quantification and appex */
+   BddCache replacecache;       /* Cache for replace and compose */
+   BddCache misccache;          /* Cache for restrict and constrain */
+   BddCache countcache;         /* Cache for satcount and pathcount */
+   BddCache multicache;         /* Cache for n-ary conjunction */
+   int multicachesize;          /* Its size, when it is allocated */
+#if ENABLE_TBDD
+   BddCache jcache;             /* Cache for the proof operations */
+#endif
+   int cacheratio;
+#if ENABLE_ADAPTCACHE
+   int cacheshrinkmiss;         /* Miss rates in percent that */
+   int cachegrowmiss;           /* trigger resizing of caches */
+   int applycachebase;          /* Sizes given by the budget */
+#if ENABLE_TBDD
+   int jcachebase;
+#endif
+#endif
+   int parthreads;              /* Apply threads, including the caller */
+   BDD satPolarity;
+   int firstReorder;            /* Used instead of local variable in order
+				   to avoid compiler warning about 'first'
+				   being clobbered by setjmp */
+
+   int this_apply_counter;      /* Keep track of number of calls to current apply operation */
+   int nodebudget;              /* Nodes an operation may build, 0 if no limit */
+   bddbudgethandler budget_handler; /* Called when the budget is used up */
+
+#if ENABLE_ITERAPPLY
+   clause_id_t iterclause;      /* Justification of the last result */
+   struct s_IterFrame *iterstack; /* Pending calls */
+   int itersize;
+   int itertop;
+#endif
+
+#if ENABLE_PARAPPLY
+   ParWorker parworker[PARAPPLYMAXTHREADS];
+   int parstarted;              /* Number of threads in the pool */
+   int paractive;               /* Set while a parallel operation runs */
+   int parquit;                 /* Tells the pool to shut down */
+   int parabort;                /* Out of nodes, redo sequentially */
+   int parspawns;               /* Tasks spawned by the caller */
+   int parsleeping;             /* Pool threads waiting for work */
+   pthread_mutex_t parmutex;
+   pthread_cond_t parcond;
+   unsigned int parcachelock[PARCACHELOCKS];
+#endif
+
+   char*            allsatProfile; /* Variable profile for bdd_allsat() */
+   bddallsathandler allsatHandler; /* Callback handler for bdd_allsat() */
+} OpState;
+
+#if ENABLE_ADAPTCACHE
+#define OPSTATE_INIT_ADAPT .cacheshrinkmiss = 20, .cachegrowmiss = 60,
+#else
+#define OPSTATE_INIT_ADAPT
+#endif
+#if ENABLE_PARAPPLY
+#define OPSTATE_INIT_PAR , .parmutex = PTHREAD_MUTEX_INITIALIZER, \
+   .parcond = PTHREAD_COND_INITIALIZER
+#else
+#define OPSTATE_INIT_PAR
+#endif
+#define OPSTATE_INIT { OPSTATE_INIT_ADAPT .parthreads = 1 OPSTATE_INIT_PAR }
+
+#if ENABLE_REENTRANT
+void *bdd_op_newstate(void)
+{
+   static const OpState init = OPSTATE_INIT;
+   return bdd_newstate(&init, sizeof(OpState));
+}
+#else
+static OpState opstate = OPSTATE_INIT;
+#endif
 
-extern bddCacheStat bddcachestats;
+#define OPSTATE BDDSTATE(OpState, BDDMOD_OP, opstate)
+#define applyop            (OPSTATE->applyop)
+#define appexop            (OPSTATE->appexop)
+#define appexid            (OPSTATE->appexid)
+#define quantid            (OPSTATE->quantid)
+#define quantvarset        (OPSTATE->quantvarset)
+#define quantvarsetID      (OPSTATE->quantvarsetID)
+#define quantlast          (OPSTATE->quantlast)
+#if ENABLE_TBDD
+#define andexvar           (OPSTATE->andexvar)
+#endif
+#define replaceid          (OPSTATE->replaceid)
+#define replacepair        (OPSTATE->replacepair)
+#define replacelast        (OPSTATE->replacelast)
+#define composelevel       (OPSTATE->composelevel)
+#define miscid             (OPSTATE->miscid)
+#define varprofile         (OPSTATE->varprofile)
+#define supportID          (OPSTATE->supportID)
+#define supportMin         (OPSTATE->supportMin)
+#define supportMax         (OPSTATE->supportMax)
+#define supportSet         (OPSTATE->supportSet)
+#define supportSize        (OPSTATE->supportSize)
+#define applycache         (OPSTATE->applycache)
+#define itecache           (OPSTATE->itecache)
+#define quantcache         (OPSTATE->quantcache)
+#define replacecache       (OPSTATE->replacecache)
+#define misccache          (OPSTATE->misccache)
+#define countcache         (OPSTATE->countcache)
+#define multicache         (OPSTATE->multicache)
+#define multicachesize     (OPSTATE->multicachesize)
+#if ENABLE_TBDD
+#define jcache             (OPSTATE->jcache)
+#endif
+#define cacheratio         (OPSTATE->cacheratio)
+#if ENABLE_ADAPTCACHE
+#define cacheshrinkmiss    (OPSTATE->cacheshrinkmiss)
+#define cachegrowmiss      (OPSTATE->cachegrowmiss)
+#define applycachebase     (OPSTATE->applycachebase)
+#if ENABLE_TBDD
+#define jcachebase         (OPSTATE->jcachebase)
+#endif
+#endif
+#define parthreads         (OPSTATE->parthreads)
+#define satPolarity        (OPSTATE->satPolarity)
+#define firstReorder       (OPSTATE->firstReorder)
+#define this_apply_counter (OPSTATE->this_apply_counter)
+#define nodebudget         (OPSTATE->nodebudget)
+#define budget_handler     (OPSTATE->budget_handler)
+#if ENABLE_ITERAPPLY
+#define iterclause         (OPSTATE->iterclause)
+#define iterstack          (OPSTATE->iterstack)
+#define itersize           (OPSTATE->itersize)
+#define itertop            (OPSTATE->itertop)
+#endif
+#if ENABLE_PARAPPLY
+#define parworker          (OPSTATE->parworker)
+#define parstarted         (OPSTATE->parstarted)
+#define paractive          (OPSTATE->paractive)
+#define parquit            (OPSTATE->parquit)
+#define parabort           (OPSTATE->parabort)
+#define parspawns          (OPSTATE->parspawns)
+#define parsleeping        (OPSTATE->parsleeping)
+#define parmutex           (OPSTATE->parmutex)
+#define parcond            (OPSTATE->parcond)
+#define parcachelock       (OPSTATE->parcachelock)
+#endif
+#define allsatProfile      (OPSTATE->allsatProfile)
+#define allsatHandler      (OPSTATE->allsatHandler)
 
    /* Internal prototypes */
 static BDD    not_rec(BDD);
-static BDD    apply_rec(BDD, BDD);
+static BDD    apply_and_rec(BDD, BDD);
+static BDD    apply_or_rec(BDD, BDD);
+static BDD    apply_xor_rec(BDD, BDD);
+static BDD    apply_imp_rec(BDD, BDD);
+static BDD    apply_any_rec(BDD, BDD, int);
 static BDD    ite_rec(BDD, BDD, BDD);
-static int    simplify_rec(BDD, BDD);
-static int    quant_rec(int);
-static int    appquant_rec(int, int);
-static int    restrict_rec(int);
+static BDD    simplify_rec(BDD, BDD);
+static BDD    quant_rec(BDD);
+static BDD    appquant_rec(BDD, BDD);
+static BDD    andmulti_rec(BDD*, int);
+static BDD    restrict_rec(BDD);
 static BDD    constrain_rec(BDD, BDD);
 static BDD    replace_rec(BDD);
 static BDD    bdd_correctify(int, BDD, BDD);
 static BDD    compose_rec(BDD, BDD);
 static BDD    veccompose_rec(BDD);
-static void   support_rec(int, int*);
+static void   support_rec(BDD, int*);
 static BDD    satone_rec(BDD);
 static BDD    satoneset_rec(BDD, BDD);
-static int    fullsatone_rec(int);
+static BDD    fullsatone_rec(BDD);
 static void   allsat_rec(BDD r);
-static double satcount_rec(int);
-static double satcountln_rec(int);
-static void   varprofile_rec(int);
+static double satcount_rec(BDD);
+static double satcountln_rec(BDD);
+static void   varprofile_rec(BDD);
 static double bdd_pathcount_rec(BDD);
 static int    varset2vartable(BDD);
 static int    varset2svartable(BDD);
@@ -181,25 +379,69 @@ static pcbdd    pcbdd_null();
 static pcbdd    pcbdd_tautology();
 static pcbdd    bdd_applyj(BDD, BDD, int op);
 static pcbdd    bdd_apply_aij(BDD, BDD, BDD);
-static pcbdd    applyj_rec(BDD, BDD);
+static pcbdd    applyj_and_rec(BDD, BDD);
+static pcbdd    applyj_imptst_rec(BDD, BDD);
 static pcbdd    apply_aij_rec(BDD, BDD, BDD);
+static pcbdd    andmultij_rec(BDD*, int);
+static pcbdd    andexj_rec(BDD, BDD);
+#endif
+
+
+   /* Apply op to l and r. With a constant op this is a direct call of
+      the kernel for that operator. */
+static ALWAYS_INLINE BDD apply_rec(BDD l, BDD r, int op)
+{
+   switch (op)
+   {
+   case bddop_and:
+      return apply_and_rec(l, r);
+   case bddop_or:
+      return apply_or_rec(l, r);
+   case bddop_xor:
+      return apply_xor_rec(l, r);
+   case bddop_imp:
+      return apply_imp_rec(l, r);
+   default:
+      return apply_any_rec(l, r, op);
+   }
+}
+
+
+#if ENABLE_TBDD
+   /* The same for the proof generating apply */
+static ALWAYS_INLINE pcbdd applyj_rec(BDD l, BDD r, int op)
+{
+   if (op == bddop_andj)
+      return applyj_and_rec(l, r);
+   return applyj_imptst_rec(l, r);
+}
 #endif
 
+
    /* Hashvalues */
-#define NOTHASH(r)           (r)
+#define NOTHASH(r)           ((unsigned int)(r))
 #define APPLYHASH(l,r,op)    (TRIPLE(l,r,op))
-#define AIJHASH(l,r,t)    (TRIPLE(l,r,t))
+#define JHASH(l,r,c)         (TRIPLE(l,r,c))
 #define ITEHASH(f,g,h)       (TRIPLE(f,g,h))
 #define RESTRHASH(r,var)     (PAIR(r,var))
 #define CONSTRAINHASH(f,c)   (PAIR(f,c))
-#define QUANTHASH(r)         (r)
-#define REPLACEHASH(r)       (r)
-#define VECCOMPOSEHASH(f)    (f)
+#define QUANTHASH(r)         ((unsigned int)(r))
+#define REPLACEHASH(r)       ((unsigned int)(r))
+#define VECCOMPOSEHASH(f)    ((unsigned int)(f))
 #define COMPOSEHASH(f,g)     (PAIR(f,g))
-#define SATCOUHASH(r)        (r)
-#define PATHCOUHASH(r)       (r)
+#define SATCOUHASH(r)        ((unsigned int)(r))
+#define PATHCOUHASH(r)       ((unsigned int)(r))
 #define APPEXHASH(l,r,op)    (PAIR(l,r))
 
+#if ENABLE_TBDD
+   /* Third key word of a proof cache entry. The operation is kept in it
+      as in the apply cache, but negated, since andimptstj keeps its
+      node t there. The variable set of andexj goes below all operation
+      codes */
+#define JKEY(op)             (-(BDD)(op))
+#define JKEY_ANDEX(v)        (-32 - (BDD)(v))
+#endif
+
 #ifndef M_LN2
 #define M_LN2 0.69314718055994530942
 #endif
@@ -213,9 +455,111 @@ static pcbdd    apply_aij_rec(BDD, BDD, BDD);
   Setup and shutdown
 *************************************************************************/
 
+   /* The cache size given to bdd_init() or implied by bdd_setcacheratio()
+      is a memory budget counted in units of CACHEUNIT bytes, the size of
+      the single entry format once used for all operations. It is split
+      between the caches in 1/64ths. */
+#define CACHEUNIT 24
+#if ENABLE_TBDD
+   /* Most of it goes to the proof cache, since each entry it loses costs
+      a clause to rebuild. Its entries take 20 bytes in the default
+      build, so it still holds a little more than one entry per unit,
+      as the single cache did */
+#define CACHESHARE_J        54
+#define CACHESHARE_APPLY     3
+#define CACHESHARE_ITE       1
+#define CACHESHARE_QUANT     2
+#define CACHESHARE_REPLACE   1
+#define CACHESHARE_MISC      1
+#else
+#define CACHESHARE_APPLY    40
+#define CACHESHARE_ITE       6
+#define CACHESHARE_QUANT     8
+#define CACHESHARE_REPLACE   4
+#define CACHESHARE_MISC      4
+#endif
+#define CACHESHARE_COUNT     2
+   /* The cache for n-ary conjunction comes on top of the budget, and is
+      only allocated when first used */
+#define CACHESHARE_MULTI     4
+
+#define CACHEENTRIES(size, share, type) \
+   (1 + (int)((long)(size) * CACHEUNIT * (share) / (64 * (long)sizeof(type))))
+
+#if ENABLE_ADAPTCACHE
+   /* How far a cache may grow above or shrink below its share */
+#define CACHEADAPT_MAXGROW   16
+#define CACHEADAPT_MAXSHRINK  4
+#endif
+
+static int bdd_operator_cachealloc(int cachesize, int resize)
+{
+   BddCache *cache[7];
+   int entries[7], entrysize[7];
+   int n, num = 0;
+
+#define CACHEADD(c, share, type) \
+   cache[num] = &c; \
+   entries[num] = CACHEENTRIES(cachesize, share, type); \
+   entrysize[num++] = sizeof(type)
+
+   CACHEADD(applycache, CACHESHARE_APPLY, BddCacheData);
+   CACHEADD(itecache, CACHESHARE_ITE, BddCacheData);
+   CACHEADD(quantcache, CACHESHARE_QUANT, BddCacheData);
+   CACHEADD(replacecache, CACHESHARE_REPLACE, BddCacheData);
+   CACHEADD(misccache, CACHESHARE_MISC, BddCacheData);
+   CACHEADD(countcache, CACHESHARE_COUNT, BddCacheDataD);
+#if ENABLE_TBDD
+   CACHEADD(jcache, CACHESHARE_J, BddCacheDataJ);
+#endif
+#undef CACHEADD
+
+   multicachesize = CACHEENTRIES(cachesize, CACHESHARE_MULTI, BddCacheDataM);
+   if (multicache.table != NULL  &&
+       BddCache_resize(&multicache, multicachesize) < 0)
+      return bdd_error(BDD_MEMORY);
+
+#if ENABLE_ADAPTCACHE
+   applycachebase = CACHEENTRIES(cachesize, CACHESHARE_APPLY, BddCacheData);
+#if ENABLE_TBDD
+   jcachebase = CACHEENTRIES(cachesize, CACHESHARE_J, BddCacheDataJ);
+#endif
+#endif
+
+   for (n=0 ; n<num ; n++)
+   {
+      int err = resize ? BddCache_resize(cache[n], entries[n])
+	 : BddCache_init(cache[n], entries[n], entrysize[n]);
+      if (err < 0)
+	 return err;
+   }
+
+#if ENABLE_GENGC
+   itecache.nodec = 1;
+#endif
+
+   return 0;
+}
+
+
+static void bdd_operator_cachedone(void)
+{
+   BddCache_done(&applycache);
+   BddCache_done(&itecache);
+   BddCache_done(&quantcache);
+   BddCache_done(&replacecache);
+   BddCache_done(&misccache);
+   BddCache_done(&countcache);
+   BddCache_done(&multicache);
+#if ENABLE_TBDD
+   BddCache_done(&jcache);
+#endif
+}
+
+
 int bdd_operator_init(int cachesize)
 {
-   if (BddCache_init(&opcache,cachesize) < 0)
+   if (bdd_operator_cachealloc(cachesize, 0) < 0)
       return bdd_error(BDD_MEMORY);
 
    quantvarsetID = 0;
@@ -230,14 +574,22 @@ int bdd_operator_init(int cachesize)
 
 void bdd_operator_done(void)
 {
+#if ENABLE_PARAPPLY
+   bdd_par_stop();
+#endif
+#if ENABLE_ITERAPPLY
+   bdd_iter_done();
+#endif
+
    if (quantvarset != NULL)
       free(quantvarset);
 
 #if ENABLE_TBDD
-   BddCache_clear_clauses(&opcache);
+   BddCache_clear_clauses(&jcache);
+   BddCache_clear_clausesm(&multicache);
    process_deferred_deletions();
 #endif
-   BddCache_done(&opcache);
+   bdd_operator_cachedone();
 
    if (supportSet != NULL)
      free(supportSet);
@@ -249,9 +601,17 @@ void bdd_operator_done(void)
 void bdd_operator_reset(void)
 {
 #if ENABLE_TBDD
-   BddCache_clear_clauses(&opcache);
+   BddCache_clear_clauses(&jcache);
+   BddCache_reset(&jcache);
+   BddCache_clear_clausesm(&multicache);
 #endif
-   BddCache_reset(&opcache);
+   BddCache_reset(&multicache);
+   BddCache_reset(&applycache);
+   BddCache_reset(&itecache);
+   BddCache_reset(&quantcache);
+   BddCache_reset(&replacecache);
+   BddCache_reset(&misccache);
+   BddCache_reset(&countcache);
 }
 
 
@@ -268,16 +628,77 @@ void bdd_operator_varresize(void)
 }
 
 
+#if ENABLE_ADAPTCACHE
+#if ENABLE_TBDD
+   /* Hash value used when the proof cache entry was inserted */
+static unsigned int jcache_hash(BddCacheDataJ *entry)
+{
+   return JHASH(entry->a, entry->b, entry->c);
+}
+#endif
+
+
+   /* New size of a cache whose miss rate since the last review is out of
+      range, or zero if it should keep its size. The rate is only judged
+      once there have been as many lookups as there are entries. */
+static int bdd_operator_cachereview(BddCache *cache, int base)
+{
+   unsigned long lookups = cache->hits + cache->misses;
+   int size = cache->tablesize;
+   int miss;
+
+   if (lookups < (unsigned long)size)
+      return 0;
+
+   miss = (int)(cache->misses * 100 / lookups);
+   cache->hits = 0;
+   cache->misses = 0;
+
+   if (miss > cachegrowmiss  &&
+       (long)size * 2 <= (long)base * CACHEADAPT_MAXGROW)
+      return size * 2;
+   if (miss < cacheshrinkmiss  &&  size / 2 >= base / CACHEADAPT_MAXSHRINK)
+      return size / 2;
+   return 0;
+}
+
+
+static void bdd_operator_cacheadapt(void)
+{
+   int size;
+
+   if ((size=bdd_operator_cachereview(&applycache, applycachebase)) > 0)
+   {
+      if (BddCache_resize(&applycache, size) < 0)
+	 return;
+      bddcachestats.opResize++;
+   }
+
+#if ENABLE_TBDD
+      /* The entries are moved, so only those that do not fit in the new
+	 table lose their justifying clauses */
+   if ((size=bdd_operator_cachereview(&jcache, jcachebase)) > 0)
+   {
+      if (BddCache_resizej(&jcache, size, jcache_hash) < 0)
+	 return;
+      bddcachestats.opResize++;
+   }
+#endif
+}
+#endif
+
+
 static void bdd_operator_noderesize(void)
 {
    if (cacheratio > 0)
    {
-      int newcachesize = bddnodesize / cacheratio;
+      int newcachesize = (int)(bddnodesize / cacheratio);
 
 #if ENABLE_TBDD
-      BddCache_clear_clauses(&opcache);
+      BddCache_clear_clauses(&jcache);
+      BddCache_clear_clausesm(&multicache);
 #endif
-      BddCache_resize(&opcache, newcachesize);
+      bdd_operator_cachealloc(newcachesize, 1);
    }
 }
 
@@ -298,14 +719,20 @@ DESCR   {* The ratio between the number of nodes in the nodetable
 	   {\tt bdd\_setcacheratio} to any positive value. When this is done
 	   the caches are resized instantly to fit the new ratio.
 	   The default is a fixed cache size determined at
-	   initialization time. *}
+	   initialization time.
+
+	   An entry here is a unit of 24 bytes. The memory is shared by
+	   separate caches for the different kinds of operations, most of
+	   which use entries of 16 bytes. *}
 RETURN  {* The previous cache ratio or a negative number on error. *}
-ALSO    {* bdd\_init *}
+ALSO    {* bdd\_init, bdd\_setcachemissrate *}
 */
 int bdd_setcacheratio(int r)
 {
-   int old = cacheratio;
+   int old;
 
+   CHECKMANAGER;
+   old = cacheratio;
    if (r <= 0)
       return bdd_error(BDD_RANGE);
    if (bddnodesize == 0)
@@ -317,6 +744,133 @@ int bdd_setcacheratio(int r)
 }
 
 
+/*
+NAME    {* bdd\_setcachemissrate *}
+SECTION {* kernel *}
+SHORT   {* Sets the miss rates at which the operator caches are resized *}
+PROTO   {* int bdd_setcachemissrate(int shrink, int grow) *}
+DESCR   {* When the package is compiled with {\tt ENABLE\_ADAPTCACHE}, the
+           hits and misses of the apply cache, and of the cache for the
+	   operations that generate proofs, are counted. After an operation
+	   where a cache has seen more lookups than it has entries, its
+	   size is doubled if more than {\tt grow} percent of the lookups
+	   missed, and halved if less than {\tt shrink} percent missed.
+	   A cache never grows beyond 16 times, or shrinks below a quarter
+	   of, its share of the size set by {\tt bdd\_init} or
+	   {\tt bdd\_setcacheratio}. The entries of the proof cache are
+	   moved to the resized table, so only the justifying clauses of
+	   entries that no longer fit are deleted. The defaults are 20 and
+	   60 percent. *}
+RETURN  {* Zero on succes, otherwise a negative error code. *}
+ALSO    {* bdd\_setcacheratio, bdd\_cachestats *}
+*/
+int bdd_setcachemissrate(int shrink, int grow)
+{
+   CHECKMANAGER;
+   if (shrink < 0  ||  grow > 100  ||  shrink > grow)
+      return bdd_error(BDD_RANGE);
+
+#if ENABLE_ADAPTCACHE
+   cacheshrinkmiss = shrink;
+   cachegrowmiss = grow;
+#endif
+   return 0;
+}
+
+
+/*
+NAME    {* bdd\_setapplythreads *}
+SECTION {* kernel *}
+SHORT   {* set the number of threads used for apply and quantification *}
+PROTO   {* int bdd_setapplythreads(int num) *}
+DESCR   {* Apply ({\tt bdd\_apply}, {\tt bdd\_and} etc.) and the
+           quantifications {\tt bdd\_exist}, {\tt bdd\_forall} and
+	   {\tt bdd\_unique} are done by up to {\tt num} threads,
+	   including the calling thread. Operations that generate proofs
+	   are always done by the calling thread alone. This only has an
+	   effect if the package is compiled with {\tt ENABLE\_PARAPPLY}.
+	   The default is one thread. *}
+RETURN  {* The old number of threads on succes, otherwise a negative
+           error code. *}
+ALSO    {* bdd\_setgbcthreads *}
+*/
+int bdd_setapplythreads(int num)
+{
+   int old;
+
+   CHECKMANAGER;
+   old = parthreads;
+   if (num < 1)
+      return bdd_error(BDD_RANGE);
+
+#if ENABLE_PARAPPLY
+      /* The pool is started again with the new size when needed */
+   bdd_par_stop();
+   parthreads = MIN(num, PARAPPLYMAXTHREADS);
+#else
+   parthreads = num;
+#endif
+   return old;
+}
+
+
+/*
+NAME    {* bdd\_setnodebudget *}
+SECTION {* kernel *}
+SHORT   {* set the number of nodes an operation may build *}
+PROTO   {* int bdd_setnodebudget(int num) *}
+DESCR   {* When the package is compiled with {\tt ENABLE\_ITERAPPLY},
+           apply ({\tt bdd\_apply}, {\tt bdd\_and} etc.), the
+	   quantifications {\tt bdd\_exist}, {\tt bdd\_forall} and
+	   {\tt bdd\_unique}, and the operations that generate proofs
+	   are run by a loop over an explicit stack of pending calls.
+	   Each time such an operation has built another {\tt num} nodes
+	   it calls the handler set by {\tt bdd\_budget\_hook}. If there
+	   is no handler, or the handler returns non-zero, the operation
+	   is aborted with the error {\tt BDD\_BREAK} and returns the
+	   constant false. Zero means no limit, which is the default. *}
+RETURN  {* The old budget on succes, otherwise a negative error code. *}
+ALSO    {* bdd\_budget\_hook, bdd\_setmaxnodenum *}
+*/
+int bdd_setnodebudget(int num)
+{
+   int old;
+
+   CHECKMANAGER;
+   old = nodebudget;
+   if (num < 0)
+      return bdd_error(BDD_RANGE);
+
+   nodebudget = num;
+   return old;
+}
+
+
+/*
+NAME    {* bdd\_budget\_hook *}
+SECTION {* kernel *}
+SHORT   {* set a handler for operations that use up their node budget *}
+PROTO   {* bddbudgethandler bdd_budget_hook(bddbudgethandler handler) *}
+DESCR   {* The handler is called with the number of nodes the running
+           operation has built so far, each time it has built the number
+	   set by {\tt bdd\_setnodebudget}. If the handler returns zero
+	   the operation resumes with a new budget, otherwise it is
+	   aborted. The handler must not call any BDD operation. The
+	   default is no handler. *}
+RETURN  {* The previous handler *}
+ALSO    {* bdd\_setnodebudget *}
+*/
+bddbudgethandler bdd_budget_hook(bddbudgethandler handler)
+{
+   bddbudgethandler old;
+
+   CHECKMANAGER;
+   old = budget_handler;
+   budget_handler = handler;
+   return old;
+}
+
+
 /*************************************************************************
   Operators
 *************************************************************************/
@@ -326,6 +880,9 @@ static void checkresize(void)
    if (bddresized)
       bdd_operator_noderesize();
    bddresized = 0;
+#if ENABLE_ADAPTCACHE
+   bdd_operator_cacheadapt();
+#endif
 }
 
 
@@ -447,6 +1004,12 @@ BDD bdd_not(BDD r)
 }
 
 
+#if ENABLE_COMPLEMENT
+static BDD not_rec(BDD r)
+{
+   return COMPLEMENT(r);
+}
+#else
 static BDD not_rec(BDD r)
 {
    BddCacheData *entry;
@@ -457,14 +1020,13 @@ static BDD not_rec(BDD r)
    if (ISONE(r))
       return BDDZERO;
 
-   entry = BddCache_lookup(&opcache, NOTHASH(r));
-
-   if (entry->a == r  &&  entry->op == bddop_not)
+   entry = BddCache_find(&applycache, NOTHASH(r), r, -1, bddop_not);
+   if (entry != NULL)
    {
 #ifdef CACHESTATS
       bddcachestats.opHit++;
 #endif
-      return entry->r.res;
+      return entry->res;
    }
 #ifdef CACHESTATS
    bddcachestats.opMiss++;
@@ -475,18 +1037,12 @@ static BDD not_rec(BDD r)
    res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
    POPREF(2);
 
-#if ENABLE_TBDD
-      BddCache_clause_evict(entry);
-#endif
-
-   entry->a = r;
-   entry->b = -1;
-   entry->c = -1;
-   entry->op = bddop_not;
-   entry->r.res = res;
+   entry = BddCache_insert(&applycache, NOTHASH(r), r, -1, bddop_not);
+   entry->res = res;
 
    return res;
 }
+#endif /* ENABLE_COMPLEMENT */
 
 
 /*=== APPLY ============================================================*/
@@ -546,21 +1102,31 @@ BDD bdd_apply(BDD l, BDD r, int op)
    if (setjmp(bddexception) == 0)
    {
       INITREF;
-      applyop = op;
 
       if (!firstReorder)
 	 bdd_disable_reorder();
-      res = apply_rec(l, r);
+#if ENABLE_PARAPPLY
+      applyop = op;  /* Read by the apply threads */
+      if ((res = bdd_par_apply(l, r)) < 0)
+#endif
+#if ENABLE_ITERAPPLY
+      res = bdd_iter_run(ITER_APPLY, op, l, r);
+#else
+      res = apply_rec(l, r, op);
+#endif
       if (!firstReorder)
 	 bdd_enable_reorder();
    }
    else
+      res = -1;  /* Interrupted for reordering */
+
+   if (res < 0)
    {
       bdd_checkreorder();
 
       if (firstReorder-- == 1)
 	 goto again;
-      res = BDDZERO;  /* avoid warning about res being uninitialized */
+      res = BDDZERO;
    }
 
    checkresize();
@@ -568,13 +1134,16 @@ BDD bdd_apply(BDD l, BDD r, int op)
 }
 
 
-static BDD apply_rec(BDD l, BDD r)
+   /* Result of apply for the operands that need no recursion, or -1.
+      The operator is a constant in the specialized kernels below, so
+      the switch is resolved at compile time there. The cases for and,
+      or, xor and imp cover all constant operands. */
+static ALWAYS_INLINE BDD apply_terminal(BDD l, BDD r, int op)
 {
-   BddCacheData *entry;
    BDD res;
    bool done = false;
 
-   switch (applyop)
+   switch (op)
    {
     case bddop_and:
        if (l == r)
@@ -585,15 +1154,19 @@ static BDD apply_rec(BDD l, BDD r)
 	   { res = r; done = true; }
        else if (ISONE(r))
 	   { res = l; done = true; }
+#if ENABLE_COMPLEMENT
+       else if (l == COMPLEMENT(r))
+	   { res = 0; done = true; }
+#endif
        if (done) {
 #if ENABLE_BTRACE
 	   if (bdd_trace_file) {
-	       fprintf(bdd_trace_file, "a %d %d %d\n", res, l, r);
+	       fprintf(bdd_trace_file, "a %" PRIbdd " %" PRIbdd " %" PRIbdd "\n", res, l, r);
 	   }
 #endif
 	   return res;
        }
-       break;
+       return -1;
     case bddop_or:
        if (l == r)
 	  return l;
@@ -603,7 +1176,11 @@ static BDD apply_rec(BDD l, BDD r)
 	  return r;
        if (ISZERO(r))
 	  return l;
-       break;
+#if ENABLE_COMPLEMENT
+       if (l == COMPLEMENT(r))
+	  return 1;
+#endif
+       return -1;
     case bddop_xor:
        if (l == r)
 	  return 0;
@@ -611,7 +1188,11 @@ static BDD apply_rec(BDD l, BDD r)
 	  return r;
        if (ISZERO(r))
 	  return l;
-       break;
+#if ENABLE_COMPLEMENT
+       if (l == COMPLEMENT(r))
+	  return 1;
+#endif
+       return -1;
     case bddop_nand:
        if (ISZERO(l) || ISZERO(r))
 	  return 1;
@@ -627,80 +1208,123 @@ static BDD apply_rec(BDD l, BDD r)
 	 return r;
       if (ISONE(r))
 	 return 1;
-      break;
+      return -1;
    }
 
    if (ISCONST(l)  &&  ISCONST(r))
-      res = oprres[applyop][l<<1 | r];
-   else
+      return oprres[op][l<<1 | r];
+   return -1;
+}
+
+
+   /* One step of apply for the operator op. It is only called with
+      a constant op, from the specialized kernels for the common
+      operators and from apply_any_rec for the rest. */
+static ALWAYS_INLINE BDD apply_kernel(BDD l, BDD r, int op)
+{
+   BddCacheData *entry;
+   BDD res;
+
+   if ((res = apply_terminal(l, r, op)) >= 0)
+      return res;
+
+#if ENABLE_COMPLEMENT
+      /* Only cache xor of regular operands */
+   if (op == bddop_xor  &&  (ISCOMPL(l)  ||  ISCOMPL(r)))
    {
-      entry = BddCache_lookup(&opcache, APPLYHASH(l,r,applyop));
+      res = apply_rec(REGULAR(l), REGULAR(r), op);
+      return ISCOMPL(l) == ISCOMPL(r) ? res : COMPLEMENT(res);
+   }
+#endif
 
-      if (entry->a == l  &&  entry->b == r  &&  entry->op == applyop)
-      {
+   entry = BddCache_find(&applycache, APPLYHASH(l,r,op), l, r, op);
+   if (entry != NULL)
+   {
 #ifdef CACHESTATS
-	 bddcachestats.opHit++;
+      bddcachestats.opHit++;
 #endif
-	 return entry->r.res;
-      }
+      return entry->res;
+   }
 #ifdef CACHESTATS
-      bddcachestats.opMiss++;
+   bddcachestats.opMiss++;
 #endif
 
-      this_apply_counter++;
-      if (0 && this_apply_counter % THIS_APPLY_REPORT == 0) {
-	  fprintf(stdout, "Current apply operation has %d recursive calls\n", this_apply_counter);
-      }
-
-      if (LEVEL(l) == LEVEL(r))
-      {
-	 PUSHREF( apply_rec(LOW(l), LOW(r)) );
-	 PUSHREF( apply_rec(HIGH(l), HIGH(r)) );
-	 res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
-      }
-      else
-      if (LEVEL(l) < LEVEL(r))
-      {
-	 PUSHREF( apply_rec(LOW(l), r) );
-	 PUSHREF( apply_rec(HIGH(l), r) );
-	 res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
-      }
-      else
-      {
-	 PUSHREF( apply_rec(l, LOW(r)) );
-	 PUSHREF( apply_rec(l, HIGH(r)) );
-	 res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
-      }
+   this_apply_counter++;
+   if (0 && this_apply_counter % THIS_APPLY_REPORT == 0) {
+       fprintf(stdout, "Current apply operation has %d recursive calls\n", this_apply_counter);
+   }
 
-      POPREF(2);
+   if (LEVEL(l) == LEVEL(r))
+   {
+      PUSHREF( apply_rec(LOW(l), LOW(r), op) );
+      PUSHREF( apply_rec(HIGH(l), HIGH(r), op) );
+      res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
+   }
+   else
+   if (LEVEL(l) < LEVEL(r))
+   {
+      PUSHREF( apply_rec(LOW(l), r, op) );
+      PUSHREF( apply_rec(HIGH(l), r, op) );
+      res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
+   }
+   else
+   {
+      PUSHREF( apply_rec(l, LOW(r), op) );
+      PUSHREF( apply_rec(l, HIGH(r), op) );
+      res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
+   }
 
-#if ENABLE_TBDD
-      BddCache_clause_evict(entry);
-#endif
+   POPREF(2);
 
-      entry->a = l;
-      entry->b = r;
-      entry->c = -1;
-      entry->op = applyop;
-      entry->r.res = res;
-   }
+   entry = BddCache_insert(&applycache, APPLYHASH(l,r,op), l, r, op);
+   entry->res = res;
 
    return res;
 }
 
 
-/*
-NAME    {* bdd\_and *}
-SECTION {* operator *}
-SHORT   {* The logical 'and' of two BDDs *}
-PROTO   {* BDD bdd_and(BDD l, BDD r) *}
-DESCR   {* This a wrapper that calls {\tt bdd\_apply(l,r,bddop\_and)}. *}
-RETURN  {* The logical 'and' of {\tt l} and {\tt r}. *}
-ALSO    {* bdd\_apply, bdd\_or, bdd\_xor *}
-*/
-BDD bdd_and(BDD l, BDD r)
+static BDD apply_and_rec(BDD l, BDD r)
 {
-   return bdd_apply(l,r,bddop_and);
+   return apply_kernel(l, r, bddop_and);
+}
+
+
+static BDD apply_or_rec(BDD l, BDD r)
+{
+   return apply_kernel(l, r, bddop_or);
+}
+
+
+static BDD apply_xor_rec(BDD l, BDD r)
+{
+   return apply_kernel(l, r, bddop_xor);
+}
+
+
+static BDD apply_imp_rec(BDD l, BDD r)
+{
+   return apply_kernel(l, r, bddop_imp);
+}
+
+
+static BDD apply_any_rec(BDD l, BDD r, int op)
+{
+   return apply_kernel(l, r, op);
+}
+
+
+/*
+NAME    {* bdd\_and *}
+SECTION {* operator *}
+SHORT   {* The logical 'and' of two BDDs *}
+PROTO   {* BDD bdd_and(BDD l, BDD r) *}
+DESCR   {* This a wrapper that calls {\tt bdd\_apply(l,r,bddop\_and)}. *}
+RETURN  {* The logical 'and' of {\tt l} and {\tt r}. *}
+ALSO    {* bdd\_apply, bdd\_or, bdd\_xor *}
+*/
+BDD bdd_and(BDD l, BDD r)
+{
+   return bdd_apply(l,r,bddop_and);
 }
 
 
@@ -825,15 +1449,22 @@ static pcbdd bdd_applyj(BDD l, BDD r, int op)
    if (setjmp(bddexception) == 0)
    {
       INITREF;
-      applyop = op;
 
       if (!firstReorder)
 	 bdd_disable_reorder();
-      res = applyj_rec(l, r);
+#if ENABLE_ITERAPPLY
+      res.root = bdd_iter_run(ITER_APPLYJ, op, l, r);
+      res.clause_id = iterclause;
+#else
+      res = applyj_rec(l, r, op);
+#endif
       if (!firstReorder)
 	 bdd_enable_reorder();
    }
    else
+      res.root = -1;  /* Interrupted for reordering */
+
+   if (res.root < 0)
    {
       bdd_checkreorder();
 
@@ -873,8 +1504,6 @@ static pcbdd bdd_apply_aij(BDD l, BDD r, BDD t)
    if (setjmp(bddexception) == 0)
    {
       INITREF;
-      /* Some of the cases degenerate to implication checks */
-      applyop = bddop_imptstj;
 
       if (!firstReorder)
 	 bdd_disable_reorder();
@@ -899,19 +1528,21 @@ static pcbdd bdd_apply_aij(BDD l, BDD r, BDD t)
 }
 
 
-static pcbdd applyj_rec(BDD l, BDD r)
+   /* One step of the proof generating apply for op, which is a constant
+      in each of the specialized kernels */
+static ALWAYS_INLINE pcbdd applyj_kernel(BDD l, BDD r, int op)
 {
-   BddCacheData *entry;
+   BddCacheDataJ *entry;
    pcbdd tres;
 
-   //   printf("applyj_rec called with l=%d (N%d), r=%d (N%d), op = %d\n", (int) l, NNAME(l), (int) r, NNAME(r), applyop);
+   //   printf("applyj_rec called with l=%d (N%d), r=%d (N%d), op = %d\n", (int) l, NNAME(l), (int) r, NNAME(r), op);
 
    tres.root = BDDZERO;
    tres.clause_id = TAUTOLOGY;
    bool done = false;
 
 
-   switch (applyop)
+   switch (op)
    {
     case bddop_andj:
        if (l == r)
@@ -922,10 +1553,15 @@ static pcbdd applyj_rec(BDD l, BDD r)
 	   { tres.root = r; done = true; }
        else if (ISONE(r))
 	   { tres.root = l; done = true; }
+#if ENABLE_COMPLEMENT
+       /* Target clause [-N, N] is a tautology */
+       else if (l == COMPLEMENT(r))
+	   { tres.root = 0; done = true; }
+#endif
        if (done) {
 #if ENABLE_BTRACE
 	   if (bdd_trace_file) {
-	       fprintf(bdd_trace_file, "a %d %d %d\n", tres.root, l, r);
+	       fprintf(bdd_trace_file, "a %" PRIbdd " %" PRIbdd " %" PRIbdd "\n", tres.root, l, r);
 	   }
 #endif
 	   return tres;
@@ -942,7 +1578,7 @@ static pcbdd applyj_rec(BDD l, BDD r)
 	   /* Implication cannot hold for all arguments */
 	   {
 	       tres.root = BDDZERO;
-	       fprintf(ERROUT, "Implication failure.  N%d -/-> N%d\n", bdd_nameid(l), bdd_nameid(r));
+	       fprintf(ERROUT, "Implication failure.  N%" PRIcid " -/-> N%" PRIcid "\n", bdd_nameid(l), bdd_nameid(r));
 	       bdd_error(TBDD_PROOF);
 	       done = true;
 	   }
@@ -950,7 +1586,7 @@ static pcbdd applyj_rec(BDD l, BDD r)
 	   /* Implication cannot hold for all arguments */
 	   {
 	       tres.root = BDDZERO;
-	       fprintf(ERROUT, "Implication failure.  N%d -/-> N%d\n", bdd_nameid(l), bdd_nameid(r));
+	       fprintf(ERROUT, "Implication failure.  N%" PRIcid " -/-> N%" PRIcid "\n", bdd_nameid(l), bdd_nameid(r));
 	       bdd_error(TBDD_PROOF);
 	       done = true;
 	   }
@@ -958,7 +1594,7 @@ static pcbdd applyj_rec(BDD l, BDD r)
        if (done) {
 #if ENABLE_BTRACE
 	   if (bdd_trace_file) {
-	       fprintf(bdd_trace_file, "i %d %d\n,", r, l);
+	       fprintf(bdd_trace_file, "i %" PRIbdd " %" PRIbdd "\n,", r, l);
 	   }
 #endif
 	   return tres;
@@ -968,14 +1604,14 @@ static pcbdd applyj_rec(BDD l, BDD r)
 
 
    {
-      entry = BddCache_lookup(&opcache, APPLYHASH(l,r,applyop));
-      if (entry->a == l  &&  entry->b == r  &&  entry->op == applyop)
+      entry = BddCache_findj(&jcache, JHASH(l,r,JKEY(op)), l, r, JKEY(op));
+      if (entry != NULL)
       {
 #ifdef CACHESTATS
 	 bddcachestats.opHit++;
 #endif
-	 tres.root = entry->r.res;
-	 tres.clause_id = entry->r.jclause;
+	 tres.root = entry->res;
+	 tres.clause_id = entry->jclause;
 #if DO_TRACE
 	 if (tres.clause_id == TRACE_CLAUSE) {
 	     printf("TRACE: Retrieving clause #%d from cache in apply_rec.  Operands = N%d, N%d\n", TRACE_CLAUSE, NNAME(l), NNAME(r));
@@ -995,6 +1631,7 @@ static pcbdd applyj_rec(BDD l, BDD r)
       pcbdd tresl;
       int splitVar;
       int splitLevel;
+      clause_id_t clauses = total_clause_count;  /* Cost of the result */
 
       this_apply_counter++;
       if (0 && this_apply_counter % THIS_APPLY_REPORT == 0) {
@@ -1004,34 +1641,34 @@ static pcbdd applyj_rec(BDD l, BDD r)
       if (LEVEL(l) == LEVEL(r))
       {
 	  splitLevel = LEVEL(l);
-	  tresl = applyj_rec(LOW(l), LOW(r));
+	  tresl = applyj_rec(LOW(l), LOW(r), op);
 	  PUSHREF( tresl.root );
-	  tresh = applyj_rec(HIGH(l), HIGH(r));
+	  tresh = applyj_rec(HIGH(l), HIGH(r), op);
 	  PUSHREF( tresh.root );
       }
       else
       if (LEVEL(l) < LEVEL(r))
       {
 	  splitLevel = LEVEL(l);
-	  tresl = applyj_rec(LOW(l), r);
+	  tresl = applyj_rec(LOW(l), r, op);
 	  PUSHREF( tresl.root );
-	  tresh = applyj_rec(HIGH(l), r);
+	  tresh = applyj_rec(HIGH(l), r, op);
 	  PUSHREF( tresh.root );
       }
       else
       {
 	  splitLevel = LEVEL(r);
-	  tresl =  applyj_rec(l, LOW(r));
+	  tresl =  applyj_rec(l, LOW(r), op);
 	  PUSHREF( tresl.root );
-	  tresh = applyj_rec(l, HIGH(r));
+	  tresh = applyj_rec(l, HIGH(r), op);
 	  PUSHREF( tresh.root );
       }
       splitVar = bdd_level2var(splitLevel);
-      if (applyop == bddop_imptstj)
+      if (op == bddop_imptstj)
 	  tres.root = ISONE(tresl.root) && ISONE(tresh.root) ? BDDONE : BDDZERO;
       else
 	  tres.root = bdd_makenode(splitLevel, READREF(2), READREF(1));
-      tres.clause_id = justify_apply(applyop, l, r, splitVar, tresl, tresh, tres.root);
+      tres.clause_id = justify_apply(op, l, r, splitVar, tresl, tresh, tres.root);
 
 #if DO_TRACE
       if (tresh.clause_id == TRACE_CLAUSE) {
@@ -1045,13 +1682,10 @@ static pcbdd applyj_rec(BDD l, BDD r)
 
       POPREF(2);
 
-      BddCache_clause_evict(entry);
-      entry->a = l;
-      entry->b = r;
-      entry->c = -1;
-      entry->op = applyop;
-      entry->r.res = tres.root;
-      entry->r.jclause = tres.clause_id;
+      entry = BddCache_insertj(&jcache, JHASH(l,r,JKEY(op)), l, r, JKEY(op),
+			       (int)(total_clause_count - clauses));
+      entry->res = tres.root;
+      entry->jclause = tres.clause_id;
 #if DO_TRACE
       if (tres.clause_id == TRACE_CLAUSE) {
 	  printf("TRACE: Adding clause #%d to cache.  Operands = N%d, N%d\n", TRACE_CLAUSE, NNAME(l), NNAME(r));
@@ -1064,18 +1698,30 @@ static pcbdd applyj_rec(BDD l, BDD r)
 
 #if ENABLE_BTRACE
    if (bdd_trace_file) {
-       if (applyop == bddop_andj)
-	   fprintf(bdd_trace_file, "a %d %d %d\n", tres.root, l, r);
-       else if (applyop == bddop_imptstj)
-	   fprintf(bdd_trace_file, "i %d %d\n", r, l);
+       if (op == bddop_andj)
+	   fprintf(bdd_trace_file, "a %" PRIbdd " %" PRIbdd " %" PRIbdd "\n", tres.root, l, r);
+       else if (op == bddop_imptstj)
+	   fprintf(bdd_trace_file, "i %" PRIbdd " %" PRIbdd "\n", r, l);
    }
 #endif
    return tres;
 }
 
+static pcbdd applyj_and_rec(BDD l, BDD r)
+{
+   return applyj_kernel(l, r, bddop_andj);
+}
+
+
+static pcbdd applyj_imptst_rec(BDD l, BDD r)
+{
+   return applyj_kernel(l, r, bddop_imptstj);
+}
+
+
 static pcbdd apply_aij_rec(BDD l, BDD r, BDD t)
 {
-   BddCacheData *entry;
+   BddCacheDataJ *entry;
    pcbdd tres;
 
    //   printf("apply_aij_rec called with l=%d (N%d), r=%d (N%d), t = %d (N%d)\n", (int) l, NNAME(l), (int) r, NNAME(r), int(t), NNAME(t));
@@ -1088,24 +1734,24 @@ static pcbdd apply_aij_rec(BDD l, BDD r, BDD t)
        return tres;
    if (ISONE(l))
        /* Implication */
-       return applyj_rec(r, t);
+       return applyj_imptst_rec(r, t);
    if (ISONE(r))
        /* Implication */
-       return applyj_rec(l, t);
+       return applyj_imptst_rec(l, t);
    if (l == r)
        /* Implication */
-       return applyj_rec(l, t);
+       return applyj_imptst_rec(l, t);
    if (ISONE(t))
        return tres;
    {
-      entry = BddCache_lookup(&opcache, APPLYHASH(l,r,t));
-      if (entry->a == l  &&  entry->b == r  &&  entry->c == t && entry->op == bddop_andimptstj)
+      entry = BddCache_findj(&jcache, JHASH(l,r,t), l, r, t);
+      if (entry != NULL)
       {
 #ifdef CACHESTATS
 	 bddcachestats.opHit++;
 #endif
-	 tres.root = entry->r.res;
-	 tres.clause_id = entry->r.jclause;
+	 tres.root = entry->res;
+	 tres.clause_id = entry->jclause;
 #if DO_TRACE
 	 if (tres.clause_id == TRACE_CLAUSE) {
 	     printf("TRACE: Retrieving clause #%d from cache in apply_aij_rec.  Operands = N%d, N%d, N%d\n", TRACE_CLAUSE, NNAME(l), NNAME(r), NNAME(t));
@@ -1125,6 +1771,7 @@ static pcbdd apply_aij_rec(BDD l, BDD r, BDD t)
       pcbdd tresl;
       int splitVar;
       int splitLevel;
+      clause_id_t clauses = total_clause_count;  /* Cost of the result */
 
       this_apply_counter++;
       if (0 && this_apply_counter % THIS_APPLY_REPORT == 0) {
@@ -1213,13 +1860,10 @@ static pcbdd apply_aij_rec(BDD l, BDD r, BDD t)
 
       POPREF(2);
 
-      BddCache_clause_evict(entry);
-      entry->a = l;
-      entry->b = r;
-      entry->c = t;
-      entry->op = bddop_andimptstj;
-      entry->r.res = tres.root;
-      entry->r.jclause = tres.clause_id;
+      entry = BddCache_insertj(&jcache, JHASH(l,r,t), l, r, t,
+			       (int)(total_clause_count - clauses));
+      entry->res = tres.root;
+      entry->jclause = tres.clause_id;
 #if DO_TRACE
       if (tres.clause_id == TRACE_CLAUSE) {
 	  printf("TRACE: Adding clause #%d to cache.  Operands = N%d, N%d, N%d\n", TRACE_CLAUSE, NNAME(l), NNAME(r), NNAME(t));
@@ -1277,228 +1921,133 @@ pcbdd bdd_and_imptst_justify(BDD l, BDD r, BDD t)
 {
    return bdd_apply_aij(l,r,t);
 }
-#endif /* ENABLE_TBDD */
-
-
 
-/*=== ITE ==============================================================*/
 
-/*
-NAME    {* bdd\_ite *}
-SECTION {* operator *}
-SHORT   {* if-then-else operator *}
-PROTO   {* BDD bdd_ite(BDD f, BDD g, BDD h) *}
-DESCR   {* Calculates the BDD for the expression
-           $(f \conj g) \disj (\neg f \conj h)$ more efficiently than doing
-	   the three operations separately. {\tt bdd\_ite} can also be used
-	   for conjunction, disjunction and any other boolean operator, but
-	   is not as efficient for the binary and unary operations. *}
-RETURN  {* The BDD for $(f \conj g) \disj (\neg f \conj h)$ *}
-ALSO    {* bdd\_apply *}
-*/
-BDD bdd_ite(BDD f, BDD g, BDD h)
+   /* Conjunction of l and r with the variables in andexvar quantified,
+      plus a proof of the clause [-l -r res] */
+static pcbdd andexj_rec(BDD l, BDD r)
 {
-   BDD res;
-   firstReorder = 1;
-   this_apply_counter = 0;
-
-   CHECKa(f, bddfalse);
-   CHECKa(g, bddfalse);
-   CHECKa(h, bddfalse);
-
- again:
-   if (setjmp(bddexception) == 0)
-   {
-      INITREF;
-
-      if (!firstReorder)
-	 bdd_disable_reorder();
-      res = ite_rec(f,g,h);
-      if (!firstReorder)
-	 bdd_enable_reorder();
-   }
-   else
-   {
-      bdd_checkreorder();
-
-      if (firstReorder-- == 1)
-	 goto again;
-      res = BDDZERO;  /* avoid warning about res being uninitialized */
-   }
-
-   checkresize();
-   return res;
-}
+   BddCacheDataJ *entry;
+   pcbdd tres, tresl, tresh, impl, imph;
+   int splitLevel, splitVar;
+   clause_id_t clauses;
 
+   tres.root = BDDZERO;
+   tres.clause_id = TAUTOLOGY;
 
-static BDD ite_rec(BDD f, BDD g, BDD h)
-{
-   BddCacheData *entry;
-   BDD res;
-
-   if (ISONE(f))
-      return g;
-   if (ISZERO(f))
-      return h;
-   if (g == h)
-      return g;
-   if (ISONE(g) && ISZERO(h))
-      return f;
-   if (ISZERO(g) && ISONE(h))
-      return not_rec(f);
+   if (ISZERO(l)  ||  ISZERO(r))
+      return tres;
+#if ENABLE_COMPLEMENT
+   /* Target clause [-N, N] is a tautology */
+   if (l == COMPLEMENT(r))
+      return tres;
+#endif
+   if (LEVEL(l) > quantlast  &&  LEVEL(r) > quantlast)
+      return applyj_and_rec(l, r);
 
-   entry = BddCache_lookup(&opcache, ITEHASH(f,g,h));
-   if (entry->a == f  &&  entry->b == g  &&  entry->c == h && entry->op == bddop_ite)
+   entry = BddCache_findj(&jcache, JHASH(l,r,JKEY_ANDEX(andexvar)), l, r,
+			  JKEY_ANDEX(andexvar));
+   if (entry != NULL)
    {
 #ifdef CACHESTATS
       bddcachestats.opHit++;
 #endif
-      return entry->r.res;
+      tres.root = entry->res;
+      tres.clause_id = entry->jclause;
+      return tres;
    }
 #ifdef CACHESTATS
    bddcachestats.opMiss++;
 #endif
-
    this_apply_counter++;
-   if (0 && this_apply_counter % THIS_APPLY_REPORT == 0) {
-       fprintf(stdout, "Current apply operation has %d recursive calls\n", this_apply_counter);
-   }
+   clauses = total_clause_count;
 
-   if (LEVEL(f) == LEVEL(g))
+   splitLevel = MIN(LEVEL(l), LEVEL(r));
+   splitVar = bdd_level2var(splitLevel);
+   tresl = andexj_rec(LEVEL(l) == splitLevel ? LOW(l) : l,
+		      LEVEL(r) == splitLevel ? LOW(r) : r);
+   PUSHREF( tresl.root );
+
+   if (INVARSET(splitLevel)  &&  ISONE(tresl.root))
    {
-      if (LEVEL(f) == LEVEL(h))
-      {
-	 PUSHREF( ite_rec(LOW(f), LOW(g), LOW(h)) );
-	 PUSHREF( ite_rec(HIGH(f), HIGH(g), HIGH(h)) );
-	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
-      }
-      else
-      if (LEVEL(f) < LEVEL(h))
-      {
-	 PUSHREF( ite_rec(LOW(f), LOW(g), h) );
-	 PUSHREF( ite_rec(HIGH(f), HIGH(g), h) );
-	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
-      }
-      else /* f > h */
-      {
-	 PUSHREF( ite_rec(f, g, LOW(h)) );
-	 PUSHREF( ite_rec(f, g, HIGH(h)) );
-	 res = bdd_makenode(LEVEL(h), READREF(2), READREF(1));
-      }
+	 /* The high half cannot change the result, and [-l -r 1] holds */
+      tres.root = BDDONE;
    }
    else
-   if (LEVEL(f) < LEVEL(g))
-   {
-      if (LEVEL(f) == LEVEL(h))
-      {
-	 PUSHREF( ite_rec(LOW(f), g, LOW(h)) );
-	 PUSHREF( ite_rec(HIGH(f), g, HIGH(h)) );
-	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
-      }
-      else
-      if (LEVEL(f) < LEVEL(h))
-      {
-	 PUSHREF( ite_rec(LOW(f), g, h) );
-	 PUSHREF( ite_rec(HIGH(f), g, h) );
-	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
-      }
-      else /* f > h */
-      {
-	 PUSHREF( ite_rec(f, g, LOW(h)) );
-	 PUSHREF( ite_rec(f, g, HIGH(h)) );
-	 res = bdd_makenode(LEVEL(h), READREF(2), READREF(1));
-      }
-   }
-   else /* f > g */
    {
-      if (LEVEL(g) == LEVEL(h))
+      tresh = andexj_rec(LEVEL(l) == splitLevel ? HIGH(l) : l,
+			 LEVEL(r) == splitLevel ? HIGH(r) : r);
+      PUSHREF( tresh.root );
+
+      if (INVARSET(splitLevel))
       {
-	 PUSHREF( ite_rec(f, LOW(g), LOW(h)) );
-	 PUSHREF( ite_rec(f, HIGH(g), HIGH(h)) );
-	 res = bdd_makenode(LEVEL(g), READREF(2), READREF(1));
+	 tres.root = apply_or_rec(READREF(2), READREF(1));
+	 PUSHREF( tres.root );
+	 impl = applyj_imptst_rec(tresl.root, tres.root);
+	 imph = applyj_imptst_rec(tresh.root, tres.root);
+	 tres.clause_id = justify_and_exist(l, r, splitVar, tresl, tresh,
+					    impl.clause_id, imph.clause_id,
+					    tres.root);
+	 POPREF(1);
       }
       else
-      if (LEVEL(g) < LEVEL(h))
       {
-	 PUSHREF( ite_rec(f, LOW(g), h) );
-	 PUSHREF( ite_rec(f, HIGH(g), h) );
-	 res = bdd_makenode(LEVEL(g), READREF(2), READREF(1));
-      }
-      else /* g > h */
-      {
-	 PUSHREF( ite_rec(f, g, LOW(h)) );
-	 PUSHREF( ite_rec(f, g, HIGH(h)) );
-	 res = bdd_makenode(LEVEL(h), READREF(2), READREF(1));
+	 tres.root = bdd_makenode(splitLevel, READREF(2), READREF(1));
+	 tres.clause_id = justify_apply(bddop_andj, l, r, splitVar,
+					tresl, tresh, tres.root);
       }
+      POPREF(1);
    }
+   POPREF(1);
 
-   POPREF(2);
-
-#if ENABLE_TBDD
-   BddCache_clause_evict(entry);
-#endif
-
-   entry->a = f;
-   entry->b = g;
-   entry->c = h;
-   entry->op = bddop_ite;
-   entry->r.res = res;
-
-   return res;
+   entry = BddCache_insertj(&jcache, JHASH(l,r,JKEY_ANDEX(andexvar)), l, r,
+			    JKEY_ANDEX(andexvar), (int)(total_clause_count - clauses));
+   entry->res = tres.root;
+   entry->jclause = tres.clause_id;
+   return tres;
 }
 
 
-/*=== RESTRICT =========================================================*/
-
 /*
-NAME    {* bdd\_restrict *}
+NAME    {* bdd\_and\_exist\_justify *}
 SECTION {* operator *}
-SHORT   {* restric a set of variables to constant values *}
-PROTO   {* BDD bdd_restrict(BDD r, BDD var) *}
-DESCR   {* This function restricts the variables in {\tt r} to constant
-           true or false. How this is done
-	   depends on how the variables are included in the variable set
-	   {\tt var}. If they
-	   are included in their positive form then they are restricted to
-	   true and vice versa. Unfortunately it is not possible to
-	   insert variables in their negated form using {\tt bdd\_makeset},
-	   so the variable set has to be build manually as a
-	   conjunction of the variables. Example: Assume variable 1 should be
-	   restricted to true and variable 3 to false.
-	   \begin{verbatim}
-  bdd X = make_user_bdd();
-  bdd R1 = BDD_ithvar(1);
-  bdd R2 = BDD_nithvar(3);
-  bdd R = bdd_addref( bdd_apply(R1,R2, bddop_and) );
-  bdd RES = bdd_addref( bdd_restrict(X,R) );
-\end{verbatim}
-	   *}
-RETURN  {* The restricted bdd. *}
-ALSO    {* bdd\_makeset, bdd\_exist, bdd\_forall *}
+SHORT   {* relational product of two BDDs, with proof generation *}
+PROTO   {* pcbdd bdd_and_exist_justify(BDD l, BDD r, BDD var) *}
+DESCR   {* Calculates the conjunction of {\tt l} and {\tt r} with the
+           variables in the variable set {\tt var} existentially
+	   quantified, like {\tt bdd\_relprod}. At the same time it
+	   proves that the conjunction implies the result, so that no
+	   separate implication test is needed. Steps at quantified
+	   variables are justified through the implications from the
+	   two cofactor results into their disjunction. *}
+RETURN  {* The relational product of {\tt l} and {\tt r} plus a proof. *}
+ALSO    {* bdd\_appex, bdd\_and\_justify, tbdd\_and\_exist *}
 */
-BDD bdd_restrict(BDD r, BDD var)
+pcbdd bdd_and_exist_justify(BDD l, BDD r, BDD var)
 {
-   BDD res;
+   pcbdd res;
    firstReorder = 1;
+   this_apply_counter = 0;
 
-   CHECKa(r,bddfalse);
-   CHECKa(var,bddfalse);
+   CHECKa(l, pcbdd_null());
+   CHECKa(r, pcbdd_null());
+   CHECKa(var, pcbdd_null());
 
    if (var < 2)  /* Empty set */
-      return r;
+      return bdd_applyj(l, r, bddop_andj);
 
  again:
    if (setjmp(bddexception) == 0)
    {
-      if (varset2svartable(var) < 0)
-	 return bddfalse;
+      if (varset2vartable(var) < 0)
+	 return pcbdd_null();
 
       INITREF;
-      miscid = (var << 3) | CACHEID_RESTRICT;
+      andexvar = var;
 
       if (!firstReorder)
 	 bdd_disable_reorder();
-      res = restrict_rec(r);
+      res = andexj_rec(l, r);
       if (!firstReorder)
 	 bdd_enable_reorder();
    }
@@ -1508,93 +2057,228 @@ BDD bdd_restrict(BDD r, BDD var)
 
       if (firstReorder-- == 1)
 	 goto again;
-      res = BDDZERO;  /* avoid warning about res being uninitialized */
+      res = pcbdd_tautology();
    }
 
    checkresize();
    return res;
 }
+#endif /* ENABLE_TBDD */
 
 
-static int restrict_rec(int r)
+
+/*=== N-ARY CONJUNCTION ================================================*/
+
+   /* Hash value of the sorted operands of an n-ary conjunction */
+static unsigned int andmulti_hash(BDD *ops, int n, int op)
 {
-   BddCacheData *entry;
-   int res;
+   unsigned int h = op;
+   int i;
 
-   if (ISCONST(r)  ||  LEVEL(r) > quantlast)
-      return r;
+   for (i=0 ; i<n ; i++)
+      h = PAIR(h, ops[i]);
+   return h;
+}
+
+
+   /* Remove the operands that are true or duplicates and sort the rest.
+      Returns the number of operands left, or -1 if the conjunction is
+      false. */
+static int andmulti_normalize(BDD *ops, int n)
+{
+   int i, j, num = 0;
 
-   entry = BddCache_lookup(&opcache, RESTRHASH(r,miscid));
-   if (entry->a == r  &&  entry->c == miscid && entry->op == bddop_misc)
+   for (i=0 ; i<n ; i++)
    {
-#ifdef CACHESTATS
-      bddcachestats.opHit++;
+      BDD t = ops[i];
+
+      if (ISZERO(t))
+	 return -1;
+      if (ISONE(t))
+	 continue;
+
+      for (j=num ; j>0  &&  ops[j-1] > t ; j--)
+	 ;
+      if (j > 0  &&  ops[j-1] == t)
+	 continue;
+#if ENABLE_COMPLEMENT
+	 /* The negation would be next to it */
+      if ((j > 0  &&  ops[j-1] == COMPLEMENT(t))  ||
+	  (j < num  &&  ops[j] == COMPLEMENT(t)))
+	 return -1;
 #endif
-      return entry->r.res;
+      memmove(ops+j+1, ops+j, (num-j)*sizeof(BDD));
+      ops[j] = t;
+      num++;
    }
-#ifdef CACHESTATS
-   bddcachestats.opMiss++;
-#endif
 
-   if (INSVARSET(LEVEL(r)))
-   {
-      if (quantvarset[LEVEL(r)] > 0)
-	 res = restrict_rec(HIGH(r));
-      else
-	 res = restrict_rec(LOW(r));
-   }
-   else
-   {
-      PUSHREF( restrict_rec(LOW(r)) );
-      PUSHREF( restrict_rec(HIGH(r)) );
-      res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
-      POPREF(2);
-   }
+   return num;
+}
 
-#if ENABLE_TBDD
-      BddCache_clause_evict(entry);
+
+   /* The level to split the operands at */
+static int andmulti_level(BDD *ops, int n)
+{
+   int i, level = LEVEL(ops[0]);
+
+   for (i=1 ; i<n ; i++)
+      level = MIN(level, LEVEL(ops[i]));
+   return level;
+}
+
+
+   /* The operands of the sub call for the low (high = 0) or high
+      (high = 1) cofactors */
+static void andmulti_cofactor(BDD *ops, int n, int level, int high, BDD *sub)
+{
+   int i;
+
+   for (i=0 ; i<n ; i++)
+      sub[i] = LEVEL(ops[i]) != level ? ops[i] : high ? HIGH(ops[i])
+	 : LOW(ops[i]);
+}
+
+
+   /* The operands are reordered; there are at most BDD_MULTIMAX */
+static BDD andmulti_rec(BDD *ops, int n)
+{
+   BddCacheDataM *entry;
+   BDD sub[BDD_MULTIMAX];
+   unsigned int hash;
+   int level;
+   BDD res;
+
+   if ((n = andmulti_normalize(ops, n)) < 0)
+      return BDDZERO;
+   if (n == 0)
+      return BDDONE;
+   if (n == 1)
+      return ops[0];
+   if (n == 2)
+      return apply_and_rec(ops[0], ops[1]);
+
+   hash = andmulti_hash(ops, n, bddop_and);
+   entry = BddCache_findm(&multicache, hash, ops, n, bddop_and);
+   if (entry != NULL)
+   {
+#ifdef CACHESTATS
+      bddcachestats.opHit++;
+#endif
+      return entry->res;
+   }
+#ifdef CACHESTATS
+   bddcachestats.opMiss++;
 #endif
+   this_apply_counter++;
 
-   entry->a = r;
-   entry->b = -1;
-   entry->c = miscid;
-   entry->op = bddop_misc;
-   entry->r.res = res;
+   level = andmulti_level(ops, n);
+   andmulti_cofactor(ops, n, level, 0, sub);
+   PUSHREF( andmulti_rec(sub, n) );
+   andmulti_cofactor(ops, n, level, 1, sub);
+   PUSHREF( andmulti_rec(sub, n) );
+   res = bdd_makenode(level, READREF(2), READREF(1));
+   POPREF(2);
 
+   entry = BddCache_insertm(&multicache, hash, ops, n, bddop_and);
+   entry->res = res;
    return res;
 }
 
 
-/*=== GENERALIZED COFACTOR =============================================*/
+#if ENABLE_TBDD
+   /* The same with a proof of the clause [-ops[0] ... -ops[n-1] res] */
+static pcbdd andmultij_rec(BDD *ops, int n)
+{
+   BddCacheDataM *entry;
+   BDD sub[BDD_MULTIMAX];
+   pcbdd tres, tresl, tresh;
+   unsigned int hash;
+   int level;
 
-/*
-NAME    {* bdd\_constrain *}
-SECTION {* operator *}
-SHORT   {* generalized cofactor *}
-PROTO   {* BDD bdd_constrain(BDD f, BDD c) *}
-DESCR   {* Computes the generalized cofactor of {\tt f} with respect to
-           {\tt c}. *}
-RETURN  {* The constrained BDD *}
-ALSO    {* bdd\_restrict, bdd\_simplify *}
-*/
-BDD bdd_constrain(BDD f, BDD c)
+   tres.clause_id = TAUTOLOGY;
+   if ((n = andmulti_normalize(ops, n)) <= 1)
+   {
+      tres.root = n < 0 ? BDDZERO : n == 0 ? BDDONE : ops[0];
+      return tres;
+   }
+   if (n == 2)
+      return applyj_and_rec(ops[0], ops[1]);
+
+   hash = andmulti_hash(ops, n, bddop_andj);
+   entry = BddCache_findm(&multicache, hash, ops, n, bddop_andj);
+   if (entry != NULL)
+   {
+#ifdef CACHESTATS
+      bddcachestats.opHit++;
+#endif
+      tres.root = entry->res;
+      tres.clause_id = entry->jclause;
+      return tres;
+   }
+#ifdef CACHESTATS
+   bddcachestats.opMiss++;
+#endif
+   this_apply_counter++;
+
+   level = andmulti_level(ops, n);
+   andmulti_cofactor(ops, n, level, 0, sub);
+   tresl = andmultij_rec(sub, n);
+   PUSHREF( tresl.root );
+   andmulti_cofactor(ops, n, level, 1, sub);
+   tresh = andmultij_rec(sub, n);
+   PUSHREF( tresh.root );
+   tres.root = bdd_makenode(level, READREF(2), READREF(1));
+   tres.clause_id = justify_and_multi(ops, n, bdd_level2var(level),
+				      tresl, tresh, tres.root);
+   POPREF(2);
+
+   entry = BddCache_insertm(&multicache, hash, ops, n, bddop_andj);
+   entry->res = tres.root;
+   entry->jclause = tres.clause_id;
+   return tres;
+}
+#endif /* ENABLE_TBDD */
+
+
+   /* Set up the cache and copy the operands, which are reordered */
+static int bdd_andmulti_start(BDD *ops, int n, BDD *args)
+{
+   int i;
+
+   if (n < 0  ||  n > BDD_MULTIMAX)
+      return bdd_error(BDD_RANGE);
+   for (i=0 ; i<n ; i++)
+   {
+      CHECK(ops[i]);
+      args[i] = ops[i];
+   }
+
+   if (multicache.table == NULL  &&
+       BddCache_init(&multicache, multicachesize, sizeof(BddCacheDataM)) < 0)
+      return bdd_error(BDD_MEMORY);
+   return 0;
+}
+
+
+   /* Conjunction of at most BDD_MULTIMAX operands in one pass */
+static BDD bdd_andmulti(BDD *ops, int n)
 {
+   BDD args[BDD_MULTIMAX];
    BDD res;
    firstReorder = 1;
    this_apply_counter = 0;
 
-   CHECKa(f,bddfalse);
-   CHECKa(c,bddfalse);
+   if (bdd_andmulti_start(ops, n, args) < 0)
+      return bddfalse;
 
  again:
    if (setjmp(bddexception) == 0)
    {
       INITREF;
-      miscid = CACHEID_CONSTRAIN;
 
       if (!firstReorder)
 	 bdd_disable_reorder();
-      res = constrain_rec(f, c);
+      res = andmulti_rec(args, n);
       if (!firstReorder)
 	 bdd_enable_reorder();
    }
@@ -1603,7 +2287,10 @@ BDD bdd_constrain(BDD f, BDD c)
       bdd_checkreorder();
 
       if (firstReorder-- == 1)
+      {
+	 memcpy(args, ops, n*sizeof(BDD));
 	 goto again;
+      }
       res = BDDZERO;  /* avoid warning about res being uninitialized */
    }
 
@@ -1612,124 +2299,133 @@ BDD bdd_constrain(BDD f, BDD c)
 }
 
 
-static BDD constrain_rec(BDD f, BDD c)
+/*
+NAME    {* bdd\_and\_multi *}
+SECTION {* operator *}
+SHORT   {* conjunction of several BDDs *}
+PROTO   {* BDD bdd_and_multi(BDD *ops, int n) *}
+DESCR   {* Calculates the conjunction of the {\tt n} BDDs in {\tt ops}.
+           Up to {\tt BDD\_MULTIMAX} (8) operands are done in a single
+	   recursive pass, which builds no intermediate results. More
+	   operands are done in groups of that size, whose conjunctions are
+	   then combined in the same way. The operands must be referenced
+	   by the caller. *}
+RETURN  {* The conjunction of the operands, or {\tt bddtrue} if
+           {\tt n} is zero. *}
+ALSO    {* bdd\_and, tbdd\_and\_multi *}
+*/
+BDD bdd_and_multi(BDD *ops, int n)
 {
-   BddCacheData *entry;
-   BDD res;
+   BDD *part, res;
+   int i, num;
 
-   if (ISONE(c))
-      return f;
-   if (ISCONST(f))
-      return f;
-   if (c == f)
-      return BDDONE;
-   if (ISZERO(c))
-      return BDDZERO;
+   if (n <= BDD_MULTIMAX)
+      return bdd_andmulti(ops, n);
 
-   entry = BddCache_lookup(&opcache, CONSTRAINHASH(f,c));
-   if (entry->a == f  &&  entry->b == c  &&  entry->c == miscid && entry->op == bddop_misc)
+   num = (n + BDD_MULTIMAX - 1) / BDD_MULTIMAX;
+   if ((part=NEW(BDD,num)) == NULL)
    {
-#ifdef CACHESTATS
-      bddcachestats.opHit++;
-#endif
-      return entry->r.res;
+      bdd_error(BDD_MEMORY);
+      return bddfalse;
    }
-#ifdef CACHESTATS
-   bddcachestats.opMiss++;
-#endif
 
-   this_apply_counter++;
-   if (0 && this_apply_counter % THIS_APPLY_REPORT == 0) {
-       fprintf(stdout, "Current apply operation has %d recursive calls\n", this_apply_counter);
-   }
+   for (i=0 ; i<num ; i++)
+      part[i] = bdd_addref(bdd_andmulti(ops + i*BDD_MULTIMAX,
+				       MIN(BDD_MULTIMAX, n - i*BDD_MULTIMAX)));
+   res = bdd_and_multi(part, num);
 
+   for (i=0 ; i<num ; i++)
+      bdd_delref(part[i]);
+   free(part);
+   return res;
+}
 
-   if (LEVEL(f) == LEVEL(c))
-   {
-      if (ISZERO(LOW(c)))
-	 res = constrain_rec(HIGH(f), HIGH(c));
-      else if (ISZERO(HIGH(c)))
-	 res = constrain_rec(LOW(f), LOW(c));
-      else
-      {
-	 PUSHREF( constrain_rec(LOW(f), LOW(c)) );
-	 PUSHREF( constrain_rec(HIGH(f), HIGH(c)) );
-	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
-	 POPREF(2);
-      }
-   }
-   else
-   if (LEVEL(f) < LEVEL(c))
+
+#if ENABLE_TBDD
+/*
+NAME    {* bdd\_and\_multi\_justify *}
+SECTION {* operator *}
+SHORT   {* conjunction of several BDDs, with proof generation *}
+PROTO   {* pcbdd bdd_and_multi_justify(BDD *ops, int n) *}
+DESCR   {* Calculates the conjunction {\tt r} of at most
+           {\tt BDD\_MULTIMAX} BDDs in a single pass, and proves the
+	   clause $\neg ops_0 \disj \ldots \disj \neg ops_{n-1} \disj r$
+	   over their extension variables. *}
+RETURN  {* The conjunction of the operands plus a proof. *}
+ALSO    {* bdd\_and\_justify, tbdd\_and\_multi *}
+*/
+pcbdd bdd_and_multi_justify(BDD *ops, int n)
+{
+   BDD args[BDD_MULTIMAX];
+   pcbdd res;
+   firstReorder = 1;
+   this_apply_counter = 0;
+
+   if (bdd_andmulti_start(ops, n, args) < 0)
+      return pcbdd_null();
+
+ again:
+   if (setjmp(bddexception) == 0)
    {
-      PUSHREF( constrain_rec(LOW(f), c) );
-      PUSHREF( constrain_rec(HIGH(f), c) );
-      res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
-      POPREF(2);
+      INITREF;
+
+      if (!firstReorder)
+	 bdd_disable_reorder();
+      res = andmultij_rec(args, n);
+      if (!firstReorder)
+	 bdd_enable_reorder();
    }
    else
    {
-      if (ISZERO(LOW(c)))
-	 res = constrain_rec(f, HIGH(c));
-      else if (ISZERO(HIGH(c)))
-	 res = constrain_rec(f, LOW(c));
-      else
+      bdd_checkreorder();
+
+      if (firstReorder-- == 1)
       {
-	 PUSHREF( constrain_rec(f, LOW(c)) );
-	 PUSHREF( constrain_rec(f, HIGH(c)) );
-	 res = bdd_makenode(LEVEL(c), READREF(2), READREF(1));
-	 POPREF(2);
+	 memcpy(args, ops, n*sizeof(BDD));
+	 goto again;
       }
+      res = pcbdd_tautology();
    }
 
-#if ENABLE_TBDD
-      BddCache_clause_evict(entry);
-#endif
-
-
-   entry->a = f;
-   entry->b = c;
-   entry->c = miscid;
-   entry->op = bddop_misc;
-   entry->r.res = res;
-
+   checkresize();
    return res;
 }
+#endif /* ENABLE_TBDD */
 
 
-/*=== REPLACE ==========================================================*/
+/*=== ITE ==============================================================*/
 
 /*
-NAME    {* bdd\_replace *}
+NAME    {* bdd\_ite *}
 SECTION {* operator *}
-SHORT   {* replaces variables with other variables *}
-PROTO   {* BDD bdd_replace(BDD r, bddPair *pair) *}
-DESCR   {* Replaces all variables in the BDD {\tt r} with the variables
-           defined by {\tt pair}. Each entry in {\tt pair} consists of a
-	   old and a new variable. Whenever the old variable is found in
-	   {\tt r} then a new node with the new variable is inserted instead.
-	*}
-ALSO   {* bdd\_newpair, bdd\_setpair, bdd\_setpairs *}
-RETURN {* The result of the operation. *}
+SHORT   {* if-then-else operator *}
+PROTO   {* BDD bdd_ite(BDD f, BDD g, BDD h) *}
+DESCR   {* Calculates the BDD for the expression
+           $(f \conj g) \disj (\neg f \conj h)$ more efficiently than doing
+	   the three operations separately. {\tt bdd\_ite} can also be used
+	   for conjunction, disjunction and any other boolean operator, but
+	   is not as efficient for the binary and unary operations. *}
+RETURN  {* The BDD for $(f \conj g) \disj (\neg f \conj h)$ *}
+ALSO    {* bdd\_apply *}
 */
-BDD bdd_replace(BDD r, bddPair *pair)
+BDD bdd_ite(BDD f, BDD g, BDD h)
 {
    BDD res;
    firstReorder = 1;
    this_apply_counter = 0;
 
-   CHECKa(r, bddfalse);
+   CHECKa(f, bddfalse);
+   CHECKa(g, bddfalse);
+   CHECKa(h, bddfalse);
 
  again:
    if (setjmp(bddexception) == 0)
    {
       INITREF;
-      replacepair = pair->result;
-      replacelast = pair->last;
-      replaceid = (pair->id << 2) | CACHEID_REPLACE;
 
       if (!firstReorder)
 	 bdd_disable_reorder();
-      res = replace_rec(r);
+      res = ite_rec(f,g,h);
       if (!firstReorder)
 	 bdd_enable_reorder();
    }
@@ -1747,21 +2443,37 @@ BDD bdd_replace(BDD r, bddPair *pair)
 }
 
 
-static BDD replace_rec(BDD r)
+static BDD ite_rec(BDD f, BDD g, BDD h)
 {
    BddCacheData *entry;
    BDD res;
 
-   if (ISCONST(r)  ||  LEVEL(r) > replacelast)
-      return r;
+   if (ISONE(f))
+      return g;
+   if (ISZERO(f))
+      return h;
+   if (g == h)
+      return g;
+   if (ISONE(g) && ISZERO(h))
+      return f;
+   if (ISZERO(g) && ISONE(h))
+      return not_rec(f);
 
-   entry = BddCache_lookup(&opcache, REPLACEHASH(r));
-   if (entry->a == r  &&  entry->c == replaceid && entry->op == bddop_replace)
+#if ENABLE_COMPLEMENT
+      /* Normalize so that both f and g are regular */
+   if (ISCOMPL(f))
+      return ite_rec(COMPLEMENT(f), h, g);
+   if (ISCOMPL(g))
+      return COMPLEMENT(ite_rec(f, COMPLEMENT(g), COMPLEMENT(h)));
+#endif
+
+   entry = BddCache_find(&itecache, ITEHASH(f,g,h), f, g, h);
+   if (entry != NULL)
    {
 #ifdef CACHESTATS
       bddcachestats.opHit++;
 #endif
-      return entry->r.res;
+      return entry->res;
    }
 #ifdef CACHESTATS
    bddcachestats.opMiss++;
@@ -1772,106 +2484,134 @@ static BDD replace_rec(BDD r)
        fprintf(stdout, "Current apply operation has %d recursive calls\n", this_apply_counter);
    }
 
-   PUSHREF( replace_rec(LOW(r)) );
-   PUSHREF( replace_rec(HIGH(r)) );
-
-   res = bdd_correctify(LEVEL(replacepair[LEVEL(r)]), READREF(2), READREF(1));
-   POPREF(2);
-
-#if ENABLE_TBDD
-      BddCache_clause_evict(entry);
-#endif
-
-
-   entry->a = r;
-   entry->b = -1;
-   entry->c = replaceid;
-   entry->op = bddop_replace;
-   entry->r.res = res;
-
-   return res;
-}
-
-
-static BDD bdd_correctify(int level, BDD l, BDD r)
-{
-   BDD res;
-
-   if (level < LEVEL(l)  &&  level < LEVEL(r))
-      return bdd_makenode(level, l, r);
-
-   if (level == LEVEL(l)  ||  level == LEVEL(r))
-   {
-      bdd_error(BDD_REPLACE);
-      return 0;
-   }
-
-   this_apply_counter++;
-   if (0 && this_apply_counter % THIS_APPLY_REPORT == 0) {
-       fprintf(stdout, "Current apply operation has %d recursive calls\n", this_apply_counter);
-   }
-
-   if (LEVEL(l) == LEVEL(r))
+   if (LEVEL(f) == LEVEL(g))
    {
-      PUSHREF( bdd_correctify(level, LOW(l), LOW(r)) );
-      PUSHREF( bdd_correctify(level, HIGH(l), HIGH(r)) );
-      res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
+      if (LEVEL(f) == LEVEL(h))
+      {
+	 PUSHREF( ite_rec(LOW(f), LOW(g), LOW(h)) );
+	 PUSHREF( ite_rec(HIGH(f), HIGH(g), HIGH(h)) );
+	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
+      }
+      else
+      if (LEVEL(f) < LEVEL(h))
+      {
+	 PUSHREF( ite_rec(LOW(f), LOW(g), h) );
+	 PUSHREF( ite_rec(HIGH(f), HIGH(g), h) );
+	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
+      }
+      else /* f > h */
+      {
+	 PUSHREF( ite_rec(f, g, LOW(h)) );
+	 PUSHREF( ite_rec(f, g, HIGH(h)) );
+	 res = bdd_makenode(LEVEL(h), READREF(2), READREF(1));
+      }
    }
    else
-   if (LEVEL(l) < LEVEL(r))
+   if (LEVEL(f) < LEVEL(g))
    {
-      PUSHREF( bdd_correctify(level, LOW(l), r) );
-      PUSHREF( bdd_correctify(level, HIGH(l), r) );
-      res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
+      if (LEVEL(f) == LEVEL(h))
+      {
+	 PUSHREF( ite_rec(LOW(f), g, LOW(h)) );
+	 PUSHREF( ite_rec(HIGH(f), g, HIGH(h)) );
+	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
+      }
+      else
+      if (LEVEL(f) < LEVEL(h))
+      {
+	 PUSHREF( ite_rec(LOW(f), g, h) );
+	 PUSHREF( ite_rec(HIGH(f), g, h) );
+	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
+      }
+      else /* f > h */
+      {
+	 PUSHREF( ite_rec(f, g, LOW(h)) );
+	 PUSHREF( ite_rec(f, g, HIGH(h)) );
+	 res = bdd_makenode(LEVEL(h), READREF(2), READREF(1));
+      }
    }
-   else
+   else /* f > g */
    {
-      PUSHREF( bdd_correctify(level, l, LOW(r)) );
-      PUSHREF( bdd_correctify(level, l, HIGH(r)) );
-      res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
+      if (LEVEL(g) == LEVEL(h))
+      {
+	 PUSHREF( ite_rec(f, LOW(g), LOW(h)) );
+	 PUSHREF( ite_rec(f, HIGH(g), HIGH(h)) );
+	 res = bdd_makenode(LEVEL(g), READREF(2), READREF(1));
+      }
+      else
+      if (LEVEL(g) < LEVEL(h))
+      {
+	 PUSHREF( ite_rec(f, LOW(g), h) );
+	 PUSHREF( ite_rec(f, HIGH(g), h) );
+	 res = bdd_makenode(LEVEL(g), READREF(2), READREF(1));
+      }
+      else /* g > h */
+      {
+	 PUSHREF( ite_rec(f, g, LOW(h)) );
+	 PUSHREF( ite_rec(f, g, HIGH(h)) );
+	 res = bdd_makenode(LEVEL(h), READREF(2), READREF(1));
+      }
    }
+
    POPREF(2);
 
-   return res; /* FIXME: cache ? */
+   entry = BddCache_insert(&itecache, ITEHASH(f,g,h), f, g, h);
+   entry->res = res;
+
+   return res;
 }
 
 
-/*=== COMPOSE ==========================================================*/
+/*=== RESTRICT =========================================================*/
 
 /*
-NAME    {* bdd\_compose *}
+NAME    {* bdd\_restrict *}
 SECTION {* operator *}
-SHORT   {* functional composition *}
-PROTO   {* BDD bdd_compose(BDD f, BDD g, int var) *}
-DESCR   {* Substitutes the variable {\tt var} with the BDD {\tt g} in
-           the BDD {\tt f}: result $= f[g/var]$. *}
-RETURN  {* The composed BDD *}
-ALSO    {* bdd\_veccompose, bdd\_replace, bdd\_restrict *}
+SHORT   {* restric a set of variables to constant values *}
+PROTO   {* BDD bdd_restrict(BDD r, BDD var) *}
+DESCR   {* This function restricts the variables in {\tt r} to constant
+           true or false. How this is done
+	   depends on how the variables are included in the variable set
+	   {\tt var}. If they
+	   are included in their positive form then they are restricted to
+	   true and vice versa. Unfortunately it is not possible to
+	   insert variables in their negated form using {\tt bdd\_makeset},
+	   so the variable set has to be build manually as a
+	   conjunction of the variables. Example: Assume variable 1 should be
+	   restricted to true and variable 3 to false.
+	   \begin{verbatim}
+  bdd X = make_user_bdd();
+  bdd R1 = BDD_ithvar(1);
+  bdd R2 = BDD_nithvar(3);
+  bdd R = bdd_addref( bdd_apply(R1,R2, bddop_and) );
+  bdd RES = bdd_addref( bdd_restrict(X,R) );
+\end{verbatim}
+	   *}
+RETURN  {* The restricted bdd. *}
+ALSO    {* bdd\_makeset, bdd\_exist, bdd\_forall *}
 */
-BDD bdd_compose(BDD f, BDD g, int var)
+BDD bdd_restrict(BDD r, BDD var)
 {
    BDD res;
    firstReorder = 1;
-   this_apply_counter = 0;
 
-   CHECKa(f, bddfalse);
-   CHECKa(g, bddfalse);
-   if (var < 0 || var >= bddvarnum)
-   {
-      bdd_error(BDD_VAR);
-      return bddfalse;
-   }
+   CHECKa(r,bddfalse);
+   CHECKa(var,bddfalse);
+
+   if (var < 2)  /* Empty set */
+      return r;
 
  again:
    if (setjmp(bddexception) == 0)
    {
+      if (varset2svartable(var) < 0)
+	 return bddfalse;
+
       INITREF;
-      composelevel = bddvar2level[var];
-      replaceid = (composelevel << 2) | CACHEID_COMPOSE;
+      miscid = (var << 3) | CACHEID_RESTRICT;
 
       if (!firstReorder)
 	 bdd_disable_reorder();
-      res = compose_rec(f, g);
+      res = restrict_rec(r);
       if (!firstReorder)
 	 bdd_enable_reorder();
    }
@@ -1889,115 +2629,83 @@ BDD bdd_compose(BDD f, BDD g, int var)
 }
 
 
-static BDD compose_rec(BDD f, BDD g)
+static BDD restrict_rec(BDD r)
 {
    BddCacheData *entry;
    BDD res;
 
-   if (LEVEL(f) > composelevel)
-      return f;
+   if (ISCONST(r)  ||  LEVEL(r) > quantlast)
+      return r;
+
+#if ENABLE_COMPLEMENT
+   if (ISCOMPL(r))
+      return COMPLEMENT(restrict_rec(REGULAR(r)));
+#endif
 
-   entry = BddCache_lookup(&opcache, COMPOSEHASH(f,g));
-   if (entry->a == f  &&  entry->b == g  &&  entry->c == replaceid && entry->op == bddop_replace)
+   entry = BddCache_find(&misccache, RESTRHASH(r,miscid), r, -1, miscid);
+   if (entry != NULL)
    {
 #ifdef CACHESTATS
       bddcachestats.opHit++;
 #endif
-      return entry->r.res;
+      return entry->res;
    }
 #ifdef CACHESTATS
    bddcachestats.opMiss++;
 #endif
 
-   this_apply_counter++;
-   if (0 && this_apply_counter % THIS_APPLY_REPORT == 0) {
-       fprintf(stdout, "Current apply operation has %d recursive calls\n", this_apply_counter);
-   }
-
-
-   if (LEVEL(f) < composelevel)
+   if (INSVARSET(LEVEL(r)))
    {
-      if (LEVEL(f) == LEVEL(g))
-      {
-	 PUSHREF( compose_rec(LOW(f), LOW(g)) );
-	 PUSHREF( compose_rec(HIGH(f), HIGH(g)) );
-	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
-      }
-      else
-      if (LEVEL(f) < LEVEL(g))
-      {
-	 PUSHREF( compose_rec(LOW(f), g) );
-	 PUSHREF( compose_rec(HIGH(f), g) );
-	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
-      }
+      if (quantvarset[LEVEL(r)] > 0)
+	 res = restrict_rec(HIGH(r));
       else
-      {
-	 PUSHREF( compose_rec(f, LOW(g)) );
-	 PUSHREF( compose_rec(f, HIGH(g)) );
-	 res = bdd_makenode(LEVEL(g), READREF(2), READREF(1));
-      }
-      POPREF(2);
+	 res = restrict_rec(LOW(r));
    }
    else
-      /*if (LEVEL(f) == composelevel) changed 2-nov-98 */
    {
-      res = ite_rec(g, HIGH(f), LOW(f));
+      PUSHREF( restrict_rec(LOW(r)) );
+      PUSHREF( restrict_rec(HIGH(r)) );
+      res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
+      POPREF(2);
    }
 
-#if ENABLE_TBDD
-      BddCache_clause_evict(entry);
-#endif
-
-
-   entry->a = f;
-   entry->b = g;
-   entry->c = replaceid;
-   entry->op = bddop_replace;
-   entry->r.res = res;
+   entry = BddCache_insert(&misccache, RESTRHASH(r,miscid), r, -1, miscid);
+   entry->res = res;
 
    return res;
 }
 
 
+/*=== GENERALIZED COFACTOR =============================================*/
+
 /*
-NAME    {* bdd\_veccompose *}
+NAME    {* bdd\_constrain *}
 SECTION {* operator *}
-SHORT   {* simultaneous functional composition *}
-PROTO   {* BDD bdd_veccompose(BDD f, bddPair *pair) *}
-DESCR   {* Uses the pairs of variables and BDDs in {\tt pair} to make
-           the simultaneous substitution: $f[g_1/V_1, \ldots, g_n/V_n]$.
-	   In this way one or more BDDs
-	   may be substituted in one step. The BDDs in
-	   {\tt pair} may depend on the variables they are substituting.
-           {\tt bdd\_compose} may be used instead of
-	   {\tt bdd\_replace} but is not as efficient when $g_i$ is a
-	   single variable, the same applies to {\tt bdd\_restrict}.
-	   Note that simultaneous substitution is not necessarily the same
-	   as repeated substitution. Example:
-	   $(x_1 \disj x_2)[x_3/x_1,x_4/x_3] = (x_3 \disj x_2) \neq
-	   ((x_1 \disj x_2)[x_3/x_1])[x_4/x_3] = (x_4 \disj x_2)$. *}
-RETURN  {* The composed BDD *}
-ALSO    {* bdd\_compose, bdd\_replace, bdd\_restrict *}
+SHORT   {* generalized cofactor *}
+PROTO   {* BDD bdd_constrain(BDD f, BDD c) *}
+DESCR   {* Computes the generalized cofactor of {\tt f} with respect to
+           {\tt c}. *}
+RETURN  {* The constrained BDD *}
+ALSO    {* bdd\_restrict, bdd\_simplify *}
 */
-BDD bdd_veccompose(BDD f, bddPair *pair)
+BDD bdd_constrain(BDD f, BDD c)
 {
    BDD res;
    firstReorder = 1;
    this_apply_counter = 0;
 
-   CHECKa(f, bddfalse);
+   CHECKa(f,bddfalse);
+   CHECKa(c,bddfalse);
 
  again:
    if (setjmp(bddexception) == 0)
    {
       INITREF;
-      replacepair = pair->result;
-      replaceid = (pair->id << 2) | CACHEID_VECCOMPOSE;
-      replacelast = pair->last;
+      miscid = CACHEID_CONSTRAIN;
 
       if (!firstReorder)
 	 bdd_disable_reorder();
-      res = veccompose_rec(f);
+      res = constrain_rec(f, c);
       if (!firstReorder)
 	 bdd_enable_reorder();
    }
@@ -2015,21 +2723,32 @@ BDD bdd_veccompose(BDD f, bddPair *pair)
 }
 
 
-static BDD veccompose_rec(BDD f)
+static BDD constrain_rec(BDD f, BDD c)
 {
    BddCacheData *entry;
-   register BDD res;
+   BDD res;
 
-   if (LEVEL(f) > replacelast)
+   if (ISONE(c))
       return f;
+   if (ISCONST(f))
+      return f;
+   if (c == f)
+      return BDDONE;
+   if (ISZERO(c))
+      return BDDZERO;
+
+#if ENABLE_COMPLEMENT
+   if (ISCOMPL(f))
+      return COMPLEMENT(constrain_rec(COMPLEMENT(f), c));
+#endif
 
-   entry = BddCache_lookup(&opcache, VECCOMPOSEHASH(f));
-   if (entry->a == f  &&  entry->c == replaceid && entry->op == bddop_replace)
+   entry = BddCache_find(&misccache, CONSTRAINHASH(f,c), f, c, miscid);
+   if (entry != NULL)
    {
 #ifdef CACHESTATS
       bddcachestats.opHit++;
 #endif
-      return entry->r.res;
+      return entry->res;
    }
 #ifdef CACHESTATS
    bddcachestats.opMiss++;
@@ -2041,57 +2760,223 @@ static BDD veccompose_rec(BDD f)
    }
 
 
-   PUSHREF( veccompose_rec(LOW(f)) );
-   PUSHREF( veccompose_rec(HIGH(f)) );
-   res = ite_rec(replacepair[LEVEL(f)], READREF(1), READREF(2));
-   POPREF(2);
-
-#if ENABLE_TBDD
-      BddCache_clause_evict(entry);
-#endif
-
-
-   entry->a = f;
-   entry->b = -1;
-   entry->c = replaceid;
-   entry->op = bddop_replace;
-   entry->r.res = res;
-
-   return res;
-}
-
-
-/*=== SIMPLIFY =========================================================*/
-
-/*
-NAME    {* bdd\_simplify *}
-SECTION {* operator *}
-SHORT   {* coudert and Madre's restrict function *}
-PROTO   {* BDD bdd_simplify(BDD f, BDD d) *}
-DESCR   {* Tries to simplify the BDD {\tt f} by restricting it to the
-           domaine covered by {\tt d}. No checks are done to see if the
-	   result is actually smaller than the input. This can be done
-	   by the user with a call to {\tt bdd\_nodecount}. *}
-ALSO    {* bdd\_restrict *}
-RETURN  {* The simplified BDD *}
-*/
-BDD bdd_simplify(BDD f, BDD d)
-{
-   BDD res;
-   firstReorder = 1;
+   if (LEVEL(f) == LEVEL(c))
+   {
+      if (ISZERO(LOW(c)))
+	 res = constrain_rec(HIGH(f), HIGH(c));
+      else if (ISZERO(HIGH(c)))
+	 res = constrain_rec(LOW(f), LOW(c));
+      else
+      {
+	 PUSHREF( constrain_rec(LOW(f), LOW(c)) );
+	 PUSHREF( constrain_rec(HIGH(f), HIGH(c)) );
+	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
+	 POPREF(2);
+      }
+   }
+   else
+   if (LEVEL(f) < LEVEL(c))
+   {
+      PUSHREF( constrain_rec(LOW(f), c) );
+      PUSHREF( constrain_rec(HIGH(f), c) );
+      res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
+      POPREF(2);
+   }
+   else
+   {
+      if (ISZERO(LOW(c)))
+	 res = constrain_rec(f, HIGH(c));
+      else if (ISZERO(HIGH(c)))
+	 res = constrain_rec(f, LOW(c));
+      else
+      {
+	 PUSHREF( constrain_rec(f, LOW(c)) );
+	 PUSHREF( constrain_rec(f, HIGH(c)) );
+	 res = bdd_makenode(LEVEL(c), READREF(2), READREF(1));
+	 POPREF(2);
+      }
+   }
+
+   entry = BddCache_insert(&misccache, CONSTRAINHASH(f,c), f, c, miscid);
+   entry->res = res;
+
+   return res;
+}
+
+
+/*=== REPLACE ==========================================================*/
+
+/*
+NAME    {* bdd\_replace *}
+SECTION {* operator *}
+SHORT   {* replaces variables with other variables *}
+PROTO   {* BDD bdd_replace(BDD r, bddPair *pair) *}
+DESCR   {* Replaces all variables in the BDD {\tt r} with the variables
+           defined by {\tt pair}. Each entry in {\tt pair} consists of a
+	   old and a new variable. Whenever the old variable is found in
+	   {\tt r} then a new node with the new variable is inserted instead.
+	*}
+ALSO   {* bdd\_newpair, bdd\_setpair, bdd\_setpairs *}
+RETURN {* The result of the operation. *}
+*/
+BDD bdd_replace(BDD r, bddPair *pair)
+{
+   BDD res;
+   firstReorder = 1;
+   this_apply_counter = 0;
+
+   CHECKa(r, bddfalse);
+
+ again:
+   if (setjmp(bddexception) == 0)
+   {
+      INITREF;
+      replacepair = pair->result;
+      replacelast = pair->last;
+      replaceid = (pair->id << 2) | CACHEID_REPLACE;
+
+      if (!firstReorder)
+	 bdd_disable_reorder();
+      res = replace_rec(r);
+      if (!firstReorder)
+	 bdd_enable_reorder();
+   }
+   else
+   {
+      bdd_checkreorder();
+
+      if (firstReorder-- == 1)
+	 goto again;
+      res = BDDZERO;  /* avoid warning about res being uninitialized */
+   }
+
+   checkresize();
+   return res;
+}
+
+
+static BDD replace_rec(BDD r)
+{
+   BddCacheData *entry;
+   BDD res;
+
+   if (ISCONST(r)  ||  LEVEL(r) > replacelast)
+      return r;
+
+#if ENABLE_COMPLEMENT
+   if (ISCOMPL(r))
+      return COMPLEMENT(replace_rec(REGULAR(r)));
+#endif
+
+   entry = BddCache_find(&replacecache, REPLACEHASH(r), r, -1, replaceid);
+   if (entry != NULL)
+   {
+#ifdef CACHESTATS
+      bddcachestats.opHit++;
+#endif
+      return entry->res;
+   }
+#ifdef CACHESTATS
+   bddcachestats.opMiss++;
+#endif
+
+   this_apply_counter++;
+   if (0 && this_apply_counter % THIS_APPLY_REPORT == 0) {
+       fprintf(stdout, "Current apply operation has %d recursive calls\n", this_apply_counter);
+   }
+
+   PUSHREF( replace_rec(LOW(r)) );
+   PUSHREF( replace_rec(HIGH(r)) );
+
+   res = bdd_correctify(LEVEL(replacepair[LEVEL(r)]), READREF(2), READREF(1));
+   POPREF(2);
+
+   entry = BddCache_insert(&replacecache, REPLACEHASH(r), r, -1, replaceid);
+   entry->res = res;
+
+   return res;
+}
+
+
+static BDD bdd_correctify(int level, BDD l, BDD r)
+{
+   BDD res;
+
+   if (level < LEVEL(l)  &&  level < LEVEL(r))
+      return bdd_makenode(level, l, r);
+
+   if (level == LEVEL(l)  ||  level == LEVEL(r))
+   {
+      bdd_error(BDD_REPLACE);
+      return 0;
+   }
+
+   this_apply_counter++;
+   if (0 && this_apply_counter % THIS_APPLY_REPORT == 0) {
+       fprintf(stdout, "Current apply operation has %d recursive calls\n", this_apply_counter);
+   }
+
+   if (LEVEL(l) == LEVEL(r))
+   {
+      PUSHREF( bdd_correctify(level, LOW(l), LOW(r)) );
+      PUSHREF( bdd_correctify(level, HIGH(l), HIGH(r)) );
+      res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
+   }
+   else
+   if (LEVEL(l) < LEVEL(r))
+   {
+      PUSHREF( bdd_correctify(level, LOW(l), r) );
+      PUSHREF( bdd_correctify(level, HIGH(l), r) );
+      res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
+   }
+   else
+   {
+      PUSHREF( bdd_correctify(level, l, LOW(r)) );
+      PUSHREF( bdd_correctify(level, l, HIGH(r)) );
+      res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
+   }
+   POPREF(2);
+
+   return res; /* FIXME: cache ? */
+}
+
+
+/*=== COMPOSE ==========================================================*/
+
+/*
+NAME    {* bdd\_compose *}
+SECTION {* operator *}
+SHORT   {* functional composition *}
+PROTO   {* BDD bdd_compose(BDD f, BDD g, int var) *}
+DESCR   {* Substitutes the variable {\tt var} with the BDD {\tt g} in
+           the BDD {\tt f}: result $= f[g/var]$. *}
+RETURN  {* The composed BDD *}
+ALSO    {* bdd\_veccompose, bdd\_replace, bdd\_restrict *}
+*/
+BDD bdd_compose(BDD f, BDD g, int var)
+{
+   BDD res;
+   firstReorder = 1;
+   this_apply_counter = 0;
 
    CHECKa(f, bddfalse);
-   CHECKa(d, bddfalse);
+   CHECKa(g, bddfalse);
+   if (var < 0 || var >= bddvarnum)
+   {
+      bdd_error(BDD_VAR);
+      return bddfalse;
+   }
 
  again:
    if (setjmp(bddexception) == 0)
    {
       INITREF;
-      applyop = bddop_or;
+      composelevel = bddvar2level[var];
+      replaceid = (composelevel << 2) | CACHEID_COMPOSE;
 
       if (!firstReorder)
 	 bdd_disable_reorder();
-      res = simplify_rec(f, d);
+      res = compose_rec(f, g);
       if (!firstReorder)
 	 bdd_enable_reorder();
    }
@@ -2109,284 +2994,1380 @@ BDD bdd_simplify(BDD f, BDD d)
 }
 
 
-static BDD simplify_rec(BDD f, BDD d)
+static BDD compose_rec(BDD f, BDD g)
 {
    BddCacheData *entry;
    BDD res;
 
-   if (ISONE(d)  ||  ISCONST(f))
+   if (LEVEL(f) > composelevel)
       return f;
-   if (d == f)
-      return BDDONE;
-   if (ISZERO(d))
-      return BDDZERO;
 
-   entry = BddCache_lookup(&opcache, APPLYHASH(f,d,bddop_simplify));
+#if ENABLE_COMPLEMENT
+   if (ISCOMPL(f))
+      return COMPLEMENT(compose_rec(REGULAR(f), g));
+#endif
 
-   if (entry->a == f  &&  entry->b == d  &&  entry->op == bddop_simplify)
+   entry = BddCache_find(&replacecache, COMPOSEHASH(f,g), f, g, replaceid);
+   if (entry != NULL)
    {
 #ifdef CACHESTATS
       bddcachestats.opHit++;
 #endif
-      return entry->r.res;
+      return entry->res;
    }
 #ifdef CACHESTATS
    bddcachestats.opMiss++;
 #endif
 
-   if (LEVEL(f) == LEVEL(d))
+   this_apply_counter++;
+   if (0 && this_apply_counter % THIS_APPLY_REPORT == 0) {
+       fprintf(stdout, "Current apply operation has %d recursive calls\n", this_apply_counter);
+   }
+
+
+   if (LEVEL(f) < composelevel)
    {
-      if (ISZERO(LOW(d)))
-	 res = simplify_rec(HIGH(f), HIGH(d));
-      else
-      if (ISZERO(HIGH(d)))
-	 res = simplify_rec(LOW(f), LOW(d));
+      if (LEVEL(f) == LEVEL(g))
+      {
+	 PUSHREF( compose_rec(LOW(f), LOW(g)) );
+	 PUSHREF( compose_rec(HIGH(f), HIGH(g)) );
+	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
+      }
       else
+      if (LEVEL(f) < LEVEL(g))
       {
-	 PUSHREF( simplify_rec(LOW(f),	LOW(d)) );
-	 PUSHREF( simplify_rec(HIGH(f), HIGH(d)) );
+	 PUSHREF( compose_rec(LOW(f), g) );
+	 PUSHREF( compose_rec(HIGH(f), g) );
 	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
-	 POPREF(2);
       }
+      else
+      {
+	 PUSHREF( compose_rec(f, LOW(g)) );
+	 PUSHREF( compose_rec(f, HIGH(g)) );
+	 res = bdd_makenode(LEVEL(g), READREF(2), READREF(1));
+      }
+      POPREF(2);
    }
    else
-   if (LEVEL(f) < LEVEL(d))
+      /*if (LEVEL(f) == composelevel) changed 2-nov-98 */
    {
-      PUSHREF( simplify_rec(LOW(f), d) );
-      PUSHREF( simplify_rec(HIGH(f), d) );
-      res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
-      POPREF(2);
+      res = ite_rec(g, HIGH(f), LOW(f));
    }
-   else /* LEVEL(d) < LEVEL(f) */
+
+   entry = BddCache_insert(&replacecache, COMPOSEHASH(f,g), f, g, replaceid);
+   entry->res = res;
+
+   return res;
+}
+
+
+/*
+NAME    {* bdd\_veccompose *}
+SECTION {* operator *}
+SHORT   {* simultaneous functional composition *}
+PROTO   {* BDD bdd_veccompose(BDD f, bddPair *pair) *}
+DESCR   {* Uses the pairs of variables and BDDs in {\tt pair} to make
+           the simultaneous substitution: $f[g_1/V_1, \ldots, g_n/V_n]$.
+	   In this way one or more BDDs
+	   may be substituted in one step. The BDDs in
+	   {\tt pair} may depend on the variables they are substituting.
+           {\tt bdd\_compose} may be used instead of
+	   {\tt bdd\_replace} but is not as efficient when $g_i$ is a
+	   single variable, the same applies to {\tt bdd\_restrict}.
+	   Note that simultaneous substitution is not necessarily the same
+	   as repeated substitution. Example:
+	   $(x_1 \disj x_2)[x_3/x_1,x_4/x_3] = (x_3 \disj x_2) \neq
+	   ((x_1 \disj x_2)[x_3/x_1])[x_4/x_3] = (x_4 \disj x_2)$. *}
+RETURN  {* The composed BDD *}
+ALSO    {* bdd\_compose, bdd\_replace, bdd\_restrict *}
+*/
+BDD bdd_veccompose(BDD f, bddPair *pair)
+{
+   BDD res;
+   firstReorder = 1;
+   this_apply_counter = 0;
+
+   CHECKa(f, bddfalse);
+
+ again:
+   if (setjmp(bddexception) == 0)
+   {
+      INITREF;
+      replacepair = pair->result;
+      replaceid = (pair->id << 2) | CACHEID_VECCOMPOSE;
+      replacelast = pair->last;
+
+      if (!firstReorder)
+	 bdd_disable_reorder();
+      res = veccompose_rec(f);
+      if (!firstReorder)
+	 bdd_enable_reorder();
+   }
+   else
+   {
+      bdd_checkreorder();
+
+      if (firstReorder-- == 1)
+	 goto again;
+      res = BDDZERO;  /* avoid warning about res being uninitialized */
+   }
+
+   checkresize();
+   return res;
+}
+
+
+static BDD veccompose_rec(BDD f)
+{
+   BddCacheData *entry;
+   register BDD res;
+
+   if (LEVEL(f) > replacelast)
+      return f;
+
+#if ENABLE_COMPLEMENT
+   if (ISCOMPL(f))
+      return COMPLEMENT(veccompose_rec(REGULAR(f)));
+#endif
+
+   entry = BddCache_find(&replacecache, VECCOMPOSEHASH(f), f, -1, replaceid);
+   if (entry != NULL)
+   {
+#ifdef CACHESTATS
+      bddcachestats.opHit++;
+#endif
+      return entry->res;
+   }
+#ifdef CACHESTATS
+   bddcachestats.opMiss++;
+#endif
+
+   this_apply_counter++;
+   if (0 && this_apply_counter % THIS_APPLY_REPORT == 0) {
+       fprintf(stdout, "Current apply operation has %d recursive calls\n", this_apply_counter);
+   }
+
+
+   PUSHREF( veccompose_rec(LOW(f)) );
+   PUSHREF( veccompose_rec(HIGH(f)) );
+   res = ite_rec(replacepair[LEVEL(f)], READREF(1), READREF(2));
+   POPREF(2);
+
+   entry = BddCache_insert(&replacecache, VECCOMPOSEHASH(f), f, -1, replaceid);
+   entry->res = res;
+
+   return res;
+}
+
+
+/*=== SIMPLIFY =========================================================*/
+
+/*
+NAME    {* bdd\_simplify *}
+SECTION {* operator *}
+SHORT   {* coudert and Madre's restrict function *}
+PROTO   {* BDD bdd_simplify(BDD f, BDD d) *}
+DESCR   {* Tries to simplify the BDD {\tt f} by restricting it to the
+           domaine covered by {\tt d}. No checks are done to see if the
+	   result is actually smaller than the input. This can be done
+	   by the user with a call to {\tt bdd\_nodecount}. *}
+ALSO    {* bdd\_restrict *}
+RETURN  {* The simplified BDD *}
+*/
+BDD bdd_simplify(BDD f, BDD d)
+{
+   BDD res;
+   firstReorder = 1;
+
+   CHECKa(f, bddfalse);
+   CHECKa(d, bddfalse);
+
+ again:
+   if (setjmp(bddexception) == 0)
+   {
+      INITREF;
+
+      if (!firstReorder)
+	 bdd_disable_reorder();
+      res = simplify_rec(f, d);
+      if (!firstReorder)
+	 bdd_enable_reorder();
+   }
+   else
+   {
+      bdd_checkreorder();
+
+      if (firstReorder-- == 1)
+	 goto again;
+      res = BDDZERO;  /* avoid warning about res being uninitialized */
+   }
+
+   checkresize();
+   return res;
+}
+
+
+static BDD simplify_rec(BDD f, BDD d)
+{
+   BddCacheData *entry;
+   BDD res;
+
+   if (ISONE(d)  ||  ISCONST(f))
+      return f;
+   if (d == f)
+      return BDDONE;
+   if (ISZERO(d))
+      return BDDZERO;
+
+   entry = BddCache_find(&applycache, APPLYHASH(f,d,bddop_simplify), f, d,
+			 bddop_simplify);
+   if (entry != NULL)
+   {
+#ifdef CACHESTATS
+      bddcachestats.opHit++;
+#endif
+      return entry->res;
+   }
+#ifdef CACHESTATS
+   bddcachestats.opMiss++;
+#endif
+
+   if (LEVEL(f) == LEVEL(d))
+   {
+      if (ISZERO(LOW(d)))
+	 res = simplify_rec(HIGH(f), HIGH(d));
+      else
+      if (ISZERO(HIGH(d)))
+	 res = simplify_rec(LOW(f), LOW(d));
+      else
+      {
+	 PUSHREF( simplify_rec(LOW(f),	LOW(d)) );
+	 PUSHREF( simplify_rec(HIGH(f), HIGH(d)) );
+	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
+	 POPREF(2);
+      }
+   }
+   else
+   if (LEVEL(f) < LEVEL(d))
+   {
+      PUSHREF( simplify_rec(LOW(f), d) );
+      PUSHREF( simplify_rec(HIGH(f), d) );
+      res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
+      POPREF(2);
+   }
+   else /* LEVEL(d) < LEVEL(f) */
+   {
+      PUSHREF( apply_or_rec(LOW(d), HIGH(d)) ); /* Exist quant */
+      res = simplify_rec(f, READREF(1));
+      POPREF(1);
+   }
+
+   entry = BddCache_insert(&applycache, APPLYHASH(f,d,bddop_simplify), f, d,
+			   bddop_simplify);
+   entry->res = res;
+
+   return res;
+}
+
+
+/*=== QUANTIFICATION ===================================================*/
+
+/*
+NAME    {* bdd\_exist *}
+SECTION {* operator *}
+SHORT   {* existential quantification of variables *}
+PROTO   {* BDD bdd_exist(BDD r, BDD var) *}
+DESCR   {* Removes all occurences in {\tt r} of variables in the set
+           {\tt var} by existential quantification. *}
+ALSO    {* bdd\_forall, bdd\_unique, bdd\_makeset *}
+RETURN  {* The quantified BDD. *}
+*/
+BDD bdd_exist(BDD r, BDD var)
+{
+   BDD res;
+   firstReorder = 1;
+   this_apply_counter = 0;
+
+   CHECKa(r, bddfalse);
+   CHECKa(var, bddfalse);
+
+   if (var < 2)  /* Empty set */
+      return r;
+
+ again:
+   if (setjmp(bddexception) == 0)
+   {
+      if (varset2vartable(var) < 0)
+	 return bddfalse;
+
+      INITREF;
+      quantid = (var << 3) | CACHEID_EXIST; /* FIXME: range */
+      applyop = bddop_or;
+
+      if (!firstReorder)
+	 bdd_disable_reorder();
+#if ENABLE_PARAPPLY
+      if ((res = bdd_par_quant(r)) < 0)
+#endif
+#if ENABLE_ITERAPPLY
+      res = bdd_iter_run(ITER_QUANT, applyop, r, 0);
+#else
+      res = quant_rec(r);
+#endif
+      if (!firstReorder)
+	 bdd_enable_reorder();
+   }
+   else
+      res = -1;  /* Interrupted for reordering */
+
+   if (res < 0)
+   {
+      bdd_checkreorder();
+
+      if (firstReorder-- == 1)
+	 goto again;
+      res = BDDZERO;
+   }
+
+   checkresize();
+   return res;
+}
+
+
+/*
+NAME    {* bdd\_forall *}
+SECTION {* operator *}
+SHORT   {* universal quantification of variables *}
+PROTO   {* BDD bdd_forall(BDD r, BDD var) *}
+DESCR   {* Removes all occurences in {\tt r} of variables in the set
+           {\tt var} by universal quantification. *}
+ALSO    {* bdd\_exist, bdd\_unique, bdd\_makeset *}
+RETURN  {* The quantified BDD. *}
+*/
+BDD bdd_forall(BDD r, BDD var)
+{
+   BDD res;
+   firstReorder = 1;
+   this_apply_counter = 0;
+
+   CHECKa(r, bddfalse);
+   CHECKa(var, bddfalse);
+
+   if (var < 2)  /* Empty set */
+      return r;
+
+ again:
+   if (setjmp(bddexception) == 0)
+   {
+      if (varset2vartable(var) < 0)
+	 return bddfalse;
+
+      INITREF;
+      quantid = (var << 3) | CACHEID_FORALL;
+      applyop = bddop_and;
+
+      if (!firstReorder)
+	 bdd_disable_reorder();
+#if ENABLE_PARAPPLY
+      if ((res = bdd_par_quant(r)) < 0)
+#endif
+#if ENABLE_ITERAPPLY
+      res = bdd_iter_run(ITER_QUANT, applyop, r, 0);
+#else
+      res = quant_rec(r);
+#endif
+      if (!firstReorder)
+	 bdd_enable_reorder();
+   }
+   else
+      res = -1;  /* Interrupted for reordering */
+
+   if (res < 0)
+   {
+      bdd_checkreorder();
+
+      if (firstReorder-- == 1)
+	 goto again;
+      res = BDDZERO;
+   }
+
+   checkresize();
+   return res;
+}
+
+
+/*
+NAME    {* bdd\_unique *}
+SECTION {* operator *}
+SHORT   {* unique quantification of variables *}
+PROTO   {* BDD bdd_unique(BDD r, BDD var) *}
+DESCR   {* Removes all occurences in {\tt r} of variables in the set
+           {\tt var} by unique quantification. This type of quantification
+	   uses a XOR operator instead of an OR operator as in the
+	   existential quantification, and an AND operator as in the
+	   universal quantification. *}
+ALSO    {* bdd\_exist, bdd\_forall, bdd\_makeset *}
+RETURN  {* The quantified BDD. *}
+*/
+BDD bdd_unique(BDD r, BDD var)
+{
+   BDD res;
+   firstReorder = 1;
+   this_apply_counter = 0;
+
+   CHECKa(r, bddfalse);
+   CHECKa(var, bddfalse);
+
+   if (var < 2)  /* Empty set */
+      return r;
+
+ again:
+   if (setjmp(bddexception) == 0)
+   {
+      if (varset2vartable(var) < 0)
+	 return bddfalse;
+
+      INITREF;
+      quantid = (var << 3) | CACHEID_UNIQUE;
+      applyop = bddop_xor;
+
+      if (!firstReorder)
+	 bdd_disable_reorder();
+#if ENABLE_PARAPPLY
+      if ((res = bdd_par_quant(r)) < 0)
+#endif
+#if ENABLE_ITERAPPLY
+      res = bdd_iter_run(ITER_QUANT, applyop, r, 0);
+#else
+      res = quant_rec(r);
+#endif
+      if (!firstReorder)
+	 bdd_enable_reorder();
+   }
+   else
+      res = -1;  /* Interrupted for reordering */
+
+   if (res < 0)
+   {
+      bdd_checkreorder();
+
+      if (firstReorder-- == 1)
+	 goto again;
+      res = BDDZERO;
+   }
+
+   checkresize();
+   return res;
+}
+
+
+static BDD quant_rec(BDD r)
+{
+   BddCacheData *entry;
+   BDD res;
+
+   if (r < 2  ||  LEVEL(r) > quantlast)
+      return r;
+
+   entry = BddCache_find(&quantcache, QUANTHASH(r), r, -1, quantid);
+   if (entry != NULL)
+   {
+#ifdef CACHESTATS
+      bddcachestats.opHit++;
+#endif
+      return entry->res;
+   }
+#ifdef CACHESTATS
+   bddcachestats.opMiss++;
+#endif
+
+   this_apply_counter++;
+   if (0 && this_apply_counter % THIS_APPLY_REPORT == 0) {
+       fprintf(stdout, "Current apply operation has %d recursive calls\n", this_apply_counter);
+   }
+
+   PUSHREF( quant_rec(LOW(r)) );
+   PUSHREF( quant_rec(HIGH(r)) );
+
+   if (INVARSET(LEVEL(r)))
+      res = apply_rec(READREF(2), READREF(1), applyop);
+   else
+      res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
+
+   POPREF(2);
+
+   entry = BddCache_insert(&quantcache, QUANTHASH(r), r, -1, quantid);
+   entry->res = res;
+
+   return res;
+}
+
+
+#if ENABLE_ITERAPPLY
+
+/*=== ITERATIVE APPLY AND QUANTIFICATION ===============================*/
+
+/* The top-level calls of apply, the proof generating apply and the
+ * quantifications are run by a loop over an explicit stack of pending
+ * calls instead of by recursion, so the depth of a BDD is not limited by
+ * the C stack. The sub results are kept on the reference stack, as in
+ * the recursive versions, where garbage collection finds them.
+ *
+ * Since nothing is left on the C stack between two steps, the loop can
+ * stop cleanly. When a reordering is due, the operation is abandoned and
+ * redone by its caller without the long jump through bddexception, and
+ * when it has built its budget of nodes the budget handler decides
+ * whether it goes on or is aborted.
+ */
+
+   /* Initial number of pending calls on the stack */
+#define ITERSTACKSIZE 1024
+
+   /* Justification of the results that need no proof */
+#if ENABLE_TBDD
+#define ITER_NOCLAUSE TAUTOLOGY
+#else
+#define ITER_NOCLAUSE 0
+#endif
+
+typedef struct s_IterFrame /* A pending call */
+{
+   short kind;     /* ITER_APPLY, ITER_QUANT or ITER_APPLYJ */
+   short state;    /* Number of sub results computed so far */
+   int op;         /* Operator of apply */
+   BDD a, b;       /* Operands, only a for quantification */
+   int level;      /* Level of the node to build */
+   int flip;       /* Complement the result */
+#if ENABLE_TBDD
+   clause_id_t clauses;  /* Clause count when the call started */
+   clause_id_t lclause;  /* Justification of the low result */
+#endif
+} IterFrame;
+
+
+
+static void bdd_iter_push(int kind, int op, BDD a, BDD b)
+{
+   IterFrame *f;
+
+   if (itertop == itersize)
+   {
+      int newsize = itersize == 0 ? ITERSTACKSIZE : 2*itersize;
+      IterFrame *newstack = (IterFrame*)realloc(iterstack,
+						sizeof(IterFrame)*newsize);
+      if (newstack == NULL)
+      {
+	 bdd_error(BDD_MEMORY);
+	 return;
+      }
+      iterstack = newstack;
+      itersize = newsize;
+   }
+
+   f = &iterstack[itertop++];
+   f->kind = kind;
+   f->state = 0;
+   f->op = op;
+   f->a = a;
+   f->b = b;
+   f->flip = 0;
+}
+
+
+   /* Finish the call on top of the stack with the result res */
+static ALWAYS_INLINE void bdd_iter_return(BDD res, clause_id_t clause)
+{
+#if ENABLE_COMPLEMENT
+   if (iterstack[itertop-1].flip)
+      res = COMPLEMENT(res);
+#endif
+   itertop--;
+   PUSHREF(res);
+   iterclause = clause;
+}
+
+
+   /* The operands of the low or high sub call, split at level */
+#define ITERLOW(x, level)  (LEVEL(x) == (level) ? LOW(x) : (x))
+#define ITERHIGH(x, level) (LEVEL(x) == (level) ? HIGH(x) : (x))
+
+
+static void bdd_iter_apply(IterFrame *f)
+{
+   BddCacheData *entry;
+   BDD l = f->a, r = f->b, res;
+
+   switch (f->state)
+   {
+   case 0:
+      if ((res = apply_terminal(l, r, f->op)) >= 0)
+      {
+	 bdd_iter_return(res, ITER_NOCLAUSE);
+	 return;
+      }
+#if ENABLE_COMPLEMENT
+	 /* Only cache xor of regular operands */
+      if (f->op == bddop_xor  &&  (ISCOMPL(l)  ||  ISCOMPL(r)))
+      {
+	 f->flip ^= ISCOMPL(l) != ISCOMPL(r);
+	 f->a = REGULAR(l);
+	 f->b = REGULAR(r);
+	 return;
+      }
+#endif
+      entry = BddCache_find(&applycache, APPLYHASH(l,r,f->op), l, r, f->op);
+      if (entry != NULL)
+      {
+#ifdef CACHESTATS
+	 bddcachestats.opHit++;
+#endif
+	 bdd_iter_return(entry->res, ITER_NOCLAUSE);
+	 return;
+      }
+#ifdef CACHESTATS
+      bddcachestats.opMiss++;
+#endif
+      this_apply_counter++;
+      f->level = MIN(LEVEL(l), LEVEL(r));
+      f->state = 1;
+      bdd_iter_push(ITER_APPLY, f->op, ITERLOW(l, f->level),
+		    ITERLOW(r, f->level));
+      return;
+
+   case 1:
+      f->state = 2;
+      bdd_iter_push(ITER_APPLY, f->op, ITERHIGH(l, f->level),
+		    ITERHIGH(r, f->level));
+      return;
+
+   default:
+      res = bdd_makenode(f->level, READREF(2), READREF(1));
+      POPREF(2);
+      entry = BddCache_insert(&applycache, APPLYHASH(l,r,f->op), l, r, f->op);
+      entry->res = res;
+      bdd_iter_return(res, ITER_NOCLAUSE);
+   }
+}
+
+
+static void bdd_iter_quant(IterFrame *f)
+{
+   BddCacheData *entry;
+   BDD r = f->a, res;
+
+   switch (f->state)
+   {
+   case 0:
+      if (r < 2  ||  LEVEL(r) > quantlast)
+      {
+	 bdd_iter_return(r, ITER_NOCLAUSE);
+	 return;
+      }
+      entry = BddCache_find(&quantcache, QUANTHASH(r), r, -1, quantid);
+      if (entry != NULL)
+      {
+#ifdef CACHESTATS
+	 bddcachestats.opHit++;
+#endif
+	 bdd_iter_return(entry->res, ITER_NOCLAUSE);
+	 return;
+      }
+#ifdef CACHESTATS
+      bddcachestats.opMiss++;
+#endif
+      this_apply_counter++;
+      f->state = 1;
+      bdd_iter_push(ITER_QUANT, 0, LOW(r), 0);
+      return;
+
+   case 1:
+      f->state = 2;
+      bdd_iter_push(ITER_QUANT, 0, HIGH(r), 0);
+      return;
+
+   case 2:
+      if (INVARSET(LEVEL(r)))
+      {
+	    /* Combine the sub results, which stay below the result */
+	 f->state = 3;
+	 bdd_iter_push(ITER_APPLY, applyop, READREF(2), READREF(1));
+	 return;
+      }
+      res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
+      POPREF(2);
+      break;
+
+   default:
+      res = READREF(1);
+      POPREF(3);
+   }
+
+   entry = BddCache_insert(&quantcache, QUANTHASH(r), r, -1, quantid);
+   entry->res = res;
+   bdd_iter_return(res, ITER_NOCLAUSE);
+}
+
+
+#if ENABLE_TBDD
+static void bdd_iter_applyj(IterFrame *f)
+{
+   BddCacheDataJ *entry;
+   BDD l = f->a, r = f->b, root;
+   pcbdd tresl, tresh;
+   int op = f->op, clause;
+
+   switch (f->state)
+   {
+   case 0:
+      root = -1;
+      if (op == bddop_andj)
+      {
+	 if (l == r)
+	    root = l;
+	 else if (ISZERO(l)  ||  ISZERO(r))
+	    root = 0;
+	 else if (ISONE(l))
+	    root = r;
+	 else if (ISONE(r))
+	    root = l;
+#if ENABLE_COMPLEMENT
+	 else if (l == COMPLEMENT(r))
+	    root = 0;
+#endif
+      }
+      else
+      {
+	 if (l == r  ||  ISZERO(l)  ||  ISONE(r))
+	    root = BDDONE;
+	 else if (ISONE(l)  ||  ISZERO(r))
+	 {
+	       /* Implication cannot hold for all arguments */
+	    fprintf(ERROUT, "Implication failure.  N%" PRIcid " -/-> N%" PRIcid "\n",
+		    bdd_nameid(l), bdd_nameid(r));
+	    bdd_error(TBDD_PROOF);
+	    root = BDDZERO;
+	 }
+      }
+      if (root >= 0)
+      {
+#if ENABLE_BTRACE
+	 if (bdd_trace_file) {
+	    if (op == bddop_andj)
+	       fprintf(bdd_trace_file, "a %" PRIbdd " %" PRIbdd " %" PRIbdd "\n", root, l, r);
+	    else
+	       fprintf(bdd_trace_file, "i %" PRIbdd " %" PRIbdd "\n", r, l);
+	 }
+#endif
+	 bdd_iter_return(root, TAUTOLOGY);
+	 return;
+      }
+
+      entry = BddCache_findj(&jcache, JHASH(l,r,JKEY(op)), l, r, JKEY(op));
+      if (entry != NULL)
+      {
+#ifdef CACHESTATS
+	 bddcachestats.opHit++;
+#endif
+	 bdd_iter_return(entry->res, entry->jclause);
+	 return;
+      }
+#ifdef CACHESTATS
+      bddcachestats.opMiss++;
+#endif
+      this_apply_counter++;
+      f->clauses = total_clause_count;
+      f->level = MIN(LEVEL(l), LEVEL(r));
+      f->state = 1;
+      bdd_iter_push(ITER_APPLYJ, op, ITERLOW(l, f->level),
+		    ITERLOW(r, f->level));
+      return;
+
+   case 1:
+      f->lclause = iterclause;
+      f->state = 2;
+      bdd_iter_push(ITER_APPLYJ, op, ITERHIGH(l, f->level),
+		    ITERHIGH(r, f->level));
+      return;
+
+   default:
+      tresl.root = READREF(2);
+      tresl.clause_id = f->lclause;
+      tresh.root = READREF(1);
+      tresh.clause_id = iterclause;
+      if (op == bddop_imptstj)
+	 root = ISONE(tresl.root) && ISONE(tresh.root) ? BDDONE : BDDZERO;
+      else
+	 root = bdd_makenode(f->level, tresl.root, tresh.root);
+      clause = justify_apply(op, l, r, bdd_level2var(f->level),
+			     tresl, tresh, root);
+      POPREF(2);
+
+      entry = BddCache_insertj(&jcache, JHASH(l,r,JKEY(op)), l, r, JKEY(op),
+			       (int)(total_clause_count - f->clauses));
+      entry->res = root;
+      entry->jclause = clause;
+#if ENABLE_BTRACE
+      if (bdd_trace_file) {
+	 if (op == bddop_andj)
+	    fprintf(bdd_trace_file, "a %" PRIbdd " %" PRIbdd " %" PRIbdd "\n", root, l, r);
+	 else
+	    fprintf(bdd_trace_file, "i %" PRIbdd " %" PRIbdd "\n", r, l);
+      }
+#endif
+      bdd_iter_return(root, clause);
+   }
+}
+#endif /* ENABLE_TBDD */
+
+
+static void bdd_iter_done(void)
+{
+   free(iterstack);
+   iterstack = NULL;
+   itersize = itertop = 0;
+}
+
+
+   /* Run the operation of the given kind on a and b to completion. The
+      result is negative if the operation stopped for reordering, in
+      which case the caller must reorder and start it again. */
+static BDD bdd_iter_run(int kind, int op, BDD a, BDD b)
+{
+   int *refbase = bddrefstacktop;
+   long int budgetmark = bddproduced;
+   long int start = bddproduced;
+   BDD res;
+
+   itertop = 0;
+   iterclause = ITER_NOCLAUSE;
+   bdditerreorder = 0;
+   bdd_iter_push(kind, op, a, b);
+   bdditerstop = 1;
+
+   while (itertop > 0)
+   {
+      IterFrame *f = &iterstack[itertop-1];
+
+      if (bdditerreorder)
+	 break;
+
+      if (nodebudget > 0  &&  bddproduced - budgetmark >= nodebudget)
+      {
+	 if (budget_handler == NULL  ||
+	     budget_handler((int)(bddproduced - start)) != 0)
+	 {
+	    itertop = 0;
+	    bddrefstacktop = refbase;
+	    bdditerstop = 0;
+	    iterclause = ITER_NOCLAUSE;
+	    bdd_error(BDD_BREAK);
+	    return BDDZERO;
+	 }
+	 budgetmark = bddproduced;
+      }
+
+      switch (f->kind)
+      {
+      case ITER_APPLY:
+	 bdd_iter_apply(f);
+	 break;
+      case ITER_QUANT:
+	 bdd_iter_quant(f);
+	 break;
+#if ENABLE_TBDD
+      case ITER_APPLYJ:
+	 bdd_iter_applyj(f);
+	 break;
+#endif
+      }
+   }
+
+   bdditerstop = 0;
+   if (itertop > 0)
+   {
+      itertop = 0;
+      bddrefstacktop = refbase;
+      iterclause = ITER_NOCLAUSE;
+      return -1;
+   }
+
+   res = READREF(1);
+   POPREF(1);
+   return res;
+}
+
+#endif /* ENABLE_ITERAPPLY */
+
+
+#if ENABLE_PARAPPLY
+
+/*=== MULTI-THREADED APPLY =============================================*/
+
+/* Apply and quantification can be run by a pool of threads in the style
+ * of Sylvan. Each recursive call spawns the call for the high branches
+ * as a task on the deque of the running thread, computes the low branches
+ * itself and then takes the task back, unless another thread has stolen
+ * it in the meantime. Threads waiting for a stolen task help by stealing
+ * work themselves. Nodes are built with bdd_makenode_par() and the
+ * operator cache is shared without locking the whole table: each entry
+ * is guarded by a sequence lock, and an entry whose lock is taken is
+ * simply treated as a miss.
+ *
+ * No garbage collection can happen while the threads run. If the node
+ * table fills up, the operation is abandoned and redone sequentially,
+ * which collects garbage and resizes as usual.
+ */
+
+static void par_lock(int *lock)
+{
+   while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE))
+      while (__atomic_load_n(lock, __ATOMIC_RELAXED))
+	 ;
+}
+
+
+static void par_unlock(int *lock)
+{
+   __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+
+
+   /* The entries that may hold the key, and the lock word guarding them */
+static BddCacheData *par_cache_set(BddCache *cache, unsigned int hash,
+				   BDD a, BDD b, BDD c, unsigned int **lock)
+{
+   unsigned int idx = BddCache_index(cache, hash, a, b, c, 0);
+
+   *lock = &parcachelock[idx % PARCACHELOCKS];
+   return (BddCacheData*)cache->table + idx;
+}
+
+#if ENABLE_ASSOCCACHE
+#define PARCACHEWAYS BDDCACHE_WAYS
+#else
+#define PARCACHEWAYS 1
+#endif
+
+
+static int par_cache_lookup(BddCache *cache, unsigned int hash,
+			    BDD a, BDD b, BDD c, BDD *res)
+{
+   unsigned int *lock;
+   BddCacheData *set = par_cache_set(cache, hash, a, b, c, &lock);
+   unsigned int seq;
+   int n, hit = 0;
+
+   seq = __atomic_load_n(lock, __ATOMIC_ACQUIRE);
+   if (seq & 1)
+      return 0;
+
+   for (n=0 ; n<PARCACHEWAYS  &&  !hit ; n++)
+   {
+      BddCacheData *entry = &set[n];
+      hit = __atomic_load_n(&entry->a, __ATOMIC_RELAXED) == a  &&
+	 __atomic_load_n(&entry->b, __ATOMIC_RELAXED) == b  &&
+	 __atomic_load_n(&entry->c, __ATOMIC_RELAXED) == c;
+      *res = __atomic_load_n(&entry->res, __ATOMIC_RELAXED);
+#if ENABLE_GENGC
+	 /* Check the nodes of an old entry without taking it over */
+      if (hit)
+      {
+	 unsigned int epoch = __atomic_load_n(&entry->epoch, __ATOMIC_RELAXED);
+	 hit = epoch == bddgcepoch  ||
+	    (BDDCACHE_ALIVE(a, epoch)  &&  BDDCACHE_ALIVE(b, epoch)  &&
+	     BDDCACHE_ALIVE(*res, epoch));
+      }
+#endif
+   }
+
+   __atomic_thread_fence(__ATOMIC_ACQUIRE);
+   return hit  &&  __atomic_load_n(lock, __ATOMIC_RELAXED) == seq;
+}
+
+
+static void par_cache_store(BddCacheData *entry, BDD a, BDD b, BDD c, BDD res)
+{
+   __atomic_store_n(&entry->a, a, __ATOMIC_RELAXED);
+   __atomic_store_n(&entry->b, b, __ATOMIC_RELAXED);
+   __atomic_store_n(&entry->c, c, __ATOMIC_RELAXED);
+   __atomic_store_n(&entry->res, res, __ATOMIC_RELAXED);
+#if ENABLE_GENGC
+   __atomic_store_n(&entry->epoch, bddgcepoch, __ATOMIC_RELAXED);
+#endif
+}
+
+
+static void par_cache_insert(BddCache *cache, unsigned int hash,
+			     BDD a, BDD b, BDD c, BDD res)
+{
+   unsigned int *lock;
+   BddCacheData *set = par_cache_set(cache, hash, a, b, c, &lock);
+   unsigned int seq = __atomic_load_n(lock, __ATOMIC_RELAXED);
+#if ENABLE_ASSOCCACHE
+   int n;
+#endif
+
+      /* Give up if another thread is writing to the same lock word */
+   if ((seq & 1)  ||
+       !__atomic_compare_exchange_n(lock, &seq, seq+1, 0,
+				    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      return;
+
+#if ENABLE_ASSOCCACHE
+      /* New entries go in front, as in BddCache_insert() */
+   for (n=BDDCACHE_WAYS-1 ; n>0 ; n--)
    {
-      PUSHREF( apply_rec(LOW(d), HIGH(d)) ); /* Exist quant */
-      res = simplify_rec(f, READREF(1));
-      POPREF(1);
+      par_cache_store(&set[n], set[n-1].a, set[n-1].b, set[n-1].c,
+		      set[n-1].res);
+#if ENABLE_GENGC
+      __atomic_store_n(&set[n].epoch, set[n-1].epoch, __ATOMIC_RELAXED);
+#endif
    }
-
-#if ENABLE_TBDD
-      BddCache_clause_evict(entry);
 #endif
+   par_cache_store(set, a, b, c, res);
+
+   __atomic_store_n(lock, seq+2, __ATOMIC_RELEASE);
+}
 
-   entry->a = f;
-   entry->b = d;
-   entry->c = -1;
-   entry->op = bddop_simplify;
-   entry->r.res = res;
 
-   return res;
+static BDD par_apply_rec(ParWorker*, BDD, BDD);
+static BDD par_quant_rec(ParWorker*, BDD);
+
+static BDD par_run(ParWorker *w, ParTask *t)
+{
+   if (t->op == PARTASK_APPLY)
+      return par_apply_rec(w, t->a, t->b);
+   return par_quant_rec(w, t->a);
 }
 
 
-/*=== QUANTIFICATION ===================================================*/
+static ParTask *par_spawn(ParWorker *w, int op, BDD a, BDD b)
+{
+   ParTask *t;
 
-/*
-NAME    {* bdd\_exist *}
-SECTION {* operator *}
-SHORT   {* existential quantification of variables *}
-PROTO   {* BDD bdd_exist(BDD r, BDD var) *}
-DESCR   {* Removes all occurences in {\tt r} of variables in the set
-           {\tt var} by existential quantification. *}
-ALSO    {* bdd\_forall, bdd\_unique, bdd\_makeset *}
-RETURN  {* The quantified BDD. *}
-*/
-BDD bdd_exist(BDD r, BDD var)
+   if (w->bottom == PARDEQUESIZE)
+      return NULL;
+
+   t = &w->deque[w->bottom];
+   t->op = op;
+   t->a = a;
+   t->b = b;
+   t->done = 0;
+
+   par_lock(&w->lock);
+   __atomic_store_n(&w->bottom, w->bottom+1, __ATOMIC_RELAXED);
+   par_unlock(&w->lock);
+
+      /* Only wake the pool when the operation turns out to be large */
+   if (w == parworker  &&  ++parspawns == PARWAKESPAWNS  &&
+       __atomic_load_n(&parsleeping, __ATOMIC_RELAXED) > 0)
+   {
+      pthread_mutex_lock(&parmutex);
+      pthread_cond_broadcast(&parcond);
+      pthread_mutex_unlock(&parmutex);
+   }
+
+   return t;
+}
+
+
+   /* Run one task stolen from a random thread. Returns 0 if none found */
+static int par_steal(ParWorker *w)
 {
-   BDD res;
-   firstReorder = 1;
-   this_apply_counter = 0;
+   ParWorker *v;
+   ParTask *t = NULL;
 
-   CHECKa(r, bddfalse);
-   CHECKa(var, bddfalse);
+   w->seed = w->seed * 1103515245 + 12345;
+   v = &parworker[(w->seed >> 16) % parstarted];
 
-   if (var < 2)  /* Empty set */
-      return r;
+   if (v == w  ||
+       __atomic_load_n(&v->top, __ATOMIC_RELAXED) >=
+       __atomic_load_n(&v->bottom, __ATOMIC_RELAXED))
+      return 0;
 
- again:
-   if (setjmp(bddexception) == 0)
+   par_lock(&v->lock);
+   if (v->top < v->bottom)
    {
-      if (varset2vartable(var) < 0)
-	 return bddfalse;
+      t = &v->deque[v->top];
+      __atomic_store_n(&v->top, v->top+1, __ATOMIC_RELAXED);
+   }
+   par_unlock(&v->lock);
 
-      INITREF;
-      quantid = (var << 3) | CACHEID_EXIST; /* FIXME: range */
-      applyop = bddop_or;
+   if (t == NULL)
+      return 0;
 
-      if (!firstReorder)
-	 bdd_disable_reorder();
-      res = quant_rec(r);
-      if (!firstReorder)
-	 bdd_enable_reorder();
+   t->res = par_run(w, t);
+   __atomic_store_n(&t->done, 1, __ATOMIC_RELEASE);
+   return 1;
+}
+
+
+   /* Get the result of the last task spawned by this thread */
+static BDD par_sync(ParWorker *w, ParTask *t)
+{
+   par_lock(&w->lock);
+   if (w->top < w->bottom)
+   {
+      __atomic_store_n(&w->bottom, w->bottom-1, __ATOMIC_RELAXED);
+      par_unlock(&w->lock);
+      return par_run(w, t);
    }
-   else
+   par_unlock(&w->lock);
+
+      /* Stolen, so everything older than it has been stolen too. The slot
+	 stays in use until the thief is done, tasks spawned meanwhile go
+	 above it. */
+   while (!__atomic_load_n(&t->done, __ATOMIC_ACQUIRE))
+      par_steal(w);
+
+   par_lock(&w->lock);
+   __atomic_store_n(&w->bottom, w->bottom-1, __ATOMIC_RELAXED);
+   __atomic_store_n(&w->top, w->bottom, __ATOMIC_RELAXED);
+   par_unlock(&w->lock);
+
+   return t->res;
+}
+
+
+static void *par_thread(void *arg)
+{
+   ParWorker *w = (ParWorker*)arg;
+
+#if ENABLE_REENTRANT
+   bddmanager = w->manager;
+#endif
+   pthread_mutex_lock(&parmutex);
+   while (!parquit)
    {
-      bdd_checkreorder();
+      if (!__atomic_load_n(&paractive, __ATOMIC_ACQUIRE))
+      {
+	 __atomic_add_fetch(&parsleeping, 1, __ATOMIC_RELAXED);
+	 pthread_cond_wait(&parcond, &parmutex);
+	 __atomic_sub_fetch(&parsleeping, 1, __ATOMIC_RELAXED);
+	 continue;
+      }
+      pthread_mutex_unlock(&parmutex);
 
-      if (firstReorder-- == 1)
-	 goto again;
-      res = BDDZERO;  /* avoid warning about res being uninitialized */
+      while (__atomic_load_n(&paractive, __ATOMIC_ACQUIRE))
+	 if (!par_steal(w))
+	    sched_yield();
+
+      pthread_mutex_lock(&parmutex);
    }
+   pthread_mutex_unlock(&parmutex);
 
-   checkresize();
-   return res;
+   return NULL;
 }
 
 
-/*
-NAME    {* bdd\_forall *}
-SECTION {* operator *}
-SHORT   {* universal quantification of variables *}
-PROTO   {* BDD bdd_forall(BDD r, BDD var) *}
-DESCR   {* Removes all occurences in {\tt r} of variables in the set
-           {\tt var} by universal quantification. *}
-ALSO    {* bdd\_exist, bdd\_unique, bdd\_makeset *}
-RETURN  {* The quantified BDD. *}
-*/
-BDD bdd_forall(BDD r, BDD var)
+static void bdd_par_stop(void)
 {
-   BDD res;
-   firstReorder = 1;
-   this_apply_counter = 0;
-
-   CHECKa(r, bddfalse);
-   CHECKa(var, bddfalse);
+   int n;
 
-   if (var < 2)  /* Empty set */
-      return r;
+   pthread_mutex_lock(&parmutex);
+   parquit = 1;
+   pthread_cond_broadcast(&parcond);
+   pthread_mutex_unlock(&parmutex);
 
- again:
-   if (setjmp(bddexception) == 0)
+   for (n=1 ; n<parstarted ; n++)
+      pthread_join(parworker[n].thread, NULL);
+   for (n=0 ; n<parstarted ; n++)
    {
-      if (varset2vartable(var) < 0)
-	 return bddfalse;
+      free(parworker[n].deque);
+      parworker[n].deque = NULL;
+   }
 
-      INITREF;
-      quantid = (var << 3) | CACHEID_FORALL;
-      applyop = bddop_and;
+   parquit = 0;
+   parstarted = 0;
+}
 
-      if (!firstReorder)
-	 bdd_disable_reorder();
-      res = quant_rec(r);
-      if (!firstReorder)
-	 bdd_enable_reorder();
-   }
-   else
+
+   /* Prepare a parallel operation. Returns -1 if it cannot be done */
+static int par_begin(void)
+{
+   int n;
+
+   if (parthreads < 2  ||  bdderrorcond)
+      return -1;
+#if ENABLE_TBDD
+   if (proof_type != PROOF_NONE)
+      return -1;
+#endif
+#if ENABLE_BTRACE
+   if (bdd_trace_file)
+      return -1;
+#endif
+
+   if (parstarted == 0)
    {
-      bdd_checkreorder();
+      for (n=0 ; n<parthreads ; n++)
+      {
+	 ParWorker *w = &parworker[n];
 
-      if (firstReorder-- == 1)
-	 goto again;
-      res = BDDZERO;  /* avoid warning about res being uninitialized */
+	 memset(w, 0, sizeof(ParWorker));
+	 w->seed = n+1;
+#if ENABLE_REENTRANT
+	 w->manager = bddmanager;
+#endif
+	 if ((w->deque=NEW(ParTask,PARDEQUESIZE)) == NULL)
+	    break;
+	 parstarted = n+1;
+	 if (n > 0  &&  pthread_create(&w->thread, NULL, par_thread, w) != 0)
+	 {
+	    free(w->deque);
+	    w->deque = NULL;
+	    parstarted = n;
+	    break;
+	 }
+      }
+
+      if (parstarted < 2)
+      {
+	 bdd_par_stop();
+	 return -1;
+      }
    }
 
-   checkresize();
-   return res;
+   parabort = 0;
+   parspawns = 0;
+   __atomic_store_n(&paractive, 1, __ATOMIC_RELEASE);
+   return 0;
 }
 
 
-/*
-NAME    {* bdd\_unique *}
-SECTION {* operator *}
-SHORT   {* unique quantification of variables *}
-PROTO   {* BDD bdd_unique(BDD r, BDD var) *}
-DESCR   {* Removes all occurences in {\tt r} of variables in the set
-           {\tt var} by unique quantification. This type of quantification
-	   uses a XOR operator instead of an OR operator as in the
-	   existential quantification, and an AND operator as in the
-	   universal quantification. *}
-ALSO    {* bdd\_exist, bdd\_forall, bdd\_makeset *}
-RETURN  {* The quantified BDD. *}
-*/
-BDD bdd_unique(BDD r, BDD var)
+static BDD par_end(BDD res)
+{
+   int n;
+
+   __atomic_store_n(&paractive, 0, __ATOMIC_RELEASE);
+
+      /* All tasks have been synced, so the batches are no longer in use */
+   for (n=0 ; n<parstarted ; n++)
+      bdd_nodebatch_done(&parworker[n].nodes);
+
+   return parabort ? -1 : res;
+}
+
+
+static BDD par_makenode(ParWorker *w, unsigned int level, BDD low, BDD high)
 {
    BDD res;
-   firstReorder = 1;
-   this_apply_counter = 0;
 
-   CHECKa(r, bddfalse);
-   CHECKa(var, bddfalse);
+   if (__atomic_load_n(&parabort, __ATOMIC_RELAXED))
+      return 0;
+   if ((res=bdd_makenode_par(&w->nodes, level, low, high)) < 0)
+   {
+      __atomic_store_n(&parabort, 1, __ATOMIC_RELAXED);
+      return 0;
+   }
+   return res;
+}
 
-   if (var < 2)  /* Empty set */
-      return r;
 
- again:
-   if (setjmp(bddexception) == 0)
+static BDD par_apply_rec(ParWorker *w, BDD l, BDD r)
+{
+   ParTask *t;
+   unsigned int level, hash;
+   BDD res, ll, lh, rl, rh, lo, hi;
+
+   if ((res = apply_terminal(l, r, applyop)) >= 0)
+      return res;
+   if (__atomic_load_n(&parabort, __ATOMIC_RELAXED))
+      return 0;
+
+#if ENABLE_COMPLEMENT
+   if (applyop == bddop_xor  &&  (ISCOMPL(l)  ||  ISCOMPL(r)))
    {
-      if (varset2vartable(var) < 0)
-	 return bddfalse;
+      res = par_apply_rec(w, REGULAR(l), REGULAR(r));
+      return ISCOMPL(l) == ISCOMPL(r) ? res : COMPLEMENT(res);
+   }
+#endif
 
-      INITREF;
-      quantid = (var << 3) | CACHEID_UNIQUE;
-      applyop = bddop_xor;
+   hash = APPLYHASH(l,r,applyop);
+   if (par_cache_lookup(&applycache, hash, l, r, applyop, &res))
+      return res;
 
-      if (!firstReorder)
-	 bdd_disable_reorder();
-      res = quant_rec(r);
-      if (!firstReorder)
-	 bdd_enable_reorder();
+   if (LEVEL(l) == LEVEL(r))
+   {
+      level = LEVEL(l);
+      ll = LOW(l);  lh = HIGH(l);
+      rl = LOW(r);  rh = HIGH(r);
    }
    else
+   if (LEVEL(l) < LEVEL(r))
    {
-      bdd_checkreorder();
-
-      if (firstReorder-- == 1)
-	 goto again;
-      res = BDDZERO;  /* avoid warning about res being uninitialized */
+      level = LEVEL(l);
+      ll = LOW(l);  lh = HIGH(l);
+      rl = rh = r;
+   }
+   else
+   {
+      level = LEVEL(r);
+      ll = lh = l;
+      rl = LOW(r);  rh = HIGH(r);
    }
 
-   checkresize();
+   t = par_spawn(w, PARTASK_APPLY, lh, rh);
+   lo = par_apply_rec(w, ll, rl);
+   hi = t != NULL ? par_sync(w, t) : par_apply_rec(w, lh, rh);
+
+   res = par_makenode(w, level, lo, hi);
+   if (!__atomic_load_n(&parabort, __ATOMIC_RELAXED))
+      par_cache_insert(&applycache, hash, l, r, applyop, res);
    return res;
 }
 
 
-static int quant_rec(int r)
+static BDD par_quant_rec(ParWorker *w, BDD r)
 {
-   BddCacheData *entry;
-   int res;
+   ParTask *t;
+   BDD res, lo, hi;
 
    if (r < 2  ||  LEVEL(r) > quantlast)
       return r;
+   if (__atomic_load_n(&parabort, __ATOMIC_RELAXED))
+      return 0;
 
-   entry = BddCache_lookup(&opcache, QUANTHASH(r));
-   if (entry->a == r  &&  entry->c == quantid && entry->op == bddop_quant)
-   {
-#ifdef CACHESTATS
-      bddcachestats.opHit++;
-#endif
-      return entry->r.res;
-   }
-#ifdef CACHESTATS
-   bddcachestats.opMiss++;
-#endif
+   if (par_cache_lookup(&quantcache, QUANTHASH(r), r, -1, quantid, &res))
+      return res;
 
-   this_apply_counter++;
-   if (0 && this_apply_counter % THIS_APPLY_REPORT == 0) {
-       fprintf(stdout, "Current apply operation has %d recursive calls\n", this_apply_counter);
-   }
+   t = par_spawn(w, PARTASK_QUANT, HIGH(r), 0);
+   lo = par_quant_rec(w, LOW(r));
+   hi = t != NULL ? par_sync(w, t) : par_quant_rec(w, HIGH(r));
 
-   PUSHREF( quant_rec(LOW(r)) );
-   PUSHREF( quant_rec(HIGH(r)) );
+   if (__atomic_load_n(&parabort, __ATOMIC_RELAXED))
+      return 0;
 
    if (INVARSET(LEVEL(r)))
-      res = apply_rec(READREF(2), READREF(1));
+      res = par_apply_rec(w, lo, hi);
    else
-      res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
+      res = par_makenode(w, LEVEL(r), lo, hi);
 
-   POPREF(2);
+   if (!__atomic_load_n(&parabort, __ATOMIC_RELAXED))
+      par_cache_insert(&quantcache, QUANTHASH(r), r, -1, quantid, res);
+   return res;
+}
 
-#if ENABLE_TBDD
-      BddCache_clause_evict(entry);
-#endif
 
-   entry->a = r;
-   entry->b = -1;
-   entry->c = quantid;
-   entry->op = bddop_quant;
-   entry->r.res = res;
+   /* Apply with the current operator, or -1 if done sequentially */
+static BDD bdd_par_apply(BDD l, BDD r)
+{
+   if (par_begin() < 0)
+      return -1;
+   return par_end(par_apply_rec(parworker, l, r));
+}
+
 
-   return res;
+   /* Quantification with the current variable set, or -1 */
+static BDD bdd_par_quant(BDD r)
+{
+   if (par_begin() < 0)
+      return -1;
+   return par_end(par_quant_rec(parworker, r));
 }
 
+#endif /* ENABLE_PARAPPLY */
+
 
 /*=== APPLY & QUANTIFY =================================================*/
 
@@ -2593,10 +4574,10 @@ BDD bdd_appuni(BDD l, BDD r, int opr, BDD var)
 }
 
 
-static int appquant_rec(int l, int r)
+static BDD appquant_rec(BDD l, BDD r)
 {
    BddCacheData *entry;
-   int res;
+   BDD res;
 
    switch (appexop)
    {
@@ -2643,20 +4624,17 @@ static int appquant_rec(int l, int r)
    else
    if (LEVEL(l) > quantlast  &&  LEVEL(r) > quantlast)
    {
-      int oldop = applyop;
-      applyop = appexop;
-      res = apply_rec(l,r);
-      applyop = oldop;
+      res = apply_rec(l, r, appexop);
    }
    else
    {
-      entry = BddCache_lookup(&opcache, APPEXHASH(l,r,appexop));
-      if (entry->a == l  &&  entry->b == r  &&  entry->c == appexid && entry->op == bddop_appex)
+      entry = BddCache_find(&quantcache, APPEXHASH(l,r,appexop), l, r, appexid);
+      if (entry != NULL)
       {
 #ifdef CACHESTATS
 	 bddcachestats.opHit++;
 #endif
-	 return entry->r.res;
+	 return entry->res;
       }
 #ifdef CACHESTATS
       bddcachestats.opMiss++;
@@ -2672,7 +4650,7 @@ static int appquant_rec(int l, int r)
 	 PUSHREF( appquant_rec(LOW(l), LOW(r)) );
 	 PUSHREF( appquant_rec(HIGH(l), HIGH(r)) );
 	 if (INVARSET(LEVEL(l)))
-	    res = apply_rec(READREF(2), READREF(1));
+	    res = apply_rec(READREF(2), READREF(1), applyop);
 	 else
 	    res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
       }
@@ -2682,7 +4660,7 @@ static int appquant_rec(int l, int r)
 	 PUSHREF( appquant_rec(LOW(l), r) );
 	 PUSHREF( appquant_rec(HIGH(l), r) );
 	 if (INVARSET(LEVEL(l)))
-	    res = apply_rec(READREF(2), READREF(1));
+	    res = apply_rec(READREF(2), READREF(1), applyop);
 	 else
 	    res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
       }
@@ -2691,22 +4669,15 @@ static int appquant_rec(int l, int r)
 	 PUSHREF( appquant_rec(l, LOW(r)) );
 	 PUSHREF( appquant_rec(l, HIGH(r)) );
 	 if (INVARSET(LEVEL(r)))
-	    res = apply_rec(READREF(2), READREF(1));
+	    res = apply_rec(READREF(2), READREF(1), applyop);
 	 else
 	    res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
       }
 
       POPREF(2);
 
-#if ENABLE_TBDD
-      BddCache_clause_evict(entry);
-#endif
-
-      entry->a = l;
-      entry->b = r;
-      entry->c = appexid;
-      entry->op = bddop_appex;
-      entry->r.res = res;
+      entry = BddCache_insert(&quantcache, APPEXHASH(l,r,appexop), l, r, appexid);
+      entry->res = res;
    }
 
    return res;
@@ -2732,7 +4703,7 @@ RETURN  {* A BDD variable set. *}
 BDD bdd_support(BDD r)
 {
    int n;
-   int res=1;
+   BDD res=1;
 
    CHECKa(r, bddfalse);
 
@@ -2790,14 +4761,14 @@ BDD bdd_support(BDD r)
 }
 
 
-static void support_rec(int r, int* support)
+static void support_rec(BDD r, int* support)
 {
    BddNode *node;
 
    if (r < 2)
       return;
 
-   node = &bddnodes[r];
+   node = &bddnodes[NODEIDX(r)];
    if (LEVELp(node) & MARKON  ||  LOWp(node) == -1)
       return;
 
@@ -2987,14 +4958,14 @@ BDD bdd_fullsatone(BDD r)
 }
 
 
-static int fullsatone_rec(int r)
+static BDD fullsatone_rec(BDD r)
 {
    if (r < 2)
       return r;
 
    if (LOW(r) != 0)
    {
-      int res = fullsatone_rec(LOW(r));
+      BDD res = fullsatone_rec(LOW(r));
       int v;
 
       for (v=LEVEL(LOW(r))-1 ; v>LEVEL(r) ; v--)
@@ -3006,7 +4977,7 @@ static int fullsatone_rec(int r)
    }
    else
    {
-      int res = fullsatone_rec(HIGH(r));
+      BDD res = fullsatone_rec(HIGH(r));
       int v;
 
       for (v=LEVEL(HIGH(r))-1 ; v>LEVEL(r) ; v--)
@@ -3166,39 +5137,30 @@ double bdd_satcountset(BDD r, BDD varset)
 }
 
 
-static double satcount_rec(int root)
+static double satcount_rec(BDD root)
 {
-   BddCacheData *entry;
-   BddNode *node;
+   BddCacheDataD *entry;
    double size, s;
 
    if (root < 2)
       return root;
 
-   entry = BddCache_lookup(&opcache, SATCOUHASH(root));
-   if (entry->a == root  &&  entry->c == miscid && entry->op == bddop_misc)
-      return entry->r.dres;
+   entry = BddCache_findd(&countcache, SATCOUHASH(root), root, miscid);
+   if (entry != NULL)
+      return entry->dres;
 
-   node = &bddnodes[root];
    size = 0;
    s = 1;
 
-   s *= pow(2.0, (float)(LEVEL(LOWp(node)) - LEVELp(node) - 1));
-   size += s * satcount_rec(LOWp(node));
+   s *= pow(2.0, (float)(LEVEL(LOW(root)) - LEVEL(root) - 1));
+   size += s * satcount_rec(LOW(root));
 
    s = 1;
-   s *= pow(2.0, (float)(LEVEL(HIGHp(node)) - LEVELp(node) - 1));
-   size += s * satcount_rec(HIGHp(node));
-
-#if ENABLE_TBDD
-      BddCache_clause_evict(entry);
-#endif
+   s *= pow(2.0, (float)(LEVEL(HIGH(root)) - LEVEL(root) - 1));
+   size += s * satcount_rec(HIGH(root));
 
-   entry->a = root;
-   entry->b = -1;
-   entry->c = miscid;
-   entry->op = bddop_misc;
-   entry->r.dres = size;
+   entry = BddCache_insertd(&countcache, SATCOUHASH(root), root, miscid);
+   entry->dres = size;
 
    return size;
 }
@@ -3256,10 +5218,9 @@ double bdd_satcountlnset(BDD r, BDD varset)
 }
 
 
-static double satcountln_rec(int root)
+static double satcountln_rec(BDD root)
 {
-   BddCacheData *entry;
-   BddNode *node;
+   BddCacheDataD *entry;
    double size, s1,s2;
 
    if (root == 0)
@@ -3267,19 +5228,17 @@ static double satcountln_rec(int root)
    if (root == 1)
       return 0.0;
 
-   entry = BddCache_lookup(&opcache, SATCOUHASH(root));
-   if (entry->a == root  &&  entry->c == miscid && entry->op == bddop_misc)
-      return entry->r.dres;
+   entry = BddCache_findd(&countcache, SATCOUHASH(root), root, miscid);
+   if (entry != NULL)
+      return entry->dres;
 
-   node = &bddnodes[root];
-
-   s1 = satcountln_rec(LOWp(node));
+   s1 = satcountln_rec(LOW(root));
    if (s1 >= 0.0)
-      s1 += LEVEL(LOWp(node)) - LEVELp(node) - 1;
+      s1 += LEVEL(LOW(root)) - LEVEL(root) - 1;
 
-   s2 = satcountln_rec(HIGHp(node));
+   s2 = satcountln_rec(HIGH(root));
    if (s2 >= 0.0)
-      s2 += LEVEL(HIGHp(node)) - LEVELp(node) - 1;
+      s2 += LEVEL(HIGH(root)) - LEVEL(root) - 1;
 
    if (s1 < 0.0)
       size = s2;
@@ -3290,15 +5249,8 @@ static double satcountln_rec(int root)
    else
       size = s1 + log1p(pow(2.0,s2-s1)) / M_LN2;
 
-#if ENABLE_TBDD
-      BddCache_clause_evict(entry);
-#endif
-
-   entry->a = root;
-   entry->b = -1;
-   entry->c = miscid;
-   entry->op = bddop_misc;
-   entry->r.dres = size;
+   entry = BddCache_insertd(&countcache, SATCOUHASH(root), root, miscid);
+   entry->dres = size;
 
    return size;
 }
@@ -3310,15 +5262,15 @@ static double satcountln_rec(int root)
 NAME    {* bdd\_nodecount *}
 SECTION {* info *}
 SHORT   {* counts the number of nodes used for a BDD *}
-PROTO   {* int bdd_nodecount(BDD r) *}
+PROTO   {* BDD bdd_nodecount(BDD r) *}
 DESCR   {* Traverses the BDD and counts all distinct nodes that are used
            for the BDD. *}
 RETURN  {* The number of nodes. *}
 ALSO    {* bdd\_pathcount, bdd\_satcount, bdd\_anodecount *}
 */
-int bdd_nodecount(BDD r)
+BDD bdd_nodecount(BDD r)
 {
-   int num=0;
+   BDD num=0;
 
    CHECK(r);
 
@@ -3333,7 +5285,7 @@ int bdd_nodecount(BDD r)
 NAME    {* bdd\_anodecount *}
 SECTION {* info *}
 SHORT   {* counts the number of shared nodes in an array of BDDs *}
-PROTO   {* int bdd_anodecount(BDD *r, int num) *}
+PROTO   {* BDD bdd_anodecount(BDD *r, int num) *}
 DESCR   {* Traverses all of the BDDs in {\tt r} and counts all distinct nodes
            that are used in the BDDs--if a node is used in more than one
 	   BDD then it only counts once. The {\tt num} parameter holds the
@@ -3341,10 +5293,10 @@ DESCR   {* Traverses all of the BDDs in {\tt r} and counts all distinct nodes
 RETURN  {* The number of nodes *}
 ALSO    {* bdd\_nodecount *}
 */
-int bdd_anodecount(BDD *r, int num)
+BDD bdd_anodecount(BDD *r, int num)
 {
    int n;
-   int cou=0;
+   BDD cou=0;
 
    for (n=0 ; n<num ; n++)
       bdd_markcount(r[n], &cou);
@@ -3388,14 +5340,14 @@ int *bdd_varprofile(BDD r)
 }
 
 
-static void varprofile_rec(int r)
+static void varprofile_rec(BDD r)
 {
    BddNode *node;
 
    if (r < 2)
       return;
 
-   node = &bddnodes[r];
+   node = &bddnodes[NODEIDX(r)];
    if (LEVELp(node) & MARKON)
       return;
 
@@ -3431,7 +5383,7 @@ double bdd_pathcount(BDD r)
 
 static double bdd_pathcount_rec(BDD r)
 {
-   BddCacheData *entry;
+   BddCacheDataD *entry;
    double size;
 
    if (ISZERO(r))
@@ -3439,21 +5391,14 @@ static double bdd_pathcount_rec(BDD r)
    if (ISONE(r))
       return 1.0;
 
-   entry = BddCache_lookup(&opcache, PATHCOUHASH(r));
-   if (entry->a == r  &&  entry->c == miscid && entry->op == bddop_misc)
-      return entry->r.dres;
+   entry = BddCache_findd(&countcache, PATHCOUHASH(r), r, miscid);
+   if (entry != NULL)
+      return entry->dres;
 
    size = bdd_pathcount_rec(LOW(r)) + bdd_pathcount_rec(HIGH(r));
 
-#if ENABLE_TBDD
-      BddCache_clause_evict(entry);
-#endif
-
-   entry->a = r;
-   entry->b = -1;
-   entry->c = miscid;
-   entry->op = bddop_misc;
-   entry->r.dres = size;
+   entry = BddCache_insertd(&countcache, PATHCOUHASH(r), r, miscid);
+   entry->dres = size;
 
    return size;
 }
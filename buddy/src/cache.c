@@ -73,23 +73,60 @@
 /*************************************************************************
 *************************************************************************/
 
-int BddCache_init(BddCache *cache, int size)
+#if ENABLE_ASSOCCACHE
+   /* Round the number of entries up to a power of two number of sets */
+static int BddCache_setsize(int size)
+{
+   int sets = 1;
+
+   while (sets < size / BDDCACHE_WAYS  &&  sets < INT_MAX / (2*BDDCACHE_WAYS))
+      sets <<= 1;
+   return sets * BDDCACHE_WAYS;
+}
+#endif
+
+
+   /* The key of all kinds of entries starts with a BDD, -1 when unused */
+#define ENTRY_KEY(cache,n) (*(BDD*)((char*)(cache)->table + (size_t)(n)*(cache)->entrysize))
+
+static int BddCache_alloc(BddCache *cache, int size)
 {
    int n;
 
+#if ENABLE_ASSOCCACHE
+   size = BddCache_setsize(size);
+#else
    size = bdd_prime_gte(size);
+#endif
    
-   if ((cache->table=NEW(BddCacheData,size)) == NULL)
+   if ((cache->table=calloc(size, cache->entrysize)) == NULL)
       return bdd_error(BDD_MEMORY);
    
-   for (n=0 ; n<size ; n++)
-      cache->table[n].a = -1;
    cache->tablesize = size;
+   for (n=0 ; n<size ; n++)
+      ENTRY_KEY(cache,n) = -1;
+#if ENABLE_ASSOCCACHE
+   cache->setmask = size / BDDCACHE_WAYS - 1;
+#endif
+#if ENABLE_ADAPTCACHE
+   cache->hits = 0;
+   cache->misses = 0;
+#endif
    
    return 0;
 }
 
 
+int BddCache_init(BddCache *cache, int size, int entrysize)
+{
+   cache->entrysize = entrysize;
+#if ENABLE_GENGC
+   cache->nodec = 0;
+#endif
+   return BddCache_alloc(cache, size);
+}
+
+
 void BddCache_done(BddCache *cache)
 {
    free(cache->table);
@@ -100,20 +137,8 @@ void BddCache_done(BddCache *cache)
 
 int BddCache_resize(BddCache *cache, int newsize)
 {
-   int n;
-
    free(cache->table);
-
-   newsize = bdd_prime_gte(newsize);
-   
-   if ((cache->table=NEW(BddCacheData,newsize)) == NULL)
-      return bdd_error(BDD_MEMORY);
-   
-   for (n=0 ; n<newsize ; n++)
-      cache->table[n].a = -1;
-   cache->tablesize = newsize;
-   
-   return 0;
+   return BddCache_alloc(cache, newsize);
 }
 
 
@@ -121,20 +146,78 @@ void BddCache_reset(BddCache *cache)
 {
    register int n;
    for (n=0 ; n<cache->tablesize ; n++)
-      cache->table[n].a = -1;
+      ENTRY_KEY(cache,n) = -1;
 }
 
 #if ENABLE_TBDD
-void BddCache_clause_evict(BddCacheData *entry) {
-    int id;
-    if (entry->a != -1 &&
-	(entry->op == bddop_andimptstj || entry->op == bddop_andj || entry->op == bddop_imptstj)) {
-	id = entry->r.jclause;
+   /* Resize a cache of proof entries, moving the entries over to the new
+      table instead of deleting all of their justifying clauses. Only the
+      entries that no longer fit lose their clauses. The hash function
+      must give the value that was used when the entry was inserted. */
+int BddCache_resizej(BddCache *cache, int newsize,
+		     unsigned int (*hash)(BddCacheDataJ *))
+{
+   BddCache old = *cache;
+   int n, err;
+
+   if ((err=BddCache_alloc(cache, newsize)) < 0)
+   {
+      *cache = old;
+      return err;
+   }
+
+   for (n=0 ; n<old.tablesize ; n++)
+   {
+      BddCacheDataJ *entry = (BddCacheDataJ*)old.table + n;
+      BddCacheDataJ *slot;
+
+      if (entry->a == -1)
+	 continue;
+      slot = (BddCacheDataJ*)cache->table +
+	 BddCache_index(cache, hash(entry),
+			entry->a, entry->b, entry->c, 0);
+#if ENABLE_ASSOCCACHE
+      {
+	 BddCacheDataJ *set = slot;
+	 int w;
+
+	 for (w=0 ; w<BDDCACHE_WAYS ; w++)
+	 {
+	    if (set[w].a == -1)
+	    {
+	       slot = &set[w];
+	       break;
+	    }
+	    if (set[w].value < slot->value)
+	       slot = &set[w];
+	 }
+	 if (slot->a != -1  &&  slot->value < entry->value)
+	 {
+	    BddCache_clause_evict(slot);
+	    slot->a = -1;
+	 }
+      }
+#endif
+      if (slot->a != -1)
+	 BddCache_clause_evict(entry);
+      else
+	 *slot = *entry;
+   }
+
+   free(old.table);
+   return 0;
+}
+
+
+void BddCache_clause_evict(BddCacheDataJ *entry) {
+    clause_id_t id;
+    if (entry->a != -1) {
+	id = entry->jclause;
 	if (id == TAUTOLOGY)
 	    return;
 #if DO_TRACE
-	if (NNAME(entry->r.res) == TRACE_NNAME) {
-	    printf("TRACE: Evicting node N%d.  Deleting clause %d\n", TRACE_NNAME, entry->r.jclause);
+	if (NNAME(entry->res) == TRACE_NNAME) {
+	    printf("TRACE: Evicting node N%d.  Deleting clause %" PRIcid "\n", TRACE_NNAME, entry->jclause);
 	}
 #endif	
 	defer_delete_clause(id);
@@ -146,10 +229,24 @@ void BddCache_clear_clauses(BddCache *cache)
    register int n;
    print_proof_comment(2, "Deleting justifying clauses for cached operations");
    for (n=0 ; n<cache->tablesize ; n++) {
-       BddCacheData *entry = &cache->table[n];
+       BddCacheDataJ *entry = (BddCacheDataJ*)cache->table + n;
        BddCache_clause_evict(entry);
    }
 }
+
+void BddCache_clause_evictm(BddCacheDataM *entry)
+{
+   if (entry->n != -1  &&  entry->op == bddop_andj  &&
+       entry->jclause != TAUTOLOGY)
+      defer_delete_clause(entry->jclause);
+}
+
+void BddCache_clear_clausesm(BddCache *cache)
+{
+   int n;
+   for (n=0 ; n<cache->tablesize ; n++)
+      BddCache_clause_evictm((BddCacheDataM*)cache->table + n);
+}
 #endif
 
 
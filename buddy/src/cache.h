@@ -78,43 +78,451 @@
 #define ENABLE_TBDD 0
 #endif
 
-typedef struct
+#ifndef ENABLE_ASSOCCACHE
+#define ENABLE_ASSOCCACHE 0
+#endif
+
+#ifndef ENABLE_ADAPTCACHE
+#define ENABLE_ADAPTCACHE 0
+#endif
+
+#ifndef ENABLE_GENGC
+#define ENABLE_GENGC 0
+#endif
+
+#if ENABLE_ASSOCCACHE
+   /* Number of entries in each set of the cache */
+#define BDDCACHE_WAYS 4
+   /* Priority of a new proof entry, on top of its cost */
+#define BDDCACHE_NEWVALUE 8
+   /* Priority added by a hit */
+#define BDDCACHE_HITVALUE 8
+#define BDDCACHE_MAXVALUE 0xFFFF
+#endif
+
+typedef struct  /* Result of an operation on up to three operands */
 {
-   union
-   {
-      double dres;
-#if ENABLE_TBDD
-       // C compiler needs to support anonymous structs
-       struct {
-	   BDD res;
-	   int jclause;
-       };
-#else
-       int res;
-#endif       
-   } r;
-   int a,b,c;
-   int op;
+   BDD a,b,c;     /* The operation must be part of the key, typically in c */
+   BDD res;
+#if ENABLE_GENGC
+   unsigned int epoch;    /* Young collection epoch it was last checked in */
+#endif
 } BddCacheData;
 
+#if ENABLE_TBDD
+typedef struct  /* Result and justifying clause of a proof operation */
+{
+   BDD a,b,c;     /* The operation is part of the key, in c */
+#if ENABLE_ASSOCCACHE
+   unsigned short value;  /* Replacement priority, decays with age */
+#endif
+   BDD res;
+   clause_id_t jclause;
+#if ENABLE_GENGC
+   unsigned int epoch;
+#endif
+} BddCacheDataJ;
+#endif
+
+typedef struct  /* Result of a conjunction of several operands */
+{
+   BDD n;                    /* Number of operands, as wide as a key */
+   int op;                   /* bddop_and, or bddop_andj with a proof */
+   BDD ops[BDD_MULTIMAX];    /* The operands in increasing order */
+   BDD res;
+#if ENABLE_TBDD
+   clause_id_t jclause;
+#endif
+#if ENABLE_GENGC
+   unsigned int epoch;
+#endif
+} BddCacheDataM;
+
+typedef struct  /* Result of a counting operation */
+{
+   BDD a,c;
+   double dres;
+#if ENABLE_GENGC
+   unsigned int epoch;
+#endif
+} BddCacheDataD;
+
 
 typedef struct
 {
-   BddCacheData *table;
+   void *table;       /* Entries of one of the above kinds */
    int tablesize;
+   int entrysize;
+#if ENABLE_ASSOCCACHE
+   unsigned int setmask;  /* Number of sets minus one */
+#endif
+#if ENABLE_ADAPTCACHE
+   unsigned long hits;    /* Lookups since the size was last reviewed */
+   unsigned long misses;
+#endif
+#if ENABLE_GENGC
+   int nodec;             /* The c operand of the entries is a node */
+#endif
 } BddCache;
 
-extern int  BddCache_init(BddCache *, int);
+extern int  BddCache_init(BddCache *, int, int);
 extern void BddCache_done(BddCache *);
 extern int  BddCache_resize(BddCache *, int);
 extern void BddCache_reset(BddCache *);
 
 #if ENABLE_TBDD
-extern void BddCache_clause_evict(BddCacheData *entry);
+extern int  BddCache_resizej(BddCache *, int,
+			     unsigned int (*)(BddCacheDataJ *));
+extern void BddCache_clause_evict(BddCacheDataJ *entry);
 extern void BddCache_clear_clauses(BddCache *);
+extern void BddCache_clause_evictm(BddCacheDataM *entry);
+extern void BddCache_clear_clausesm(BddCache *);
+#endif
+
+#if ENABLE_GENGC
+   /* A young collection does not clear the caches. An entry that was
+      last checked in an earlier epoch is only used if none of its nodes
+      (or -1 for an unused operand) has been freed since. It then belongs
+      to the current epoch again. */
+#define BDDCACHE_ALIVE(r, epoch) \
+   ((r) < 0  ||  bddnodedeath[NODEIDX(r)] <= (epoch))
+#define BDDCACHE_VALID(entry, alive) \
+   ((entry)->epoch == bddgcepoch  ||  \
+    ((alive)  &&  ((entry)->epoch = bddgcepoch, 1)))
+#define BDDCACHE_STAMP(entry) ((entry)->epoch = bddgcepoch)
+#else
+#define BDDCACHE_VALID(entry, alive) 1
+#define BDDCACHE_STAMP(entry)
+#endif
+
+#if ENABLE_ADAPTCACHE
+#define BDDCACHE_HIT(cache)  ((cache)->hits++)
+#define BDDCACHE_MISS(cache) ((cache)->misses++)
+#else
+#define BDDCACHE_HIT(cache)
+#define BDDCACHE_MISS(cache)
+#endif
+
+
+   /* Index of the entry, or first entry of the set, that may hold the key */
+static inline unsigned int BddCache_index(BddCache *cache, unsigned int hash,
+					  BDD a, BDD b, BDD c, int op)
+{
+#if ENABLE_ASSOCCACHE
+   unsigned long long h;
+
+      /* The hash value of the caller is not used; instead all of the
+	 key is mixed, as the sets are found by masking the low bits. */
+   (void)hash;
+   h = (unsigned int)a * 0x9E3779B97F4A7C15ULL;
+   h = (h ^ (unsigned int)b) * 0xC2B2AE3D27D4EB4FULL;
+   h = (h ^ (unsigned int)c) * 0x165667B19E3779F9ULL;
+   h ^= (unsigned int)op;
+   h ^= h >> 29;
+   h *= 0xFF51AFD7ED558CCDULL;
+   h ^= h >> 32;
+
+   return (h & cache->setmask) * BDDCACHE_WAYS;
+#else
+   (void)a; (void)b; (void)c; (void)op;
+   return hash % cache->tablesize;
+#endif
+}
+
+
+#if ENABLE_ASSOCCACHE
+   /* Replacement in sets of plain entries: a hit moves the entry one
+      step towards the front of its set, and a new entry goes in front,
+      pushing out the last one. */
+#define BDDCACHE_FIND(cache, type, set, match)				\
+   {									\
+      int n_;								\
+      for (n_=0 ; n_<BDDCACHE_WAYS ; n_++)				\
+      {									\
+	 type *entry = &(set)[n_];					\
+	 if (match)							\
+	 {								\
+	    BDDCACHE_HIT(cache);					\
+	    if (n_ > 0)							\
+	    {								\
+	       type tmp_ = (set)[n_-1];					\
+	       (set)[n_-1] = *entry;					\
+	       *entry = tmp_;						\
+	       entry--;							\
+	    }								\
+	    return entry;						\
+	 }								\
+      }									\
+      BDDCACHE_MISS(cache);						\
+      return NULL;							\
+   }
+
+#define BDDCACHE_INSERT(set)						\
+   {									\
+      int n_;								\
+      for (n_=BDDCACHE_WAYS-1 ; n_>0 ; n_--)				\
+	 (set)[n_] = (set)[n_-1];					\
+      entry = &(set)[0];						\
+   }
+#endif
+
+
+#if ENABLE_GENGC
+static inline int BddCache_alive(BddCache *cache, BddCacheData *entry)
+{
+   return BDDCACHE_ALIVE(entry->a, entry->epoch)  &&
+      BDDCACHE_ALIVE(entry->b, entry->epoch)  &&
+      BDDCACHE_ALIVE(entry->res, entry->epoch)  &&
+      (!cache->nodec  ||  BDDCACHE_ALIVE(entry->c, entry->epoch));
+}
+#endif
+
+
+   /* Find the result for the key (a,b,c), or NULL if it is not cached */
+static inline BddCacheData *BddCache_find(BddCache *cache, unsigned int hash,
+					  BDD a, BDD b, BDD c)
+{
+   BddCacheData *set = (BddCacheData*)cache->table +
+      BddCache_index(cache, hash, a, b, c, 0);
+#if ENABLE_ASSOCCACHE
+   BDDCACHE_FIND(cache, BddCacheData, set,
+		 entry->a == a  &&  entry->b == b  &&  entry->c == c  &&
+		 BDDCACHE_VALID(entry, BddCache_alive(cache, entry)))
+#else
+   if (set->a == a  &&  set->b == b  &&  set->c == c  &&
+       BDDCACHE_VALID(set, BddCache_alive(cache, set)))
+   {
+      BDDCACHE_HIT(cache);
+      return set;
+   }
+   BDDCACHE_MISS(cache);
+   return NULL;
 #endif
+}
 
-#define BddCache_lookup(cache, hash) (&(cache)->table[hash % (cache)->tablesize])
+
+   /* Get an entry for storing the result for the key (a,b,c) */
+static inline BddCacheData *BddCache_insert(BddCache *cache, unsigned int hash,
+					    BDD a, BDD b, BDD c)
+{
+   BddCacheData *entry = (BddCacheData*)cache->table +
+      BddCache_index(cache, hash, a, b, c, 0);
+#if ENABLE_ASSOCCACHE
+   BDDCACHE_INSERT(entry)
+#endif
+   entry->a = a;
+   entry->b = b;
+   entry->c = c;
+   BDDCACHE_STAMP(entry);
+   return entry;
+}
+
+
+static inline BddCacheDataD *BddCache_findd(BddCache *cache, unsigned int hash,
+					    BDD a, BDD c)
+{
+   BddCacheDataD *set = (BddCacheDataD*)cache->table +
+      BddCache_index(cache, hash, a, 0, c, 0);
+#if ENABLE_ASSOCCACHE
+   BDDCACHE_FIND(cache, BddCacheDataD, set,
+		 entry->a == a  &&  entry->c == c  &&
+		 BDDCACHE_VALID(entry, BDDCACHE_ALIVE(a, entry->epoch)))
+#else
+   if (set->a == a  &&  set->c == c  &&
+       BDDCACHE_VALID(set, BDDCACHE_ALIVE(a, set->epoch)))
+   {
+      BDDCACHE_HIT(cache);
+      return set;
+   }
+   BDDCACHE_MISS(cache);
+   return NULL;
+#endif
+}
+
+
+static inline BddCacheDataD *BddCache_insertd(BddCache *cache,
+					      unsigned int hash, BDD a, BDD c)
+{
+   BddCacheDataD *entry = (BddCacheDataD*)cache->table +
+      BddCache_index(cache, hash, a, 0, c, 0);
+#if ENABLE_ASSOCCACHE
+   BDDCACHE_INSERT(entry)
+#endif
+   entry->a = a;
+   entry->c = c;
+   BDDCACHE_STAMP(entry);
+   return entry;
+}
+
+
+#if ENABLE_TBDD
+#if ENABLE_GENGC
+static inline int BddCache_alivej(BddCacheDataJ *entry)
+{
+   return BDDCACHE_ALIVE(entry->a, entry->epoch)  &&
+      BDDCACHE_ALIVE(entry->b, entry->epoch)  &&
+      BDDCACHE_ALIVE(entry->c, entry->epoch)  &&
+      BDDCACHE_ALIVE(entry->res, entry->epoch);
+}
+#endif
+
+
+   /* Entries whose nodes have been freed keep their justifying clause
+      until they are replaced */
+static inline BddCacheDataJ *BddCache_findj(BddCache *cache, unsigned int hash,
+					    BDD a, BDD b, BDD c)
+{
+   BddCacheDataJ *set = (BddCacheDataJ*)cache->table +
+      BddCache_index(cache, hash, a, b, c, 0);
+#if ENABLE_ASSOCCACHE
+   int n;
+
+   for (n=0 ; n<BDDCACHE_WAYS ; n++)
+   {
+      BddCacheDataJ *entry = &set[n];
+      if (entry->a == a  &&  entry->b == b  &&  entry->c == c  &&
+	  BDDCACHE_VALID(entry, BddCache_alivej(entry)))
+      {
+	 if (entry->value <= BDDCACHE_MAXVALUE - BDDCACHE_HITVALUE)
+	    entry->value += BDDCACHE_HITVALUE;
+	 BDDCACHE_HIT(cache);
+	 return entry;
+      }
+   }
+   BDDCACHE_MISS(cache);
+   return NULL;
+#else
+   if (set->a == a  &&  set->b == b  &&  set->c == c  &&
+       BDDCACHE_VALID(set, BddCache_alivej(set)))
+   {
+      BDDCACHE_HIT(cache);
+      return set;
+   }
+   BDDCACHE_MISS(cache);
+   return NULL;
+#endif
+}
+
+
+   /* Get an entry for storing the result for the key (a,b,c), after
+      deleting the justifying clause of the entry it replaces. The cost
+      is the number of proof clauses generated for the result. With
+      ENABLE_ASSOCCACHE an expensive entry is kept longer than a cheap
+      one when its set is full. */
+static inline BddCacheDataJ *BddCache_insertj(BddCache *cache,
+					      unsigned int hash,
+					      BDD a, BDD b, BDD c, int cost)
+{
+   BddCacheDataJ *entry = (BddCacheDataJ*)cache->table +
+      BddCache_index(cache, hash, a, b, c, 0);
+#if ENABLE_ASSOCCACHE
+   BddCacheDataJ *set = entry;
+   int n;
+
+   for (n=0 ; n<BDDCACHE_WAYS ; n++)
+   {
+      if (set[n].a == -1)
+      {
+	 entry = &set[n];
+	 break;
+      }
+      if (set[n].value < entry->value)
+	 entry = &set[n];
+   }
+
+      /* Everything else in the set gets older */
+   for (n=0 ; n<BDDCACHE_WAYS ; n++)
+      set[n].value -= (set[n].value >> 2) + (set[n].value > 0);
+
+   if (cost > BDDCACHE_MAXVALUE - BDDCACHE_NEWVALUE)
+      cost = BDDCACHE_MAXVALUE - BDDCACHE_NEWVALUE;
+   entry->value = BDDCACHE_NEWVALUE + cost;
+#else
+   (void)cost;
+#endif
+
+   BddCache_clause_evict(entry);
+   entry->a = a;
+   entry->b = b;
+   entry->c = c;
+   BDDCACHE_STAMP(entry);
+   return entry;
+}
+#endif
+
+
+static inline int BddCache_matchm(BddCacheDataM *entry, BDD *ops, int n,
+				  int op)
+{
+   int i;
+
+   if (entry->n != n  ||  entry->op != op)
+      return 0;
+   for (i=0 ; i<n ; i++)
+      if (entry->ops[i] != ops[i])
+	 return 0;
+#if ENABLE_GENGC
+   if (entry->epoch != bddgcepoch)
+   {
+      for (i=0 ; i<n ; i++)
+	 if (!BDDCACHE_ALIVE(ops[i], entry->epoch))
+	    return 0;
+      if (!BDDCACHE_ALIVE(entry->res, entry->epoch))
+	 return 0;
+      entry->epoch = bddgcepoch;
+   }
+#endif
+   return 1;
+}
+
+
+   /* Find the result for the n sorted operands in ops */
+static inline BddCacheDataM *BddCache_findm(BddCache *cache, unsigned int hash,
+					    BDD *ops, int n, int op)
+{
+   BddCacheDataM *set = (BddCacheDataM*)cache->table +
+      BddCache_index(cache, hash, hash, n, op, 0);
+#if ENABLE_ASSOCCACHE
+   BDDCACHE_FIND(cache, BddCacheDataM, set,
+		 BddCache_matchm(entry, ops, n, op))
+#else
+   if (BddCache_matchm(set, ops, n, op))
+   {
+      BDDCACHE_HIT(cache);
+      return set;
+   }
+   BDDCACHE_MISS(cache);
+   return NULL;
+#endif
+}
+
+
+   /* Get an entry for storing the result for the n sorted operands in
+      ops, after deleting the justifying clause of the entry it
+      replaces */
+static inline BddCacheDataM *BddCache_insertm(BddCache *cache,
+					      unsigned int hash,
+					      BDD *ops, int n, int op)
+{
+   BddCacheDataM *entry = (BddCacheDataM*)cache->table +
+      BddCache_index(cache, hash, hash, n, op, 0);
+   int i;
+
+#if ENABLE_ASSOCCACHE
+#if ENABLE_TBDD
+   BddCache_clause_evictm(&entry[BDDCACHE_WAYS-1]);
+#endif
+   BDDCACHE_INSERT(entry)
+#elif ENABLE_TBDD
+   BddCache_clause_evictm(entry);
+#endif
+   entry->n = n;
+   entry->op = op;
+   for (i=0 ; i<n ; i++)
+      entry->ops[i] = ops[i];
+   BDDCACHE_STAMP(entry);
+   return entry;
+}
 
 
 #endif /* _CACHE_H */
@@ -49,7 +49,7 @@ using namespace std;
 #define IOFORMAT_ALL    3
 #define IOFORMAT_FDDSET 4
 
-int bdd_ioformat::curformat = IOFORMAT_SET;
+BDD_TLS int bdd_ioformat::curformat = IOFORMAT_SET;
 bdd_ioformat bddset(IOFORMAT_SET);
 bdd_ioformat bddtable(IOFORMAT_TABLE);
 bdd_ioformat bdddot(IOFORMAT_DOT);
@@ -61,13 +61,13 @@ const bdd bddtruepp = bdd_true();
 const bdd bddfalsepp = bdd_false();
 
    /* Internal prototypes */
-static void bdd_printset_rec(ostream&, int, int*);
-static void bdd_printdot_rec(ostream&, int);
-static void fdd_printset_rec(ostream &, int, int *);
+static void bdd_printset_rec(ostream&, BDD, int*);
+static void bdd_printdot_rec(ostream&, BDD);
+static void fdd_printset_rec(ostream &, BDD, int *);
 
 
-static bddstrmhandler strmhandler_bdd;
-static bddstrmhandler strmhandler_fdd;
+static BDD_TLS bddstrmhandler strmhandler_bdd;
+static BDD_TLS bddstrmhandler strmhandler_fdd;
 
    // Avoid calling C++ version of anodecount
 #undef bdd_anodecount
@@ -111,6 +111,24 @@ bdd bdd_buildcube(int val, int width, const bdd *variables)
 }
 
 
+bdd bdd_and_multi(const bdd *operands, int num)
+{
+   BDD *ops = NEW(BDD,num > 0 ? num : 1);
+   BDD res;
+   int n;
+
+      // No need for ref.cou. since operands[n] holds the reference
+   for (n=0 ; n<num ; n++)
+      ops[n] = operands[n].root;
+
+   res = bdd_and_multi(ops, num);
+
+   free(ops);
+
+   return res;
+}
+
+
 int bdd_setbddpairs(bddPair *pair, int *oldvar, const bdd *newvar, int size)
 {
    if (pair == NULL)
@@ -124,10 +142,10 @@ int bdd_setbddpairs(bddPair *pair, int *oldvar, const bdd *newvar, int size)
 }
 
 
-int bdd_anodecountpp(const bdd *r, int num)
+BDD bdd_anodecountpp(const bdd *r, int num)
 {
    BDD *cpr = NEW(BDD,num);
-   int cou;
+   BDD cou;
    int n;
 
       // No need for ref.cou. since r[n] holds the reference
@@ -157,7 +175,7 @@ bdd bdd::operator=(const bdd &r)
 }
 
 
-bdd bdd::operator=(int r)
+bdd bdd::operator=(BDD r)
 {
    if (root != r)
    {
@@ -239,13 +257,13 @@ ostream &operator<<(ostream &o, const bdd &r)
 
       for (int n=0 ; n<bddnodesize ; n++)
       {
-	 if (LEVEL(n) & MARKON)
+	 BddNode *node = &bddnodes[n];
+
+	 if (MARKEDp(node))
 	 {
-	    BddNode *node = &bddnodes[n];
-	 
 	    LEVELp(node) &= MARKOFF;
 
-	    o << "[" << setw(5) << n << "] ";
+	    o << "[" << setw(5) << NODEREF(n) << "] ";
 	    if (strmhandler_bdd)
 	       strmhandler_bdd(o,bddlevel2var[LEVELp(node)]);
 	    else
@@ -330,13 +348,13 @@ ostream &operator<<(ostream &o, const bdd_ioformat &f)
    else
    if (f.format == IOFORMAT_ALL)
    {
-      for (int n=0 ; n<bddnodesize ; n++)
+      for (int n=0 ; n<bddnodeinit ; n++)
       {
 	 const BddNode *node = &bddnodes[n];
 	 
 	 if (LOWp(node) != -1)
 	 {
-	    o << "[" << setw(5) << n << "] ";
+	    o << "[" << setw(5) << NODEREF(n) << "] ";
 	    if (strmhandler_bdd)
 	       strmhandler_bdd(o,bddlevel2var[LEVELp(node)]);
 	    else
@@ -352,7 +370,7 @@ ostream &operator<<(ostream &o, const bdd_ioformat &f)
 }
 
 
-static void bdd_printset_rec(ostream& o, int r, int* set)
+static void bdd_printset_rec(ostream& o, BDD r, int* set)
 {
    int n;
    int first;
@@ -395,19 +413,22 @@ static void bdd_printset_rec(ostream& o, int r, int* set)
 }
 
 
-static void bdd_printdot_rec(ostream& o, int r)
+static void bdd_printdot_rec(ostream& o, BDD r)
 {
    if (ISCONST(r) || MARKED(r))
       return;
 
+   r = REGULAR(r);
    o << r << "[label=\"";
    if (strmhandler_bdd)
       strmhandler_bdd(o,bddlevel2var[LEVEL(r)]);
    else
       o << bddlevel2var[LEVEL(r)];
    o << "\"];\n";
-   o << r << " -> " << LOW(r) << "[style=dotted];\n";
-   o << r << " -> " << HIGH(r) << "[style=filled];\n";
+   o << r << " -> " << REGULAR(LOW(r)) << "[style=dotted"
+     << (ISCOMPL(LOW(r)) ? ", arrowhead=odot" : "") << "];\n";
+   o << r << " -> " << REGULAR(HIGH(r)) << "[style=filled"
+     << (ISCOMPL(HIGH(r)) ? ", arrowhead=odot" : "") << "];\n";
 
    SETMARK(r);
    
@@ -416,7 +437,7 @@ static void bdd_printdot_rec(ostream& o, int r)
 }
 
 
-static void fdd_printset_rec(ostream &o, int r, int *set)
+static void fdd_printset_rec(ostream &o, BDD r, int *set)
 {
    int n,m,i;
    int used = 0;
@@ -42,7 +42,7 @@
 #include "fdd.h"
 
 
-static void fdd_printset_rec(FILE *, int, int *);
+static void fdd_printset_rec(FILE *, BDD, int *);
 
 /*======================================================================*/
 /* NOTE: ALL FDD operations works with LSB in top of the variable order */
@@ -61,12 +61,31 @@ typedef struct s_Domain
 static void Domain_allocate(Domain*, int);
 static void Domain_done(Domain*);
 
-static int    firstbddvar;
-static int    fdvaralloc;         /* Number of allocated domains */
-static int    fdvarnum;           /* Number of defined domains */
-static Domain *domain;            /* Table of domain sizes */
+typedef struct s_FddState
+{
+   int    firstbddvar;
+   int    fdvaralloc;         /* Number of allocated domains */
+   int    fdvarnum;           /* Number of defined domains */
+   Domain *domain;            /* Table of domain sizes */
+
+   bddfilehandler filehandler;
+} FddState;
+
+#if ENABLE_REENTRANT
+void *bdd_fdd_newstate(void)
+{
+   return bdd_newstate(NULL, sizeof(FddState));
+}
+#else
+static FddState fddstate;
+#endif
 
-static bddfilehandler filehandler;
+#define FDDSTATE BDDSTATE(FddState, BDDMOD_FDD, fddstate)
+#define firstbddvar (FDDSTATE->firstbddvar)
+#define fdvaralloc  (FDDSTATE->fdvaralloc)
+#define fdvarnum    (FDDSTATE->fdvarnum)
+#define domain      (FDDSTATE->domain)
+#define filehandler (FDDSTATE->filehandler)
 
 /*************************************************************************
   Domain definition
@@ -377,7 +396,7 @@ ALSO    {* fdd\_ithset *}
 BDD fdd_ithvar(int var, int val)
 {
    int n;
-   int v=1, tmp;
+   BDD v=1, tmp;
    
    if (!bddrunning)
    {
@@ -674,7 +693,10 @@ ALSO    {* fdd\_printset, bdd\_file\_hook *}
 */
 bddfilehandler fdd_file_hook(bddfilehandler h)
 {
-   bddfilehandler old = filehandler;
+   bddfilehandler old;
+
+   CHECKMANAGER;
+   old = filehandler;
    filehandler = h;
    return old;
 }
@@ -730,7 +752,7 @@ void fdd_fprintset(FILE *ofile, BDD r)
 }
 
 
-static void fdd_printset_rec(FILE *ofile, int r, int *set)
+static void fdd_printset_rec(FILE *ofile, BDD r, int *set)
 {
    int n,m,i;
    int used = 0;
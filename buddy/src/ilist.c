@@ -61,11 +61,11 @@ static ilist ilist_error(char *fname) {
 }
 
 /* 
-   Convert an array of ints to an ilist.  Don't call free_ilist on
+   Convert an array of clause_id_t to an ilist.  Don't call free_ilist on
    this one!  The size of the array should be max_length + ILIST_OVHD
    Will be statically sized
 */
-ilist ilist_make(int *p, int max_length) {
+ilist ilist_make(clause_id_t *p, int max_length) {
     ilist result = p+ILIST_OVHD;
     ILIST_LENGTH(result) = 0;
     ILIST_MAXLENGTHFIELD(result) = max_length;
@@ -76,7 +76,7 @@ ilist ilist_make(int *p, int max_length) {
 ilist ilist_new(int max_length) {
     if (max_length == 0)
 	max_length++;
-    int *p = calloc(max_length + ILIST_OVHD, sizeof(int));
+    clause_id_t *p = calloc(max_length + ILIST_OVHD, sizeof(clause_id_t));
      ilist result = p+ILIST_OVHD;
     ILIST_LENGTH(result) = 0;
     ILIST_MAXLENGTHFIELD(result) = -max_length;
@@ -88,7 +88,7 @@ void ilist_free(ilist ils) {
     if (!ils)
 	return;
     if (ILIST_MAXLENGTHFIELD(ils) < 0) {
-	int *p = ILIST_BASE(ils);
+	clause_id_t *p = ILIST_BASE(ils);
 	free(p);
     }
 }
@@ -97,7 +97,7 @@ void ilist_free(ilist ils) {
 int ilist_length(ilist ils) {
     if (ils == TAUTOLOGY_CLAUSE)
 	return 0;
-    return ILIST_LENGTH(ils);
+    return (int) ILIST_LENGTH(ils);
 }
 
 /*
@@ -105,17 +105,17 @@ int ilist_length(ilist ils) {
   When lengthening, new contents are undefined
 */
 ilist ilist_resize(ilist ils, int nlength) {
-    int list_max_length = ILIST_MAXLENGTHFIELD(ils);
+    int list_max_length = (int) ILIST_MAXLENGTHFIELD(ils);
     int true_max_length = IABS(list_max_length);
     if (nlength > true_max_length) {
 	if (list_max_length < 0) {
-	    int *p = ILIST_BASE(ils);
+	    clause_id_t *p = ILIST_BASE(ils);
 	    int old_tml = true_max_length;
 	    /* Dynamically resize */
 	    true_max_length *= 2;
 	    if (nlength > true_max_length)
 		true_max_length = nlength;
-	    p = realloc(p, (true_max_length + ILIST_OVHD) * sizeof(int));
+	    p = realloc(p, (true_max_length + ILIST_OVHD) * sizeof(clause_id_t));
 	    if (p == NULL) {
 		/* Need to throw error here */
 		fprintf(ERROUT, "Failed to grow ilist allocation from %d to %d\n",
@@ -136,8 +136,8 @@ ilist ilist_resize(ilist ils, int nlength) {
   Add new value(s) to end of ilist.
   For dynamic ilists, the value of the pointer may change
 */
-ilist ilist_push(ilist ils, int val) {
-    int length = ILIST_LENGTH(ils);
+ilist ilist_push(ilist ils, clause_id_t val) {
+    int length = (int) ILIST_LENGTH(ils);
     int nlength = length+1;
     ils = ilist_resize(ils, nlength);
     if (!ils) {
@@ -153,7 +153,7 @@ ilist ilist_push(ilist ils, int val) {
   Populate ilist with 1, 2, 3, or 4 elements.
   For dynamic ilists, the value of the pointer may change
  */
-ilist ilist_fill1(ilist ils, int val1) {
+ilist ilist_fill1(ilist ils, clause_id_t val1) {
     ils = ilist_resize(ils, 1);
     if (!ils) {
 	/* Want to throw an exception here */
@@ -163,7 +163,7 @@ ilist ilist_fill1(ilist ils, int val1) {
     return ils;
 }
 
-ilist ilist_fill2(ilist ils, int val1, int val2) {
+ilist ilist_fill2(ilist ils, clause_id_t val1, clause_id_t val2) {
     ils = ilist_resize(ils, 2);
     if (!ils) {
 	/* Want to throw an exception here */
@@ -174,7 +174,7 @@ ilist ilist_fill2(ilist ils, int val1, int val2) {
     return ils;
 }
 
-ilist ilist_fill3(ilist ils, int val1, int val2, int val3) {
+ilist ilist_fill3(ilist ils, clause_id_t val1, clause_id_t val2, clause_id_t val3) {
     ils = ilist_resize(ils, 3);
     if (!ils) {
 	/* Want to throw an exception here */
@@ -186,7 +186,7 @@ ilist ilist_fill3(ilist ils, int val1, int val2, int val3) {
     return ils;
 }
 
-ilist ilist_fill4(ilist ils, int val1, int val2, int val3, int val4) {
+ilist ilist_fill4(ilist ils, clause_id_t val1, clause_id_t val2, clause_id_t val3, clause_id_t val4) {
     ils = ilist_resize(ils, 4);
     if (!ils) {
 	/* Want to throw an exception here */
@@ -202,10 +202,10 @@ ilist ilist_fill4(ilist ils, int val1, int val2, int val3, int val4) {
 /*
   Dynamically allocate ilist and fill from array
  */
-ilist ilist_copy_list(int *ls, int length) {
+ilist ilist_copy_list(clause_id_t *ls, int length) {
     ilist rils =  ilist_new(length);
     rils = ilist_resize(rils, length);
-    memcpy(rils, ls, length*sizeof(int));
+    memcpy(rils, ls, length*sizeof(clause_id_t));
     return rils;
 }
 
@@ -215,9 +215,9 @@ ilist ilist_copy_list(int *ls, int length) {
  */
 ilist ilist_read_file(FILE *infile) {
     ilist rils = ilist_new(1);
-    int val;
+    clause_id_t val;
     int rcode;
-    while ((rcode = fscanf(infile, "%d", &val)) == 1) {
+    while ((rcode = fscanf(infile, "%" PRIcid, &val)) == 1) {
 	rils = ilist_push(rils, val);
     }
     if (rcode != EOF)
@@ -229,7 +229,7 @@ ilist ilist_read_file(FILE *infile) {
 /*
   Test whether value is member of list
  */
-extern bool ilist_is_member(ilist ils, int val) {
+extern bool ilist_is_member(ilist ils, clause_id_t val) {
     int i;
     for (i = 0; i < ilist_length(ils); i++)
 	if (val == ils[i])
@@ -248,11 +248,11 @@ ilist ilist_copy(ilist ils) {
 /*
   Reverse elements in ilist
  */
-void ilist_reverse(int *ils) {
+void ilist_reverse(clause_id_t *ils) {
     int left = 0;
     int right = ilist_length(ils)-1;
     while (left < right) {
-	int v = ils[left];
+	clause_id_t v = ils[left];
 	ils[left] = ils[right];
 	ils[right] = v;
 	left++;
@@ -264,8 +264,8 @@ void ilist_reverse(int *ils) {
   Sort integers in ascending order
  */
 int int_compare_ilist(const void *i1p, const void *i2p) {
-    int i1 = *(int *) i1p;
-    int i2 = *(int *) i2p;
+    clause_id_t i1 = *(clause_id_t *) i1p;
+    clause_id_t i2 = *(clause_id_t *) i2p;
     if (i1 < i2)
 	return -1;
     if (i1 > i2)
@@ -277,8 +277,8 @@ int int_compare_ilist(const void *i1p, const void *i2p) {
 /*
   Put elements of ilist into ascending order
  */
-void ilist_sort(int *ils) {
-    qsort((void *) ils, ilist_length(ils), sizeof(int), int_compare_ilist);
+void ilist_sort(clause_id_t *ils) {
+    qsort((void *) ils, ilist_length(ils), sizeof(clause_id_t), int_compare_ilist);
 }
 
 
@@ -298,7 +298,7 @@ int ilist_print(ilist ils, FILE *out, const char *sep) {
 	return rval;
     }
     for (i = 0; i < ilist_length(ils); i++) {
-	int pval = fprintf(out, "%s%d", space, ils[i]);
+	int pval = fprintf(out, "%s%" PRIcid, space, ils[i]);
 	if (pval < 0)
 	    return pval;
 	rval += pval;
@@ -320,7 +320,7 @@ int ilist_format(ilist ils, char *out, const char *sep, int maxlen) {
     for (i = 0; i < ilist_length(ils); i++) {
 	if (len >= maxlen)
 	    break;
-	int xlen = snprintf(out+len, maxlen-len, "%s%d", space, ils[i]);
+	int xlen = snprintf(out+len, maxlen-len, "%s%" PRIcid, space, ils[i]);
 	len += xlen;
 	space = sep;
     }
@@ -34,6 +34,10 @@
 #include <stdbool.h>
 #include <limits.h>
 
+#ifndef ENABLE_LARGE
+#define ENABLE_LARGE 0
+#endif
+
 
 /*============================================
    Integer lists
@@ -48,6 +52,24 @@
 extern "C" {
 #endif
 
+/*
+  Literals and clause IDs.  In large mode (ENABLE_LARGE) they are 64
+  bits wide, so that a proof can have more than INT_MAX clauses and
+  extension variables.  PRIcid is the printf conversion for them, as in
+  "%" PRIcid.
+*/
+#if ENABLE_LARGE
+typedef long long clause_id_t;
+#define CLAUSE_ID_MAX LLONG_MAX
+#define CLAUSE_ID_MIN LLONG_MIN
+#define PRIcid "lld"
+#else
+typedef int clause_id_t;
+#define CLAUSE_ID_MAX INT_MAX
+#define CLAUSE_ID_MIN INT_MIN
+#define PRIcid "d"
+#endif
+
 /*
   Data type ilist is used to represent clauses and clause id lists.
   These are simply lists of integers, where the value at position -1
@@ -56,7 +78,7 @@ extern "C" {
   statically-allocated ilists and negative for ones that can be
   dynamically resized.
 */
-typedef int *ilist;
+typedef clause_id_t *ilist;
   
 /*
   Difference between ilist maximum length and number of allocated
@@ -75,11 +97,11 @@ typedef int *ilist;
 #define FALSE_CUBE ((ilist) INT_MIN)
 
 /* 
-   Convert an array of ints to an ilist.  Don't call free_ilist on
+   Convert an array of clause_id_t to an ilist.  Don't call free_ilist on
    this one!  The size of the array should be max_length + ILIST_OVHD
    Will be statically sized
 */
-extern ilist ilist_make(int *p, int max_length);
+extern ilist ilist_make(clause_id_t *p, int max_length);
 
 /* Allocate a new ilist. */
 extern ilist ilist_new(int max_length);
@@ -100,21 +122,21 @@ extern ilist ilist_resize(ilist ils, int nlength);
   Add new value(s) to end of ilist.
   For dynamic ilists, the value of the pointer may change
 */
-extern ilist ilist_push(ilist ils, int val);
+extern ilist ilist_push(ilist ils, clause_id_t val);
 
 /*
   Populate ilist with 1, 2, 3, or 4 elements.
   For dynamic ilists, the value of the pointer may change
  */
-extern ilist ilist_fill1(ilist ils, int val1);
-extern ilist ilist_fill2(ilist ils, int val1, int val2);
-extern ilist ilist_fill3(ilist ils, int val1, int val2, int val3);
-extern ilist ilist_fill4(ilist ils, int val1, int val2, int val3, int val4);
+extern ilist ilist_fill1(ilist ils, clause_id_t val1);
+extern ilist ilist_fill2(ilist ils, clause_id_t val1, clause_id_t val2);
+extern ilist ilist_fill3(ilist ils, clause_id_t val1, clause_id_t val2, clause_id_t val3);
+extern ilist ilist_fill4(ilist ils, clause_id_t val1, clause_id_t val2, clause_id_t val3, clause_id_t val4);
 
 /*
   Test whether value is member of list
  */
-extern bool ilist_is_member(ilist ils, int val);
+extern bool ilist_is_member(ilist ils, clause_id_t val);
 
 /*
   Dynamically allocate ilist and copy from existing one.
@@ -124,7 +146,7 @@ extern ilist ilist_copy(ilist ils);
 /*
   Dynamically allocate ilist and fill from array
  */
-extern ilist ilist_copy_list(int *ls, int length);
+extern ilist ilist_copy_list(clause_id_t *ls, int length);
 
 /*
   Dynamically allocate ilist and fill with numbers from a text file
@@ -135,12 +157,12 @@ extern ilist ilist_read_file(FILE *infile);
 /*
   Reverse elements in ilist
  */
-extern void ilist_reverse(int *ls);
+extern void ilist_reverse(clause_id_t *ls);
 
 /*
   Put elements of ilist into ascending order
  */
-extern void ilist_sort(int *ls);
+extern void ilist_sort(clause_id_t *ls);
 
 /*
   Print elements of an ilist separated by sep.  Return value < 0 if error
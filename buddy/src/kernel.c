@@ -84,6 +84,14 @@
 #include "prover.h"
 #endif
 
+#if ENABLE_PARGC || ENABLE_PARAPPLY
+#include <pthread.h>
+#endif
+
+#if ENABLE_NODEARENA
+#include <sys/mman.h>
+#endif
+
 /*************************************************************************
   Various definitions and global variables
 *************************************************************************/
@@ -113,47 +121,121 @@ const BDD bddfalse=0;                    /* The constant false bdd */
 
 /*=== INTERNAL DEFINITIONS =============================================*/
 
-/* Min. number of nodes (%) that has to be left after a garbage collect
-   unless a resize should be done. */
-static int minfreenodes=20;
+#if ENABLE_PARGC
+   /* Minimum number of nodes for each garbage collection thread */
+#define PARGCMINNODES   (1 << 16)
+#define PARGCMAXTHREADS 64
+
+typedef struct s_GbcRange /* Part of the node table handled by one thread */
+{
+   BDD lo, hi;       /* Nodes lo..hi-1 */
+   BDD pos;          /* Next node to sweep, lo-1 when done */
+   BDD *stack;       /* Mark stack of this thread */
+   BDD stacksize;
+   int error;        /* Marking failed for lack of memory */
+   BDD freepos;      /* First node of the free list of the range */
+   BDD freelast;     /* Last node of the free list of the range */
+   BDD freenum;
+   BDD freed;        /* Number of nodes collected */
+#if ENABLE_OAUNIQUE
+   BDD uniquenum;
+#endif
+#if ENABLE_TBDD
+   clause_id_t *dels; /* Deleted clauses: xvar, count, clause ids ... */
+   BDD delnum;
+   BDD delsize;
+#endif
+#if ENABLE_REENTRANT
+   bdd_manager *manager; /* Manager of the collecting thread */
+#endif
+} GbcRange;
+#endif
+
+#if ENABLE_OAUNIQUE
+typedef struct s_BddUnique /* Unique table slot */
+{
+   BddKey key;         /* Full hash value of (level,low,high) */
+   BDD node;           /* Node index, 0 for an empty slot */
+} BddUnique;
+#endif
 
 
 /*=== GLOBAL KERNEL VARIABLES ==========================================*/
 
-int          bddrunning;            /* Flag - package initialized */
-int          bdderrorcond;          /* Some error condition */
-int          bddnodesize;           /* Number of allocated nodes */
-int          bddmaxnodesize;        /* Maximum allowed number of nodes */
-int          bddmaxnodeincrease;    /* Max. # of nodes used to inc. table */
-BddNode*     bddnodes;          /* All of the bdd nodes */
-int          bddfreepos;        /* First free node */
-int          bddfreenum;        /* Number of free nodes */
-long int     bddproduced;       /* Number of new nodes ever produced */
-int          bddvarnum;         /* Number of defined BDD variables */
-int*         bddrefstack;       /* Internal node reference stack */
-int*         bddrefstacktop;    /* Internal node reference stack top */
-int*         bddvar2level;      /* Variable -> level table */
-int*         bddlevel2var;      /* Level -> variable table */
-jmp_buf      bddexception;      /* Long-jump point for interrupting calc. */
-int          bddresized;        /* Flag indicating a resize of the nodetable */
-
-bddCacheStat bddcachestats;
+#if ENABLE_REENTRANT
+   /* Threads that have not set up a manager point at this one, so that
+      reading the state before bdd_init() behaves as without managers */
+static bdd_manager bddnomanager;
 
-#if ENABLE_BTRACE
-FILE *bdd_trace_file = NULL;
+BDD_TLS bdd_manager *bddmanager = &bddnomanager;
+#else
+BddKernel bddkernel;
 #endif
 
 
 /*=== PRIVATE KERNEL VARIABLES =========================================*/
 
-static BDD*     bddvarset;             /* Set of defined BDD variables */
-static int      gbcollectnum;          /* Number of garbage collections */
-static int      cachesize;             /* Size of the operator caches */
-static long int gbcclock;              /* Clock ticks used in GBC */
-static int      usednodes_nextreorder; /* When to do reorder next time */
-static bddinthandler  err_handler;     /* Error handler */
-static bddgbchandler  gbc_handler;     /* Garbage collection handler */
-static bdd2inthandler resize_handler;  /* Node-table-resize handler */
+typedef struct s_KernelState
+{
+   /* Min. number of nodes (%) that has to be left after a garbage collect
+      unless a resize should be done. */
+   int      bddminfreenodes;
+#if ENABLE_GENGC
+   BDD*     bddyoung;              /* Nodes (indices) made since the last GBC */
+   BDD      bddyoungnum;           /* Number of such nodes */
+#endif
+#if ENABLE_OAUNIQUE
+   BddUnique* bddunique;           /* Open addressing unique table */
+   BddKey   bdduniquesize;         /* Number of slots (power of two) */
+   int      bdduniqueshift;        /* Key bits - log2(bdduniquesize) */
+   BDD      bdduniquenum;          /* Number of occupied slots */
+#endif
+   BDD*     bddvarset;             /* Set of defined BDD variables */
+   int      gbcollectnum;          /* Number of garbage collections */
+   int      bddcachesize;          /* Size of the operator caches */
+   long int gbcclock;              /* Clock ticks used in GBC */
+   BDD      usednodes_nextreorder; /* When to do reorder next time */
+   int      gbcthreads;            /* Threads used for garbage collection */
+   bddinthandler  err_handler;     /* Error handler */
+   bddgbchandler  gbc_handler;     /* Garbage collection handler */
+   bddresizehandler resize_handler; /* Node-table-resize handler */
+#if ENABLE_PARGC
+   GbcRange gbcrange[PARGCMAXTHREADS]; /* Parts of a parallel collection */
+#endif
+} KernelState;
+
+#define KERNELSTATE_INIT { .bddminfreenodes = 20, .gbcthreads = 1 }
+
+#if ENABLE_REENTRANT
+static const KernelState kernelstate_init = KERNELSTATE_INIT;
+#else
+static KernelState kernelstate = KERNELSTATE_INIT;
+#endif
+
+#define KSTATE BDDSTATE(KernelState, BDDMOD_KERNEL, kernelstate)
+#define bddminfreenodes       (KSTATE->bddminfreenodes)
+#if ENABLE_GENGC
+#define bddyoung              (KSTATE->bddyoung)
+#define bddyoungnum           (KSTATE->bddyoungnum)
+#endif
+#if ENABLE_OAUNIQUE
+#define bddunique             (KSTATE->bddunique)
+#define bdduniquesize         (KSTATE->bdduniquesize)
+#define bdduniqueshift        (KSTATE->bdduniqueshift)
+#define bdduniquenum          (KSTATE->bdduniquenum)
+#endif
+#define bddvarset             (KSTATE->bddvarset)
+#define gbcollectnum          (KSTATE->gbcollectnum)
+#define bddcachesize          (KSTATE->bddcachesize)
+#define gbcclock              (KSTATE->gbcclock)
+#define usednodes_nextreorder (KSTATE->usednodes_nextreorder)
+#define gbcthreads            (KSTATE->gbcthreads)
+#define err_handler           (KSTATE->err_handler)
+#define gbc_handler           (KSTATE->gbc_handler)
+#define resize_handler        (KSTATE->resize_handler)
+#if ENABLE_PARGC
+#define gbcrange              (KSTATE->gbcrange)
+#endif
 
 
    /* Strings for all error mesages */
@@ -190,7 +272,38 @@ static char *errorstrings[BDD_ERRNUM] =
 
 /*=== OTHER INTERNAL DEFINITIONS =======================================*/
 
-#define NODEHASH(lvl,l,h) (TRIPLE(lvl,l,h) % bddnodesize)
+#define NODEHASH(lvl,l,h) ((BDD)(NODEKEY(lvl,l,h) % (BddKey)bddnodesize))
+
+   /* Node table sizes are primes.  These are only searched for below
+      2^32, so a larger table in large mode gets an odd size instead */
+#if ENABLE_LARGE
+#define NODEPRIME_GTE(n) ((n) >= (BDD)UINT_MAX-64 ? ((n) | 1) : (BDD)bdd_prime_gte((unsigned int)(n)))
+#define NODEPRIME_LTE(n) ((n) >= (BDD)UINT_MAX ? (((n)-1) | 1) : (BDD)bdd_prime_lte((unsigned int)(n)))
+#else
+#define NODEPRIME_GTE(n) bdd_prime_gte(n)
+#define NODEPRIME_LTE(n) bdd_prime_lte(n)
+#endif
+
+#if ENABLE_OAUNIQUE
+   /* The unique table is probed linearly from a slot given by the
+      upper bits of a multiplicative hash of the node key.  It is
+      rebuilt on garbage collection, so no deletion markers are needed,
+      and it is doubled whenever it becomes half full. */
+#if ENABLE_LARGE
+#define UNIQUEKEYBITS       64
+#define UNIQUESLOT(key)     (((key) * 11400714819323198485ULL) >> bdduniqueshift)
+#else
+#define UNIQUEKEYBITS       32
+#define UNIQUESLOT(key)     (((key) * 2654435769U) >> bdduniqueshift)
+#endif
+#define UNIQUENEXT(pos)     (((pos) + 1) & (bdduniquesize - 1))
+#define UNIQUEMINSIZE       1024
+#define UNIQUEPREFETCHDIST  8
+
+static int  bdd_unique_init(BDD);
+static void bdd_unique_insert(BddKey, BDD);
+static int  bdd_unique_resize(void);
+#endif
 
 // Debugging macros.  Currently disabled
 
@@ -215,9 +328,179 @@ static char *errorstrings[BDD_ERRNUM] =
 /* } */
 
 #if ENABLE_TBDD
-static int bdd_dclause_p(BddNode *n, dclause_t dtype);
+static clause_id_t bdd_dclause_p(BddNode *n, dclause_t dtype);
+#endif
+
+#if ENABLE_PARGC
+static void bdd_gbc_pardone(void);
+#endif
+
+#if ENABLE_NODEARENA
+   /* Number of nodes initialized at a time when the free list runs dry */
+#define NODEINITCHUNK   (1 << 16)
+#endif
+
+#if ENABLE_PARAPPLY
+   /* Number of nodes an apply thread takes from the free list at a time */
+#define PARNODEBATCH    256
+
+   /* Protects the free list while apply threads refill their batches */
+static pthread_mutex_t bddfreelock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void *bdd_nodearray_resize(void*, size_t, BDD);
+static void bdd_nodearray_free(void*, size_t);
+
+#if ENABLE_REENTRANT
+/*************************************************************************
+  Managers
+*************************************************************************/
+
+   /* Allocate a state block, copied from 'init' or cleared if it is NULL */
+void *bdd_newstate(const void *init, size_t size)
+{
+   void *state = malloc(size);
+
+   if (state != NULL)
+   {
+      if (init != NULL)
+	 memcpy(state, init, size);
+      else
+	 memset(state, 0, size);
+   }
+
+   return state;
+}
+
+
+static bdd_manager *bdd_new_manager(void)
+{
+   bdd_manager *m = (bdd_manager*)calloc(1, sizeof(bdd_manager));
+   int n;
+
+   if (m == NULL)
+      return NULL;
+
+   m->state[BDDMOD_KERNEL] = bdd_newstate(&kernelstate_init, sizeof(KernelState));
+   m->state[BDDMOD_OP] = bdd_op_newstate();
+   m->state[BDDMOD_REORDER] = bdd_reorder_newstate();
+   m->state[BDDMOD_IO] = bdd_io_newstate();
+   m->state[BDDMOD_FDD] = bdd_fdd_newstate();
+   m->state[BDDMOD_PAIRS] = bdd_pairs_newstate();
+#if ENABLE_TBDD
+   m->state[BDDMOD_PROVER] = prover_newstate(&m->provervars);
+   m->state[BDDMOD_TBDD] = tbdd_newstate();
+   m->state[BDDMOD_PSEUDO] = pseudo_newstate();
 #endif
 
+   for (n=0 ; n<BDDMOD_NUM ; n++)
+      if (m->state[n] == NULL)
+      {
+	 for (n=0 ; n<BDDMOD_NUM ; n++)
+	    free(m->state[n]);
+	 free(m);
+	 return NULL;
+      }
+
+   return m;
+}
+
+
+   /* Give the thread a manager before it changes any state */
+void bdd_need_manager(void)
+{
+   if ((bddmanager=bdd_new_manager()) == NULL)
+   {
+      bddmanager = &bddnomanager;
+      bdd_default_errhandler(BDD_MEMORY);
+   }
+}
+
+
+/*
+NAME    {* bdd\_get\_manager *}
+SECTION {* kernel *}
+SHORT   {* get the current manager of the thread *}
+PROTO   {* bdd_manager *bdd_get_manager(void) *}
+DESCR   {* When compiled with {\tt ENABLE\_REENTRANT} all the state of a
+           package, from the node table to the proof file, is held by a
+	   manager. Every BDD function works on the current manager of
+	   the calling thread. A thread has no manager until it calls
+	   {\tt bdd\_init} (or one of the functions that configure the
+	   package before that) or {\tt bdd\_set\_manager}. *}
+RETURN  {* The current manager, or {\tt NULL} if the thread has none. *}
+ALSO    {* bdd\_set\_manager, bdd\_free\_manager, bdd\_init *}
+*/
+bdd_manager *bdd_get_manager(void)
+{
+   return bddmanager == &bddnomanager ? NULL : bddmanager;
+}
+
+
+/*
+NAME    {* bdd\_set\_manager *}
+SECTION {* kernel *}
+SHORT   {* set the current manager of the thread *}
+PROTO   {* bdd_manager *bdd_set_manager(bdd_manager *m) *}
+DESCR   {* Makes {\tt m}, as returned by {\tt bdd\_get\_manager}, the
+           current manager of the calling thread. A job can so be moved
+	   from one thread to another, and one thread can switch between
+	   several packages. A manager must not be used by two threads at
+	   the same time, except by the helper threads of
+	   {\tt ENABLE\_PARGC} and {\tt ENABLE\_PARAPPLY}, which the
+	   package starts on the manager of the calling thread. With
+	   {\tt m} being {\tt NULL} the thread is left without a manager,
+	   and the next {\tt bdd\_init} starts a new package. *}
+RETURN  {* The previous manager of the thread, or {\tt NULL}. *}
+ALSO    {* bdd\_get\_manager, bdd\_free\_manager *}
+*/
+bdd_manager *bdd_set_manager(bdd_manager *m)
+{
+   bdd_manager *old = bdd_get_manager();
+
+   bddmanager = (m == NULL ? &bddnomanager : m);
+   return old;
+}
+
+
+/*
+NAME    {* bdd\_free\_manager *}
+SECTION {* kernel *}
+SHORT   {* free a manager *}
+PROTO   {* int bdd_free_manager(bdd_manager *m) *}
+DESCR   {* Frees the manager {\tt m} once its package is done with
+           {\tt bdd\_done} or {\tt tbdd\_done}. If {\tt m} is the
+	   current manager of the calling thread, the thread is left
+	   without a manager. *}
+RETURN  {* Zero on succes, otherwise a negative error code. *}
+ALSO    {* bdd\_get\_manager, bdd\_set\_manager *}
+*/
+int bdd_free_manager(bdd_manager *m)
+{
+   bdd_manager *old = bddmanager;
+   int running, n;
+
+   if (m == NULL)
+      return 0;
+
+      /* The kernel variables are only named through the current manager */
+   bddmanager = m;
+   running = bddrunning;
+   bddmanager = old;
+   if (running)
+      return bdd_error(BDD_RUNNING);
+
+   if (m == bddmanager)
+      bddmanager = &bddnomanager;
+   for (n=0 ; n<BDDMOD_NUM ; n++)
+      free(m->state[n]);
+   free(m);
+
+   return 0;
+}
+#endif /* ENABLE_REENTRANT */
+
+
 /*************************************************************************
   BDD misc. user operations
 *************************************************************************/
@@ -226,7 +509,7 @@ static int bdd_dclause_p(BddNode *n, dclause_t dtype);
 NAME   {* bdd\_init *}
 SECTION {* kernel *}
 SHORT  {* initializes the BDD package *}
-PROTO  {* int bdd_init(int nodesize, int cachesize) *}
+PROTO  {* int bdd_init(BDD nodesize, int cachesize) *}
 DESCR  {* This function initiates the bdd package and {\em must} be called
           before any bdd operations are done. The argument {\tt nodesize}
 	  is the initial number of nodes in the nodetable and {\tt cachesize}
@@ -242,42 +525,120 @@ DESCR  {* This function initiates the bdd package and {\em must} be called
 	  The initial number of nodes is not critical for any bdd operation
 	  as the table will be resized whenever there are to few nodes left
 	  after a garbage collection. But it does have some impact on the
-	  efficency of the operations. *}
+	  efficency of the operations.
+
+	  When compiled with {\tt ENABLE\_REENTRANT} all package state
+	  belongs to the current manager of the calling thread. A thread
+	  without one gets a new manager here, so each thread may call
+	  {\tt bdd\_init} and then run its own, independent package. BDDs,
+	  pairs and TBDDs must only be used with the manager they were
+	  made by. *}
 RETURN {* If no errors occur then 0 is returned, otherwise
           a negative error code. *}
-ALSO   {* bdd\_done, bdd\_resize\_hook *}
+ALSO   {* bdd\_done, bdd\_resize\_hook, bdd\_set\_manager *}
 */
-int bdd_init(int initnodesize, int cs)
+int bdd_init(BDD initnodesize, int cs)
 {
-   int n, err;
+#if !ENABLE_NODEARENA
+   BDD n;
+#endif
+   int err;
+
+#if ENABLE_REENTRANT
+   if (bddmanager == &bddnomanager  &&
+       (bddmanager=bdd_new_manager()) == NULL)
+   {
+      bddmanager = &bddnomanager;
+      return BDD_MEMORY;
+   }
+#endif
 
    if (bddrunning)
       return bdd_error(BDD_RUNNING);
 
-   bddnodesize = bdd_prime_gte(initnodesize);
+   bddnodesize = NODEPRIME_GTE(initnodesize);
+#if ENABLE_NODEARENA
+   if (bddnodesize > BDD_ARENANODES)
+      bddnodesize = NODEPRIME_LTE(BDD_ARENANODES);
+#endif
 
-   if ((bddnodes=(BddNode*)malloc(sizeof(BddNode)*bddnodesize)) == NULL)
+   if ((bddnodes=(BddNode*)bdd_nodearray_resize(NULL, sizeof(BddNode), bddnodesize)) == NULL)
+      return bdd_error(BDD_MEMORY);
+#if ENABLE_SPLITNODE
+   if ((bddnodelinks=(BddNodeLink*)bdd_nodearray_resize(NULL, sizeof(BddNodeLink), bddnodesize)) == NULL)
+   {
+      bdd_nodearray_free(bddnodes, sizeof(BddNode));
+      bddnodes = NULL;
+      return bdd_error(BDD_MEMORY);
+   }
+#if ENABLE_TBDD
+   if ((bddnodeproofs=(BddNodeProof*)bdd_nodearray_resize(NULL, sizeof(BddNodeProof), bddnodesize)) == NULL)
+   {
+      bdd_nodearray_free(bddnodes, sizeof(BddNode));
+      bdd_nodearray_free(bddnodelinks, sizeof(BddNodeLink));
+      bddnodes = NULL;
+      bddnodelinks = NULL;
       return bdd_error(BDD_MEMORY);
+   }
+#endif
+#endif
 
    bddresized = 0;
 
+#if ENABLE_NODEARENA
+      /* Fresh arena pages are zero filled, so all hash chains are already
+	 empty. Only the first chunk of nodes is put on the free list now,
+	 the rest is initialized on demand by bdd_nodes_init(). */
+   bddfreepos = 0;
+   bddnodeinit = 2;
+   bdd_nodes_init(MIN(bddnodesize, NODEINITCHUNK));
+#else
    for (n=0 ; n<bddnodesize ; n++)
    {
       bddnodes[n].refcou = 0;
-      LOW(n) = -1;
-      bddnodes[n].hash = 0;
-      LEVEL(n) = 0;
-      bddnodes[n].next = n+1;
+      bddnodes[n].low = -1;
+      HASH(n) = 0;
+      bddnodes[n].level = 0;
+      NEXT(n) = n+1;
    }
-   bddnodes[bddnodesize-1].next = 0;
+   NEXT(bddnodesize-1) = 0;
+   bddfreepos = 2;
+   bddnodeinit = bddnodesize;
+#endif
 
    bddnodes[0].refcou = bddnodes[1].refcou = MAXREF;
-   LEVEL(0) = LEVEL(1) = MAXVAR;
-   LOW(0) = HIGH(0) = 0;
-   LOW(1) = HIGH(1) = 1;
+   bddnodes[0].level = bddnodes[1].level = MAXVAR;
+   bddnodes[0].low = bddnodes[0].high = 0;
+   bddnodes[1].low = bddnodes[1].high = 1;
 #if ENABLE_TBDD
-   XVAR(0) = -TAUTOLOGY;
-   XVAR(1) = TAUTOLOGY;
+   NODEXVAR(0) = -TAUTOLOGY;
+   NODEXVAR(1) = TAUTOLOGY;
+#endif
+
+   if ((bddmarkstack=(BDD*)bdd_nodearray_resize(NULL, sizeof(BDD), bddnodesize)) == NULL)
+   {
+      bdd_done();
+      return bdd_error(BDD_MEMORY);
+   }
+
+#if ENABLE_GENGC
+   bddyoungnum = 0;
+   bddgcepoch = 0;
+   if ((bddyoung=(BDD*)bdd_nodearray_resize(NULL, sizeof(BDD), bddnodesize)) == NULL  ||
+       (bddnodedeath=(unsigned int*)bdd_nodearray_resize(NULL, sizeof(unsigned int), bddnodesize)) == NULL)
+   {
+      bdd_done();
+      return bdd_error(BDD_MEMORY);
+   }
+   memset(bddnodedeath, 0, sizeof(unsigned int)*bddnodesize);
+#endif
+
+#if ENABLE_OAUNIQUE
+   if (bdd_unique_init(bddnodesize) < 0)
+   {
+      bdd_done();
+      return bdd_error(BDD_MEMORY);
+   }
 #endif
 
    if ((err=bdd_operator_init(cs)) < 0)
@@ -286,13 +647,12 @@ int bdd_init(int initnodesize, int cs)
       return err;
    }
 
-   bddfreepos = 2;
    bddfreenum = CHECKRANGE(bddnodesize-2);
    bddrunning = 1;
    bddvarnum = 0;
    gbcollectnum = 0;
    gbcclock = 0;
-   cachesize = cs;
+   bddcachesize = cs;
    usednodes_nextreorder = bddnodesize;
    bddmaxnodeincrease = DEFAULTMAXNODEINC;
 
@@ -302,8 +662,10 @@ int bdd_init(int initnodesize, int cs)
    bddcachestats.uniqueChain = 0;
    bddcachestats.uniqueHit = 0;
    bddcachestats.uniqueMiss = 0;
+   bddcachestats.uniqueMaxChain = 0;
    bddcachestats.opHit = 0;
    bddcachestats.opMiss = 0;
+   bddcachestats.opResize = 0;
    bddcachestats.swapCount = 0;
 
    bdd_gbc_hook(bdd_default_gbchandler);
@@ -338,13 +700,13 @@ void bdd_done(void)
 
 #if ENABLE_TBDD
    if (proof_type != PROOF_NONE) {
-       int dbuf[4+ILIST_OVHD];
+       clause_id_t dbuf[4+ILIST_OVHD];
        ilist dlist;
-       int id;
-       int n;
+       clause_id_t id;
+       BDD n;
 
        print_proof_comment(2, "Delete clauses for all remaining nodes");
-       for (n=bddnodesize-1; n>=2 ; n--)
+       for (n=bddnodeinit-1; n>=2 ; n--)
 	   {
 	       BddNode *node = &bddnodes[n];
 	       if (LEVELp(node) > 0 && LOWp(node) != -1)
@@ -361,7 +723,7 @@ void bdd_done(void)
 			   ilist_push(dlist, id);
 
 		       if (ilist_length(dlist) > 0)
-			   print_proof_comment(2, "Delete defining clauses for node N%d.", XVARp(node));
+			   print_proof_comment(2, "Delete defining clauses for node N%" PRIcid ".", XVARp(node));
 
 		       delete_clauses(dlist);
 		   }
@@ -369,20 +731,45 @@ void bdd_done(void)
    }
 #endif
 
-   free(bddnodes);
+   bdd_nodearray_free(bddnodes, sizeof(BddNode));
+#if ENABLE_OAUNIQUE
+   free(bddunique);
+   bddunique = NULL;
+   bdduniquesize = 0;
+#endif
+#if ENABLE_SPLITNODE
+   bdd_nodearray_free(bddnodelinks, sizeof(BddNodeLink));
+   bddnodelinks = NULL;
+#if ENABLE_TBDD
+   bdd_nodearray_free(bddnodeproofs, sizeof(BddNodeProof));
+   bddnodeproofs = NULL;
+#endif
+#endif
+#if ENABLE_PARGC
+   bdd_gbc_pardone();
+#endif
    free(bddrefstack);
+   bdd_nodearray_free(bddmarkstack, sizeof(BDD));
+#if ENABLE_GENGC
+   bdd_nodearray_free(bddyoung, sizeof(BDD));
+   bdd_nodearray_free(bddnodedeath, sizeof(unsigned int));
+   bddyoung = NULL;
+   bddnodedeath = NULL;
+#endif
    free(bddvarset);
    free(bddvar2level);
    free(bddlevel2var);
 
    bddnodes = NULL;
    bddrefstack = NULL;
+   bddmarkstack = NULL;
    bddvarset = NULL;
 
    bdd_operator_done();
 
    bddrunning = 0;
    bddnodesize = 0;
+   bddnodeinit = 0;
    bddmaxnodesize = 0;
    bddvarnum = 0;
    bddproduced = 0;
@@ -519,7 +906,7 @@ int bdd_setvarnum_ordered(int num, int *varlist)
 
    if (bddrefstack != NULL)
       free(bddrefstack);
-   bddrefstack = bddrefstacktop = (int*)malloc(sizeof(int)*(num*2+4));
+   bddrefstack = bddrefstacktop = (BDD*)malloc(sizeof(BDD)*(num*2+4));
 
    bddvarnum = num;
 
@@ -536,12 +923,12 @@ int bdd_setvarnum_ordered(int num, int *varlist)
 	 return -bdderrorcond;
       }
 
-      bddnodes[bddvarset[bdv*2]].refcou = MAXREF;
-      bddnodes[bddvarset[bdv*2+1]].refcou = MAXREF;
+      bddnodes[NODEIDX(bddvarset[bdv*2])].refcou = MAXREF;
+      bddnodes[NODEIDX(bddvarset[bdv*2+1])].refcou = MAXREF;
    }
 
-   LEVEL(0) = num;
-   LEVEL(1) = num;
+   bddnodes[0].level = num;
+   bddnodes[1].level = num;
    bddvar2level[num] = num;
    bddlevel2var[num] = num;
 
@@ -605,7 +992,10 @@ ALSO  {* bdd\_errstring *}
 */
 bddinthandler bdd_error_hook(bddinthandler handler)
 {
-   bddinthandler tmp = err_handler;
+   bddinthandler tmp;
+
+   CHECKMANAGER;
+   tmp = err_handler;
    err_handler = handler;
    return tmp;
 }
@@ -663,7 +1053,10 @@ RETURN {* The previous handler *}
 ALSO {* bdd\_resize\_hook, bdd\_reorder\_hook *} */
 bddgbchandler bdd_gbc_hook(bddgbchandler handler)
 {
-   bddgbchandler tmp = gbc_handler;
+   bddgbchandler tmp;
+
+   CHECKMANAGER;
+   tmp = gbc_handler;
    gbc_handler = handler;
    return tmp;
 }
@@ -673,7 +1066,7 @@ bddgbchandler bdd_gbc_hook(bddgbchandler handler)
 NAME  {* bdd\_resize\_hook  *}
 SECTION {* kernel *}
 SHORT {* set a handler for nodetable resizes *}
-PROTO {* bdd2inthandler bdd_resize_hook(bdd2inthandler handler) *}
+PROTO {* bddresizehandler bdd_resize_hook(bddresizehandler handler) *}
 DESCR {* Whenever it is impossible to get enough free nodes by a garbage
          collection then the node table is resized and a test is done to see
 	 if a handler is supllied by the user for this event. If so then
@@ -686,7 +1079,7 @@ DESCR {* Whenever it is impossible to get enough free nodes by a garbage
 
 	 Any handler should be defined like this:
 	 \begin{verbatim}
-void my_resize_handler(int oldsize, int newsize)
+void my_resize_handler(BDD oldsize, BDD newsize)
 {
    ...
 }
@@ -694,9 +1087,12 @@ void my_resize_handler(int oldsize, int newsize)
 RETURN {* The previous handler *}
 ALSO  {* bdd\_gbc\_hook, bdd\_reorder\_hook, bdd\_setminfreenodes  *}
 */
-bdd2inthandler bdd_resize_hook(bdd2inthandler handler)
+bddresizehandler bdd_resize_hook(bddresizehandler handler)
 {
-   bdd2inthandler tmp = handler;
+   bddresizehandler tmp;
+
+   CHECKMANAGER;
+   tmp = handler;
    resize_handler = handler;
    return tmp;
 }
@@ -716,8 +1112,10 @@ ALSO    {* bdd\_setmaxnodenum, bdd\_setminfreenodes *}
 */
 int bdd_setmaxincrease(int size)
 {
-   int old = bddmaxnodeincrease;
+   int old;
 
+   CHECKMANAGER;
+   old = bddmaxnodeincrease;
    if (size < 0)
       return bdd_error(BDD_SIZE);
 
@@ -725,11 +1123,42 @@ int bdd_setmaxincrease(int size)
    return old;
 }
 
+/*
+NAME    {* bdd\_setgbcthreads *}
+SECTION {* kernel *}
+SHORT   {* set the number of threads used for garbage collection *}
+PROTO   {* int bdd_setgbcthreads(int num) *}
+DESCR   {* Garbage collections are done by up to {\tt num} threads, each
+           handling at least 65536 nodes of the node table. This only
+	   has an effect if the package is compiled with
+	   {\tt ENABLE\_PARGC}. The default is one thread. *}
+RETURN  {* The old number of threads on succes, otherwise a negative
+           error code. *}
+ALSO    {* bdd\_gbc *}
+*/
+int bdd_setgbcthreads(int num)
+{
+   int old;
+
+   CHECKMANAGER;
+   old = gbcthreads;
+   if (num < 1)
+      return bdd_error(BDD_RANGE);
+
+#if ENABLE_PARGC
+   gbcthreads = MIN(num, PARGCMAXTHREADS);
+#else
+   gbcthreads = num;
+#endif
+   return old;
+}
+
+
 /*
 NAME    {* bdd\_setmaxnodenum *}
 SECTION {* kernel *}
 SHORT {* set the maximum available number of bdd nodes *}
-PROTO {* int bdd_setmaxnodenum(int size) *}
+PROTO {* BDD bdd_setmaxnodenum(BDD size) *}
 DESCR {* This function sets the maximal number of bdd nodes the package may
          allocate before it gives up a bdd operation. The
 	 argument {\tt size} is the absolute maximal number of nodes there
@@ -742,11 +1171,12 @@ DESCR {* This function sets the maximal number of bdd nodes the package may
 RETURN {* The old threshold on succes, otherwise a negative error code. *}
 ALSO   {* bdd\_setmaxincrease, bdd\_setminfreenodes *}
 */
-int bdd_setmaxnodenum(int size)
+BDD bdd_setmaxnodenum(BDD size)
 {
+   CHECKMANAGER;
    if (size > bddnodesize  ||  size == 0)
    {
-      int old = bddmaxnodesize;
+      BDD old = bddmaxnodesize;
       bddmaxnodesize = size;
       return old;
    }
@@ -775,12 +1205,14 @@ ALSO    {* bdd\_setmaxnodenum, bdd\_setmaxincrease *}
 */
 int bdd_setminfreenodes(int mf)
 {
-   int old = minfreenodes;
+   int old;
 
+   CHECKMANAGER;
+   old = bddminfreenodes;
    if (mf<0 || mf>100)
       return bdd_error(BDD_RANGE);
 
-   minfreenodes = mf;
+   bddminfreenodes = mf;
    return old;
 }
 
@@ -789,7 +1221,7 @@ int bdd_setminfreenodes(int mf)
 NAME    {* bdd\_getnodenum *}
 SECTION {* kernel *}
 SHORT   {* get the number of active nodes in use *}
-PROTO   {* int bdd_getnodenum(void) *}
+PROTO   {* BDD bdd_getnodenum(void) *}
 DESCR   {* Returns the number of nodes in the nodetable that are
            currently in use. Note that dead nodes that have not been
 	   reclaimed yet
@@ -797,7 +1229,7 @@ DESCR   {* Returns the number of nodes in the nodetable that are
 RETURN  {* The number of nodes. *}
 ALSO    {* bdd\_getallocnum, bdd\_setmaxnodenum *}
 */
-int bdd_getnodenum(void)
+BDD bdd_getnodenum(void)
 {
     return bddnodesize - CHECKRANGE(bddfreenum);
 }
@@ -806,13 +1238,13 @@ int bdd_getnodenum(void)
 NAME    {* bdd\_getallocnum *}
 SECTION {* kernel *}
 SHORT   {* get the number of allocated nodes *}
-PROTO   {* int bdd_getallocnum(void) *}
+PROTO   {* BDD bdd_getallocnum(void) *}
 DESCR   {* Returns the number of nodes currently allocated. This includes
            both dead and active nodes. *}
 RETURN  {* The number of nodes. *}
 ALSO    {* bdd\_getnodenum, bdd\_setmaxnodenum *}
 */
-int bdd_getallocnum(void)
+BDD bdd_getallocnum(void)
 {
    return bddnodesize;
 }
@@ -881,9 +1313,9 @@ void bdd_stats(bddStat *s)
    s->nodenum = bddnodesize;
    s->maxnodenum = bddmaxnodesize;
    s->freenodes = bddfreenum;
-   s->minfreenodes = minfreenodes;
+   s->minfreenodes = bddminfreenodes;
    s->varnum = bddvarnum;
-   s->cachesize = cachesize;
+   s->cachesize = bddcachesize;
    s->gbcnum = gbcollectnum;
 
 }
@@ -905,6 +1337,13 @@ ALSO    {* bddCacheStat, bdd\_printstat *}
 void bdd_cachestats(bddCacheStat *s)
 {
    *s = bddcachestats;
+#if ENABLE_OAUNIQUE
+   s->uniqueSize = bdduniquesize;
+   s->uniqueNodes = bdduniquenum;
+#else
+   s->uniqueSize = bddnodesize;
+   s->uniqueNodes = bddnodesize - bddfreenum;
+#endif
 }
 
 
@@ -938,11 +1377,18 @@ void bdd_fprintstat(FILE *ofile)
    fprintf(ofile, "c => Hit rate =   %.2f\n",
 	   (s.uniqueHit+s.uniqueMiss > 0) ?
 	   ((float)s.uniqueHit)/((float)s.uniqueHit+s.uniqueMiss) : 0);
+   fprintf(ofile, "c => Avg chain =  %.2f\n",
+	   (s.uniqueAccess > 0) ?
+	   ((float)s.uniqueChain)/((float)s.uniqueAccess) : 0);
+   fprintf(ofile, "c Unique Max Chain: %ld\n", s.uniqueMaxChain);
+   fprintf(ofile, "c Unique Size:    %ld\n", s.uniqueSize);
+   fprintf(ofile, "c Unique Nodes:   %ld\n", s.uniqueNodes);
    fprintf(ofile, "c Operator Hits:  %ld\n", s.opHit);
    fprintf(ofile, "c Operator Miss:  %ld\n", s.opMiss);
    fprintf(ofile, "c => Hit rate =   %.2f\n",
 	   (s.opHit+s.opMiss > 0) ?
 	   ((float)s.opHit)/((float)s.opHit+s.opMiss) : 0);
+   fprintf(ofile, "c Operator Resize: %ld\n", s.opResize);
    fprintf(ofile, "c Swap count =    %ld\n", s.swapCount);
 }
 
@@ -989,6 +1435,11 @@ void bdd_default_errhandler(int e)
 
 int bdd_error(int e)
 {
+#if ENABLE_REENTRANT
+      /* No handler is installed before the thread has a manager */
+   if (bddmanager->state[BDDMOD_KERNEL] == NULL)
+      return e;
+#endif
    if (err_handler != NULL)
       err_handler(e);
 
@@ -1165,12 +1616,12 @@ BDD bdd_high(BDD root)
 NAME    {* bdd\_xvar *}
 SECTION {* info *}
 SHORT   {* gets the extension variable associated with a bdd node *}
-PROTO   {* BDD bdd_xvar(BDD r) *}
+PROTO   {* clause_id_t bdd_xvar(BDD r) *}
 DESCR   {* Gets the extension variable assoicated with bdd node {\tt r} *}
 RETURN  {* The extension variable *}
 ALSO    {* bdd\_nameid*}
 */
-BDD bdd_xvar(BDD root)
+clause_id_t bdd_xvar(BDD root)
 {
    CHECK(root);
    return (XVAR(root));
@@ -1180,17 +1631,23 @@ BDD bdd_xvar(BDD root)
 NAME    {* bdd\_dclause *}
 SECTION {* info *}
 SHORT   {* gets the id of specified defining clause of a node *}
-PROTO   {* BDD bdd_dclause(BDD r dclause_t dtype) *}
+PROTO   {* clause_id_t bdd_dclause(BDD r, dclause_t dtype) *}
 DESCR   {* gets id of defining clause {\tt dtype} for node {\tt r} *}
 RETURN  {* The bdd of the true branch *}
 ALSO    {* bdd\_xvar *}
 */
-int bdd_dclause(BDD root, dclause_t dtype)
+clause_id_t bdd_dclause(BDD root, dclause_t dtype)
 {
    CHECK(root);
    if (root < 2)
        return TAUTOLOGY;
-   int result = DCLAUSE(root) + dtype;
+#if ENABLE_COMPLEMENT
+   /* The clauses of a negated node are those of the node with the
+      roles of the up and down clauses exchanged */
+   clause_id_t result = DCLAUSE(root) + (ISCOMPL(root) ? dtype ^ DEF_HD : dtype);
+#else
+   clause_id_t result = DCLAUSE(root) + dtype;
+#endif
    switch (dtype) {
    case DEF_HU:
        return ISZERO(HIGH(root)) ? TAUTOLOGY : result;
@@ -1206,9 +1663,9 @@ int bdd_dclause(BDD root, dclause_t dtype)
    }
 }
 
-static int bdd_dclause_p(BddNode *n, dclause_t dtype)
+static clause_id_t bdd_dclause_p(BddNode *n, dclause_t dtype)
 {
-   int result = DCLAUSEp(n) + dtype;
+   clause_id_t result = DCLAUSEp(n) + dtype;
    switch (dtype) {
    case DEF_HU:
        return ISZERO(HIGHp(n)) ? TAUTOLOGY : result;
@@ -1227,12 +1684,12 @@ static int bdd_dclause_p(BddNode *n, dclause_t dtype)
 NAME    {* bdd\_nameid *}
 SECTION {* info *}
 SHORT   {* gets an integer representation of a node for documentation purposes *}
-PROTO   {* BDD bdd_nameid(BDD r) *}
+PROTO   {* clause_id_t bdd_nameid(BDD r) *}
 DESCR   {* gets an integer representation of {\tt r} for documentation purposes *}
 RETURN  {* The integer *}
 ALSO    {* bdd\_xvar *}
 */
-BDD bdd_nameid(BDD root)
+clause_id_t bdd_nameid(BDD root)
 {
    CHECK(root);
    return (NNAME(root));
@@ -1251,7 +1708,8 @@ void bdd_default_gbchandler(int pre, bddGbcStat *s)
 {
    if (!pre)
    {
-      printf("c Garbage collection #%d: %d nodes / %d free / %d previously freed ",
+      printf("c %s collection #%d: %" PRIbdd " nodes / %" PRIbdd " free / %" PRIbdd " previously freed ",
+	     s->young ? "Young garbage" : "Garbage",
 	     s->num, s->nodes, s->freenodes, s->prevfreednodes);
       printf(" / %.1fs / %.1fs total\n",
 	     (float)s->time/(float)(CLOCKS_PER_SEC),
@@ -1260,9 +1718,74 @@ void bdd_default_gbchandler(int pre, bddGbcStat *s)
 }
 
 
+#if ENABLE_OAUNIQUE
+
+static int bdd_unique_init(BDD size)
+{
+   bdduniquesize = 1;
+   bdduniqueshift = UNIQUEKEYBITS;
+   while (bdduniquesize < UNIQUEMINSIZE  ||  bdduniquesize < (BddKey)size)
+   {
+      bdduniquesize <<= 1;
+      bdduniqueshift--;
+   }
+
+   if ((bddunique=NEW(BddUnique,bdduniquesize)) == NULL)
+      return -1;
+   memset(bddunique, 0, sizeof(BddUnique)*bdduniquesize);
+   bdduniquenum = 0;
+   return 0;
+}
+
+
+static void bdd_unique_insert(BddKey key, BDD n)
+{
+   register BddKey pos = UNIQUESLOT(key);
+
+   while (bddunique[pos].node != 0)
+      pos = UNIQUENEXT(pos);
+
+   bddunique[pos].key = key;
+   bddunique[pos].node = n;
+   bdduniquenum++;
+}
+
+
+   /* Double the unique table and reinsert all nodes in use */
+static int bdd_unique_resize(void)
+{
+   BddUnique *newtable;
+   BDD n;
+
+   if (bdduniqueshift == 0)
+      return -1;
+   newtable = NEW(BddUnique, bdduniquesize << 1);
+   if (newtable == NULL)
+      return -1;
+
+   free(bddunique);
+   bddunique = newtable;
+   bdduniquesize <<= 1;
+   bdduniqueshift--;
+   memset(bddunique, 0, sizeof(BddUnique)*bdduniquesize);
+   bdduniquenum = 0;
+
+   for (n=2 ; n<bddnodeinit ; n++)
+   {
+      register BddNode *node = &bddnodes[n];
+
+      if (LOWp(node) != -1)
+	 bdd_unique_insert(NODEKEY(LEVELp(node), LOWp(node), HIGHp(node)), n);
+   }
+   return 0;
+}
+
+#else /* ENABLE_OAUNIQUE */
+
+
 static void bdd_gbc_rehash(void)
 {
-   int n;
+   BDD n;
 
    bddfreepos = 0;
    bddfreenum = 0;
@@ -1273,82 +1796,679 @@ static void bdd_gbc_rehash(void)
 
       if (LOWp(node) != -1)
       {
-	 register unsigned int hash;
+	 register BDD hash;
 
 	 hash = NODEHASH(LEVELp(node), LOWp(node), HIGHp(node));
-	 node->next = bddnodes[hash].hash;
-	 bddnodes[hash].hash = n;
+	 NEXTp(node) = HASH(hash);
+	 HASH(hash) = n;
       }
       else
       {
-	 node->next = CHECKNODE(bddfreepos);
+	 NEXTp(node) = CHECKNODE(bddfreepos);
 	 bddfreepos = CHECKNODE(n);
 	 CHECKRANGE(bddfreenum++);
       }
    }
 }
 
+#endif /* ENABLE_OAUNIQUE */
 
-void bdd_gbc(void)
-{
-   int *r;
-   int n;
-   long int c2, c1 = clock();
-   int freed = 0;
 
-#if ENABLE_TBDD
-   int dbuf[4+ILIST_OVHD];
-   ilist dlist;
-   int id;
+#if ENABLE_PARGC
 
-#if DO_TRACE
-   printf("Starting GC\n");
-#endif
+/* Multi-threaded garbage collection. The node table is split into one
+ * range per thread. In the first phase each thread marks from the
+ * referenced nodes in its range, setting the mark bits atomically since
+ * the marked sub-graphs overlap. In the second phase each thread sweeps
+ * its range: live nodes are pushed atomically on the unique table, dead
+ * nodes are put on a free list private to the range. The free lists are
+ * then joined in node order and the defining clauses of the dead nodes
+ * are deleted in the same order as in the sequential collector, so the
+ * proof does not depend on the number of threads.
+ */
+
+static unsigned int gbcmarkbit;  /* MARKON as found in the first node word */
+
+   /* Set the mark bit of a node. Returns true if it was not set already */
+#if ENABLE_LARGE
+#define GBCTRYMARK(p) \
+   (!(__atomic_fetch_or(&(p)->level, MARKON, __ATOMIC_RELAXED) & MARKON))
+#else
+#define GBCTRYMARK(p) \
+   (!(__atomic_fetch_or((unsigned int*)(p), gbcmarkbit, __ATOMIC_RELAXED) \
+      & gbcmarkbit))
 #endif
 
 
-   if (gbc_handler != NULL)
-   {
-      bddGbcStat s;
-      s.nodes = bddnodesize;
-      s.freenodes = bddfreenum;
-      s.time = 0;
-      s.sumtime = gbcclock;
-      s.num = gbcollectnum;
-      gbc_handler(1, &s);
-   }
+static int bdd_gbc_growstack(GbcRange *r)
+{
+   BDD size = r->stacksize == 0 ? 1024 : 2*r->stacksize;
+   BDD *stack = (BDD*)realloc(r->stack, sizeof(BDD)*size);
 
-   for (r=bddrefstack ; r<bddrefstacktop ; r++) {
-       bdd_mark(*r);
-   }
+   if (stack == NULL)
+      return -1;
+   r->stack = stack;
+   r->stacksize = size;
+   return 0;
+}
 
-   for (n=0 ; n<bddnodesize ; n++)
-   {
-       if (bddnodes[n].refcou > 0) {
-	   bdd_mark(n);
-       }
-      bddnodes[n].hash = 0;
-   }
 
-   bddfreepos = 0;
-   bddfreenum = 0;
+static void bdd_gbc_markfrom(GbcRange *r, BDD n)
+{
+   BddNode *node = &bddnodes[n];
+   BDD sp = 0;
 
-#if ENABLE_TBDD
-   print_proof_comment(2, "Deleting clauses for nodes that have been collected");
-#endif
+   if (MARKEDp(node)  ||  LOWp(node) == -1  ||  !GBCTRYMARK(node))
+      return;
 
-   for (n=bddnodesize-1 ; n>=2 ; n--)
+   if (r->stacksize == 0  &&  bdd_gbc_growstack(r) < 0)
    {
-      register BddNode *node = &bddnodes[n];
+      r->error = 1;
+      return;
+   }
+   r->stack[sp++] = n;
 
-      if ((LEVELp(node) & MARKON)  &&  LOWp(node) != -1)
-      {
-	 register unsigned int hash;
+   while (sp > 0)
+   {
+      BDD c[2];
+      int k;
 
-	 LEVELp(node) &= MARKOFF;
-	 hash = NODEHASH(LEVELp(node), LOWp(node), HIGHp(node));
-	 node->next = bddnodes[hash].hash;
-	 bddnodes[hash].hash = n;
+      node = &bddnodes[r->stack[--sp]];
+      c[0] = LOWp(node);
+      c[1] = HIGHp(node);
+      PREFETCH(&bddnodes[NODEIDX(c[0])]);
+      PREFETCH(&bddnodes[NODEIDX(c[1])]);
+
+      for (k=0 ; k<2 ; k++)
+      {
+	 if (c[k] < 2)
+	    continue;
+
+	 node = &bddnodes[NODEIDX(c[k])];
+	 if (MARKEDp(node)  ||  LOWp(node) == -1  ||  !GBCTRYMARK(node))
+	    continue;
+
+	 if (sp == r->stacksize  &&  bdd_gbc_growstack(r) < 0)
+	 {
+	    r->error = 1;
+	    return;
+	 }
+	 r->stack[sp++] = NODEIDX(c[k]);
+      }
+   }
+}
+
+
+static void *bdd_gbc_markthread(void *arg)
+{
+   GbcRange *r = (GbcRange*)arg;
+   BDD n;
+
+#if ENABLE_REENTRANT
+   bddmanager = r->manager;
+#endif
+   for (n=r->lo ; n<r->hi  &&  !r->error ; n++)
+   {
+#if !ENABLE_OAUNIQUE
+      HASH(n) = 0;
+#endif
+      if (n >= 2  &&  bddnodes[n].refcou > 0)
+	 bdd_gbc_markfrom(r, n);
+   }
+
+      /* Finish clearing the hash table if marking was given up */
+#if !ENABLE_OAUNIQUE
+   for ( ; n<r->hi ; n++)
+      HASH(n) = 0;
+#endif
+   return NULL;
+}
+
+
+#if ENABLE_OAUNIQUE
+static void bdd_unique_insert_atomic(BddKey key, BDD n)
+{
+   register BddKey pos = UNIQUESLOT(key);
+
+   for (;;)
+   {
+      BDD empty = 0;
+
+      if (__atomic_load_n(&bddunique[pos].node, __ATOMIC_RELAXED) == 0  &&
+	  __atomic_compare_exchange_n(&bddunique[pos].node, &empty, n, 0,
+				      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+	 break;
+      pos = UNIQUENEXT(pos);
+   }
+
+   bddunique[pos].key = key;
+}
+#endif
+
+
+#if ENABLE_TBDD
+static void bdd_gbc_deleteclauses(clause_id_t xvar, clause_id_t *ids, int num)
+{
+   clause_id_t dbuf[4+ILIST_OVHD];
+   ilist dlist = ilist_make(dbuf, 4);
+   int k;
+
+   for (k=0 ; k<num ; k++)
+      ilist_push(dlist, ids[k]);
+
+   if (ilist_length(dlist) > 0)
+      print_proof_comment(2, "Delete defining clauses for node N%" PRIcid, xvar);
+   delete_clauses(dlist);
+}
+
+
+   /* Find the defining clauses of a dead node and either delete them now
+      or record them for later. Returns -1 if there is no room to record */
+static int bdd_gbc_collectclauses(GbcRange *r, BddNode *node, int direct)
+{
+   clause_id_t ids[4], id;
+   int num = 0, k;
+
+   if ((id = bdd_dclause_p(node, DEF_HU)) != TAUTOLOGY)
+      ids[num++] = id;
+   if ((id = bdd_dclause_p(node, DEF_LU)) != TAUTOLOGY)
+      ids[num++] = id;
+   if ((id = bdd_dclause_p(node, DEF_HD)) != TAUTOLOGY)
+      ids[num++] = id;
+   if ((id = bdd_dclause_p(node, DEF_LD)) != TAUTOLOGY)
+      ids[num++] = id;
+
+   if (direct)
+   {
+      bdd_gbc_deleteclauses(XVARp(node), ids, num);
+      return 0;
+   }
+
+   if (r->delnum + 6 > r->delsize)
+   {
+      BDD size = r->delsize == 0 ? 4096 : 2*r->delsize;
+      clause_id_t *dels = (clause_id_t*)realloc(r->dels, sizeof(clause_id_t)*size);
+
+      if (dels == NULL)
+	 return -1;
+      r->dels = dels;
+      r->delsize = size;
+   }
+
+   r->dels[r->delnum++] = XVARp(node);
+   r->dels[r->delnum++] = num;
+   for (k=0 ; k<num ; k++)
+      r->dels[r->delnum++] = ids[k];
+   return 0;
+}
+#endif
+
+
+   /* Sweep the range downwards from r->pos. When "direct" is false this
+      runs concurrently with the other ranges, and it stops early if the
+      deleted clauses cannot be recorded. */
+static void bdd_gbc_sweeprange(GbcRange *r, int direct)
+{
+   BDD lo = MAX(r->lo, 2);
+
+   for ( ; r->pos>=lo ; r->pos--)
+   {
+      BDD n = r->pos;
+      register BddNode *node = &bddnodes[n];
+
+      if ((LEVELp(node) & MARKON)  &&  LOWp(node) != -1)
+      {
+	 LEVELp(node) &= MARKOFF;
+#if ENABLE_OAUNIQUE
+	 if (direct)
+	    bdd_unique_insert(NODEKEY(LEVELp(node), LOWp(node), HIGHp(node)), n);
+	 else
+	 {
+	    bdd_unique_insert_atomic(NODEKEY(LEVELp(node), LOWp(node),
+					    HIGHp(node)), n);
+	    r->uniquenum++;
+	 }
+#else
+	 {
+	    register BDD hash;
+
+	    hash = NODEHASH(LEVELp(node), LOWp(node), HIGHp(node));
+	    NEXTp(node) = __atomic_exchange_n(&HASH(hash), n, __ATOMIC_RELAXED);
+	 }
+#endif
+      }
+      else
+      {
+	 if (LOWp(node) != -1)
+	 {
+#if ENABLE_TBDD
+	    if (proof_type != PROOF_NONE  &&
+		bdd_gbc_collectclauses(r, node, direct) < 0)
+	       return;
+#endif
+	    r->freed++;
+	 }
+
+	 LOWp(node) = -1;
+	 NEXTp(node) = r->freepos;
+	 if (r->freepos == 0)
+	    r->freelast = n;
+	 r->freepos = n;
+	 r->freenum++;
+      }
+   }
+}
+
+
+static void *bdd_gbc_sweepthread(void *arg)
+{
+   GbcRange *r = (GbcRange*)arg;
+
+#if ENABLE_REENTRANT
+   bddmanager = r->manager;
+#endif
+   bdd_gbc_sweeprange(r, 0);
+   return NULL;
+}
+
+
+   /* Run one function on all ranges. A range that does not get a thread
+      of its own is handled by the calling thread. The threads work on
+      the manager of the calling thread. */
+static void bdd_gbc_runthreads(void *(*fn)(void*), int num)
+{
+   pthread_t thread[PARGCMAXTHREADS];
+   int started[PARGCMAXTHREADS];
+   int n;
+
+#if ENABLE_REENTRANT
+   for (n=0 ; n<num ; n++)
+      gbcrange[n].manager = bddmanager;
+#endif
+
+   for (n=1 ; n<num ; n++)
+      started[n] = pthread_create(&thread[n], NULL, fn, &gbcrange[n]) == 0;
+
+   fn(&gbcrange[0]);
+
+   for (n=1 ; n<num ; n++)
+   {
+      if (started[n])
+	 pthread_join(thread[n], NULL);
+      else
+	 fn(&gbcrange[n]);
+   }
+}
+
+
+   /* Collect garbage with up to "gbcthreads" threads. Returns the number
+      of nodes collected, or -1 if the collection should be done by
+      bdd_gbc_sequential() instead. */
+static BDD bdd_gbc_parallel(void)
+{
+   int num = (int)MIN(gbcthreads, bddnodesize / PARGCMINNODES);
+   BDD *r;
+   BDD next, freed;
+   int n, error;
+
+   if (num < 2)
+      return -1;
+#if ENABLE_BTRACE
+   if (bdd_trace_file)
+      return -1;
+#endif
+
+   if (gbcmarkbit == 0)
+   {
+      BddNode tmp;
+
+      memset(&tmp, 0, sizeof(BddNode));
+      tmp.level = MARKON;
+      memcpy(&gbcmarkbit, &tmp, sizeof(unsigned int));
+   }
+
+   for (r=bddrefstack ; r<bddrefstacktop ; r++)
+      bdd_mark(*r);
+
+   for (n=0 ; n<num ; n++)
+   {
+      GbcRange *g = &gbcrange[n];
+
+      g->lo = (BDD)(((long long)bddnodesize * n) / num);
+      g->hi = (BDD)(((long long)bddnodesize * (n+1)) / num);
+      g->error = 0;
+   }
+
+   bdd_gbc_runthreads(bdd_gbc_markthread, num);
+
+   for (n=0, error=0 ; n<num ; n++)
+      error |= gbcrange[n].error;
+
+      /* Out of memory for a mark stack - start again in one thread */
+   if (error)
+   {
+      BDD m;
+
+      for (m=0 ; m<bddnodesize ; m++)
+	 UNMARK(m);
+      return -1;
+   }
+
+#if ENABLE_OAUNIQUE
+   memset(bddunique, 0, sizeof(BddUnique)*bdduniquesize);
+   bdduniquenum = 0;
+#endif
+
+#if ENABLE_TBDD
+   print_proof_comment(2, "Deleting clauses for nodes that have been collected");
+#endif
+
+   for (n=0 ; n<num ; n++)
+   {
+      GbcRange *g = &gbcrange[n];
+
+      g->pos = g->hi-1;
+      g->freepos = g->freelast = 0;
+      g->freenum = g->freed = 0;
+#if ENABLE_OAUNIQUE
+      g->uniquenum = 0;
+#endif
+#if ENABLE_TBDD
+      g->delnum = 0;
+#endif
+   }
+
+   bdd_gbc_runthreads(bdd_gbc_sweepthread, num);
+
+      /* Delete clauses and join the free lists from the top of the table,
+	 which is the order used by bdd_gbc_sequential() */
+   for (n=num-1, next=0, freed=0 ; n>=0 ; n--)
+   {
+      GbcRange *g = &gbcrange[n];
+
+#if ENABLE_OAUNIQUE
+      bdduniquenum += g->uniquenum;
+#endif
+#if ENABLE_TBDD
+      {
+	 BDD k = 0;
+
+	 while (k < g->delnum)
+	 {
+	    bdd_gbc_deleteclauses(g->dels[k], &g->dels[k+2], (int)g->dels[k+1]);
+	    k += 2 + g->dels[k+1];
+	 }
+      }
+#endif
+
+	 /* Finish a range that ran out of memory for the clause record */
+      bdd_gbc_sweeprange(g, 1);
+
+      if (g->freenum > 0)
+      {
+	 NEXT(g->freelast) = next;
+	 next = g->freepos;
+      }
+      freed += g->freed;
+   }
+
+   bddfreepos = next;
+   bddfreenum = 0;
+   for (n=0 ; n<num ; n++)
+      bddfreenum += gbcrange[n].freenum;
+
+   return freed;
+}
+
+
+static void bdd_gbc_pardone(void)
+{
+   int n;
+
+   for (n=0 ; n<PARGCMAXTHREADS ; n++)
+   {
+      free(gbcrange[n].stack);
+      gbcrange[n].stack = NULL;
+      gbcrange[n].stacksize = 0;
+#if ENABLE_TBDD
+      free(gbcrange[n].dels);
+      gbcrange[n].dels = NULL;
+      gbcrange[n].delsize = 0;
+#endif
+   }
+}
+
+#endif /* ENABLE_PARGC */
+
+
+#if ENABLE_GENGC
+
+/* Generational garbage collection. Since nodes are never changed after
+ * they are made (except while reordering, which ends with a full
+ * collection), a node can only point to nodes older than itself. The
+ * nodes made since the last collection (the young nodes, listed in
+ * "bddyoung") can therefore only be reached from young nodes with a
+ * reference and from the reference stack. A young collection marks and
+ * sweeps these nodes only, so its cost depends on the number of nodes
+ * made since the last collection and not on the size of the node table.
+ * The mark bit is used inverted: all young nodes are marked first and the
+ * mark is removed from the ones found to be alive.
+ *
+ * The operator caches are not cleared, as that would cost time in
+ * proportion to their size. Instead each young collection starts a new
+ * epoch, and a freed node records the epoch in "bddnodedeath". A cache
+ * entry made in an earlier epoch is only used if none of its nodes has
+ * been freed since (see cache.h).
+ */
+
+#if ENABLE_OAUNIQUE
+   /* Remove node n from the unique table by shifting later entries of its
+      probe sequence back, so no deletion markers are needed */
+static void bdd_unique_remove(BddKey key, BDD n)
+{
+   register BddKey pos = UNIQUESLOT(key);
+   BddKey next;
+
+   while (bddunique[pos].node != n)
+      pos = UNIQUENEXT(pos);
+
+   for (next=UNIQUENEXT(pos) ; bddunique[next].node != 0 ;
+	next=UNIQUENEXT(next))
+   {
+      BddKey home = UNIQUESLOT(bddunique[next].key);
+
+	 /* Leave the entry if its home slot is in (pos,next] */
+      if (pos <= next ? (pos < home  &&  home <= next)
+	              : (pos < home  ||  home <= next))
+	 continue;
+
+      bddunique[pos] = bddunique[next];
+      pos = next;
+   }
+
+   bddunique[pos].node = 0;
+   bdduniquenum--;
+}
+#endif
+
+
+static void bdd_gbc_unlink(BddNode *node, BDD n)
+{
+#if ENABLE_OAUNIQUE
+   bdd_unique_remove(NODEKEY(LEVELp(node), LOWp(node), HIGHp(node)), n);
+#else
+   BDD *p = &HASH(NODEHASH(LEVELp(node), LOWp(node), HIGHp(node)));
+
+      /* Young nodes are found first in the chains, so this is short */
+   while (*p != n)
+      p = &NEXT(*p);
+   *p = NEXTp(node);
+#endif
+}
+
+
+   /* Clear the mark of node r if it is young and push it on the stack */
+#define YOUNGPUSH(sp,r) \
+   { if ((r) >= 2  &&  MARKED(r)) { UNMARK(r); *(sp)++ = NODEIDX(r); } }
+
+static BDD bdd_gbc_young(void)
+{
+   BDD *sp = bddmarkstack;
+   BDD *r;
+   BDD n, freed = 0;
+
+#if ENABLE_TBDD
+   clause_id_t dbuf[4+ILIST_OVHD];
+   ilist dlist;
+   clause_id_t id;
+#endif
+
+   bddgcepoch++;
+
+   for (n=0 ; n<bddyoungnum ; n++)
+      SETMARK(NODEREF(bddyoung[n]));
+
+   for (r=bddrefstack ; r<bddrefstacktop ; r++)
+      YOUNGPUSH(sp, *r);
+
+   for (n=0 ; n<bddyoungnum ; n++)
+   {
+      if (bddnodes[bddyoung[n]].refcou > 0)
+	 YOUNGPUSH(sp, NODEREF(bddyoung[n]));
+
+      while (sp > bddmarkstack)
+      {
+	 BddNode *node = &bddnodes[*--sp];
+	 BDD low = LOWp(node), high = HIGHp(node);
+
+	 PREFETCH(&bddnodes[NODEIDX(low)]);
+	 PREFETCH(&bddnodes[NODEIDX(high)]);
+	 YOUNGPUSH(sp, low);
+	 YOUNGPUSH(sp, high);
+      }
+   }
+
+#if ENABLE_TBDD
+   print_proof_comment(2, "Deleting clauses for young nodes that have been collected");
+#endif
+
+   for (n=bddyoungnum-1 ; n>=0 ; n--)
+   {
+      BDD i = bddyoung[n];
+      BddNode *node = &bddnodes[i];
+
+      if (!MARKEDp(node))
+	 continue;
+      UNMARKp(node);
+
+      bdd_gbc_unlink(node, i);
+      bddnodedeath[i] = bddgcepoch;
+
+#if ENABLE_TBDD
+      if (proof_type != PROOF_NONE)
+      {
+	 dlist = ilist_make(dbuf, 4);
+	 /* Delete defining clauses */
+	 if ((id = bdd_dclause_p(node, DEF_HU)) != TAUTOLOGY)
+	    ilist_push(dlist, id);
+	 if ((id = bdd_dclause_p(node, DEF_LU)) != TAUTOLOGY)
+	    ilist_push(dlist, id);
+	 if ((id = bdd_dclause_p(node, DEF_HD)) != TAUTOLOGY)
+	    ilist_push(dlist, id);
+	 if ((id = bdd_dclause_p(node, DEF_LD)) != TAUTOLOGY)
+	    ilist_push(dlist, id);
+
+	 if (ilist_length(dlist) > 0)
+	    print_proof_comment(2, "Delete defining clauses for node N%" PRIcid, XVARp(node));
+	 delete_clauses(dlist);
+      }
+#endif
+#if ENABLE_BTRACE
+      if (bdd_trace_file)
+	 fprintf(bdd_trace_file, "d %" PRIbdd "\n", i);
+#endif
+
+      freed++;
+      LOWp(node) = -1;
+      NEXTp(node) = CHECKNODE(bddfreepos);
+      bddfreepos = CHECKNODE(i);
+      CHECKRANGE(bddfreenum++);
+   }
+
+   return freed;
+}
+
+#endif /* ENABLE_GENGC */
+
+
+   /* Mark from all roots and sweep the whole node table in one thread.
+      Returns the number of nodes collected. */
+static BDD bdd_gbc_sequential(void)
+{
+   BDD *r;
+   BDD n;
+   BDD freed = 0;
+
+#if ENABLE_TBDD
+   clause_id_t dbuf[4+ILIST_OVHD];
+   ilist dlist;
+   clause_id_t id;
+#endif
+
+   for (r=bddrefstack ; r<bddrefstacktop ; r++) {
+       bdd_mark(*r);
+   }
+
+   for (n=0 ; n<bddnodesize ; n++)
+   {
+       if (bddnodes[n].refcou > 0) {
+	   bdd_mark(NODEREF(n));
+       }
+#if !ENABLE_OAUNIQUE
+      HASH(n) = 0;
+#endif
+   }
+
+   bddfreepos = 0;
+   bddfreenum = 0;
+
+#if ENABLE_OAUNIQUE
+   memset(bddunique, 0, sizeof(BddUnique)*bdduniquesize);
+   bdduniquenum = 0;
+#endif
+
+#if ENABLE_TBDD
+   print_proof_comment(2, "Deleting clauses for nodes that have been collected");
+#endif
+
+   for (n=bddnodesize-1 ; n>=2 ; n--)
+   {
+      register BddNode *node = &bddnodes[n];
+
+#if ENABLE_OAUNIQUE
+      if (n >= 2+UNIQUEPREFETCHDIST)
+      {
+	 BddNode *ahead = node - UNIQUEPREFETCHDIST;
+	 if (LOWp(ahead) != -1)
+	    PREFETCH(&bddunique[UNIQUESLOT(NODEKEY(LEVELp(ahead) & MARKOFF,
+						  LOWp(ahead), HIGHp(ahead)))]);
+      }
+#endif
+
+      if ((LEVELp(node) & MARKON)  &&  LOWp(node) != -1)
+      {
+	 LEVELp(node) &= MARKOFF;
+#if ENABLE_OAUNIQUE
+	 bdd_unique_insert(NODEKEY(LEVELp(node), LOWp(node), HIGHp(node)), n);
+#else
+	 {
+	    register BDD hash;
+
+	    hash = NODEHASH(LEVELp(node), LOWp(node), HIGHp(node));
+	    NEXTp(node) = HASH(hash);
+	    HASH(hash) = n;
+	 }
+#endif
       }
       else
       {
@@ -1368,7 +2488,7 @@ void bdd_gbc(void)
 		      ilist_push(dlist, id);
 
 		  if (ilist_length(dlist) > 0) {
-		      print_proof_comment(2, "Delete defining clauses for node N%d", XVARp(node));
+		      print_proof_comment(2, "Delete defining clauses for node N%" PRIcid, XVARp(node));
 		  }
 		  delete_clauses(dlist);
 	      }
@@ -1383,22 +2503,71 @@ void bdd_gbc(void)
 	     freed++;
 #endif
 	 LOWp(node) = -1;
-	 node->next = CHECKNODE(bddfreepos);
+	 NEXTp(node) = CHECKNODE(bddfreepos);
 	 bddfreepos = CHECKNODE(n);
 	 CHECKRANGE(bddfreenum++);
       }
 #if ENABLE_BTRACE
       if (bdd_trace_file)
-	  fprintf(bdd_trace_file, "d %d\n", n);
+	  fprintf(bdd_trace_file, "d %" PRIbdd "\n", n);
 #endif
    }
 
-#if DO_TRACE
-   printf("Flushing caches\n");
+   return freed;
+}
+
+
+   /* Collect garbage, either in the whole node table or (if "young" is
+      true) only among the nodes made since the last collection */
+static void bdd_gbc_collect(int young)
+{
+   long int c2, c1 = clock();
+   BDD freed;
+
+#if ENABLE_TBDD && DO_TRACE
+   printf("Starting GC\n");
 #endif
 
+   if (gbc_handler != NULL)
+   {
+      bddGbcStat s;
+      s.nodes = bddnodesize;
+      s.freenodes = bddfreenum;
+      s.time = 0;
+      s.sumtime = gbcclock;
+      s.num = gbcollectnum;
+      s.young = young;
+      gbc_handler(1, &s);
+   }
 
-   bdd_operator_reset();
+      /* The sweep phases look at every node in the table */
+   if (!young)
+      bdd_nodes_init(bddnodesize);
+
+#if ENABLE_GENGC
+   if (young)
+      freed = bdd_gbc_young();
+   else
+#endif
+#if ENABLE_PARGC
+   if ((freed = bdd_gbc_parallel()) < 0)
+#endif
+      freed = bdd_gbc_sequential();
+
+#if ENABLE_GENGC
+      /* All surviving nodes are old now */
+   bddyoungnum = 0;
+#endif
+
+      /* Cache entries with nodes freed by a young collection are
+	 recognized by their epoch */
+   if (!young)
+   {
+#if DO_TRACE
+      printf("Flushing caches\n");
+#endif
+      bdd_operator_reset();
+   }
 
    c2 = clock();
    gbcclock += c2-c1;
@@ -1417,11 +2586,18 @@ void bdd_gbc(void)
       s.sumtime = gbcclock;
       s.num = gbcollectnum;
       s.prevfreednodes = freed;
+      s.young = young;
       gbc_handler(0, &s);
    }
 }
 
 
+void bdd_gbc(void)
+{
+   bdd_gbc_collect(0);
+}
+
+
 /*
 NAME    {* bdd\_addref *}
 SECTION {* kernel *}
@@ -1438,9 +2614,9 @@ BDD bdd_addref(BDD root)
 {
    if (root < 2  ||  !bddrunning)
       return root;
-   if (root >= bddnodesize)
+   if (NODEIDX(root) >= bddnodesize)
       return bdd_error(BDD_ILLBDD);
-   if (LOW(root) == -1)
+   if (ISFREE(root))
       return bdd_error(BDD_ILLBDD);
 
    INCREF(root);
@@ -1464,9 +2640,9 @@ BDD bdd_delref(BDD root)
 {
    if (root < 2  ||  !bddrunning)
       return root;
-   if (root >= bddnodesize)
+   if (NODEIDX(root) >= bddnodesize)
       return bdd_error(BDD_ILLBDD);
-   if (LOW(root) == -1)
+   if (ISFREE(root))
       return bdd_error(BDD_ILLBDD);
 
    /* if the following line is present, fails there much earlier */
@@ -1479,31 +2655,68 @@ BDD bdd_delref(BDD root)
 
 /*=== RECURSIVE MARK / UNMARK ==========================================*/
 
-void bdd_mark(int i)
+/* The traversals below use the explicit stack "bddmarkstack" instead of
+ * recursion, so that very deep BDDs cannot overflow the C stack. A node is
+ * marked (or unmarked) when it is pushed, which means that it is pushed at
+ * most once and that a stack with room for "bddnodesize" entries is
+ * enough. The children of a node are prefetched together before their
+ * mark bits are tested.
+ */
+
+#define MARKPUSH(sp,n) (*(sp)++ = (n))
+#define MARKPOP(sp)    (*--(sp))
+
+void bdd_mark(BDD i)
 {
+   BDD *sp = bddmarkstack;
    BddNode *node;
 
    if (i < 2)
       return;
 
-   node = &bddnodes[i];
+   node = &bddnodes[NODEIDX(i)];
    if (LEVELp(node) & MARKON  ||  LOWp(node) == -1)
       return;
 
    LEVELp(node) |= MARKON;
+   MARKPUSH(sp, NODEIDX(i));
 
-   bdd_mark(LOWp(node));
-   bdd_mark(HIGHp(node));
+   while (sp > bddmarkstack)
+   {
+      BDD c[2];
+      int k;
+
+      node = &bddnodes[MARKPOP(sp)];
+      c[0] = LOWp(node);
+      c[1] = HIGHp(node);
+      PREFETCH(&bddnodes[NODEIDX(c[0])]);
+      PREFETCH(&bddnodes[NODEIDX(c[1])]);
+
+      for (k=0 ; k<2 ; k++)
+      {
+	 if (c[k] < 2)
+	    continue;
+
+	 node = &bddnodes[NODEIDX(c[k])];
+	 if (LEVELp(node) & MARKON  ||  LOWp(node) == -1)
+	    continue;
+
+	 LEVELp(node) |= MARKON;
+	 MARKPUSH(sp, NODEIDX(c[k]));
+      }
+   }
 }
 
 
-void bdd_mark_upto(int i, int level)
+void bdd_mark_upto(BDD i, int level)
 {
-   BddNode *node = &bddnodes[i];
+   BDD *sp = bddmarkstack;
+   BddNode *node;
 
    if (i < 2)
       return;
 
+   node = &bddnodes[NODEIDX(i)];
    if (LEVELp(node) & MARKON  ||  LOWp(node) == -1)
       return;
 
@@ -1511,66 +2724,169 @@ void bdd_mark_upto(int i, int level)
       return;
 
    LEVELp(node) |= MARKON;
+   MARKPUSH(sp, NODEIDX(i));
+
+   while (sp > bddmarkstack)
+   {
+      BDD c[2];
+      int k;
+
+      node = &bddnodes[MARKPOP(sp)];
+      c[0] = LOWp(node);
+      c[1] = HIGHp(node);
+      PREFETCH(&bddnodes[NODEIDX(c[0])]);
+      PREFETCH(&bddnodes[NODEIDX(c[1])]);
+
+      for (k=0 ; k<2 ; k++)
+      {
+	 if (c[k] < 2)
+	    continue;
+
+	 node = &bddnodes[NODEIDX(c[k])];
+	 if (LEVELp(node) & MARKON  ||  LOWp(node) == -1)
+	    continue;
+
+	 if (LEVELp(node) > level)
+	    continue;
 
-   bdd_mark_upto(LOWp(node), level);
-   bdd_mark_upto(HIGHp(node), level);
+	 LEVELp(node) |= MARKON;
+	 MARKPUSH(sp, NODEIDX(c[k]));
+      }
+   }
 }
 
 
-void bdd_markcount(int i, int *cou)
+void bdd_markcount(BDD i, BDD *cou)
 {
+   BDD *sp = bddmarkstack;
    BddNode *node;
 
    if (i < 2)
       return;
 
-   node = &bddnodes[i];
+   node = &bddnodes[NODEIDX(i)];
    if (MARKEDp(node)  ||  LOWp(node) == -1)
       return;
 
    SETMARKp(node);
    *cou += 1;
+   MARKPUSH(sp, NODEIDX(i));
+
+   while (sp > bddmarkstack)
+   {
+      BDD c[2];
+      int k;
+
+      node = &bddnodes[MARKPOP(sp)];
+      c[0] = LOWp(node);
+      c[1] = HIGHp(node);
+      PREFETCH(&bddnodes[NODEIDX(c[0])]);
+      PREFETCH(&bddnodes[NODEIDX(c[1])]);
+
+      for (k=0 ; k<2 ; k++)
+      {
+	 if (c[k] < 2)
+	    continue;
+
+	 node = &bddnodes[NODEIDX(c[k])];
+	 if (MARKEDp(node)  ||  LOWp(node) == -1)
+	    continue;
 
-   bdd_markcount(LOWp(node), cou);
-   bdd_markcount(HIGHp(node), cou);
+	 SETMARKp(node);
+	 *cou += 1;
+	 MARKPUSH(sp, NODEIDX(c[k]));
+      }
+   }
 }
 
 
-void bdd_unmark(int i)
+void bdd_unmark(BDD i)
 {
+   BDD *sp = bddmarkstack;
    BddNode *node;
 
    if (i < 2)
       return;
 
-   node = &bddnodes[i];
-
+   node = &bddnodes[NODEIDX(i)];
    if (!MARKEDp(node)  ||  LOWp(node) == -1)
       return;
+
    UNMARKp(node);
+   MARKPUSH(sp, NODEIDX(i));
+
+   while (sp > bddmarkstack)
+   {
+      BDD c[2];
+      int k;
+
+      node = &bddnodes[MARKPOP(sp)];
+      c[0] = LOWp(node);
+      c[1] = HIGHp(node);
+      PREFETCH(&bddnodes[NODEIDX(c[0])]);
+      PREFETCH(&bddnodes[NODEIDX(c[1])]);
+
+      for (k=0 ; k<2 ; k++)
+      {
+	 if (c[k] < 2)
+	    continue;
+
+	 node = &bddnodes[NODEIDX(c[k])];
+	 if (!MARKEDp(node)  ||  LOWp(node) == -1)
+	    continue;
 
-   bdd_unmark(LOWp(node));
-   bdd_unmark(HIGHp(node));
+	 UNMARKp(node);
+	 MARKPUSH(sp, NODEIDX(c[k]));
+      }
+   }
 }
 
 
-void bdd_unmark_upto(int i, int level)
+void bdd_unmark_upto(BDD i, int level)
 {
-   BddNode *node = &bddnodes[i];
+   BDD *sp = bddmarkstack;
+   BddNode *node;
 
    if (i < 2)
       return;
 
+   node = &bddnodes[NODEIDX(i)];
    if (!(LEVELp(node) & MARKON))
       return;
 
    LEVELp(node) &= MARKOFF;
-
    if (LEVELp(node) > level)
       return;
 
-   bdd_unmark_upto(LOWp(node), level);
-   bdd_unmark_upto(HIGHp(node), level);
+   MARKPUSH(sp, NODEIDX(i));
+
+   while (sp > bddmarkstack)
+   {
+      BDD c[2];
+      int k;
+
+      node = &bddnodes[MARKPOP(sp)];
+      c[0] = LOWp(node);
+      c[1] = HIGHp(node);
+      PREFETCH(&bddnodes[NODEIDX(c[0])]);
+      PREFETCH(&bddnodes[NODEIDX(c[1])]);
+
+      for (k=0 ; k<2 ; k++)
+      {
+	 if (c[k] < 2)
+	    continue;
+
+	 node = &bddnodes[NODEIDX(c[k])];
+	 if (!(LEVELp(node) & MARKON))
+	    continue;
+
+	 LEVELp(node) &= MARKOFF;
+	 if (LEVELp(node) > level)
+	    continue;
+
+	 MARKPUSH(sp, NODEIDX(c[k]));
+      }
+   }
 }
 
 
@@ -1578,13 +2894,58 @@ void bdd_unmark_upto(int i, int level)
   Unique node table functions
 *************************************************************************/
 
-int bdd_makenode(unsigned int level, int low, int high)
+#if ENABLE_TBDD
+/* Give a fresh node its extension variable and defining clauses.
+   vid is the variable of the node, which is passed explicitly since
+   the level field holds the variable during reordering */
+void bdd_define_node(BDD res, int vid)
+{
+   BddNode *node = &bddnodes[res];
+   clause_id_t nid, hid, lid, huid, luid;
+   clause_id_t dbuf[3+ILIST_OVHD];
+   clause_id_t abuf[2+ILIST_OVHD];
+   ilist dlist, alist;
+
+   if (proof_type == PROOF_NONE) {
+       XVARp(node) = res;
+       DCLAUSEp(node) = 0;
+       return;
+   }
+
+   nid = ++(*variable_counter);
+   hid = XVAR(HIGHp(node));
+   lid = XVAR(LOWp(node));
+   dlist = ilist_make(dbuf, 3);
+   alist = ilist_make(abuf, 2);
+   XVARp(node) = nid;
+   DCLAUSEp(node) = *clause_id_counter + 1;
+   print_proof_comment(2, "Defining clauses for node N%" PRIcid " = ITE(V%d (level=%d), N%" PRIcid ", N%" PRIcid ")", nid, vid, bdd_var2level(vid), NNAME(HIGHp(node)), NNAME(LOWp(node)));
+   huid = generate_clause(defining_clause(dlist, DEF_HU, nid, vid, hid, lid), alist);
+   luid = generate_clause(defining_clause(dlist, DEF_LU, nid, vid, hid, lid), alist);
+   if (huid != TAUTOLOGY)
+       ilist_push(alist, -huid);
+   if (luid != TAUTOLOGY)
+       ilist_push(alist, -luid);
+   generate_clause(defining_clause(dlist, DEF_HD, nid, vid, hid, lid), alist);
+   generate_clause(defining_clause(dlist, DEF_LD, nid, vid, hid, lid), alist);
+}
+#endif
+
+
+BDD bdd_makenode(unsigned int level, BDD low, BDD high)
 {
    register BddNode *node;
-   register unsigned int hash;
-   register int res;
+   register BddKey hash;
+   register BDD res;
+#if ENABLE_OAUNIQUE
+   register BddKey key;
+   int rehash = 0;
+#endif
+#ifdef UNIQUESTATS
+   long unsigned int chain = 0;
+#endif
 
-#ifdef CACHESTATS
+#ifdef UNIQUESTATS
    bddcachestats.uniqueAccess++;
 #endif
 
@@ -1592,29 +2953,72 @@ int bdd_makenode(unsigned int level, int low, int high)
    if (low == high)
       return low;
 
+#if ENABLE_COMPLEMENT
+      /* Keep the low edge regular by moving its complement to the result */
+   if (ISCOMPL(low))
+      return COMPLEMENT(bdd_makenode(level, COMPLEMENT(low), COMPLEMENT(high)));
+#endif
+
       /* Try to find an existing node of this kind */
+#if ENABLE_OAUNIQUE
+   key = NODEKEY(level, low, high);
+   hash = UNIQUESLOT(key);
+
+   while ((res = bddunique[hash].node) != 0)
+   {
+      if (bddunique[hash].key == key)
+      {
+	 node = &bddnodes[res];
+	 if (LEVELp(node) == level  &&  LOWp(node) == low  &&  HIGHp(node) == high)
+	 {
+#ifdef UNIQUESTATS
+	    bddcachestats.uniqueHit++;
+	    if (chain > bddcachestats.uniqueMaxChain)
+	       bddcachestats.uniqueMaxChain = chain;
+#endif
+	    return NODEREF(res);
+	 }
+      }
+
+      hash = UNIQUENEXT(hash);
+#ifdef UNIQUESTATS
+      bddcachestats.uniqueChain++;
+      chain++;
+#endif
+   }
+#else
    hash = NODEHASH(level, low, high);
-   res = bddnodes[hash].hash;
+   res = HASH(hash);
 
    while(res != 0)
    {
-      if (LEVEL(res) == level  &&  LOW(res) == low  &&  HIGH(res) == high)
+      node = &bddnodes[res];
+      if (LEVELp(node) == level  &&  LOWp(node) == low  &&  HIGHp(node) == high)
       {
-#ifdef CACHESTATS
+#ifdef UNIQUESTATS
 	 bddcachestats.uniqueHit++;
+	 if (chain > bddcachestats.uniqueMaxChain)
+	    bddcachestats.uniqueMaxChain = chain;
 #endif
-	 return res;
+	 return NODEREF(res);
 #if DO_TRACE && ENABLE_TBDD
 	 if (NNAME(res) == TRACE_NNAME)
 	     printf("Found node N%d in unique table\n", TRACE_NNAME);
 #endif
       }
 
-      res = CHECKNODE(bddnodes[res].next);
-#ifdef CACHESTATS
+      res = CHECKNODE(NEXT(res));
+#ifdef UNIQUESTATS
       bddcachestats.uniqueChain++;
+      chain++;
 #endif
    }
+#endif
+
+#ifdef UNIQUESTATS
+   if (chain > bddcachestats.uniqueMaxChain)
+      bddcachestats.uniqueMaxChain = chain;
+#endif
 
    /* Error checking */
    if (level >= LEVEL(low))
@@ -1632,10 +3036,30 @@ int bdd_makenode(unsigned int level, int low, int high)
    }
 
       /* No existing node -> build one */
-#ifdef CACHESTATS
+#ifdef UNIQUESTATS
    bddcachestats.uniqueMiss++;
 #endif
 
+#if ENABLE_OAUNIQUE
+      /* Keep the unique table at most half full */
+   if (2*(BddKey)(bdduniquenum+1) > bdduniquesize)
+   {
+      if (bdd_unique_resize() < 0)
+      {
+	 bdd_error(BDD_MEMORY);
+	 bdderrorcond = abs(BDD_MEMORY);
+	 return 0;
+      }
+      rehash = 1;
+   }
+#endif
+
+#if ENABLE_NODEARENA
+      /* Use the nodes not touched so far before collecting garbage */
+   if (bddfreepos == 0  &&  bddnodeinit < bddnodesize)
+      bdd_nodes_init(MIN(bddnodesize, bddnodeinit + NODEINITCHUNK));
+#endif
+
       /* Any free nodes to use ? */
    if (bddfreepos == 0)
    {
@@ -1643,20 +3067,41 @@ int bdd_makenode(unsigned int level, int low, int high)
 	 return 0;
 
          /* Try to allocate more nodes */
+#if ENABLE_GENGC
+	 /* Collect the young nodes first, and everything only if that
+	    does not leave enough free nodes */
+      bdd_gbc_collect(1);
+      if (((long)bddfreenum*100) / bddnodesize <= bddminfreenodes)
+	 bdd_gbc_collect(0);
+#else
       bdd_gbc();
+#endif
 
       if (CHECKRANGE(bddnodesize-bddfreenum) >= usednodes_nextreorder  &&
 	  bdd_reorder_ready())
       {
+#if ENABLE_ITERAPPLY
+	    /* The operation is abandoned by itself after this node */
+	 if (bdditerstop)
+	    bdditerreorder = 1;
+	 else
+#endif
 	 longjmp(bddexception,1);
       }
 
-      if ((bddfreenum*100) / bddnodesize <= minfreenodes)
+      if (((long)bddfreenum*100) / bddnodesize <= bddminfreenodes)
       {
 	 bdd_noderesize(1);
+#if !ENABLE_OAUNIQUE
 	 hash = NODEHASH(level, low, high);
+#endif
       }
 
+#if ENABLE_OAUNIQUE
+	 /* The table was rebuilt, so the free slot must be found again */
+      rehash = 1;
+#endif
+
          /* Panic if that is not possible */
       if (bddfreepos == 0)
       {
@@ -1668,9 +3113,12 @@ int bdd_makenode(unsigned int level, int low, int high)
 
       /* Build new node */
    res = CHECKNODE(bddfreepos);
-   bddfreepos = CHECKNODE(bddnodes[bddfreepos].next);
+   bddfreepos = CHECKNODE(NEXT(bddfreepos));
    CHECKRANGE(bddfreenum--);
    bddproduced++;
+#if ENABLE_GENGC
+   bddyoung[bddyoungnum++] = res;
+#endif
 
    node = &bddnodes[res];
    LEVELp(node) = level;
@@ -1679,103 +3127,471 @@ int bdd_makenode(unsigned int level, int low, int high)
 
 #if ENABLE_BTRACE
    if (bdd_trace_file)
-       fprintf(bdd_trace_file, "n %d %d %d %d\n", res, level, high, low);
+       fprintf(bdd_trace_file, "n %" PRIbdd " %d %" PRIbdd " %" PRIbdd "\n", res, level, high, low);
 #endif
 
    #if ENABLE_TBDD
-   if (level > 0) {
-       if (proof_type == PROOF_NONE) {
-	   XVARp(node) = res;
-	   DCLAUSEp(node) = 0;
-       } else {
-	   int nid = ++(*variable_counter);
-	   int vid = bdd_level2var(level);
-	   int hid = XVAR(high);
-	   int lid = XVAR(low);
-	   int hname = NNAME(high);
-	   int lname = NNAME(low);
-	   int dbuf[3+ILIST_OVHD];
-	   int abuf[2+ILIST_OVHD];
-	   ilist dlist = ilist_make(dbuf, 3);
-	   ilist alist = ilist_make(abuf, 2);
-	   int huid, luid;
-	   XVARp(node) = nid;
-	   DCLAUSEp(node) = *clause_id_counter + 1;
-	   print_proof_comment(2, "Defining clauses for node N%d = ITE(V%d (level=%d), N%d, N%d)", nid, vid, level, hname, lname);
-	   huid = generate_clause(defining_clause(dlist, DEF_HU, nid, vid, hid, lid), alist);
-	   luid = generate_clause(defining_clause(dlist, DEF_LU, nid, vid, hid, lid), alist);
-	   if (huid != TAUTOLOGY)
-	       ilist_push(alist, -huid);
-	   if (luid != TAUTOLOGY)
-	       ilist_push(alist, -luid);
-	   generate_clause(defining_clause(dlist, DEF_HD, nid, vid, hid, lid), alist);
-	   generate_clause(defining_clause(dlist, DEF_LD, nid, vid, hid, lid), alist);
-       }
-   }
+   if (bdd_level2var(level) > 0)
+       bdd_define_node(res, bdd_level2var(level));
    #endif
       /* Insert node */
-   node->next = bddnodes[hash].hash;
-   bddnodes[hash].hash = res;
+#if ENABLE_OAUNIQUE
+   if (rehash)
+      bdd_unique_insert(key, res);
+   else
+   {
+      bddunique[hash].key = key;
+      bddunique[hash].node = res;
+      bdduniquenum++;
+   }
+#else
+   NEXTp(node) = HASH(hash);
+   HASH(hash) = res;
+#endif
 
 #if DO_TRACE && ENABLE_TBDD
-	 if (NNAME(res) == TRACE_NNAME)
+	 if (NNAME(NODEREF(res)) == TRACE_NNAME)
 	     printf("TRACE: Added node N%d to unique table\n", TRACE_NNAME);
+#endif
+   return NODEREF(res);
+}
+
+
+#if ENABLE_PARAPPLY
+
+/* Node construction for the multi-threaded apply. No garbage collection
+ * or resizing can happen while the threads run. Each thread builds nodes
+ * from a private batch taken from the free list and publishes them in
+ * the unique table with compare-and-swap, so a node is never inserted
+ * twice. A negative result means that the node table, or the open
+ * addressing table, is too full to continue, and the operation must be
+ * redone sequentially.
+ */
+
+static int bdd_nodebatch_refill(BddNodeBatch *b)
+{
+   BDD n, last = 0, num = 0;
+
+   pthread_mutex_lock(&bddfreelock);
+#if ENABLE_NODEARENA
+   if (bddfreepos == 0  &&  bddnodeinit < bddnodesize)
+      bdd_nodes_init(MIN(bddnodesize, bddnodeinit + NODEINITCHUNK));
+#endif
+
+   for (n=bddfreepos ; n != 0  &&  num < PARNODEBATCH ; n=NEXT(n))
+   {
+      last = n;
+      num++;
+   }
+
+   if (num > 0)
+   {
+      b->freepos = bddfreepos;
+      b->freenum = num;
+      bddfreepos = NEXT(last);
+      NEXT(last) = 0;
+      bddfreenum -= num;
+   }
+   pthread_mutex_unlock(&bddfreelock);
+
+   return num > 0 ? 0 : -1;
+}
+
+
+   /* Give a node that lost the race for its unique table slot back */
+static void bdd_nodebatch_put(BddNodeBatch *b, BDD n)
+{
+   bddnodes[n].low = -1;
+   bddnodes[n].level = 0;
+   NEXT(n) = b->freepos;
+   b->freepos = n;
+   b->freenum++;
+}
+
+
+static BDD bdd_nodebatch_get(BddNodeBatch *b, unsigned int level,
+			     BDD low, BDD high)
+{
+   BddNode *node;
+   BDD res;
+
+   if (b->freepos == 0  &&  bdd_nodebatch_refill(b) < 0)
+      return -1;
+
+   res = b->freepos;
+   b->freepos = NEXT(res);
+   b->freenum--;
+
+   node = &bddnodes[res];
+   node->refcou = 0;
+   LEVELp(node) = level;
+   LOWp(node) = low;
+   HIGHp(node) = high;
+#if ENABLE_TBDD
+   XVARp(node) = res;
+   DCLAUSEp(node) = 0;
 #endif
    return res;
 }
 
 
+BDD bdd_makenode_par(BddNodeBatch *b, unsigned int level, BDD low, BDD high)
+{
+   register BddNode *node;
+   BDD res = 0;
+#if ENABLE_OAUNIQUE
+   BddKey key, pos;
+#else
+   BddKey hash;
+   BDD head, stop, n;
+#endif
+
+   if (low == high)
+      return low;
+
+#if ENABLE_COMPLEMENT
+   if (ISCOMPL(low))
+   {
+      res = bdd_makenode_par(b, level, COMPLEMENT(low), COMPLEMENT(high));
+      return res < 0 ? res : COMPLEMENT(res);
+   }
+#endif
+
+#if ENABLE_OAUNIQUE
+   key = NODEKEY(level, low, high);
+   pos = UNIQUESLOT(key);
+
+   for (;;)
+   {
+      BddUnique slot;
+
+#if ENABLE_LARGE
+	 /* A slot is too wide to be exchanged as a whole, so the node is
+	    published alone and the key is only used by sequential code */
+      slot.node = __atomic_load_n(&bddunique[pos].node, __ATOMIC_ACQUIRE);
+      slot.key = key;
+#else
+      __atomic_load(&bddunique[pos], &slot, __ATOMIC_ACQUIRE);
+#endif
+
+      if (slot.node == 0)
+      {
+	 BddUnique newslot;
+
+	    /* Leave room for the sequential code to grow the table */
+	 if (4*(long long)__atomic_load_n(&bdduniquenum, __ATOMIC_RELAXED)
+	     > 3*(long long)bdduniquesize)
+	    return -1;
+	 if (res == 0  &&  (res=bdd_nodebatch_get(b, level, low, high)) < 0)
+	    return -1;
+
+	 newslot.key = key;
+	 newslot.node = res;
+#if ENABLE_LARGE
+	 if (__atomic_compare_exchange_n(&bddunique[pos].node, &slot.node,
+					 newslot.node, 0, __ATOMIC_RELEASE,
+					 __ATOMIC_ACQUIRE))
+	 {
+	    bddunique[pos].key = newslot.key;
+	    __atomic_add_fetch(&bdduniquenum, 1, __ATOMIC_RELAXED);
+	    break;
+	 }
+#else
+	 if (__atomic_compare_exchange(&bddunique[pos], &slot, &newslot, 0,
+				       __ATOMIC_RELEASE, __ATOMIC_ACQUIRE))
+	 {
+	    __atomic_add_fetch(&bdduniquenum, 1, __ATOMIC_RELAXED);
+	    break;
+	 }
+#endif
+      }
+
+      if (slot.key == key)
+      {
+	 node = &bddnodes[slot.node];
+	 if (LEVELp(node) == level  &&  LOWp(node) == low  &&  HIGHp(node) == high)
+	 {
+	    if (res != 0)
+	       bdd_nodebatch_put(b, res);
+	    return NODEREF(slot.node);
+	 }
+      }
+
+      if (slot.node != 0)
+	 pos = UNIQUENEXT(pos);
+   }
+#else
+   hash = NODEHASH(level, low, high);
+   head = __atomic_load_n(&HASH(hash), __ATOMIC_ACQUIRE);
+   stop = 0;
+
+   for (;;)
+   {
+	 /* Only the part of the chain added since the last look is new */
+      for (n=head ; n != stop ; n=NEXT(n))
+      {
+	 node = &bddnodes[n];
+	 if (LEVELp(node) == level  &&  LOWp(node) == low  &&  HIGHp(node) == high)
+	 {
+	    if (res != 0)
+	       bdd_nodebatch_put(b, res);
+	    return NODEREF(n);
+	 }
+      }
+
+      if (res == 0  &&  (res=bdd_nodebatch_get(b, level, low, high)) < 0)
+	 return -1;
+
+      stop = head;
+      NEXT(res) = head;
+      if (__atomic_compare_exchange_n(&HASH(hash), &head, res, 0,
+				      __ATOMIC_RELEASE, __ATOMIC_ACQUIRE))
+	 break;
+   }
+#endif
+
+   b->produced++;
+#if ENABLE_GENGC
+   bddyoung[__atomic_fetch_add(&bddyoungnum, 1, __ATOMIC_RELAXED)] = res;
+#endif
+   return NODEREF(res);
+}
+
+
+   /* Put the unused nodes of a batch back on the free list. Must only
+      be called when no apply thread is running. */
+void bdd_nodebatch_done(BddNodeBatch *b)
+{
+   BDD last;
+
+   if (b->freenum > 0)
+   {
+      for (last=b->freepos ; NEXT(last) != 0 ; last=NEXT(last))
+	 ;
+      NEXT(last) = bddfreepos;
+      bddfreepos = b->freepos;
+      bddfreenum += b->freenum;
+   }
+   bddproduced += b->produced;
+
+   b->freepos = 0;
+   b->freenum = 0;
+   b->produced = 0;
+}
+
+#endif /* ENABLE_PARAPPLY */
+
+
 int bdd_noderesize(int doRehash)
 {
    BddNode *newnodes;
-   int oldsize = bddnodesize;
-   int n;
+   BDD *newstack;
+   BDD oldsize = bddnodesize;
+   long long newsize;
+   BDD n;
 
    if (bddnodesize >= bddmaxnodesize  &&  bddmaxnodesize > 0)
       return -1;
 
-   bddnodesize = bddnodesize << 1;
+      /* Computed in long long to stay clear of overflow near MAXNODENUM */
+   newsize = (long long)oldsize << 1;
+
+   if (newsize > oldsize + (long long)bddmaxnodeincrease)
+      newsize = oldsize + (long long)bddmaxnodeincrease;
+
+   if (newsize > bddmaxnodesize  &&  bddmaxnodesize > 0)
+      newsize = bddmaxnodesize;
+
+#if ENABLE_NODEARENA
+   if (newsize > BDD_ARENANODES)
+      newsize = BDD_ARENANODES;
+#endif
 
-   if (bddnodesize > oldsize + bddmaxnodeincrease)
-      bddnodesize = oldsize + bddmaxnodeincrease;
+   if (newsize > MAXNODENUM)
+      newsize = MAXNODENUM;
 
-   if (bddnodesize > bddmaxnodesize  &&  bddmaxnodesize > 0)
-      bddnodesize = bddmaxnodesize;
+   bddnodesize = NODEPRIME_LTE((BDD)newsize);
 
-   bddnodesize = bdd_prime_lte(bddnodesize);
+      /* No more nodes can be addressed */
+   if (bddnodesize <= oldsize)
+   {
+      bddnodesize = oldsize;
+      return -1;
+   }
 
    if (resize_handler != NULL)
       resize_handler(oldsize, bddnodesize);
 
-   newnodes = (BddNode*)realloc(bddnodes, sizeof(BddNode)*bddnodesize);
+      /* The new nodes are linked in front of the untouched ones */
+   bdd_nodes_init(oldsize);
+
+   newnodes = (BddNode*)bdd_nodearray_resize(bddnodes, sizeof(BddNode), bddnodesize);
    if (newnodes == NULL)
       return bdd_error(BDD_MEMORY);
    bddnodes = newnodes;
 
+   newstack = (BDD*)bdd_nodearray_resize(bddmarkstack, sizeof(BDD), bddnodesize);
+   if (newstack == NULL)
+      return bdd_error(BDD_MEMORY);
+   bddmarkstack = newstack;
+
+#if ENABLE_GENGC
+   newstack = (BDD*)bdd_nodearray_resize(bddyoung, sizeof(BDD), bddnodesize);
+   if (newstack == NULL)
+      return bdd_error(BDD_MEMORY);
+   bddyoung = newstack;
+
+   {
+      unsigned int *newdeath = (unsigned int*)
+	 bdd_nodearray_resize(bddnodedeath, sizeof(unsigned int), bddnodesize);
+      if (newdeath == NULL)
+	 return bdd_error(BDD_MEMORY);
+      bddnodedeath = newdeath;
+      memset(bddnodedeath+oldsize, 0, sizeof(unsigned int)*(bddnodesize-oldsize));
+   }
+#endif
+
+#if ENABLE_SPLITNODE
+   {
+      BddNodeLink *newlinks;
+      newlinks = (BddNodeLink*)bdd_nodearray_resize(bddnodelinks, sizeof(BddNodeLink), bddnodesize);
+      if (newlinks == NULL)
+	 return bdd_error(BDD_MEMORY);
+      bddnodelinks = newlinks;
+   }
+#if ENABLE_TBDD
+   {
+      BddNodeProof *newproofs;
+      newproofs = (BddNodeProof*)bdd_nodearray_resize(bddnodeproofs, sizeof(BddNodeProof), bddnodesize);
+      if (newproofs == NULL)
+	 return bdd_error(BDD_MEMORY);
+      bddnodeproofs = newproofs;
+   }
+#endif
+#endif
+
+#if !ENABLE_OAUNIQUE
    if (doRehash)
       for (n=0 ; n<oldsize ; n++)
-	 bddnodes[n].hash = 0;
+	 HASH(n) = 0;
+#endif
 
    for (n=oldsize ; n<bddnodesize ; n++)
    {
       bddnodes[n].refcou = 0;
-      bddnodes[n].hash = 0;
-      LEVEL(n) = 0;
-      LOW(n) = -1;
-      bddnodes[n].next = n+1;
+      HASH(n) = 0;
+      bddnodes[n].level = 0;
+      bddnodes[n].low = -1;
+      NEXT(n) = n+1;
    }
-   bddnodes[bddnodesize-1].next = CHECKNODE(bddfreepos);
+   NEXT(bddnodesize-1) = CHECKNODE(bddfreepos);
    bddfreepos = CHECKNODE(oldsize);
    bddfreenum += CHECKRANGE(bddnodesize - oldsize);
+   bddnodeinit = bddnodesize;
 
+      /* The open addressing table does not depend on the node table size */
+#if !ENABLE_OAUNIQUE
    if (doRehash)
       bdd_gbc_rehash();
+#endif
 
    bddresized = 1;
    return 0;
 }
 
 
+   /* Put the untouched nodes below "upto" on the free list. Their hash
+      fields may already hold chain heads and are left alone. */
+void bdd_nodes_init(BDD upto)
+{
+   BDD n;
+
+   if (upto <= bddnodeinit)
+      return;
+
+   for (n=bddnodeinit ; n<upto ; n++)
+   {
+      bddnodes[n].refcou = 0;
+      bddnodes[n].level = 0;
+      bddnodes[n].low = -1;
+      NEXT(n) = n+1;
+   }
+   NEXT(upto-1) = CHECKNODE(bddfreepos);
+   bddfreepos = CHECKNODE(bddnodeinit);
+   bddnodeinit = upto;
+}
+
+
+#if ENABLE_NODEARENA
+
+/* The node arrays are kept in address ranges with room for BDD_ARENANODES
+ * entries, reserved when the package is initialized. Growing an array
+ * only commits more of its range, so nodes never move and nothing is
+ * copied. Pages are zero filled and backed by memory when first touched.
+ */
+
+static size_t bdd_arena_bytes(size_t elsize, BDD num)
+{
+   size_t bytes = elsize * (size_t)num;
+   return (bytes + BDD_ARENAALIGN - 1) & ~(size_t)(BDD_ARENAALIGN - 1);
+}
+
+
+static void *bdd_nodearray_resize(void *p, size_t elsize, BDD num)
+{
+   size_t size = bdd_arena_bytes(elsize, BDD_ARENANODES);
+
+   if (p == NULL)
+   {
+#if defined(MAP_HUGETLB) && BDD_ARENAHUGETLB
+      p = mmap(NULL, size, PROT_NONE,
+	       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_HUGETLB, -1, 0);
+      if (p == MAP_FAILED)
+#endif
+      p = mmap(NULL, size, PROT_NONE,
+	       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      if (p == MAP_FAILED)
+	 return NULL;
+#ifdef MADV_HUGEPAGE
+      madvise(p, size, MADV_HUGEPAGE);
+#endif
+      if (mprotect(p, bdd_arena_bytes(elsize, num), PROT_READ|PROT_WRITE) != 0)
+      {
+	 munmap(p, size);
+	 return NULL;
+      }
+      return p;
+   }
+
+   if (mprotect(p, bdd_arena_bytes(elsize, num), PROT_READ|PROT_WRITE) != 0)
+      return NULL;
+   return p;
+}
+
+
+static void bdd_nodearray_free(void *p, size_t elsize)
+{
+   if (p != NULL)
+      munmap(p, bdd_arena_bytes(elsize, BDD_ARENANODES));
+}
+
+#else /* ENABLE_NODEARENA */
+
+static void *bdd_nodearray_resize(void *p, size_t elsize, BDD num)
+{
+   return realloc(p, elsize * (size_t)num);
+}
+
+
+static void bdd_nodearray_free(void *p, size_t elsize)
+{
+   (void)elsize;
+   free(p);
+}
+
+#endif /* ENABLE_NODEARENA */
+
+
 void bdd_checkreorder(void)
 {
    bdd_reorder_auto();
@@ -1812,7 +3628,8 @@ RETURN  {* Zero on success, otherwise a negative error code. *}
 */
 int bdd_scanset(BDD r, int **varset, int *varnum)
 {
-   int n, num;
+   BDD n;
+   int num;
 
    CHECK(r);
    if (r < 2)
@@ -1855,7 +3672,8 @@ ALSO    {* bdd\_scanset *}
 RETURN {* A BDD variable set. *} */
 BDD BDD_makeset(int *varset, int varnum)
 {
-   int v, res=1;
+   int v;
+   BDD res=1;
 
    for (v=varnum-1 ; v>=0 ; v--)
    {
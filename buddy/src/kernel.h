@@ -74,6 +74,77 @@
 #define ENABLE_TBDD 0
 #endif
 
+/** Enabling complement edges **/
+#ifndef ENABLE_COMPLEMENT
+#define ENABLE_COMPLEMENT 0
+#endif
+
+/** Enabling split (structure of arrays) node table **/
+#ifndef ENABLE_SPLITNODE
+#define ENABLE_SPLITNODE 0
+#endif
+
+/** Enabling open addressing unique table **/
+#ifndef ENABLE_OAUNIQUE
+#define ENABLE_OAUNIQUE 0
+#endif
+
+/** Enabling multi-threaded garbage collection **/
+#ifndef ENABLE_PARGC
+#define ENABLE_PARGC 0
+#endif
+
+/** Enabling generational garbage collection **/
+#ifndef ENABLE_GENGC
+#define ENABLE_GENGC 0
+#endif
+
+/** Enabling reserved address range (mmap) for the node table **/
+#ifndef ENABLE_NODEARENA
+#define ENABLE_NODEARENA 0
+#endif
+
+/** Enabling large mode (full word variable levels and reference counts,
+    64 bit node references and clause IDs) **/
+#ifndef ENABLE_LARGE
+#define ENABLE_LARGE 0
+#endif
+
+/** Enabling multi-threaded apply **/
+#ifndef ENABLE_PARAPPLY
+#define ENABLE_PARAPPLY 0
+#endif
+
+/** Enabling set-associative operator cache **/
+#ifndef ENABLE_ASSOCCACHE
+#define ENABLE_ASSOCCACHE 0
+#endif
+
+/** Enabling operator caches that are resized by their miss rate **/
+#ifndef ENABLE_ADAPTCACHE
+#define ENABLE_ADAPTCACHE 0
+#endif
+
+/** Enabling apply and quantification with an explicit stack **/
+#ifndef ENABLE_ITERAPPLY
+#define ENABLE_ITERAPPLY 0
+#endif
+
+/** Enabling a writer thread for proof output **/
+#ifndef ENABLE_ASYNCPROOF
+#define ENABLE_ASYNCPROOF 0
+#endif
+
+/** Enabling gzip compression of proofs with zlib **/
+#ifndef ENABLE_ZLIB
+#define ENABLE_ZLIB 0
+#endif
+
+   /* The full cache statistics include the unique table probe counters */
+#if defined(CACHESTATS) && !defined(UNIQUESTATS)
+#define UNIQUESTATS
+#endif
+
 /*=== Includes =========================================================*/
 
 #include <limits.h>
@@ -115,97 +186,313 @@
    /* Sanity check argument and return eventual error code */
 #define CHECK(r)\
    if (!bddrunning) return bdd_error(BDD_RUNNING);\
-   else if ((r) < 0  ||  (r) >= bddnodesize) return bdd_error(BDD_ILLBDD);\
-   else if (r >= 2 && LOW(r) == -1) return bdd_error(BDD_ILLBDD)\
+   else if ((r) < 0  ||  NODEIDX(r) >= bddnodesize) return bdd_error(BDD_ILLBDD);\
+   else if (r >= 2 && ISFREE(r)) return bdd_error(BDD_ILLBDD)\
 
    /* Sanity check argument and return eventually the argument 'a' */
 #define CHECKa(r,a)\
    if (!bddrunning) { bdd_error(BDD_RUNNING); return (a); }\
-   else if ((r) < 0  ||  (r) >= bddnodesize)\
+   else if ((r) < 0  ||  NODEIDX(r) >= bddnodesize)\
      { bdd_error(BDD_ILLBDD); return (a); }\
-   else if (r >= 2 && LOW(r) == -1)\
+   else if (r >= 2 && ISFREE(r))\
      { bdd_error(BDD_ILLBDD); return (a); }
 
 #define CHECKn(r)\
    if (!bddrunning) { bdd_error(BDD_RUNNING); return; }\
-   else if ((r) < 0  ||  (r) >= bddnodesize)\
+   else if ((r) < 0  ||  NODEIDX(r) >= bddnodesize)\
      { bdd_error(BDD_ILLBDD); return; }\
-   else if (r >= 2 && LOW(r) == -1)\
+   else if (r >= 2 && ISFREE(r))\
      { bdd_error(BDD_ILLBDD); return; }
 
 
 /*=== SEMI-INTERNAL TYPES ==============================================*/
 
+#if ENABLE_SPLITNODE
+
+   /* With a split node table only the fields needed for traversal are
+      kept in 'bddnodes'. The unique table links and the proof data live
+      in parallel arrays indexed by the same node number. */
+typedef struct s_BddNode /* Node table entry */
+{
+#if ENABLE_LARGE
+   unsigned int refcou;
+   unsigned int level;
+#else
+   unsigned int refcou : 10;
+   unsigned int level  : 22;
+#endif
+   BDD low;
+   BDD high;
+} BddNode;
+
+typedef struct s_BddNodeLink /* Unique table links of a node */
+{
+   BDD hash;
+   BDD next;
+} BddNodeLink;
+
+#if ENABLE_TBDD
+typedef struct s_BddNodeProof /* Proof data of a node */
+{
+   clause_id_t xvar;     /* Associated extension variable */
+   clause_id_t dclause;  /* Base index of defining clause */
+} BddNodeProof;
+#endif /* ENABLE_TBDD */
+
+#else
+
 typedef struct s_BddNode /* Node table entry */
 {
+#if ENABLE_LARGE
+   unsigned int refcou;
+   unsigned int level;
+#else
    unsigned int refcou : 10;
    unsigned int level  : 22;
-   int low;
-   int high;
-   int hash;
-   int next;
+#endif
+   BDD low;
+   BDD high;
+   BDD hash;
+   BDD next;
 #if ENABLE_TBDD
-   int xvar;     /* Associated extension variable */
-   int dclause;  /* Base index of defining clause */
+   clause_id_t xvar;     /* Associated extension variable */
+   clause_id_t dclause;  /* Base index of defining clause */
 #endif /* ENABLE_TBDD */
 } BddNode;
 
+#endif /* ENABLE_SPLITNODE */
+
+#if ENABLE_PARAPPLY
+typedef struct s_BddNodeBatch /* Free nodes owned by one apply thread */
+{
+   BDD freepos;   /* First node of the private free list */
+   BDD freenum;   /* Number of nodes on it */
+   BDD produced;  /* Number of nodes built from it */
+} BddNodeBatch;
+#endif
+
 
 /*=== KERNEL VARIABLES =================================================*/
 
+typedef struct s_BddKernel /* Kernel variables used by all modules */
+{
+   int       bddrunning;         /* Flag - package initialized */
+   int       bdderrorcond;       /* Some error condition was met */
+   BDD       bddnodesize;        /* Number of allocated nodes */
+   BDD       bddmaxnodesize;     /* Maximum allowed number of nodes */
+   int       bddmaxnodeincrease; /* Max. # of nodes used to inc. table */
+   BddNode*  bddnodes;           /* All of the bdd nodes */
+#if ENABLE_SPLITNODE
+   BddNodeLink*  bddnodelinks;   /* Unique table links of the nodes */
+#if ENABLE_TBDD
+   BddNodeProof* bddnodeproofs;  /* Proof data of the nodes */
+#endif
+#endif
+   BDD       bddfreepos;         /* First free node */
+   BDD       bddfreenum;         /* Number of free nodes */
+   int       bddvarnum;          /* Number of defined BDD variables */
+   BDD*      bddrefstack;        /* Internal node reference stack */
+   BDD*      bddrefstacktop;     /* Internal node reference stack top */
+   BDD*      bddmarkstack;       /* Stack for the non-recursive traversals */
+   BDD       bddnodeinit;        /* Nodes from here on are not initialized */
+   long int  bddproduced;        /* Number of new nodes ever produced */
+   int*      bddvar2level;       /* Variable -> level table */
+   int*      bddlevel2var;       /* Level -> variable table */
+   jmp_buf   bddexception;       /* Long-jump point for interrupting calc. */
+   int       bddresized;         /* Flag indicating a resize of the nodetable */
+   bddCacheStat bddcachestats;
+#if ENABLE_GENGC
+   unsigned int* bddnodedeath;   /* Epoch in which a young GBC freed the node */
+   unsigned int bddgcepoch;      /* Number of young GBCs */
+#endif
+#if ENABLE_ITERAPPLY
+   int       bdditerstop;        /* An operation can stop by itself */
+   int       bdditerreorder;     /* It must stop for reordering */
+#endif
+#if ENABLE_BTRACE
+   FILE *bdd_trace_file;
+#endif
+} BddKernel;
+
+   /* Each module keeps its other variables in a state block of its own */
+#define BDDMOD_KERNEL   0
+#define BDDMOD_OP       1
+#define BDDMOD_REORDER  2
+#define BDDMOD_IO       3
+#define BDDMOD_FDD      4
+#define BDDMOD_PAIRS    5
+#if ENABLE_TBDD
+#define BDDMOD_PROVER   6
+#define BDDMOD_TBDD     7
+#define BDDMOD_PSEUDO   8
+#define BDDMOD_NUM      9
+#else
+#define BDDMOD_NUM      6
+#endif
+
+#if ENABLE_REENTRANT
+
+   /* All the state of one package. The thread works on the manager that
+      'bddmanager' points at, and helper threads started for it point at
+      the same manager. */
+struct s_bdd_manager
+{
+#if ENABLE_TBDD
+   prover_vars_t provervars;    /* First, as prover.h relies on that */
+#endif
+   BddKernel kernel;
+   void *state[BDDMOD_NUM];     /* State blocks of the modules */
+};
+
+#define BDDKERNEL (&bddmanager->kernel)
+#define BDDSTATE(type,mod,local) ((type*)bddmanager->state[mod])
+
+   /* Entry points that change the state before bdd_init() give the
+      thread a manager of its own */
+#define CHECKMANAGER \
+   if (bddmanager->state[BDDMOD_KERNEL] == NULL) bdd_need_manager()
+
+#else
+
+#define BDDKERNEL (&bddkernel)
+#define BDDSTATE(type,mod,local) (&(local))
+#define CHECKMANAGER
+
+#endif /* ENABLE_REENTRANT */
+
 #ifdef CPLUSPLUS
 extern "C" {
 #endif
 
-extern int       bddrunning;         /* Flag - package initialized */
-extern int       bdderrorcond;       /* Some error condition was met */
-extern int       bddnodesize;        /* Number of allocated nodes */
-extern int       bddmaxnodesize;     /* Maximum allowed number of nodes */
-extern int       bddmaxnodeincrease; /* Max. # of nodes used to inc. table */
-extern BddNode*  bddnodes;           /* All of the bdd nodes */
-extern int       bddvarnum;          /* Number of defined BDD variables */
-extern int*      bddrefstack;        /* Internal node reference stack */
-extern int*      bddrefstacktop;     /* Internal node reference stack top */
-extern int*      bddvar2level;
-extern int*      bddlevel2var;
-extern jmp_buf   bddexception;
-extern int       bddreorderdisabled;
-extern int       bddresized;
-extern bddCacheStat bddcachestats;
-
-#if ENABLE_BTRACE
-extern FILE *bdd_trace_file;
+#if ENABLE_REENTRANT
+extern void  bdd_need_manager(void);
+extern void* bdd_newstate(const void*, size_t);
+extern void* bdd_op_newstate(void);
+extern void* bdd_reorder_newstate(void);
+extern void* bdd_io_newstate(void);
+extern void* bdd_fdd_newstate(void);
+extern void* bdd_pairs_newstate(void);
+#if ENABLE_TBDD
+extern void* prover_newstate(prover_vars_t*);
+extern void* tbdd_newstate(void);
+extern void* pseudo_newstate(void);
+#endif
+#else
+extern BddKernel bddkernel;
 #endif
 
 #ifdef CPLUSPLUS
 }
 #endif
 
+#define bddrunning         (BDDKERNEL->bddrunning)
+#define bdderrorcond       (BDDKERNEL->bdderrorcond)
+#define bddnodesize        (BDDKERNEL->bddnodesize)
+#define bddmaxnodesize     (BDDKERNEL->bddmaxnodesize)
+#define bddmaxnodeincrease (BDDKERNEL->bddmaxnodeincrease)
+#define bddnodes           (BDDKERNEL->bddnodes)
+#if ENABLE_SPLITNODE
+#define bddnodelinks       (BDDKERNEL->bddnodelinks)
+#if ENABLE_TBDD
+#define bddnodeproofs      (BDDKERNEL->bddnodeproofs)
+#endif
+#endif
+#define bddfreepos         (BDDKERNEL->bddfreepos)
+#define bddfreenum         (BDDKERNEL->bddfreenum)
+#define bddvarnum          (BDDKERNEL->bddvarnum)
+#define bddrefstack        (BDDKERNEL->bddrefstack)
+#define bddrefstacktop     (BDDKERNEL->bddrefstacktop)
+#define bddmarkstack       (BDDKERNEL->bddmarkstack)
+#define bddnodeinit        (BDDKERNEL->bddnodeinit)
+#define bddproduced        (BDDKERNEL->bddproduced)
+#define bddvar2level       (BDDKERNEL->bddvar2level)
+#define bddlevel2var       (BDDKERNEL->bddlevel2var)
+#define bddexception       (BDDKERNEL->bddexception)
+#define bddresized         (BDDKERNEL->bddresized)
+#define bddcachestats      (BDDKERNEL->bddcachestats)
+#if ENABLE_GENGC
+#define bddnodedeath       (BDDKERNEL->bddnodedeath)
+#define bddgcepoch         (BDDKERNEL->bddgcepoch)
+#endif
+#if ENABLE_ITERAPPLY
+#define bdditerstop        (BDDKERNEL->bdditerstop)
+#define bdditerreorder     (BDDKERNEL->bdditerreorder)
+#endif
+#if ENABLE_BTRACE
+#define bdd_trace_file     (BDDKERNEL->bdd_trace_file)
+#endif
+
 
 /*=== KERNEL DEFINITIONS ===============================================*/
 
 /* 
    Note: Although have 22 bits allocated for variable, upper bit
    required for mark bit used in GC.  That leaves 21 bits available
-   for actual level number
+   for actual level number.  In large mode the level has a word of
+   its own, leaving 31 bits.
  */
+#if ENABLE_LARGE
+#define MAXVAR 0x7FFFFFFF
+#else
 #define MAXVAR 0x1FFFFF
+#endif
 #define MAXREF 0x3FF
 
+   /* Max. number of nodes that can be addressed by a BDD reference */
+#if ENABLE_LARGE
+#define BDD_MAX LLONG_MAX
+#else
+#define BDD_MAX INT_MAX
+#endif
+#if ENABLE_COMPLEMENT
+#define MAXNODENUM (BDD_MAX >> 1)
+#else
+#define MAXNODENUM BDD_MAX
+#endif
+
+   /* Max. number of operands of a conjunction done in one pass */
+#define BDD_MULTIMAX 8
+
+   /* Edges and node table entries.
+      With complement edges, bit 0 of a BDD reference negates the function
+      of the node it points to.  Node 0 is the false terminal, so that
+      bddfalse (0) and bddtrue (1) keep their usual values and node 1 is
+      never used.  The stored low edge of a node is always regular.
+      Without complement edges, references and node indices coincide. */
+#if ENABLE_COMPLEMENT
+#define NODEIDX(a)     ((a) >> 1)
+#define NODEREF(n)     ((n) << 1)
+#define ISCOMPL(a)     ((a) & 1)
+#define REGULAR(a)     ((a) & ~1)
+#define COMPLEMENT(a)  ((a) ^ 1)
+#else
+#define NODEIDX(a)     (a)
+#define NODEREF(n)     (n)
+#define ISCOMPL(a)     0
+#define REGULAR(a)     (a)
+#endif
+#define ISFREE(a)      (bddnodes[NODEIDX(a)].low == -1)
+
    /* Reference counting */
-#define DECREF(n) if (bddnodes[n].refcou!=MAXREF && bddnodes[n].refcou>0) bddnodes[n].refcou--
-#define INCREF(n) if (bddnodes[n].refcou<MAXREF) bddnodes[n].refcou++
+#define DECREF(n) if (bddnodes[NODEIDX(n)].refcou!=MAXREF && bddnodes[NODEIDX(n)].refcou>0) bddnodes[NODEIDX(n)].refcou--
+#define INCREF(n) if (bddnodes[NODEIDX(n)].refcou<MAXREF) bddnodes[NODEIDX(n)].refcou++
 #define DECREFp(n) if (n->refcou!=MAXREF && n->refcou>0) n->refcou--
 #define INCREFp(n) if (n->refcou<MAXREF) n->refcou++
-#define HASREF(n) (bddnodes[n].refcou > 0)
+#define HASREF(n) (bddnodes[NODEIDX(n)].refcou > 0)
 
    /* Marking BDD nodes */
+#if ENABLE_LARGE
+#define MARKON   0x80000000  /* Bit used to mark a node (1) */
+#define MARKOFF  0x7FFFFFFF  /* - unmark */
+#define MARKHIDE 0x7FFFFFFF
+#else
 #define MARKON   0x200000    /* Bit used to mark a node (1) */
 #define MARKOFF  0x1FFFFF    /* - unmark */
 #define MARKHIDE 0x1FFFFF
-#define SETMARK(n)  (bddnodes[n].level |= MARKON)
-#define UNMARK(n)   (bddnodes[n].level &= MARKOFF)
-#define MARKED(n)   (bddnodes[n].level & MARKON)
+#endif
+#define SETMARK(n)  (bddnodes[NODEIDX(n)].level |= MARKON)
+#define UNMARK(n)   (bddnodes[NODEIDX(n)].level &= MARKOFF)
+#define MARKED(n)   (bddnodes[NODEIDX(n)].level & MARKON)
 #define SETMARKp(p) (node->level |= MARKON)
 #define UNMARKp(p)  (node->level &= MARKOFF)
 #define MARKEDp(p)  (node->level & MARKON)
@@ -215,23 +502,82 @@ extern FILE *bdd_trace_file;
 #define PAIR(a,b)      ((unsigned int)((((unsigned int)a)+((unsigned int)b))*(((unsigned int)a)+((unsigned int)b)+((unsigned int)1))/((unsigned int)2)+((unsigned int)a)))
 #define TRIPLE(a,b,c)  ((unsigned int)(PAIR((unsigned int)c,PAIR(a,b))))
 
+   /* Hash of a node's (level,low,high), used for the node table.  In
+      large mode it is 64 bits wide, so that a table with more than 2^32
+      entries is spread over all of its buckets */
+#if ENABLE_LARGE
+typedef unsigned long long BddKey;
+#define LPAIR(a,b)     ((BddKey)((((BddKey)a)+((BddKey)b))*(((BddKey)a)+((BddKey)b)+((BddKey)1))/((BddKey)2)+((BddKey)a)))
+#define NODEKEY(a,b,c) ((BddKey)(LPAIR((BddKey)c,LPAIR(a,b))))
+#else
+typedef unsigned int BddKey;
+#define NODEKEY(a,b,c) TRIPLE(a,b,c)
+#endif
+
+   /* Hint that a memory location will soon be read */
+#ifdef __GNUC__
+#define PREFETCH(a) __builtin_prefetch(a)
+#else
+#define PREFETCH(a)
+#endif
+
+   /* Inline even large functions, which are specialized by constant
+      arguments at each call */
+#ifdef __GNUC__
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define ALWAYS_INLINE inline
+#endif
+
    /* Inspection of BDD nodes */
 #define ISCONST(a) ((a) < 2)
 #define ISNONCONST(a) ((a) >= 2)
 #define ISONE(a)   ((a) == 1)
 #define ISZERO(a)  ((a) == 0)
-#define LEVEL(a)   (bddnodes[a].level)
+#define LEVEL(a)   (bddnodes[NODEIDX(a)].level)
+#if ENABLE_COMPLEMENT
+#define LOW(a)     (bddnodes[NODEIDX(a)].low ^ ISCOMPL(a))
+#define HIGH(a)    (bddnodes[NODEIDX(a)].high ^ ISCOMPL(a))
+#else
 #define LOW(a)     (bddnodes[a].low)
 #define HIGH(a)    (bddnodes[a].high)
+#endif
 #define LEVELp(p)   ((p)->level)
 #define LOWp(p)     ((p)->low)
 #define HIGHp(p)    ((p)->high)
 
+   /* Unique table links (indexed by node number, not by reference) */
+#if ENABLE_SPLITNODE
+#define NODENUMp(p) ((BDD)((p) - bddnodes))
+#define HASH(n)     (bddnodelinks[n].hash)
+#define NEXT(n)     (bddnodelinks[n].next)
+#define HASHp(p)    (bddnodelinks[NODENUMp(p)].hash)
+#define NEXTp(p)    (bddnodelinks[NODENUMp(p)].next)
+#else
+#define HASH(n)     (bddnodes[n].hash)
+#define NEXT(n)     (bddnodes[n].next)
+#define HASHp(p)    ((p)->hash)
+#define NEXTp(p)    ((p)->next)
+#endif
+
 #if ENABLE_TBDD
-#define XVAR(a)      (bddnodes[a].xvar)
-#define DCLAUSE(a)   (bddnodes[a].dclause)
+#if ENABLE_SPLITNODE
+#define NODEXVAR(n)  (bddnodeproofs[n].xvar)
+#define XVARp(p)     (bddnodeproofs[NODENUMp(p)].xvar)
+#define DCLAUSEp(p)  (bddnodeproofs[NODENUMp(p)].dclause)
+#define DCLAUSE(a)   (bddnodeproofs[NODEIDX(a)].dclause)
+#else
+#define NODEXVAR(n)  (bddnodes[n].xvar)
 #define XVARp(p)     ((p)->xvar)
 #define DCLAUSEp(p)  ((p)->dclause)
+#define DCLAUSE(a)   (bddnodes[NODEIDX(a)].dclause)
+#endif
+#if ENABLE_COMPLEMENT
+   /* A complemented edge names the negated extension variable */
+#define XVAR(a)      (ISCOMPL(a) ? -NODEXVAR(NODEIDX(a)) : NODEXVAR(NODEIDX(a)))
+#else
+#define XVAR(a)      NODEXVAR(a)
+#endif
 #define NNAME(a) ((a) < 2?(a):XVAR(a))
 #endif /* ENABLE_TBDD */
 
@@ -256,6 +602,19 @@ extern FILE *bdd_trace_file;
 
 #define DEFAULTMAXNODEINC 50000
 
+#if ENABLE_NODEARENA
+   /* Max. number of nodes the reserved address range has room for */
+#ifndef BDD_ARENANODES
+#define BDD_ARENANODES (1 << 28)
+#endif
+   /* Unit in which the range is committed (one huge page) */
+#define BDD_ARENAALIGN (2 << 20)
+   /* Set to 1 to ask for explicit huge pages (needs a hugetlbfs pool) */
+#ifndef BDD_ARENAHUGETLB
+#define BDD_ARENAHUGETLB 0
+#endif
+#endif
+
 #define MIN(a,b) ((a) < (b) ? (a) : (b))
 #define MAX(a,b) ((a) > (b) ? (a) : (b))
 #define ABS(a) ((a)<0?-(a):(a))
@@ -269,14 +628,22 @@ extern "C" {
 #endif
 
 extern int    bdd_error(int);
-extern int    bdd_makenode(unsigned int, int, int);
+extern BDD    bdd_makenode(unsigned int, BDD, BDD);
+#if ENABLE_TBDD
+extern void   bdd_define_node(BDD, int);
+#endif
 extern int    bdd_noderesize(int);
+extern void   bdd_nodes_init(BDD);
+#if ENABLE_PARAPPLY
+extern BDD    bdd_makenode_par(BddNodeBatch*, unsigned int, BDD, BDD);
+extern void   bdd_nodebatch_done(BddNodeBatch*);
+#endif
 extern void   bdd_checkreorder(void);
-extern void   bdd_mark(int);
-extern void   bdd_mark_upto(int, int);
-extern void   bdd_markcount(int, int*);
-extern void   bdd_unmark(int);
-extern void   bdd_unmark_upto(int, int);
+extern void   bdd_mark(BDD);
+extern void   bdd_mark_upto(BDD, int);
+extern void   bdd_markcount(BDD, BDD*);
+extern void   bdd_unmark(BDD);
+extern void   bdd_unmark_upto(BDD, int);
 extern void   bdd_register_pair(bddPair*);
 extern int   *fdddec2bin(int, int);
 
@@ -312,20 +679,28 @@ extern void   bdd_cpp_init(void);
 /* Data type for proof-generating operations */
 typedef struct {
     BDD root;
-    int clause_id;
+    clause_id_t clause_id;
 } pcbdd;
 
 /* In file prover.c */
 /* Complete proof of apply operation */
 /* Absolute of returned value indicates the ID of the justifying proof step */
 /* Value will be < 0 when previous clause ID also used as intermediate step */
-extern int justify_apply(int op, BDD l, BDD r, int splitVar, pcbdd tresl, pcbdd tresh, BDD res);
+extern clause_id_t justify_apply(int op, BDD l, BDD r, int splitVar, pcbdd tresl, pcbdd tresh, BDD res);
+/* Complete proof of one step of n-ary conjunction */
+extern clause_id_t justify_and_multi(BDD *ops, int n, int splitVar, pcbdd tresl, pcbdd tresh, BDD res);
+/* Complete proof of one step of and-exist at a quantified variable */
+extern clause_id_t justify_and_exist(BDD l, BDD r, int splitVar, pcbdd tresl, pcbdd tresh, clause_id_t impl_id, clause_id_t imph_id, BDD res);
+/* New defining clauses for a node rewritten by a swap of adjacent levels */
+extern clause_id_t justify_swap(BDD f, int x, int y, BDD f00, BDD f01, BDD f10, BDD f11, BDD g0, BDD g1);
 
 /* In file bddop.c */
 /* Low-level functions to implement operations on TBDDs */
 pcbdd      bdd_and_justify(BDD, BDD);    
 pcbdd      bdd_imptst_justify(BDD, BDD);    
 pcbdd      bdd_and_imptst_justify(BDD, BDD, BDD);    
+pcbdd      bdd_and_multi_justify(BDD *, int);
+pcbdd      bdd_and_exist_justify(BDD, BDD, BDD);
 
 #endif
 
@@ -40,8 +40,24 @@
 
 /*======================================================================*/
 
-static int      pairsid;            /* Pair identifier */
-static bddPair* pairs;              /* List of all replacement pairs in use */
+typedef struct s_PairsState
+{
+   int      pairsid;            /* Pair identifier */
+   bddPair* pairs;              /* List of all replacement pairs in use */
+} PairsState;
+
+#if ENABLE_REENTRANT
+void *bdd_pairs_newstate(void)
+{
+   return bdd_newstate(NULL, sizeof(PairsState));
+}
+#else
+static PairsState pairsstate;
+#endif
+
+#define PAIRSSTATE BDDSTATE(PairsState, BDDMOD_PAIRS, pairsstate)
+#define pairsid (PAIRSSTATE->pairsid)
+#define pairs   (PAIRSSTATE->pairs)
 
 
 /*************************************************************************
@@ -101,7 +117,7 @@ void bdd_pairs_vardown(int level)
    
    for (p=pairs ; p!=NULL ; p=p->next)
    {
-      int tmp;
+      BDD tmp;
 
       tmp = p->result[level];
       p->result[level] = p->result[level+1];
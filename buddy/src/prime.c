@@ -210,6 +210,9 @@ static int hasEasyFactors(unsigned int src)
 
 static int isPrime(unsigned int src)
 {
+  if (src < 2)
+    return 0;
+
   if (hasEasyFactors(src))
     return 0;
 
@@ -29,47 +29,585 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
 #include "tbdd.h"
 #include "prover.h"
 #include "kernel.h"
 
+#include <stdint.h>
+#if ENABLE_ASYNCPROOF
+#include <pthread.h>
+#endif
+#if ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+/* Vectorized encoding of binary proofs.  It packs 32-bit values, and so
+   it is not used for the 64-bit clause IDs of large mode */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !ENABLE_LARGE
+#define PACK_VECTOR 1
+#include <immintrin.h>
+#else
+#define PACK_VECTOR 0
+#endif
+
 
-/* Global variables exported by prover */
+/* Global variables exported by prover.  In a reentrant build they are
+   part of the manager, and set up by prover_newstate() */
+#if !ENABLE_REENTRANT
 proof_type_t proof_type = PROOF_FRAT;
 int verbosity_level = 1;
-int *variable_counter = NULL;
-int *clause_id_counter = NULL;
+clause_id_t *variable_counter = NULL;
+clause_id_t *clause_id_counter = NULL;
 /* int clause_limit = CLAUSE_LIMIT_LRAT; */
-int total_clause_count = 0;
-int input_clause_count = 0;
-int input_variable_count = 0;
-int max_live_clause_count = 0;
-int deleted_clause_count = 0;
+clause_id_t total_clause_count = 0;
+clause_id_t input_clause_count = 0;
+clause_id_t input_variable_count = 0;
+clause_id_t max_live_clause_count = 0;
+clause_id_t deleted_clause_count = 0;
+/* Proof output: size and number of blocks handed to the writer thread,
+   and whether the proof should be synced to disk when done */
+int proof_block_size = 1 << 20;
+int proof_block_count = 4;
+bool proof_sync = false;
+proof_compress_t proof_compression = PROOF_COMPRESS_NONE;
+#endif
 
-/* Global variables used by prover */
-static FILE *proof_file = NULL;
 /*
    For LRAT, only need to keep dictionary of input clauses.
    For DRAT & FRAT, need dictionary of all clauses in order to delete them.
+
+   Clauses are stored back to back in slabs of clause_id_t ints, each as
+   its length followed by its literals.  clause_ref[cid-ref_base-1]
+   locates clause cid, with the slab number in the upper bits and the offset of the
+   length in the lower SLAB_BITS bits, plus one so that 0 means no
+   clause.  A slab is freed as soon as all of its clauses are deleted,
+   and the slabs are compacted when more than half of their space holds
+   deleted clauses.  In large mode the references are 64 bits wide, so
+   that the number of slabs is only limited by memory.  When the input
+   clauses are not supplied, their IDs are never stored and the table
+   starts after them at ref_base.
 */
+#define SLAB_BITS 20
+#define SLAB_INTS (1 << SLAB_BITS)
+#if ENABLE_LARGE
+typedef unsigned long long clause_ref_t;
+#define MAX_SLABS INT_MAX
+#else
+typedef unsigned clause_ref_t;
+#define MAX_SLABS ((1 << (32 - SLAB_BITS)) - 1)
+#endif
+
+typedef struct {
+    clause_id_t *data;
+    int size;       /* Allocated ints.  Larger than SLAB_INTS for long clauses */
+    int used;       /* Ints holding clauses, live or deleted */
+    int live;       /* Ints holding live clauses */
+} clause_slab_t;
 
-static bool do_binary = false;
-static ilist *all_clauses = NULL;
-static int alloc_clause_count = 0;
-static int live_clause_count = 0;
-static ilist deferred_deletion_list = NULL;
-/* Track empty clause to:
-   1) Know if it has been generated
-   2) Finalize it for FRAT proof
-   3) Make sure it only gets finalized once
+
+/*
+  Proof output is appended to memory blocks, which a writer thread
+  passes on to the proof file.  The blocks form a ring: the prover fills
+  block 'fill', and the 'queued' blocks before it, starting at 'head',
+  wait for the writer.  At most count-1 blocks can be queued, so a full
+  queue makes the prover wait.  The sink is shared with the writer, so
+  it is not thread local.  Without ENABLE_ASYNCPROOF the sink is only
+  set up to compress the proof.  Then, or if no thread can be started,
+  each block is written by the prover as soon as it is full.
+
+  With compression, each block is compressed on its own, so that the
+  pieces of the file can be decompressed independently:
+
+  - PROOF_COMPRESS_LZ: A sequence of frames.  Each frame has a 12-byte
+    header: the bytes 'T' 'B' 'L' 'Z', the length of the decompressed
+    data, and the length of the frame data, both 4 bytes little-endian.
+    If bit 31 of the frame data length is set, the data is stored
+    uncompressed.  Otherwise it is a sequence of LZ77 matches, each
+    with a token byte holding the number of literals in the upper 4
+    bits and the match length minus 4 in the lower 4 bits.  A value of
+    15 is extended by the following bytes, adding each byte until one
+    is less than 255.  The token is followed by the literals and by the
+    2-byte little-endian distance back to the match, with the match
+    length extension, if any, after that.  The last token of a frame
+    has only literals.
+
+  - PROOF_COMPRESS_GZIP: A sequence of gzip members, as read by gzip -d.
+    Each member has an extra field with subfield 'T' 'B' holding the
+    length of the member as 4 bytes little-endian.
 */
-static int empty_clause_id = TAUTOLOGY;
-static bool empty_clause_finalized = false;
+typedef struct {
+    FILE *file;
+    char **block;
+    size_t *len;
+    size_t size;
+    int count;
+    int fill;
+    int head;
+    int queued;
+    bool stop;
+    bool error;
+    bool threaded;
+    proof_compress_t codec;
+    unsigned char *zbuf;
+    size_t zsize;
+    uint32_t *lz_table;
+#if ENABLE_ZLIB
+    z_stream zs;
+    bool zs_init;
+#endif
+#if ENABLE_ASYNCPROOF
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t space;
+#endif
+} proof_sink_t;
+
+/* Global variables used by prover */
+typedef struct {
+    FILE *proof_file;
+    bool do_binary;
+    clause_ref_t *clause_ref;
+    clause_id_t ref_count;
+    clause_id_t ref_base;
+    clause_slab_t *slabs;
+    int slab_count;
+    /* Slab being filled, or -1 */
+    int slab_fill;
+    size_t slab_live_ints;
+    size_t slab_dead_ints;
+    /* Copy of input clause returned by get_input_clause */
+    ilist input_view;
+    clause_id_t live_clause_count;
+    ilist deferred_deletion_list;
+    /* Track empty clause to:
+       1) Know if it has been generated
+       2) Finalize it for FRAT proof
+       3) Make sure it only gets finalized once
+    */
+    clause_id_t empty_clause_id;
+    bool empty_clause_finalized;
+    // Buffer used when generating binary files
+    unsigned char *dest_buf;
+    size_t dest_buf_len;
+    proof_sink_t *sink;
+    /* Free part of the block being filled */
+    char *sink_pos;
+    char *sink_end;
+} prover_state_t;
+
+#define PROVER_STATE_INIT { .slab_fill = -1, .empty_clause_id = TAUTOLOGY }
+
+#if ENABLE_REENTRANT
+void *prover_newstate(prover_vars_t *vars) {
+    /* The field names are macros here, so the initializer is positional */
+    static const prover_vars_t vars_init = { PROOF_FRAT, 1, NULL, NULL, 0, 0, 0, 0, 0,
+                                             1 << 20, 4, false, PROOF_COMPRESS_NONE };
+    static const prover_state_t init = PROVER_STATE_INIT;
+    *vars = vars_init;
+    return bdd_newstate(&init, sizeof(prover_state_t));
+}
+#else
+static prover_state_t prover_state = PROVER_STATE_INIT;
+#endif
+
+#define PSTATE BDDSTATE(prover_state_t, BDDMOD_PROVER, prover_state)
+#define proof_file (PSTATE->proof_file)
+#define do_binary (PSTATE->do_binary)
+#define clause_ref (PSTATE->clause_ref)
+#define ref_count (PSTATE->ref_count)
+#define ref_base (PSTATE->ref_base)
+#define slabs (PSTATE->slabs)
+#define slab_count (PSTATE->slab_count)
+#define slab_fill (PSTATE->slab_fill)
+#define slab_live_ints (PSTATE->slab_live_ints)
+#define slab_dead_ints (PSTATE->slab_dead_ints)
+#define input_view (PSTATE->input_view)
+#define live_clause_count (PSTATE->live_clause_count)
+#define deferred_deletion_list (PSTATE->deferred_deletion_list)
+#define empty_clause_id (PSTATE->empty_clause_id)
+#define empty_clause_finalized (PSTATE->empty_clause_finalized)
+#define dest_buf (PSTATE->dest_buf)
+#define dest_buf_len (PSTATE->dest_buf_len)
+#define sink (PSTATE->sink)
+#define sink_pos (PSTATE->sink_pos)
+#define sink_end (PSTATE->sink_end)
+
+#define LZ_HASH_BITS 14
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 65535
+#define LZ_HEADER 12
+#define LZ_STORED 0x80000000u
+
+#define GZIP_HEADER 20
+#define GZIP_TRAILER 8
+
+/* Largest frame for len bytes of data */
+static size_t lz_bound(size_t len) {
+    return LZ_HEADER + len + len/255 + 16;
+}
+
+static void put_le32(unsigned char *d, uint32_t x) {
+    d[0] = x & 0xFF;
+    d[1] = (x >> 8) & 0xFF;
+    d[2] = (x >> 16) & 0xFF;
+    d[3] = x >> 24;
+}
+
+static unsigned char *lz_put_length(unsigned char *d, size_t len) {
+    while (len >= 255) {
+        *d++ = 255;
+        len -= 255;
+    }
+    *d++ = len;
+    return d;
+}
+
+static unsigned char *lz_put_sequence(unsigned char *d, const unsigned char *lit, size_t nlit, size_t mlen) {
+    unsigned char *token = d++;
+    *token = (nlit >= 15 ? 15 : nlit) << 4 | (mlen >= 15 ? 15 : mlen);
+    if (nlit >= 15)
+        d = lz_put_length(d, nlit - 15);
+    memcpy(d, lit, nlit);
+    return d + nlit;
+}
+
+/*
+  Greedy LZ77 with a hash table of the positions of 4-byte sequences.
+  Return the length of the compressed data.
+ */
+static size_t lz_compress(const unsigned char *src, size_t len, unsigned char *dest, uint32_t *table) {
+    const unsigned char *ip = src;
+    const unsigned char *anchor = src;
+    const unsigned char *end = src + len;
+    unsigned char *d = dest;
+    memset(table, 0, sizeof(uint32_t) << LZ_HASH_BITS);
+    if (len > LZ_MIN_MATCH) {
+        const unsigned char *limit = end - LZ_MIN_MATCH;
+        while (ip < limit) {
+            uint32_t seq;
+            memcpy(&seq, ip, 4);
+            uint32_t h = (seq * 2654435761u) >> (32 - LZ_HASH_BITS);
+            /* Table holds position+1, so that 0 is empty */
+            uint32_t pos = table[h];
+            table[h] = ip - src + 1;
+            const unsigned char *ref = pos == 0 ? ip : src + pos - 1;
+            if (ref == ip || ip - ref > LZ_MAX_OFFSET || memcmp(ref, ip, LZ_MIN_MATCH) != 0) {
+        	/* Skip faster through data that does not compress */
+        	ip += 1 + ((ip - anchor) >> 6);
+        	continue;
+            }
+            const unsigned char *mp = ip + LZ_MIN_MATCH;
+            const unsigned char *rp = ref + LZ_MIN_MATCH;
+            while (mp < end && *mp == *rp) {
+        	mp++;
+        	rp++;
+            }
+            size_t offset = ip - ref;
+            size_t mlen = mp - ip - LZ_MIN_MATCH;
+            d = lz_put_sequence(d, anchor, ip - anchor, mlen);
+            *d++ = offset & 0xFF;
+            *d++ = offset >> 8;
+            if (mlen >= 15)
+        	d = lz_put_length(d, mlen - 15);
+            ip = anchor = mp;
+        }
+    }
+    d = lz_put_sequence(d, anchor, end - anchor, 0);
+    return d - dest;
+}
+
+/* Write one block to the file, compressing it as requested */
+static bool sink_write_block(proof_sink_t *ps, const char *data, size_t len) {
+    const unsigned char *src = (const unsigned char *) data;
+    unsigned char *z = ps->zbuf;
+    size_t zlen;
+    switch (ps->codec) {
+    case PROOF_COMPRESS_LZ:
+        zlen = lz_compress(src, len, z + LZ_HEADER, ps->lz_table);
+        if (zlen >= len) {
+            memcpy(z + LZ_HEADER, src, len);
+            zlen = len;
+            put_le32(z + 8, (uint32_t) len | LZ_STORED);
+        } else
+            put_le32(z + 8, (uint32_t) zlen);
+        memcpy(z, "TBLZ", 4);
+        put_le32(z + 4, (uint32_t) len);
+        zlen += LZ_HEADER;
+        break;
+#if ENABLE_ZLIB
+    case PROOF_COMPRESS_GZIP: {
+        static const unsigned char header[GZIP_HEADER-4] = {
+            0x1F, 0x8B, 8, 4, 0, 0, 0, 0, 0, 255, 8, 0, 'T', 'B', 4, 0
+        };
+        if (deflateReset(&ps->zs) != Z_OK)
+            return false;
+        ps->zs.next_in = (Bytef *) src;
+        ps->zs.avail_in = len;
+        ps->zs.next_out = z + GZIP_HEADER;
+        ps->zs.avail_out = ps->zsize - GZIP_HEADER - GZIP_TRAILER;
+        if (deflate(&ps->zs, Z_FINISH) != Z_STREAM_END)
+            return false;
+        zlen = GZIP_HEADER + ps->zs.total_out + GZIP_TRAILER;
+        memcpy(z, header, GZIP_HEADER-4);
+        put_le32(z + GZIP_HEADER - 4, (uint32_t) zlen);
+        put_le32(z + zlen - 8, crc32(crc32(0, Z_NULL, 0), src, len));
+        put_le32(z + zlen - 4, (uint32_t) len);
+        break;
+    }
+#endif
+    default:
+        return fwrite(data, 1, len, ps->file) == len;
+    }
+    return fwrite(z, 1, zlen, ps->file) == zlen;
+}
+
+#if ENABLE_ASYNCPROOF
+static void *sink_writer(void *arg) {
+    proof_sink_t *ps = (proof_sink_t *) arg;
+    pthread_mutex_lock(&ps->lock);
+    while (true) {
+        while (ps->queued == 0 && !ps->stop)
+            pthread_cond_wait(&ps->work, &ps->lock);
+        if (ps->queued == 0)
+            break;
+        int bi = ps->head;
+        bool ok;
+        pthread_mutex_unlock(&ps->lock);
+        ok = sink_write_block(ps, ps->block[bi], ps->len[bi]);
+        pthread_mutex_lock(&ps->lock);
+        if (!ok)
+            ps->error = true;
+        ps->head = (ps->head + 1) % ps->count;
+        ps->queued--;
+        pthread_cond_signal(&ps->space);
+    }
+    pthread_mutex_unlock(&ps->lock);
+    return NULL;
+}
+#endif
+
+static void sink_free(proof_sink_t *ps) {
+    int bi;
+    if (ps->block) {
+        for (bi = 0; bi < ps->count; bi++)
+            free(ps->block[bi]);
+    }
+    free(ps->block);
+    free(ps->len);
+    free(ps->zbuf);
+    free(ps->lz_table);
+#if ENABLE_ZLIB
+    if (ps->zs_init)
+        deflateEnd(&ps->zs);
+#endif
+#if ENABLE_ASYNCPROOF
+    pthread_mutex_destroy(&ps->lock);
+    pthread_cond_destroy(&ps->work);
+    pthread_cond_destroy(&ps->space);
+#endif
+    free(ps);
+}
+
+/* Set up compression of blocks.  Return false if out of memory */
+static bool sink_codec_init(proof_sink_t *ps, proof_compress_t codec) {
+    ps->codec = codec;
+    switch (codec) {
+    case PROOF_COMPRESS_LZ:
+        ps->zsize = lz_bound(ps->size);
+        ps->lz_table = malloc(sizeof(uint32_t) << LZ_HASH_BITS);
+        if (ps->lz_table == NULL)
+            return false;
+        break;
+#if ENABLE_ZLIB
+    case PROOF_COMPRESS_GZIP:
+        if (deflateInit2(&ps->zs, Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            return false;
+        ps->zs_init = true;
+        ps->zsize = GZIP_HEADER + deflateBound(&ps->zs, ps->size) + GZIP_TRAILER;
+        break;
+#endif
+    default:
+        ps->codec = PROOF_COMPRESS_NONE;
+        return true;
+    }
+    ps->zbuf = malloc(ps->zsize);
+    return ps->zbuf != NULL;
+}
+
+static int sink_start(FILE *pfile) {
+    proof_sink_t *ps = calloc(1, sizeof(proof_sink_t));
+    int bi;
+    if (ps == NULL)
+        return bdd_error(BDD_MEMORY);
+    ps->file = pfile;
+    ps->size = proof_block_size < 4096 ? 4096 : proof_block_size;
+#if ENABLE_ASYNCPROOF
+    ps->count = proof_block_count < 2 ? 2 : proof_block_count;
+    pthread_mutex_init(&ps->lock, NULL);
+    pthread_cond_init(&ps->work, NULL);
+    pthread_cond_init(&ps->space, NULL);
+#else
+    ps->count = 1;
+#endif
+    ps->block = calloc(ps->count, sizeof(char *));
+    ps->len = calloc(ps->count, sizeof(size_t));
+    if (ps->block == NULL || ps->len == NULL || !sink_codec_init(ps, proof_compression)) {
+        sink_free(ps);
+        return bdd_error(BDD_MEMORY);
+    }
+    for (bi = 0; bi < ps->count; bi++) {
+        if ((ps->block[bi] = malloc(ps->size)) == NULL) {
+            sink_free(ps);
+            return bdd_error(BDD_MEMORY);
+        }
+    }
+#if ENABLE_ASYNCPROOF
+    /* Otherwise write synchronously */
+    ps->threaded = pthread_create(&ps->thread, NULL, sink_writer, ps) == 0;
+#endif
+    sink = ps;
+    sink_pos = ps->block[0];
+    sink_end = sink_pos + ps->size;
+    return 0;
+}
+
+/* Queue the block being filled, waiting while the queue is full */
+static void sink_push() {
+    proof_sink_t *ps = sink;
+    char *start = ps->block[ps->fill];
+    bool error = false;
+    if (sink_pos == start)
+        return;
+    if (!ps->threaded) {
+        if (!sink_write_block(ps, start, sink_pos - start))
+            ps->error = true;
+        error = ps->error;
+        sink_pos = start;
+    }
+#if ENABLE_ASYNCPROOF
+    else {
+        /* The writer sets ps->error while holding the lock */
+        pthread_mutex_lock(&ps->lock);
+        while (ps->queued == ps->count-1)
+            pthread_cond_wait(&ps->space, &ps->lock);
+        ps->len[ps->fill] = sink_pos - start;
+        ps->fill = (ps->fill + 1) % ps->count;
+        ps->queued++;
+        error = ps->error;
+        pthread_cond_signal(&ps->work);
+        pthread_mutex_unlock(&ps->lock);
+        sink_pos = ps->block[ps->fill];
+    }
+#endif
+    sink_end = sink_pos + ps->size;
+    if (error)
+        bdd_error(BDD_FILE);
+}
+
+/* Write out everything and stop the writer */
+static void sink_stop() {
+    proof_sink_t *ps = sink;
+    bool error;
+    if (ps == NULL)
+        return;
+    sink_push();
+#if ENABLE_ASYNCPROOF
+    if (ps->threaded) {
+        pthread_mutex_lock(&ps->lock);
+        ps->stop = true;
+        pthread_cond_signal(&ps->work);
+        pthread_mutex_unlock(&ps->lock);
+        pthread_join(ps->thread, NULL);
+    }
+#endif
+    error = ps->error;
+    sink = NULL;
+    sink_pos = sink_end = NULL;
+    sink_free(ps);
+    if (error)
+        bdd_error(BDD_FILE);
+}
 
+static size_t proof_write(const void *data, size_t size, size_t n, FILE *out) {
+    const char *src = (const char *) data;
+    size_t len = size * n;
+    if (sink == NULL || out != sink->file)
+        return fwrite(data, size, n, out);
+    while (len > 0) {
+        size_t room = sink_end - sink_pos;
+        size_t chunk = len < room ? len : room;
+        memcpy(sink_pos, src, chunk);
+        sink_pos += chunk;
+        src += chunk;
+        len -= chunk;
+        if (sink_pos == sink_end)
+            sink_push();
+    }
+    return n;
+}
 
-// Buffer used when generating binary files
-static unsigned char *dest_buf = NULL;
-static size_t dest_buf_len = 0;
+static int proof_vprintf(FILE *out, const char *fmt, va_list vlist) {
+    va_list vcopy;
+    int rval;
+    if (sink == NULL || out != sink->file)
+        return vfprintf(out, fmt, vlist);
+    va_copy(vcopy, vlist);
+    rval = vsnprintf(sink_pos, sink_end - sink_pos, fmt, vcopy);
+    va_end(vcopy);
+    if (rval >= 0 && rval < sink_end - sink_pos) {
+        sink_pos += rval;
+        return rval;
+    }
+    sink_push();
+    if (rval >= 0 && rval < sink_end - sink_pos) {
+        rval = vsnprintf(sink_pos, sink_end - sink_pos, fmt, vlist);
+        sink_pos += rval;
+        return rval;
+    }
+    /* Too long for a block */
+    if (rval >= 0) {
+        char *buf = malloc(rval+1);
+        if (buf == NULL)
+            return -1;
+        vsnprintf(buf, rval+1, fmt, vlist);
+        proof_write(buf, 1, rval, out);
+        free(buf);
+    }
+    return rval;
+}
+
+static int proof_printf(FILE *out, const char *fmt, ...) {
+    va_list vlist;
+    int rval;
+    va_start(vlist, fmt);
+    rval = proof_vprintf(out, fmt, vlist);
+    va_end(vlist);
+    return rval;
+}
+
+static int proof_ilist_print(ilist ils, FILE *out, const char *sep) {
+    int i;
+    int rval = 0;
+    const char *space = "";
+    if (sink == NULL || out != sink->file)
+        return ilist_print(ils, out, sep);
+    if (ils == TAUTOLOGY_CLAUSE)
+        return proof_printf(out, "TAUT");
+    if (ils == NULL)
+        return proof_printf(out, "NULL");
+    for (i = 0; i < ilist_length(ils); i++) {
+        int pval = proof_printf(out, "%s%" PRIcid, space, ils[i]);
+        if (pval < 0)
+            return pval;
+        rval += pval;
+        space = sep;
+    }
+    return rval;
+}
 
 // Parameters
 // Cutoff betweeen large and small allocations (in terms of clauses)
@@ -103,6 +641,9 @@ static size_t dest_buf_len = 0;
  */
 #define MAX_CLAUSE 4
 #define MAX_HINT 8
+/* Clauses and unit lists arising in n-ary conjunction proofs */
+#define MAX_MULTI_CLAUSE (BDD_MULTIMAX+2)
+#define MAX_UNITS (3*BDD_MULTIMAX+8)
 
 /*
   With what frequency should proof size be announced
@@ -112,28 +653,181 @@ static size_t dest_buf_len = 0;
 /* Useful static functions */
 
 
+/* Clause database */
+
+/* Make room for references to clauses up through cid */
+static void clause_db_grow(clause_id_t cid) {
+    if (cid <= ref_base + ref_count)
+        return;
+    size_t ncount = 2 * (size_t) ref_count;
+    if (ncount < (size_t) (cid - ref_base) + INITIAL_CLAUSE_COUNT)
+        ncount = (size_t) (cid - ref_base) + INITIAL_CLAUSE_COUNT;
+    if (ncount > (size_t) (CLAUSE_ID_MAX - ref_base))
+        ncount = (size_t) (CLAUSE_ID_MAX - ref_base);
+    clause_ref_t *nref = realloc(clause_ref, ncount * sizeof(clause_ref_t));
+    if (nref == NULL) {
+        bdd_error(BDD_MEMORY);
+        return;
+    }
+    memset(nref + ref_count, 0, (ncount - ref_count) * sizeof(clause_ref_t));
+    clause_ref = nref;
+    ref_count = ncount;
+}
+
+/*
+  Start new slab with room for at least need ints.  Return slab number.
+  A clause longer than SLAB_INTS gets a slab of its own.
+ */
+static int clause_db_new_slab(int need) {
+    int si;
+    for (si = 0; si < slab_count; si++)
+        if (slabs[si].data == NULL)
+            break;
+    if (si == slab_count) {
+        if (slab_count == MAX_SLABS)
+            return bdd_error(BDD_MEMORY);
+        int ncount = slab_count == 0 ? 16 : 2 * slab_count;
+        if (ncount > MAX_SLABS)
+            ncount = MAX_SLABS;
+        clause_slab_t *nslabs = realloc(slabs, ncount * sizeof(clause_slab_t));
+        if (nslabs == NULL)
+            return bdd_error(BDD_MEMORY);
+        memset(nslabs + slab_count, 0, (ncount - slab_count) * sizeof(clause_slab_t));
+        slabs = nslabs;
+        slab_count = ncount;
+    }
+    int size = need > SLAB_INTS ? need : SLAB_INTS;
+    slabs[si].data = malloc(size * sizeof(clause_id_t));
+    if (slabs[si].data == NULL)
+        return bdd_error(BDD_MEMORY);
+    slabs[si].size = size;
+    slabs[si].used = 0;
+    slabs[si].live = 0;
+    return si;
+}
+
+/* Copy clause of length len into the slabs as clause cid */
+static void clause_db_put(clause_id_t cid, clause_id_t *lits, int len) {
+    int need = len + 1;
+    clause_db_grow(cid);
+    if (slab_fill < 0 || slabs[slab_fill].used + need > slabs[slab_fill].size) {
+        int si = clause_db_new_slab(need);
+        if (si < 0)
+            return;
+        if (slab_fill >= 0 && slabs[slab_fill].live == 0) {
+            /* Everything in the old slab has been deleted */
+            slab_dead_ints -= slabs[slab_fill].used;
+            free(slabs[slab_fill].data);
+            slabs[slab_fill].data = NULL;
+        }
+        slab_fill = si;
+    }
+    clause_slab_t *sp = &slabs[slab_fill];
+    clause_id_t *c = sp->data + sp->used;
+    c[0] = len;
+    memcpy(c+1, lits, len * sizeof(clause_id_t));
+    clause_ref[cid-ref_base-1] = ((clause_ref_t) slab_fill << SLAB_BITS | sp->used) + 1;
+    sp->used += need;
+    sp->live += need;
+    slab_live_ints += need;
+}
+
+/* Find stored clause.  Return pointer to its length, followed by its literals, or NULL */
+static clause_id_t *clause_db_find(clause_id_t cid) {
+    if (cid <= ref_base || cid > ref_base + ref_count || clause_ref[cid-ref_base-1] == 0)
+        return NULL;
+    clause_ref_t ref = clause_ref[cid-ref_base-1] - 1;
+    return slabs[ref >> SLAB_BITS].data + (ref & (SLAB_INTS-1));
+}
+
+/* Move all live clauses into new slabs, in order of clause ID */
+static void clause_db_compact() {
+    clause_slab_t *old_slabs = slabs;
+    int old_count = slab_count;
+    clause_id_t cid;
+    int si;
+    slabs = NULL;
+    slab_count = 0;
+    slab_fill = -1;
+    slab_live_ints = slab_dead_ints = 0;
+    for (cid = ref_base+1; cid <= ref_base + ref_count; cid++) {
+        clause_ref_t ref = clause_ref[cid-ref_base-1];
+        if (ref == 0)
+            continue;
+        ref--;
+        clause_id_t *c = old_slabs[ref >> SLAB_BITS].data + (ref & (SLAB_INTS-1));
+        clause_db_put(cid, c+1, (int) c[0]);
+    }
+    for (si = 0; si < old_count; si++)
+        free(old_slabs[si].data);
+    free(old_slabs);
+}
+
+/* Delete stored clause */
+static void clause_db_delete(clause_id_t cid) {
+    clause_id_t *c = clause_db_find(cid);
+    if (c == NULL)
+        return;
+    clause_ref_t ref = clause_ref[cid-ref_base-1] - 1;
+    int si = (int) (ref >> SLAB_BITS);
+    int need = (int) c[0] + 1;
+    clause_ref[cid-ref_base-1] = 0;
+    slabs[si].live -= need;
+    slab_live_ints -= need;
+    if (slabs[si].live == 0 && si != slab_fill) {
+        /* Bulk free */
+        slab_dead_ints -= slabs[si].used - need;
+        free(slabs[si].data);
+        slabs[si].data = NULL;
+        return;
+    }
+    slab_dead_ints += need;
+    /* Compaction scans all clause IDs, so let enough deletions pay for it */
+    if (slab_dead_ints > slab_live_ints && slab_dead_ints >= 4 * (size_t) SLAB_INTS
+        && slab_dead_ints >= (size_t) ref_count / 8)
+        clause_db_compact();
+}
+
+static void clause_db_free() {
+    int si;
+    for (si = 0; si < slab_count; si++)
+        free(slabs[si].data);
+    free(slabs);
+    free(clause_ref);
+    slabs = NULL;
+    clause_ref = NULL;
+    slab_count = 0;
+    ref_count = 0;
+    ref_base = 0;
+    slab_fill = -1;
+    slab_live_ints = slab_dead_ints = 0;
+    if (input_view != NULL)
+        ilist_free(input_view);
+    input_view = NULL;
+}
+
 /* API functions */
-int prover_init(FILE *pfile, int *var_counter, int *cls_counter, ilist *input_clauses, ilist variable_ordering, proof_type_t ptype, bool binary) {
+int prover_init(FILE *pfile, clause_id_t *var_counter, clause_id_t *cls_counter, ilist *input_clauses, ilist variable_ordering, proof_type_t ptype, bool binary) {
+    CHECKMANAGER;
     empty_clause_id = TAUTOLOGY;
     proof_type = ptype;
     do_binary = binary;
-    if (do_binary) {
-        dest_buf_len = 100;
-        dest_buf = malloc(dest_buf_len);
-        if (!dest_buf)
-            return bdd_error(BDD_MEMORY);
-    }
+    dest_buf_len = 100;
+    dest_buf = malloc(dest_buf_len);
+    if (!dest_buf)
+        return bdd_error(BDD_MEMORY);
     proof_file = pfile;
+    /* Without the writer thread, blocks are only needed for compression */
+    if (proof_file != NULL && ptype != PROOF_NONE &&
+        (ENABLE_ASYNCPROOF || proof_compression != PROOF_COMPRESS_NONE)) {
+        int err = sink_start(proof_file);
+        if (err != 0)
+            return err;
+    }
 
     variable_counter = var_counter;
     input_variable_count = *variable_counter;
 
-    if (input_variable_count > MAXVAR) {
-        fprintf(stderr, "FATAL: Input variable count %d > Maximum %d allowed by BDD package\n",
-        	input_variable_count, MAXVAR);
-        bdd_error(BDD_VAR);
-    }
-
     clause_id_counter = cls_counter;
     if (clause_id_counter) {
         input_clause_count = total_clause_count = *clause_id_counter;
@@ -141,29 +835,22 @@ int prover_init(FILE *pfile, int *var_counter, int *cls_counter, ilist *input_cl
     }
 
     deleted_clause_count = 0;
+    ref_base = input_clauses ? 0 : input_clause_count;
     if (proof_type == PROOF_NONE && input_clauses) {
-        all_clauses = calloc(input_clause_count, sizeof(ilist));
-        if (all_clauses == NULL)
-            return bdd_error(BDD_MEMORY);
-        int cid;
+        clause_id_t cid;
         for (cid = 0; cid < input_clause_count; cid++)
-            all_clauses[cid] = ilist_copy(input_clauses[cid]);
+            clause_db_put(cid+1, input_clauses[cid], ilist_length(input_clauses[cid]));
     } else if (proof_type != PROOF_NONE) {
-            alloc_clause_count = input_clause_count + INITIAL_CLAUSE_COUNT;
-        all_clauses = calloc(alloc_clause_count, sizeof(ilist));
-        if (all_clauses == NULL)
-            return bdd_error(BDD_MEMORY);
-        print_proof_comment(1, "Proof of CNF file with %d variables and %d clauses", input_variable_count, input_clause_count);
-        int cid;
-        for (cid = 0; cid < alloc_clause_count; cid++)
-        	all_clauses[cid] = TAUTOLOGY_CLAUSE;
+        clause_db_grow(input_clause_count);
+        print_proof_comment(1, "Proof of CNF file with %" PRIcid " variables and %" PRIcid " clauses", input_variable_count, input_clause_count);
+        clause_id_t cid;
         if (input_clauses) {
             for (cid = 0; cid < input_clause_count; cid++) {
-        	all_clauses[cid] = ilist_copy(input_clauses[cid]);
+        	clause_db_put(cid+1, input_clauses[cid], ilist_length(input_clauses[cid]));
         	if (print_ok(2)) {
-        	    fprintf(proof_file, "c Input Clause #%d: ", cid+1);
-        	    ilist_print(all_clauses[cid], proof_file, " ");
-        	    fprintf(proof_file, " 0\n");
+        	    proof_printf(proof_file, "c Input Clause #%" PRIcid ": ", cid+1);
+        	    proof_ilist_print(input_clauses[cid], proof_file, " ");
+        	    proof_printf(proof_file, " 0\n");
         	}
             }
         }
@@ -181,32 +868,33 @@ int prover_init(FILE *pfile, int *var_counter, int *cls_counter, ilist *input_cl
     int *varlist = NULL;
     if (variable_ordering != NULL) {
         if (ilist_length(variable_ordering) != input_variable_count) {
-            fprintf(ERROUT, "c Invalid variable ordering.  Given ordering for %d variables.  Must have %d\n",
+            fprintf(ERROUT, "c Invalid variable ordering.  Given ordering for %d variables.  Must have %" PRIcid "\n",
         	    ilist_length(variable_ordering), input_variable_count);
             return bdd_error(BDD_DECVNUM);
         }
         varlist = calloc(input_variable_count+1, sizeof(int));
         if (varlist == NULL)
             return bdd_error(BDD_MEMORY);
-        int level;
+        clause_id_t level;
         /* We start with level 1. */
         varlist[0] = 0;
         for (level = 1; level <= input_variable_count; level++) {
-            varlist[level] = variable_ordering[level-1];
+            varlist[level] = (int) variable_ordering[level-1];
         }
     }
 
     bdd_setcacheratio(BUDDY_CACHE_RATIO);
     bdd_setmaxincrease(bincrease);
-    bdd_setvarnum_ordered(input_variable_count+1, varlist);
-    bdd_disable_reorder();
+    /* A count the BDD package cannot hold is reported by it as out of range */
+    bdd_setvarnum_ordered(input_variable_count < MAXVAR ? (int) input_variable_count+1 : MAXVAR, varlist);
+    /* Reordering is left to the user.  Swaps rederive the defining
+       clauses of the nodes they rewrite, so proofs stay valid */
     return rval;
 }
 
 void prover_done() {
-    free(dest_buf);
     if (proof_type == PROOF_FRAT) {
-        int ebuf[ILIST_OVHD];
+        clause_id_t ebuf[ILIST_OVHD];
         ilist elist = ilist_make(ebuf, 0);
         /* Do final garbage collection to delete remaining clauses */
         //	bdd_gbc();
@@ -217,6 +905,18 @@ void prover_done() {
         }
     }
 
+    sink_stop();
+    if (proof_file != NULL && proof_type != PROOF_NONE) {
+        if (fflush(proof_file) != 0)
+            bdd_error(BDD_FILE);
+        if (proof_sync && fsync(fileno(proof_file)) != 0)
+            bdd_error(BDD_FILE);
+    }
+    free(dest_buf);
+    dest_buf = NULL;
+    dest_buf_len = 0;
+    clause_db_free();
+
     //    if (deferred_deletion_list)
     //        ilist_free(deferred_deletion_list);
 }
@@ -226,32 +926,32 @@ void prover_done() {
 void print_clause(FILE *out, ilist clause) {
     int i;
     if (clause == TAUTOLOGY_CLAUSE) {
-        fprintf(out, "TAUT");
+        proof_printf(out, "TAUT");
         return;
     }
     char *bstring = "[";
     for (i = 0; i < ilist_length(clause); i++) {
-        int lit = clause[i];
+        clause_id_t lit = clause[i];
         if (lit == TAUTOLOGY)
-            fprintf(out, "%sTRUE", bstring);
+            proof_printf(out, "%sTRUE", bstring);
         else if (lit == -TAUTOLOGY)
-            fprintf(out, "%sFALSE", bstring);
+            proof_printf(out, "%sFALSE", bstring);
         else
-            fprintf(out, "%s%d", bstring, lit);
+            proof_printf(out, "%s%" PRIcid, bstring, lit);
         bstring = ", ";
     }
-    fprintf(out, "]");
+    proof_printf(out, "]");
 }
 
 /* Helper function for clause cleaning.  Sort literals to put variables in descending order */
 int literal_compare(const void *l1p, const void *l2p) {
      int bvn = bdd_varnum();
-     int l1 = *(int *) l1p;
-     int l2 = *(int *) l2p;
-     int v1 = l1 < 0 ? -l1 : l1;
-     int v2 = l2 < 0 ? -l2 : l2;
-     int x1 = v1 < bvn ? bdd_var2level(v1) : v1;
-     int x2 = v2 < bvn ? bdd_var2level(v2) : v2;
+     clause_id_t l1 = *(clause_id_t *) l1p;
+     clause_id_t l2 = *(clause_id_t *) l2p;
+     clause_id_t v1 = l1 < 0 ? -l1 : l1;
+     clause_id_t v2 = l2 < 0 ? -l2 : l2;
+     clause_id_t x1 = v1 < bvn ? bdd_var2level((int) v1) : v1;
+     clause_id_t x2 = v2 < bvn ? bdd_var2level((int) v2) : v2;
      if (x2 > x1)
          return 1;
      if (x2 < x1)
@@ -268,20 +968,20 @@ ilist clean_clause(ilist clause) {
     //    printf("Cleaning clause [");
     //    ilist_print(clause, stdout, " ");
     /* Sort the literals */
-    qsort((void *) clause, ilist_length(clause), sizeof(int), literal_compare);
+    qsort((void *) clause, ilist_length(clause), sizeof(clause_id_t), literal_compare);
     int geti = 0;
     int puti = 0;
-    int plit = 0;
+    clause_id_t plit = 0;
     while (geti < len) {
-        int lit = clause[geti++];
+        clause_id_t lit = clause[geti++];
         if (lit == TAUTOLOGY)
             return TAUTOLOGY_CLAUSE;
         if (lit == -TAUTOLOGY)
             continue;
         if (lit == 0) {
-            fprintf(proof_file, "c ERROR.  Encountered literal 0 cleaning clause [");
-            ilist_print(clause, proof_file, " ");
-            fprintf(proof_file, "].\n");
+            proof_printf(proof_file, "c ERROR.  Encountered literal 0 cleaning clause [");
+            proof_ilist_print(clause, proof_file, " ");
+            proof_printf(proof_file, "].\n");
 
             fprintf(ERROUT, "c ERROR.  Encountered literal 0 cleaning clause [");
             ilist_print(clause, ERROUT, " ");
@@ -304,15 +1004,15 @@ ilist clean_clause(ilist clause) {
 
 #if DO_TRACE
 /* Look for specified ID  among clause or hints */
-static void trace_list(ilist list, int step_id, char *msg) {
+static void trace_list(ilist list, clause_id_t step_id, char *msg) {
     int i;
     if (list == TAUTOLOGY_CLAUSE)
         return;
     int len = ilist_length(list);
     for (i = 0; i < len; i++) {
-        int id = list[i];
+        clause_id_t id = list[i];
         if (id == TRACE_CLAUSE) {
-            printf("TRACE.  Found %d on step #%d: %s [", TRACE_CLAUSE, step_id, msg);
+            printf("TRACE.  Found %d on step #%" PRIcid ": %s [", TRACE_CLAUSE, step_id, msg);
             ilist_print(list, stdout, " ");
             printf("]\n");
         }
@@ -326,7 +1026,7 @@ static ilist clean_hints(ilist hints) {
     int geti = 0;
     int puti = 0;
     while (geti < len) {
-        int lit = hints[geti++];
+        clause_id_t lit = hints[geti++];
         if (lit != TAUTOLOGY)
             hints[puti++] = lit;
     }
@@ -336,25 +1036,91 @@ static ilist clean_hints(ilist hints) {
 
 
 /*
-  Compress integer list into byte sequence.
-  Unsigned char array passed in to fill.
-  Should be 5x longer than number of int's
+  Binary proofs encode each integer x as the unsigned value 2|x| + (x<0),
+  7 bits per byte, low bits first, with the high bit set in all but the
+  last byte.  So an int takes at most 5 bytes, and a 64-bit clause ID of
+  large mode at most 10.  On x86, lists of 32-bit ints are encoded four
+  at a time with SSSE3 when the processor supports it.  The encoders
+  store whole words, and so they can write up to PACK_SLACK bytes past
+  the end of the encoding.
  */
-static int check_buffer(int icount) {
-    size_t len = 5*icount;
+#if ENABLE_LARGE
+typedef unsigned long long uclause_id_t;
+#define BINARY_INT_BYTES 10
+#else
+typedef unsigned uclause_id_t;
+#define BINARY_INT_BYTES 5
+#endif
+#define PACK_SLACK 16
+
+/* Text lines need at most 11 (20 in large mode) characters plus a
+   separator per int */
+#if ENABLE_LARGE
+#define TEXT_INT_BYTES 21
+#else
+#define TEXT_INT_BYTES 12
+#endif
+
+/* Make dest_buf hold at least len bytes */
+static int check_buffer(size_t len) {
     if (len > dest_buf_len) {
-        dest_buf_len = len;
-        dest_buf = realloc(dest_buf, len);
-        if (dest_buf == NULL)
+        size_t nlen = 2*dest_buf_len;
+        if (nlen < len)
+            nlen = len;
+        unsigned char *nbuf = realloc(dest_buf, nlen);
+        if (nbuf == NULL)
             return bdd_error(BDD_MEMORY);
+        dest_buf = nbuf;
+        dest_buf_len = nlen;
     }
     return 0;
 }
 
+/*
+  Get space to format a proof line of icount ints.  When the writer
+  thread is running, this is in the block being filled, and so the
+  line never gets copied.  Complete the line with proof_commit.
+ */
+static unsigned char *proof_reserve(FILE *out, int icount) {
+    size_t len = do_binary ?
+        BINARY_INT_BYTES * (size_t) icount + PACK_SLACK :
+        TEXT_INT_BYTES * (size_t) icount;
+    if (sink != NULL && out == sink->file && len <= sink->size) {
+        if ((size_t) (sink_end - sink_pos) < len)
+            sink_push();
+        return (unsigned char *) sink_pos;
+    }
+    check_buffer(len);
+    return dest_buf;
+}
+
+/* Write line from start up to end.  Return negative value on error */
+static int proof_commit(FILE *out, unsigned char *start, unsigned char *end) {
+    if (sink != NULL && start == (unsigned char *) sink_pos) {
+        sink_pos = (char *) end;
+        return 0;
+    }
+    if (proof_write(start, 1, end - start, out) != (size_t) (end - start))
+        return -1;
+    return 0;
+}
+
 /* Convert integer into byte sequence.  Return number of bytes */
-static int int_byte_pack(int x, unsigned char *dest) {
+#if PACK_VECTOR
+static inline int int_byte_pack(clause_id_t x, unsigned char *dest) {
+    unsigned u = x < 0 ? 2*(0u-(unsigned) x)+1 : 2*(unsigned) x;
+    /* Spread into 7-bit groups and mark all but the last byte */
+    unsigned long long v = (u & 0x7F) | (u & 0x3F80ULL) << 1 | (u & 0x1FC000ULL) << 2
+        | (u & 0xFE00000ULL) << 3 | (unsigned long long) (u >> 28) << 32;
+    int n = (31 - __builtin_clz(u | 1)) / 7 + 1;
+    v |= 0x8080808080ULL & ((1ULL << (8*n - 8)) - 1);
+    memcpy(dest, &v, 8);
+    return n;
+}
+#else
+static int int_byte_pack(clause_id_t x, unsigned char *dest) {
     unsigned char *d = dest;
-    unsigned u = x < 0 ? 2*(-x)+1 : 2*x;
+    uclause_id_t u = x < 0 ? 2*(0-(uclause_id_t) x)+1 : 2*(uclause_id_t) x;
     while (u >= 128) {
         unsigned char b = u & 0x7F;
         u >>= 7;
@@ -363,24 +1129,179 @@ static int int_byte_pack(int x, unsigned char *dest) {
     *d++ = u;
     return d - dest;
 }
+#endif
+
+/* Encode len integers.  Return number of bytes */
+static int int_array_pack(const clause_id_t *src, int len, unsigned char *dest) {
+    int i;
+    unsigned char *d = dest;
+    for (i = 0; i < len; i++)
+        d += int_byte_pack(src[i], d);
+    return d - dest;
+}
+
+#if PACK_VECTOR
+/*
+  For each combination of four lengths of 1-4 bytes, with the length-1
+  of lane i in bits 2i and 2i+1 of the index, the shuffle that gathers
+  the used bytes of each 32-bit lane, and the total number of bytes.
+ */
+static unsigned char pack_shuffle[256][16];
+static unsigned char pack_length[256];
+static int (*array_pack_fun)(const clause_id_t *src, int len, unsigned char *dest) = int_array_pack;
+
+/* Spread 4 bits into bits 0, 2, 4, and 6 */
+static inline int pack_spread(int b) {
+    return (b & 0x1) | (b & 0x2) << 1 | (b & 0x4) << 2 | (b & 0x8) << 3;
+}
+
+__attribute__((target("ssse3")))
+static int int_array_pack_ssse3(const clause_id_t *src, int len, unsigned char *dest) {
+    unsigned char *d = dest;
+    int i = 0;
+    for (; i + 4 <= len; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i s = _mm_srai_epi32(x, 31);
+        /* 2|x| + (x<0) */
+        __m128i u = _mm_sub_epi32(_mm_slli_epi32(_mm_sub_epi32(_mm_xor_si128(x, s), s), 1), s);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_srli_epi32(u, 28), _mm_setzero_si128())) != 0xFFFF) {
+            /* Some value needs 5 bytes */
+            d += int_array_pack(src + i, 4, d);
+            continue;
+        }
+        __m128i m1 = _mm_cmpgt_epi32(u, _mm_set1_epi32(0x7F));
+        __m128i m2 = _mm_cmpgt_epi32(u, _mm_set1_epi32(0x3FFF));
+        __m128i m3 = _mm_cmpgt_epi32(u, _mm_set1_epi32(0x1FFFFF));
+        __m128i v = _mm_or_si128(
+            _mm_or_si128(_mm_and_si128(u, _mm_set1_epi32(0x7F)),
+        		 _mm_and_si128(_mm_slli_epi32(u, 1), _mm_set1_epi32(0x7F00))),
+            _mm_or_si128(_mm_and_si128(_mm_slli_epi32(u, 2), _mm_set1_epi32(0x7F0000)),
+        		 _mm_and_si128(_mm_slli_epi32(u, 3), _mm_set1_epi32(0x7F000000))));
+        v = _mm_or_si128(v,
+            _mm_or_si128(_mm_and_si128(m1, _mm_set1_epi32(0x80)),
+        		 _mm_or_si128(_mm_and_si128(m2, _mm_set1_epi32(0x8000)),
+        			      _mm_and_si128(m3, _mm_set1_epi32(0x800000)))));
+        int key = pack_spread(_mm_movemask_ps(_mm_castsi128_ps(m1)))
+            + pack_spread(_mm_movemask_ps(_mm_castsi128_ps(m2)))
+            + pack_spread(_mm_movemask_ps(_mm_castsi128_ps(m3)));
+        v = _mm_shuffle_epi8(v, _mm_loadu_si128((const __m128i *) pack_shuffle[key]));
+        _mm_storeu_si128((__m128i *) d, v);
+        d += pack_length[key];
+    }
+    d += int_array_pack(src + i, len - i, d);
+    return d - dest;
+}
+
+__attribute__((constructor))
+static void pack_init(void) {
+    int key, lane, k;
+    for (key = 0; key < 256; key++) {
+        int n = 0;
+        memset(pack_shuffle[key], 0x80, 16);
+        for (lane = 0; lane < 4; lane++) {
+            int bytes = ((key >> (2*lane)) & 0x3) + 1;
+            for (k = 0; k < bytes; k++)
+        	pack_shuffle[key][n++] = 4*lane + k;
+        }
+        pack_length[key] = n;
+    }
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("ssse3"))
+        array_pack_fun = int_array_pack_ssse3;
+}
+#endif /* PACK_VECTOR */
+
+/* Convert integer array into byte sequence.  Return number of bytes */
+static int array_byte_pack(const clause_id_t *src, int len, unsigned char *dest) {
+#if PACK_VECTOR
+    return array_pack_fun(src, len, dest);
+#else
+    return int_array_pack(src, len, dest);
+#endif
+}
 
 /* Convert integer list into byte sequence.  Return number of bytes */
 static int ilist_byte_pack(ilist src_list, unsigned char *dest) {
+    return array_byte_pack(src_list, ilist_length(src_list), dest);
+}
+
+/*
+  Text output is formatted into the same space as binary output, and
+  so each proof line is written with a single call.
+ */
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/* Write decimal representation of integer.  Return number of bytes */
+static int int_text_pack(clause_id_t x, unsigned char *dest) {
+    unsigned char buf[TEXT_INT_BYTES];
+    unsigned char *p = buf + TEXT_INT_BYTES;
+    unsigned char *d = dest;
+    uclause_id_t u = x < 0 ? 0u - (uclause_id_t) x : (uclause_id_t) x;
+    *d = '-';
+    d += x < 0;
+    while (u >= 100) {
+        uclause_id_t q = u / 100;
+        unsigned r = (unsigned) (u - 100*q);
+        p -= 2;
+        memcpy(p, digit_pairs + 2*r, 2);
+        u = q;
+    }
+    if (u >= 10) {
+        p -= 2;
+        memcpy(p, digit_pairs + 2*u, 2);
+    } else
+        *--p = '0' + u;
+    int len = buf + TEXT_INT_BYTES - p;
+    memcpy(d, p, len);
+    return d + len - dest;
+}
+
+/* Write integer list, separated by spaces.  Return number of bytes */
+static int array_text_pack(const clause_id_t *src, int len, unsigned char *dest) {
     int i;
     unsigned char *d = dest;
-    for (i = 0; i < ilist_length(src_list); i++) {
-        d += int_byte_pack(src_list[i], d);
+    for (i = 0; i < len; i++) {
+        d += int_text_pack(src[i], d);
+        *d++ = ' ';
     }
-    return d - dest;
+    /* No trailing separator */
+    return d - dest - (len > 0);
+}
+
+static int ilist_text_pack(ilist src_list, unsigned char *dest) {
+    return array_text_pack(src_list, ilist_length(src_list), dest);
+}
+
+/* Copy string without terminating null.  Return number of bytes */
+static int str_text_pack(const char *s, unsigned char *dest) {
+    int len = strlen(s);
+    memcpy(dest, s, len);
+    return len;
 }
 
 /* Return clause ID */
 /* For DRAT proof, hints can be NULL */
-int generate_clause(ilist literals, ilist hints) {
+clause_id_t generate_clause(ilist literals, ilist hints) {
     if (proof_type == PROOF_NONE)
         return TAUTOLOGY;
     ilist clause = clean_clause(literals);
-    int cid = ++(*clause_id_counter);
+    /* The largest ID stands for TAUTOLOGY.  Stop rather than reach it */
+    if (*clause_id_counter >= CLAUSE_ID_MAX-1) {
+        fprintf(ERROUT, "c ERROR: Exceeding clause limit %" PRIcid "\n", CLAUSE_ID_MAX-1);
+        bdd_error(TBDD_PROOF);
+        return TAUTOLOGY;
+    }
+    clause_id_t cid = ++(*clause_id_counter);
     /* if ((cid+MAX_CLAUSE) > clause_limit) { */
     /*     fprintf(ERROUT, "c ERROR: Exceeding clause limit %d\n", clause_limit); */
     /*     bdd_report(); */
@@ -391,11 +1312,8 @@ int generate_clause(ilist literals, ilist hints) {
     /*     printf("c Have reached proof clause #%d\n", cid); */
     int rval = 0;
     hints = clean_hints(hints);
-    unsigned char *d = dest_buf;
-    if (do_binary) {
-        check_buffer(ilist_length(literals) + ilist_length(hints) + 4);
-        d = dest_buf;
-    }
+    unsigned char *start = proof_reserve(proof_file, ilist_length(literals) + ilist_length(hints) + 4);
+    unsigned char *d = start;
 
 #if DO_TRACE
     trace_list(clause, cid, "Generated clause");
@@ -405,88 +1323,50 @@ int generate_clause(ilist literals, ilist hints) {
     if (clause == TAUTOLOGY_CLAUSE)
         return TAUTOLOGY;
     if (empty_clause_id == TAUTOLOGY) {
-        if (do_binary)
+        if (do_binary) {
             *d++ = 'a';
-        else if (proof_type == PROOF_FRAT)
-            fprintf(proof_file, "a ");
-        if (proof_type == PROOF_LRAT || proof_type == PROOF_FRAT) {
-            if (do_binary) {
+            if (proof_type == PROOF_LRAT || proof_type == PROOF_FRAT)
         	d += int_byte_pack(cid, d);
-            } else {
-        	rval = fprintf(proof_file, "%d ", cid);
-        	if (rval < 0)
-        	    bdd_error(BDD_FILE);
-            }
-        }
-        if (do_binary) {
             d += ilist_byte_pack(clause, d);
-        } else
-            ilist_print(clause, proof_file, " ");
-
-        if (proof_type == PROOF_LRAT) {
-            if (do_binary) {
+            if (proof_type == PROOF_LRAT) {
         	d += int_byte_pack(0, d);
         	d += ilist_byte_pack(hints, d);
-            } else {
-        	rval = fprintf(proof_file, " 0 ");
-        	if (rval < 0)
-        	    bdd_error(BDD_FILE);
-        	rval = ilist_print(hints, proof_file, " ");
-        	if (rval < 0)
-        	    bdd_error(BDD_FILE);
             }
-        }
-        if (proof_type == PROOF_FRAT) {
-            if (do_binary) {
+            if (proof_type == PROOF_FRAT) {
         	d += int_byte_pack(0, d);
         	*d++ = 'l';
         	d += ilist_byte_pack(hints, d);
-            } else {
-        	rval = fprintf(proof_file, " 0 l ");
-        	if (rval < 0)
-        	    bdd_error(BDD_FILE);
-        	rval = ilist_print(hints, proof_file, " ");
-        	if (rval < 0)
-        	    bdd_error(BDD_FILE);
             }
-        }
-        if (do_binary) {
             d += int_byte_pack(0, d);
-            rval = fwrite(dest_buf, 1, d - dest_buf, proof_file);
-            if (rval < 0)
-        	bdd_error(BDD_FILE);
         } else {
-            rval = fprintf(proof_file, " 0\n");
-            if (rval < 0)
-        	bdd_error(BDD_FILE);
+            if (proof_type == PROOF_FRAT)
+        	d += str_text_pack("a ", d);
+            if (proof_type == PROOF_LRAT || proof_type == PROOF_FRAT) {
+        	d += int_text_pack(cid, d);
+        	*d++ = ' ';
+            }
+            d += ilist_text_pack(clause, d);
+            if (proof_type == PROOF_LRAT) {
+        	d += str_text_pack(" 0 ", d);
+        	d += ilist_text_pack(hints, d);
+            }
+            if (proof_type == PROOF_FRAT) {
+        	d += str_text_pack(" 0 l ", d);
+        	d += ilist_text_pack(hints, d);
+            }
+            d += str_text_pack(" 0\n", d);
         }
+        rval = proof_commit(proof_file, start, d);
+        if (rval < 0)
+            bdd_error(BDD_FILE);
     }
     total_clause_count++;
     live_clause_count++;
     max_live_clause_count = MAX(max_live_clause_count, live_clause_count);
 
-    if (proof_type == PROOF_DRAT || proof_type == PROOF_FRAT) {
+    if (proof_type == PROOF_DRAT || proof_type == PROOF_FRAT)
         /* Must store copy of clause */
-        if (cid >= alloc_clause_count) {
-            /* must expand */
-            double efactor = 2.0;
-            int new_alloc_clause_count = (int) (alloc_clause_count * efactor);
-            while (new_alloc_clause_count <= cid) {
-        	/* Expanding by too much causes overflow */
-        	efactor = 1.0 + (efactor-1.0)/2.0;
-        if (efactor < 1.0) bdd_error(BDD_MEMORY);
-        	new_alloc_clause_count = (int) (alloc_clause_count * efactor);
-            }
-            int i;
-            all_clauses = realloc(all_clauses, new_alloc_clause_count * sizeof(ilist));
-            if (all_clauses == NULL)
-        	bdd_error(BDD_MEMORY);
-            for (i = alloc_clause_count; i < new_alloc_clause_count; i++)
-        	all_clauses[i] = TAUTOLOGY_CLAUSE;
-            alloc_clause_count = new_alloc_clause_count;
-        }
-        all_clauses[cid-1] = ilist_copy(clause);
-    }
+        clause_db_put(cid, clause, ilist_length(clause));
     if (ilist_length(clause) == 0)
         empty_clause_id = cid;
 
@@ -494,10 +1374,10 @@ int generate_clause(ilist literals, ilist hints) {
 }
 
 /* For FRAT, have special clauses */
-extern void insert_frat_clause(FILE *pfile, char cmd, int clause_id, ilist literals, bool binary) {
+extern void insert_frat_clause(FILE *pfile, char cmd, clause_id_t clause_id, ilist literals, bool binary) {
     ilist clause = clean_clause(literals);
     int rval = 0;
-    unsigned char *d = dest_buf;
+    unsigned char *start, *d;
 
     // Make sure empty clause only finalized once
     if (cmd == 'f' && empty_clause_id != TAUTOLOGY && ilist_length(literals) == 0) {
@@ -508,23 +1388,23 @@ extern void insert_frat_clause(FILE *pfile, char cmd, int clause_id, ilist liter
     }
 
     if (binary) {
-        check_buffer(ilist_length(clause) + 3);
-        d = dest_buf;
+        d = start = proof_reserve(pfile, ilist_length(clause) + 3);
         d += int_byte_pack(cmd, d);
         d += int_byte_pack(clause_id, d);
         d += ilist_byte_pack(clause, d);
         d += int_byte_pack(0, d);
-        rval = fwrite(dest_buf, 1, d - dest_buf, pfile);
+        rval = proof_commit(pfile, start, d);
         if (rval < 0)
             bdd_error(BDD_FILE);
     } else {
-        rval = fprintf(pfile, "%c %d ", cmd, clause_id);
-        if (rval < 0)
-            bdd_error(BDD_FILE);
-        rval = ilist_print(clause, pfile, " ");
-        if (rval < 0)
-            bdd_error(BDD_FILE);
-        rval = fprintf(pfile, " 0\n");
+        d = start = proof_reserve(pfile, ilist_length(clause) + 3);
+        *d++ = cmd;
+        *d++ = ' ';
+        d += int_text_pack(clause_id, d);
+        *d++ = ' ';
+        d += ilist_text_pack(clause, d);
+        d += str_text_pack(" 0\n", d);
+        rval = proof_commit(pfile, start, d);
         if (rval < 0)
             bdd_error(BDD_FILE);
     }
@@ -532,7 +1412,7 @@ extern void insert_frat_clause(FILE *pfile, char cmd, int clause_id, ilist liter
 
 void delete_clauses(ilist clause_ids) {
     int rval;
-    unsigned char *d = dest_buf;
+    unsigned char *start, *d;
 
     clause_ids = clean_hints(clause_ids);
 
@@ -549,20 +1429,20 @@ void delete_clauses(ilist clause_ids) {
 
     if (proof_type == PROOF_LRAT) {
         if (do_binary) {
-            check_buffer(ilist_length(clause_ids) + 3);
-            d = dest_buf;
+            d = start = proof_reserve(proof_file, ilist_length(clause_ids) + 3);
             *d++ = 'd';
             d += ilist_byte_pack(clause_ids, d);
             d += int_byte_pack(0, d);
-            rval = fwrite(dest_buf, 1, d - dest_buf, proof_file);
+            rval = proof_commit(proof_file, start, d);
             if (rval < 0)
         	bdd_error(BDD_FILE);
         } else {
-            rval = fprintf(proof_file, "%d d ", *clause_id_counter);
-            if (rval < 0)
-        	bdd_error(BDD_FILE);
-            ilist_print(clause_ids, proof_file, " ");
-            rval = fprintf(proof_file, " 0\n");
+            d = start = proof_reserve(proof_file, ilist_length(clause_ids) + 3);
+            d += int_text_pack(*clause_id_counter, d);
+            d += str_text_pack(" d ", d);
+            d += ilist_text_pack(clause_ids, d);
+            d += str_text_pack(" 0\n", d);
+            rval = proof_commit(proof_file, start, d);
             if (rval < 0)
         	bdd_error(BDD_FILE);
         }
@@ -570,51 +1450,47 @@ void delete_clauses(ilist clause_ids) {
         // DRAT or FRAT
         int i;
         for (i = 0; i < ilist_length(clause_ids); i++) {
-            int cid = clause_ids[i];
-            ilist clause = all_clauses[cid-1];
-            if (clause == TAUTOLOGY_CLAUSE)
+            clause_id_t cid = clause_ids[i];
+            clause_id_t *clause = clause_db_find(cid);
+            if (clause == NULL)
         	continue;
             if (cid == empty_clause_id)
         	// Empty clause should not be deleted
         	continue;
-            if (ilist_length(clause) <= 1 && proof_type == PROOF_DRAT)
+            int clen = (int) clause[0];
+            if (clen <= 1 && proof_type == PROOF_DRAT)
         	// Don't delete unit clauses in DRAT
         	continue;
             if (do_binary) {
-        	check_buffer(ilist_length(clause) + 3);
-        	d = dest_buf;
+        	d = start = proof_reserve(proof_file, clen + 3);
         	*d++ = 'd';
         	if (proof_type == PROOF_FRAT)
         	    d += int_byte_pack(cid, d);
-        	d += ilist_byte_pack(clause, d);
+        	d += array_byte_pack(clause+1, clen, d);
         	d += int_byte_pack(0, d);
-        	rval = fwrite(dest_buf, 1, d - dest_buf, proof_file);
+        	rval = proof_commit(proof_file, start, d);
         	if (rval < 0)
         	    bdd_error(BDD_FILE);
             } else {
-        	rval = fprintf(proof_file, "d ");
-        	if (rval < 0)
-        	    bdd_error(BDD_FILE);
+        	d = start = proof_reserve(proof_file, clen + 3);
+        	d += str_text_pack("d ", d);
         	if (proof_type == PROOF_FRAT) {
-        	    rval = fprintf(proof_file, "%d ", cid);
-        	    if (rval < 0)
-        		bdd_error(BDD_FILE);
+        	    d += int_text_pack(cid, d);
+        	    *d++ = ' ';
         	}
-        	rval = ilist_print(clause, proof_file, " ");
-        	if (rval < 0)
-        	    bdd_error(BDD_FILE);
-        	rval = fprintf(proof_file, " 0\n");
+        	d += array_text_pack(clause+1, clen, d);
+        	d += str_text_pack(" 0\n", d);
+        	rval = proof_commit(proof_file, start, d);
         	if (rval < 0)
         	    bdd_error(BDD_FILE);
             }
-            ilist_free(clause);
-            all_clauses[cid-1] = TAUTOLOGY_CLAUSE;
+            clause_db_delete(cid);
         }
     }
 }
 
 /* Some deletions must be deferred until top-level apply completes */
-void defer_delete_clause(int clause_id) {
+void defer_delete_clause(clause_id_t clause_id) {
     deferred_deletion_list = ilist_push(deferred_deletion_list, clause_id);
 }
 
@@ -627,11 +1503,18 @@ void process_deferred_deletions() {
 }
 
 
-/* Retrieve input clause.  NULL if invalid */
-ilist get_input_clause(int id) {
+/* Retrieve copy of input clause, valid until the next call.  NULL if invalid */
+ilist get_input_clause(clause_id_t id) {
     if (id > input_clause_count)
         return NULL;
-    return all_clauses[id-1];
+    clause_id_t *clause = clause_db_find(id);
+    if (clause == NULL)
+        return TAUTOLOGY_CLAUSE;
+    if (input_view == NULL)
+        input_view = ilist_new((int) clause[0]);
+    input_view = ilist_resize(input_view, (int) clause[0]);
+    memcpy(input_view, clause+1, clause[0] * sizeof(clause_id_t));
+    return input_view;
 }
 
 bool print_ok(int vlevel) {
@@ -650,15 +1533,15 @@ void print_proof_comment(int vlevel, const char *fmt, ...) {
     int rval;
     if (print_ok(vlevel)) {
         va_list vlist;
-        rval = fprintf(proof_file, "c ");
+        rval = proof_printf(proof_file, "c ");
         if (rval < 0)
             bdd_error(BDD_FILE);
         va_start(vlist, fmt);
-        rval = vfprintf(proof_file, fmt, vlist);
+        rval = proof_vprintf(proof_file, fmt, vlist);
         if (rval < 0)
             bdd_error(BDD_FILE);
         va_end(vlist);
-        rval = fprintf(proof_file, "\n");
+        rval = proof_printf(proof_file, "\n");
         if (rval < 0)
             bdd_error(BDD_FILE);
     }
@@ -669,7 +1552,7 @@ void print_proof_comment(int vlevel, const char *fmt, ...) {
    ils should be big enough for 3 elemeents.
    Result should be processed with clean_clause()
 */
-ilist defining_clause(ilist ils, dclause_t dtype, int nid, int vid, int hid, int lid) {
+ilist defining_clause(ilist ils, dclause_t dtype, clause_id_t nid, int vid, clause_id_t hid, clause_id_t lid) {
     switch(dtype) {
     case DEF_HU:
         ils = ilist_fill3(ils,  nid, -vid, -hid);
@@ -707,10 +1590,10 @@ const char *hint_name[HINT_COUNT+1] = {"RESHU", "ARG1HD", "ARG2HD", "OPH", "RESL
   Data structures used during proof generation
  */
 
-static int hint_id[HINT_COUNT+1];
-static int hint_buf[HINT_COUNT+1][MAX_CLAUSE+ILIST_OVHD];
-static ilist hint_clause[HINT_COUNT+1];
-static bool hint_used[HINT_COUNT+1];
+static BDD_TLS clause_id_t hint_id[HINT_COUNT+1];
+static BDD_TLS clause_id_t hint_buf[HINT_COUNT+1][MAX_CLAUSE+ILIST_OVHD];
+static BDD_TLS ilist hint_clause[HINT_COUNT+1];
+static BDD_TLS bool hint_used[HINT_COUNT+1];
 
 static jtype_t hint_hl_order[HINT_COUNT] =
     { HINT_RESHU, HINT_ARG1HD, HINT_ARG2HD, HINT_OPH, HINT_RESLU, HINT_ARG1LD, HINT_ARG2LD, HINT_OPL };
@@ -751,9 +1634,9 @@ static void show_hints(FILE *outfile) {
     jtype_t hi;
     for (hi = (jtype_t) 0; hi < HINT_COUNT+1; hi++) {
         if (hint_id[hi] != TAUTOLOGY) {
-            fprintf(outfile, "c    %s: #%d = [", hint_name[hi], hint_id[hi]);
-            ilist_print(hint_clause[hi], outfile, " ");
-            fprintf(outfile, "]\n");
+            proof_printf(outfile, "c    %s: #%" PRIcid " = [", hint_name[hi], hint_id[hi]);
+            proof_ilist_print(hint_clause[hi], outfile, " ");
+            proof_printf(outfile, "]\n");
         }
     }
 }
@@ -768,41 +1651,47 @@ static ilist target_imply(ilist ils, BDD l, BDD r) {
 }
 
 
-static bool rup_check(ilist target_clause, jtype_t *horder, int hcount) {
-    int ubuf[8+ILIST_OVHD];
-    ilist ulist = ilist_make(ubuf, 8);
-    int cbuf[MAX_CLAUSE+ILIST_OVHD];
-    ilist cclause = ilist_make(cbuf, MAX_CLAUSE);
+/*
+  Check that the target clause follows from the hint clauses by unit
+  propagation, taking the hints in the given order.  Marks the hints used.
+  Absent hints are given as TAUTOLOGY_CLAUSE.
+ */
+static bool rup_run(ilist target_clause, ilist *hclause, const char **hname, bool *hused, int *horder, int hcount) {
+    clause_id_t ubuf[MAX_UNITS+ILIST_OVHD];
+    ilist ulist = ilist_make(ubuf, MAX_UNITS);
+    clause_id_t cbuf[MAX_MULTI_CLAUSE+ILIST_OVHD];
+    ilist cclause = ilist_make(cbuf, MAX_MULTI_CLAUSE);
     int oi, hi, li, ui;
     for (ui = 0; ui < ilist_length(target_clause); ui++)
         ilist_push(ulist, -target_clause[ui]);
     if (print_ok(4)) {
-        fprintf(proof_file, "c RUP start.  Target = [");
-        ilist_print(target_clause, proof_file, " ");
-        fprintf(proof_file, "]\n");
+        proof_printf(proof_file, "c RUP start.  Target = [");
+        proof_ilist_print(target_clause, proof_file, " ");
+        proof_printf(proof_file, "]\n");
     }
-    for (hi = 0; hi < HINT_COUNT; hi++)
-        hint_used[hi] = false;
+    for (oi = 0; oi < hcount; oi++)
+        hused[horder[oi]] = false;
     for (oi = 0; oi < hcount; oi++) {
-        jtype_t hi = horder[oi];
-        if (hint_id[hi] != TAUTOLOGY) {
-            ilist clause = hint_clause[hi];
+        hi = horder[oi];
+        if (hclause[hi] != TAUTOLOGY_CLAUSE) {
+            ilist clause = hclause[hi];
             /* Operate on copy of clause so that can manipulate */
             ilist_resize(cclause, 0);
             for (li = 0; li < ilist_length(clause); li++)
         	ilist_push(cclause, clause[li]);
             if (print_ok(4)) {
-        	fprintf(proof_file, "c   RUP step.  Units = [");
-        	ilist_print(ulist, proof_file, " ");
-        	fprintf(proof_file, "] Clause = %s\n", hint_name[hi]);
+        	proof_printf(proof_file, "c   RUP step.  Units = [");
+        	proof_ilist_print(ulist, proof_file, " ");
+        	proof_printf(proof_file, "] Clause = %s\n", hname[hi]);
             }
             li = 0;
-            while (li < ilist_length(cclause)) {
-        	int lit = cclause[li];
+            bool satisfied = false;
+            while (!satisfied && li < ilist_length(cclause)) {
+        	clause_id_t lit = cclause[li];
         	if (print_ok(5)) {
-        	    fprintf(proof_file, "c     cclause = [");
-        	    ilist_print(cclause, proof_file, " ");
-        	    fprintf(proof_file, "]  ");
+        	    proof_printf(proof_file, "c     cclause = [");
+        	    proof_ilist_print(cclause, proof_file, " ");
+        	    proof_printf(proof_file, "]  ");
         	}
         	bool found = false;
         	for (ui = 0; ui < ilist_length(ulist); ui++) {
@@ -812,17 +1701,20 @@ static bool rup_check(ilist target_clause, jtype_t *horder, int hcount) {
         	    }
         	    if (lit == ulist[ui]) {
         		if (print_ok(5))
-        		    fprintf(proof_file, "c Unit %d Found.  Creates tautology\n", -lit);
-        		return false;
+        		    proof_printf(proof_file, "c Unit %" PRIcid " Found.  Clause satisfied\n", lit);
+        		satisfied = true;
+        		break;
         	    }
         	}
+        	if (satisfied)
+        	    break;
         	if (found) {
         	    if (print_ok(5))
-        		fprintf(proof_file, "c Unit %d found.  Deleting %d\n", -lit, lit);
+        		proof_printf(proof_file, "c Unit %" PRIcid " found.  Deleting %" PRIcid "\n", -lit, lit);
         	    if (ilist_length(cclause) == 1) {
         		print_proof_comment(4, "c   Conflict detected");
         		/* Conflict detected */
-        		hint_used[hi] = true;
+        		hused[hi] = true;
         		return true;
         	    } else {
         		/* Remove lit from cclause by swapping with last one */
@@ -832,15 +1724,15 @@ static bool rup_check(ilist target_clause, jtype_t *horder, int hcount) {
         	    }
         	} else {
         	    if (print_ok(5))
-        		fprintf(proof_file, "c Unit %d NOT found.  Keeping %d\n", -lit, lit);
+        		proof_printf(proof_file, "c Unit %" PRIcid " NOT found.  Keeping %" PRIcid "\n", -lit, lit);
         	    li++;
         	}
             }
-            if (ilist_length(cclause) == 1) {
+            if (!satisfied && ilist_length(cclause) == 1) {
         	/* Unit propagation */
-        	print_proof_comment(5, "  Unit propagation of %d", cclause[0]);
+        	print_proof_comment(5, "  Unit propagation of %" PRIcid, cclause[0]);
         	ilist_push(ulist, cclause[0]);
-        	hint_used[hi] = true;
+        	hused[hi] = true;
             }
         }
     }
@@ -851,26 +1743,127 @@ static bool rup_check(ilist target_clause, jtype_t *horder, int hcount) {
 
 
 
-int justify_apply(int op, BDD l, BDD r, int splitVar, pcbdd tresl, pcbdd tresh, BDD res) {
-    int tbuf[MAX_CLAUSE+ILIST_OVHD];
-    ilist targ = ilist_make(tbuf, MAX_CLAUSE);
-    int itbuf[MAX_CLAUSE+ILIST_OVHD];
+static bool rup_check(ilist target_clause, jtype_t *horder, int hcount) {
+    int order[HINT_COUNT+1];
+    ilist clauses[HINT_COUNT+1];
+    int oi, hi;
+    for (hi = 0; hi < HINT_COUNT+1; hi++)
+        clauses[hi] = hint_id[hi] == TAUTOLOGY ? TAUTOLOGY_CLAUSE : hint_clause[hi];
+    for (oi = 0; oi < hcount; oi++)
+        order[oi] = horder[oi];
+    return rup_run(target_clause, clauses, hint_name, hint_used, order, hcount);
+}
+
+
+/*
+  Generate the proof of the target clause from the completed hints,
+  either as a single clause or split on the variable splitVar.
+  Returns the ID of the clause.
+ */
+static clause_id_t justify_from_hints(ilist targ, int splitVar) {
+    clause_id_t itbuf[MAX_CLAUSE+ILIST_OVHD];
     ilist itarg = ilist_make(itbuf, MAX_CLAUSE);
-    int abuf[8+ILIST_OVHD];
+    clause_id_t abuf[8+ILIST_OVHD];
     ilist ant = ilist_make(abuf, 8);
-    int dbuf[1+ILIST_OVHD];
+    clause_id_t dbuf[1+ILIST_OVHD];
     ilist del = ilist_make(dbuf, 1);
     int oi, hi, li;
+    clause_id_t jid = 0;
+
+    bool checked = false;
+    if (hint_id[HINT_OPH] == TAUTOLOGY) {
+        /* Try for single clause proof */
+        if (rup_check(targ, hint_hl_order, HINT_COUNT)) {
+            checked = true;
+            for (oi = 0; oi < HINT_COUNT; oi++) {
+        	hi = hint_hl_order[oi];
+        	if (hint_used[hi])
+        	    ilist_push(ant, hint_id[hi]);
+            }
+            jid = generate_clause(targ, ant);
+        }
+
+    }
+    if (!checked && hint_id[HINT_OPL] == TAUTOLOGY) {
+        if (rup_check(targ, hint_lh_order, HINT_COUNT)) {
+            checked = true;
+            for (oi = 0; oi < HINT_COUNT; oi++) {
+        	hi = hint_lh_order[oi];
+        	if (hint_used[hi])
+        	    ilist_push(ant, hint_id[hi]);
+            }
+            jid = generate_clause(targ, ant);
+        }
+    }
+    if (!checked) {
+        ilist_push(itarg, -splitVar);
+        for (li = 0; li < ilist_length(targ); li++)
+            ilist_push(itarg, targ[li]);
+        itarg = clean_clause(itarg);
+        if (!rup_check(itarg, hint_h_order, HINT_COUNT/2)) {
+            proof_printf(proof_file, "c ERROR.  RUP check failed in first half of proof.  Target = [");
+            proof_ilist_print(itarg, proof_file, " ");
+            proof_printf(proof_file, "].\n");
+            print_proof_comment(3, "  Candidate hints:");
+            show_hints(proof_file);
+
+            fprintf(ERROUT, "c ERROR.  RUP check failed in first half of proof.  Target = [");
+            ilist_print(itarg, ERROUT, " ");
+            fprintf(ERROUT, "].\n");
+            fprintf(ERROUT, "c   Candidate hints:");
+            show_hints(ERROUT);
+            bdd_error(TBDD_PROOF);
+        }
+        for (oi = 0; oi < HINT_COUNT/2; oi++) {
+            hi = hint_h_order[oi];
+            if (hint_used[hi])
+        	ilist_push(ant, hint_id[hi]);
+        }
+        clause_id_t iid = generate_clause(itarg, ant);
+        hint_id[HINT_EXTRA] = iid;
+        hint_clause[HINT_EXTRA] = itarg;
+        if (!rup_check(targ, hint_l_order, HINT_COUNT/2+1)) {
+            proof_printf(proof_file, "c Uh-Oh.  RUP check failed in second half of proof.  Target = [");
+            proof_ilist_print(targ, proof_file, " ");
+            proof_printf(proof_file, "].\n");
+            print_proof_comment(3, "  Candidate hints:");
+            show_hints(proof_file);
+
+            fprintf(ERROUT, "c Uh-Oh.  RUP check failed in second half of proof.  Target = [");
+            ilist_print(itarg, ERROUT, " ");
+            fprintf(ERROUT, "].\n");
+            fprintf(ERROUT, "c   Candidate hints:");
+            show_hints(ERROUT);
+            bdd_error(TBDD_PROOF);
+
+        }
+        ilist_resize(ant, 0);
+        for (oi = 0; oi < HINT_COUNT/2+1; oi++) {
+            hi = hint_l_order[oi];
+            if (hint_used[hi])
+        	ilist_push(ant, hint_id[hi]);
+        }
+        // Negate ID to show that two clauses were generated
+        //	jid = -generate_clause(targ, ant);
+        jid = generate_clause(targ, ant);
+        ilist_fill1(del, iid);
+        delete_clauses(del);
+    }
+    return jid;
+}
+
+clause_id_t justify_apply(int op, BDD l, BDD r, int splitVar, pcbdd tresl, pcbdd tresh, BDD res) {
+    clause_id_t tbuf[MAX_CLAUSE+ILIST_OVHD];
+    ilist targ = ilist_make(tbuf, MAX_CLAUSE);
     int splitLevel = bdd_var2level(splitVar);
 
-    int jid = 0;
     if (op == bddop_andj) {
         targ = clean_clause(target_and(targ, l, r, res));
-        print_proof_comment(2, "Generating proof that N%d & N%d --> N%d", bdd_nameid(l), bdd_nameid(r), bdd_nameid(res));
-        print_proof_comment(3, "splitVar = %d, tresl.root = N%d, tresh.root = N%d", splitVar, bdd_nameid(tresl.root), bdd_nameid(tresh.root));
+        print_proof_comment(2, "Generating proof that N%" PRIcid " & N%" PRIcid " --> N%" PRIcid, bdd_nameid(l), bdd_nameid(r), bdd_nameid(res));
+        print_proof_comment(3, "splitVar = %d, tresl.root = N%" PRIcid ", tresh.root = N%" PRIcid, splitVar, bdd_nameid(tresl.root), bdd_nameid(tresh.root));
     } else {
         targ = clean_clause(target_imply(targ, l, r));
-        print_proof_comment(2, "Generating proof that N%d --> N%d", bdd_nameid(l), bdd_nameid(r));
+        print_proof_comment(2, "Generating proof that N%" PRIcid " --> N%" PRIcid, bdd_nameid(l), bdd_nameid(r));
         print_proof_comment(3, "splitVar = %d", splitVar);
     }
     if (targ == TAUTOLOGY_CLAUSE) {
@@ -878,9 +1871,9 @@ int justify_apply(int op, BDD l, BDD r, int splitVar, pcbdd tresl, pcbdd tresh,
         return TAUTOLOGY;
     }
     if (print_ok(3)) {
-        fprintf(proof_file, "c Target clause = [");
-        ilist_print(targ, proof_file, " ");
-        fprintf(proof_file, "]\n");
+        proof_printf(proof_file, "c Target clause = [");
+        proof_ilist_print(targ, proof_file, " ");
+        proof_printf(proof_file, "]\n");
     }
 
 
@@ -937,28 +1930,233 @@ int justify_apply(int op, BDD l, BDD r, int splitVar, pcbdd tresl, pcbdd tresh,
         show_hints(proof_file);
     }
 
+    return justify_from_hints(targ, splitVar);
+}
+
+/*
+  Justification of an and-exist step that quantifies splitVar.  The
+  result is the disjunction of the cofactor results, and the
+  implications from each of them into the result take the place of
+  the defining clauses for the result.
+ */
+clause_id_t justify_and_exist(BDD l, BDD r, int splitVar, pcbdd tresl, pcbdd tresh, clause_id_t impl_id, clause_id_t imph_id, BDD res) {
+    clause_id_t tbuf[MAX_CLAUSE+ILIST_OVHD];
+    ilist targ = ilist_make(tbuf, MAX_CLAUSE);
+    int splitLevel = bdd_var2level(splitVar);
+
+    targ = clean_clause(target_and(targ, l, r, res));
+    print_proof_comment(2, "Generating proof that Exists %d (N%" PRIcid " & N%" PRIcid ") --> N%" PRIcid, splitVar, bdd_nameid(l), bdd_nameid(r), bdd_nameid(res));
+    print_proof_comment(3, "tresl.root = N%" PRIcid ", tresh.root = N%" PRIcid, bdd_nameid(tresl.root), bdd_nameid(tresh.root));
+    if (targ == TAUTOLOGY_CLAUSE) {
+        print_proof_comment(2, "Tautology");
+        return TAUTOLOGY;
+    }
+    if (print_ok(3)) {
+        proof_printf(proof_file, "c Target clause = [");
+        proof_ilist_print(targ, proof_file, " ");
+        proof_printf(proof_file, "]\n");
+    }
+
+    initialize_hints();
+    if (LEVEL(l) == splitLevel) {
+        hint_id[HINT_ARG1LD] = bdd_dclause(l, DEF_LD);
+        hint_clause[HINT_ARG1LD] = defining_clause(hint_clause[HINT_ARG1LD], DEF_LD, XVAR(l), splitVar, XVAR(HIGH(l)), XVAR(LOW(l)));
+        hint_id[HINT_ARG1HD] = bdd_dclause(l, DEF_HD);
+        hint_clause[HINT_ARG1HD] = defining_clause(hint_clause[HINT_ARG1HD], DEF_HD, XVAR(l), splitVar, XVAR(HIGH(l)), XVAR(LOW(l)));
+    }
+    if (LEVEL(r) == splitLevel) {
+        hint_id[HINT_ARG2LD] = bdd_dclause(r, DEF_LD);
+        hint_clause[HINT_ARG2LD] = defining_clause(hint_clause[HINT_ARG2LD], DEF_LD, XVAR(r), splitVar, XVAR(HIGH(r)), XVAR(LOW(r)));
+        hint_id[HINT_ARG2HD] = bdd_dclause(r, DEF_HD);
+        hint_clause[HINT_ARG2HD] = defining_clause(hint_clause[HINT_ARG2HD], DEF_HD, XVAR(r), splitVar, XVAR(HIGH(r)), XVAR(LOW(r)));
+    }
+
+    BDD ll = LEVEL(l) == splitLevel ? LOW(l) : l;
+    BDD lh = LEVEL(l) == splitLevel ? HIGH(l) : l;
+    BDD rl = LEVEL(r) == splitLevel ? LOW(r) : r;
+    BDD rh = LEVEL(r) == splitLevel ? HIGH(r) : r;
+
+    hint_id[HINT_RESLU] = impl_id;
+    hint_clause[HINT_RESLU] = target_imply(hint_clause[HINT_RESLU], tresl.root, res);
+    hint_id[HINT_RESHU] = imph_id;
+    hint_clause[HINT_RESHU] = target_imply(hint_clause[HINT_RESHU], tresh.root, res);
+    hint_id[HINT_OPL] = tresl.clause_id;
+    hint_clause[HINT_OPL] = target_and(hint_clause[HINT_OPL], ll, rl, tresl.root);
+    hint_id[HINT_OPH] = tresh.clause_id;
+    hint_clause[HINT_OPH] = target_and(hint_clause[HINT_OPH], lh, rh, tresh.root);
+
+    complete_hints();
+    if (print_ok(3)) {
+        print_proof_comment(3, "Hints:");
+        show_hints(proof_file);
+    }
+    return justify_from_hints(targ, splitVar);
+}
+
+
+/*
+  Justification of an n-ary conjunction step.  For operands u_1 ... u_n
+  and result w, prove the clause [-u_1 ... -u_n w].  The hints have the
+  same roles as for justify_apply, but with one pair of defining clauses
+  per operand.  The high half of the hints comes first, then the low
+  half, and then the extra intermediate clause.
+ */
+
+#define MULTI_HINT_COUNT (2*(BDD_MULTIMAX+2)+1)
+
+static BDD_TLS clause_id_t mhint_id[MULTI_HINT_COUNT];
+static BDD_TLS clause_id_t mhint_buf[MULTI_HINT_COUNT][MAX_MULTI_CLAUSE+ILIST_OVHD];
+static BDD_TLS ilist mhint_clause[MULTI_HINT_COUNT];
+static BDD_TLS bool mhint_used[MULTI_HINT_COUNT];
+static BDD_TLS const char *mhint_name[MULTI_HINT_COUNT];
+
+static ilist target_and_multi(ilist ils, BDD *ops, int n, BDD s) {
+    int i;
+    ilist_resize(ils, 0);
+    for (i = 0; i < n; i++)
+        ilist_push(ils, -XVAR(ops[i]));
+    ilist_push(ils, XVAR(s));
+    return ils;
+}
+
+static void show_multi_hints(FILE *outfile, int count) {
+    int hi;
+    for (hi = 0; hi < count; hi++) {
+        if (mhint_id[hi] != TAUTOLOGY) {
+            proof_printf(outfile, "c    %s: #%" PRIcid " = [", mhint_name[hi], mhint_id[hi]);
+            proof_ilist_print(mhint_clause[hi], outfile, " ");
+            proof_printf(outfile, "]\n");
+        }
+    }
+}
+
+/* Add the antecedents used by a RUP check */
+static void push_multi_used(ilist ant, int *order, int count) {
+    int oi;
+    for (oi = 0; oi < count; oi++) {
+        if (mhint_used[order[oi]])
+            ilist_push(ant, mhint_id[order[oi]]);
+    }
+}
+
+static void multi_check_failed(ilist targ, const char *msg, int count) {
+    proof_printf(proof_file, "c ERROR.  RUP check failed in %s of proof.  Target = [", msg);
+    proof_ilist_print(targ, proof_file, " ");
+    proof_printf(proof_file, "].\n");
+    print_proof_comment(3, "  Candidate hints:");
+    show_multi_hints(proof_file, count);
+
+    fprintf(ERROUT, "c ERROR.  RUP check failed in %s of proof.  Target = [", msg);
+    ilist_print(targ, ERROUT, " ");
+    fprintf(ERROUT, "].\n");
+    fprintf(ERROUT, "c   Candidate hints:");
+    show_multi_hints(ERROUT, count);
+    bdd_error(TBDD_PROOF);
+}
+
+clause_id_t justify_and_multi(BDD *ops, int n, int splitVar, pcbdd tresl, pcbdd tresh, BDD res) {
+    clause_id_t tbuf[MAX_MULTI_CLAUSE+ILIST_OVHD];
+    ilist targ = ilist_make(tbuf, MAX_MULTI_CLAUSE);
+    clause_id_t itbuf[MAX_MULTI_CLAUSE+ILIST_OVHD];
+    ilist itarg = ilist_make(itbuf, MAX_MULTI_CLAUSE);
+    clause_id_t abuf[MULTI_HINT_COUNT+ILIST_OVHD];
+    ilist ant = ilist_make(abuf, MULTI_HINT_COUNT);
+    clause_id_t dbuf[1+ILIST_OVHD];
+    ilist del = ilist_make(dbuf, 1);
+    int order[MULTI_HINT_COUNT];
+    BDD opl[BDD_MULTIMAX], oph[BDD_MULTIMAX];
+    int i, hi, li;
+    int splitLevel = bdd_var2level(splitVar);
+    /* Offset of the low half, and index of the extra hint */
+    int half = n+2;
+    int extra = 2*half;
+    int count = extra+1;
+    clause_id_t jid = 0;
+
+    targ = clean_clause(target_and_multi(targ, ops, n, res));
+    print_proof_comment(2, "Generating proof of %d-way conjunction --> N%" PRIcid, n, bdd_nameid(res));
+    print_proof_comment(3, "splitVar = %d, tresl.root = N%" PRIcid ", tresh.root = N%" PRIcid, splitVar, bdd_nameid(tresl.root), bdd_nameid(tresh.root));
+    if (targ == TAUTOLOGY_CLAUSE) {
+        print_proof_comment(2, "Tautology");
+        return TAUTOLOGY;
+    }
+    if (print_ok(3)) {
+        proof_printf(proof_file, "c Target clause = [");
+        proof_ilist_print(targ, proof_file, " ");
+        proof_printf(proof_file, "]\n");
+    }
+
+    /* Prepare the candidates */
+    for (hi = 0; hi < count; hi++) {
+        mhint_id[hi] = TAUTOLOGY;
+        mhint_clause[hi] = ilist_make(mhint_buf[hi], MAX_MULTI_CLAUSE);
+    }
+    mhint_name[0] = "RESHU";
+    mhint_name[half] = "RESLU";
+    mhint_name[n+1] = "OPH";
+    mhint_name[half+n+1] = "OPL";
+    mhint_name[extra] = "EXTRA";
+
+    for (i = 0; i < n; i++) {
+        BDD u = ops[i];
+        mhint_name[1+i] = "ARGHD";
+        mhint_name[half+1+i] = "ARGLD";
+        if (LEVEL(u) == splitLevel) {
+            mhint_id[1+i] = bdd_dclause(u, DEF_HD);
+            mhint_clause[1+i] = defining_clause(mhint_clause[1+i], DEF_HD, XVAR(u), splitVar, XVAR(HIGH(u)), XVAR(LOW(u)));
+            mhint_id[half+1+i] = bdd_dclause(u, DEF_LD);
+            mhint_clause[half+1+i] = defining_clause(mhint_clause[half+1+i], DEF_LD, XVAR(u), splitVar, XVAR(HIGH(u)), XVAR(LOW(u)));
+            opl[i] = LOW(u);
+            oph[i] = HIGH(u);
+        } else
+            opl[i] = oph[i] = u;
+    }
+
+    BDD resl = LEVEL(res) == splitLevel ? LOW(res) : res;
+    BDD resh = LEVEL(res) == splitLevel ? HIGH(res) : res;
+    if (LEVEL(res) == splitLevel) {
+        mhint_id[0] = bdd_dclause(res, DEF_HU);
+        mhint_clause[0] = defining_clause(mhint_clause[0], DEF_HU, XVAR(res), splitVar, XVAR(HIGH(res)), XVAR(LOW(res)));
+        mhint_id[half] = bdd_dclause(res, DEF_LU);
+        mhint_clause[half] = defining_clause(mhint_clause[half], DEF_LU, XVAR(res), splitVar, XVAR(HIGH(res)), XVAR(LOW(res)));
+    }
+    mhint_id[n+1] = tresh.clause_id;
+    mhint_clause[n+1] = target_and_multi(mhint_clause[n+1], oph, n, resh);
+    mhint_id[half+n+1] = tresl.clause_id;
+    mhint_clause[half+n+1] = target_and_multi(mhint_clause[half+n+1], opl, n, resl);
+
+    /* Same as complete_hints */
+    for (hi = 0; hi < count; hi++) {
+        if (mhint_id[hi] == TAUTOLOGY)
+            mhint_clause[hi] = TAUTOLOGY_CLAUSE;
+        else {
+            mhint_clause[hi] = clean_clause(mhint_clause[hi]);
+            if (mhint_clause[hi] == TAUTOLOGY_CLAUSE)
+        	mhint_id[hi] = TAUTOLOGY;
+        }
+    }
+    if (print_ok(3)) {
+        print_proof_comment(3, "Hints:");
+        show_multi_hints(proof_file, count);
+    }
+
     bool checked = false;
-    if (hint_id[HINT_OPH] == TAUTOLOGY) {
+    if (mhint_id[n+1] == TAUTOLOGY) {
         /* Try for single clause proof */
-        if (rup_check(targ, hint_hl_order, HINT_COUNT)) {
+        for (hi = 0; hi < extra; hi++)
+            order[hi] = hi;
+        if (rup_run(targ, mhint_clause, mhint_name, mhint_used, order, extra)) {
             checked = true;
-            for (oi = 0; oi < HINT_COUNT; oi++) {
-        	hi = hint_hl_order[oi];
-        	if (hint_used[hi])
-        	    ilist_push(ant, hint_id[hi]);
-            }
+            push_multi_used(ant, order, extra);
             jid = generate_clause(targ, ant);
         }
-
     }
-    if (!checked && hint_id[HINT_OPL] == TAUTOLOGY) {
-        if (rup_check(targ, hint_lh_order, HINT_COUNT)) {
+    if (!checked && mhint_id[half+n+1] == TAUTOLOGY) {
+        for (hi = 0; hi < extra; hi++)
+            order[hi] = (hi + half) % extra;
+        if (rup_run(targ, mhint_clause, mhint_name, mhint_used, order, extra)) {
             checked = true;
-            for (oi = 0; oi < HINT_COUNT; oi++) {
-        	hi = hint_lh_order[oi];
-        	if (hint_used[hi])
-        	    ilist_push(ant, hint_id[hi]);
-            }
+            push_multi_used(ant, order, extra);
             jid = generate_clause(targ, ant);
         }
     }
@@ -967,54 +2165,158 @@ int justify_apply(int op, BDD l, BDD r, int splitVar, pcbdd tresl, pcbdd tresh,
         for (li = 0; li < ilist_length(targ); li++)
             ilist_push(itarg, targ[li]);
         itarg = clean_clause(itarg);
-        if (!rup_check(itarg, hint_h_order, HINT_COUNT/2)) {
-            fprintf(proof_file, "c ERROR.  RUP check failed in first half of proof.  Target = [");
-            ilist_print(itarg, proof_file, " ");
-            fprintf(proof_file, "].\n");
-            print_proof_comment(3, "  Candidate hints:");
-            show_hints(proof_file);
-
-            fprintf(ERROUT, "c ERROR.  RUP check failed in first half of proof.  Target = [");
-            ilist_print(itarg, ERROUT, " ");
-            fprintf(ERROUT, "].\n");
-            fprintf(ERROUT, "c   Candidate hints:");
-            show_hints(ERROUT);
-            bdd_error(TBDD_PROOF);
-        }
-        for (oi = 0; oi < HINT_COUNT/2; oi++) {
-            hi = hint_h_order[oi];
-            if (hint_used[hi])
-        	ilist_push(ant, hint_id[hi]);
-        }
-        int iid = generate_clause(itarg, ant);
-        hint_id[HINT_EXTRA] = iid;
-        hint_clause[HINT_EXTRA] = itarg;
-        if (!rup_check(targ, hint_l_order, HINT_COUNT/2+1)) {
-            fprintf(proof_file, "c Uh-Oh.  RUP check failed in second half of proof.  Target = [");
-            ilist_print(targ, proof_file, " ");
-            fprintf(proof_file, "].\n");
-            print_proof_comment(3, "  Candidate hints:");
-            show_hints(proof_file);
-
-            fprintf(ERROUT, "c Uh-Oh.  RUP check failed in second half of proof.  Target = [");
-            ilist_print(itarg, ERROUT, " ");
-            fprintf(ERROUT, "].\n");
-            fprintf(ERROUT, "c   Candidate hints:");
-            show_hints(ERROUT);
-            bdd_error(TBDD_PROOF);
-
-        }
+        for (hi = 0; hi < half; hi++)
+            order[hi] = hi;
+        if (!rup_run(itarg, mhint_clause, mhint_name, mhint_used, order, half))
+            multi_check_failed(itarg, "first half", count);
+        push_multi_used(ant, order, half);
+        clause_id_t iid = generate_clause(itarg, ant);
+        mhint_id[extra] = iid;
+        mhint_clause[extra] = itarg;
+        order[0] = extra;
+        for (hi = 0; hi < half; hi++)
+            order[hi+1] = half+hi;
+        if (!rup_run(targ, mhint_clause, mhint_name, mhint_used, order, half+1))
+            multi_check_failed(targ, "second half", count);
         ilist_resize(ant, 0);
-        for (oi = 0; oi < HINT_COUNT/2+1; oi++) {
-            hi = hint_l_order[oi];
-            if (hint_used[hi])
-        	ilist_push(ant, hint_id[hi]);
-        }
-        // Negate ID to show that two clauses were generated
-        //	jid = -generate_clause(targ, ant);
+        push_multi_used(ant, order, half+1);
         jid = generate_clause(targ, ant);
         ilist_fill1(del, iid);
         delete_clauses(del);
     }
     return jid;
 }
+
+/******* Support for reordering *****/
+
+/*
+  Hints for rederiving a defining clause when two adjacent levels are
+  swapped.  The first three are used under the assumption x = 1, the
+  last three under x = 0, and EXTRA is the clause derived under x = 1.
+ */
+#define SWAP_HINT_COUNT 7
+#define SWAP_EXTRA 3
+
+static void swap_hint(ilist *hclause, clause_id_t *hbuf, clause_id_t *hid, int hi, BDD n, dclause_t dtype, int vid, bool split) {
+    if (!split || n < 2) {
+        hid[hi] = TAUTOLOGY;
+        hclause[hi] = TAUTOLOGY_CLAUSE;
+        return;
+    }
+    hid[hi] = bdd_dclause(n, dtype);
+    hclause[hi] = clean_clause(defining_clause(ilist_make(hbuf, 3), dtype, XVAR(n), vid, XVAR(HIGH(n)), XVAR(LOW(n))));
+    if (hid[hi] == TAUTOLOGY || hclause[hi] == TAUTOLOGY_CLAUSE) {
+        hid[hi] = TAUTOLOGY;
+        hclause[hi] = TAUTOLOGY_CLAUSE;
+    }
+}
+
+static void swap_check_failed(ilist targ, BDD f, const char *msg) {
+    fprintf(ERROUT, "c ERROR.  RUP check failed in %s of swap for node N%" PRIcid ".  Target = [", msg, NNAME(f));
+    ilist_print(targ, ERROUT, " ");
+    fprintf(ERROUT, "].\n");
+    bdd_error(TBDD_PROOF);
+}
+
+/*
+  Node f = ITE(x, f1, f0) with f1 = ITE(y, f11, f10) and f0 = ITE(y, f01, f00)
+  is about to be rewritten in place as ITE(y, g1, g0) with
+  g1 = ITE(x, f11, f01) and g0 = ITE(x, f10, f00).  The function of f
+  does not change, so it keeps its extension variable.  Generate its
+  defining clauses over the new children, each by case splitting on x.
+  The four new clauses get consecutive IDs, and the first is returned.
+  The old defining clauses of f are left to the caller to delete.
+ */
+clause_id_t justify_swap(BDD f, int x, int y, BDD f00, BDD f01, BDD f10, BDD f11, BDD g0, BDD g1) {
+    clause_id_t tbuf[4][3+ILIST_OVHD];
+    ilist targ[4];
+    clause_id_t itbuf[4][4+ILIST_OVHD];
+    ilist itarg[4];
+    clause_id_t iid[4];
+    clause_id_t hbuf[SWAP_HINT_COUNT][3+ILIST_OVHD];
+    ilist hclause[SWAP_HINT_COUNT];
+    clause_id_t hid[SWAP_HINT_COUNT];
+    bool hused[SWAP_HINT_COUNT];
+    const char *hname[SWAP_HINT_COUNT] = { "", "", "", "EXTRA", "", "", "" };
+    clause_id_t abuf[SWAP_HINT_COUNT+ILIST_OVHD];
+    ilist ant;
+    clause_id_t dbuf[4+ILIST_OVHD];
+    ilist del = ilist_make(dbuf, 4);
+    int order[SWAP_HINT_COUNT];
+    BDD f0 = LOW(f), f1 = HIGH(f);
+    clause_id_t nid = XVAR(f);
+    clause_id_t first;
+    int t, hi, li;
+
+    print_proof_comment(2, "Swapping V%d and V%d in node N%" PRIcid ".  Children N%" PRIcid ", N%" PRIcid " --> N%" PRIcid ", N%" PRIcid,
+        		x, y, nid, NNAME(f1), NNAME(f0), NNAME(g1), NNAME(g0));
+
+    /* First pass: derive each new clause under the assumption x = 1 */
+    for (t = DEF_HU; t <= DEF_LD; t++) {
+        bool up = t == DEF_HU || t == DEF_LU;
+        BDD g = (t == DEF_HU || t == DEF_HD) ? g1 : g0;
+        bool gsplit = g != ((t == DEF_HU || t == DEF_HD) ? f11 : f10);
+
+        targ[t] = clean_clause(defining_clause(ilist_make(tbuf[t], 3), t, nid, y, XVAR(g1), XVAR(g0)));
+        iid[t] = TAUTOLOGY;
+        itarg[t] = TAUTOLOGY_CLAUSE;
+        if (targ[t] == TAUTOLOGY_CLAUSE)
+            continue;
+
+        swap_hint(hclause, hbuf[0], hid, 0, g, up ? DEF_HD : DEF_HU, x, gsplit);
+        swap_hint(hclause, hbuf[1], hid, 1, f1, t, y, f1 != f11);
+        swap_hint(hclause, hbuf[2], hid, 2, f, up ? DEF_HU : DEF_HD, x, true);
+        for (hi = 0; hi < 3; hi++)
+            order[hi] = up ? hi : 2-hi;
+
+        itarg[t] = ilist_make(itbuf[t], 4);
+        ilist_push(itarg[t], -x);
+        for (li = 0; li < ilist_length(targ[t]); li++)
+            ilist_push(itarg[t], targ[t][li]);
+        itarg[t] = clean_clause(itarg[t]);
+        if (itarg[t] == TAUTOLOGY_CLAUSE)
+            continue;
+        if (!rup_run(itarg[t], hclause, hname, hused, order, 3))
+            swap_check_failed(itarg[t], f, "first half");
+        ant = ilist_make(abuf, SWAP_HINT_COUNT);
+        for (hi = 0; hi < 3; hi++)
+            if (hused[order[hi]])
+        	ilist_push(ant, hid[order[hi]]);
+        iid[t] = generate_clause(itarg[t], ant);
+    }
+
+    /* Second pass: the new defining clauses, with consecutive IDs */
+    first = *clause_id_counter + 1;
+    for (t = DEF_HU; t <= DEF_LD; t++) {
+        bool up = t == DEF_HU || t == DEF_LU;
+        BDD g = (t == DEF_HU || t == DEF_HD) ? g1 : g0;
+        bool gsplit = g != ((t == DEF_HU || t == DEF_HD) ? f11 : f10);
+
+        ant = ilist_make(abuf, SWAP_HINT_COUNT);
+        if (targ[t] == TAUTOLOGY_CLAUSE) {
+            /* Still uses up an ID */
+            generate_clause(defining_clause(ilist_make(tbuf[t], 3), t, nid, y, XVAR(g1), XVAR(g0)), ant);
+            continue;
+        }
+
+        hid[SWAP_EXTRA] = iid[t];
+        hclause[SWAP_EXTRA] = iid[t] == TAUTOLOGY ? TAUTOLOGY_CLAUSE : itarg[t];
+        swap_hint(hclause, hbuf[4], hid, 4, g, up ? DEF_LD : DEF_LU, x, gsplit);
+        swap_hint(hclause, hbuf[5], hid, 5, f0, t, y, f0 != f01);
+        swap_hint(hclause, hbuf[6], hid, 6, f, up ? DEF_LU : DEF_LD, x, true);
+        order[0] = SWAP_EXTRA;
+        for (hi = 0; hi < 3; hi++)
+            order[hi+1] = up ? 4+hi : 6-hi;
+
+        if (!rup_run(targ[t], hclause, hname, hused, order, 4))
+            swap_check_failed(targ[t], f, "second half");
+        for (hi = 0; hi < 4; hi++)
+            if (hused[order[hi]])
+        	ilist_push(ant, hid[order[hi]]);
+        generate_clause(targ[t], ant);
+        if (iid[t] != TAUTOLOGY)
+            ilist_push(del, iid[t]);
+    }
+    delete_clauses(del);
+    return first;
+}
@@ -53,19 +53,58 @@ extern "C" {
 #endif
 
 /* Global variables exported by prover */
+#if ENABLE_REENTRANT
+/* In a reentrant build they belong to the current manager, which starts
+   with them.  As for errno, the names are then macros */
+typedef struct {
+    proof_type_t proof_type;
+    int verbosity_level;
+    clause_id_t *variable_counter;
+    clause_id_t *clause_id_counter;
+    clause_id_t total_clause_count;
+    clause_id_t input_variable_count;
+    clause_id_t input_clause_count;
+    clause_id_t max_live_clause_count;
+    clause_id_t deleted_clause_count;
+    int proof_block_size;
+    int proof_block_count;
+    bool proof_sync;
+    proof_compress_t proof_compression;
+} prover_vars_t;
+
+#define PROVER_VARS ((prover_vars_t *) bddmanager)
+#define proof_type (PROVER_VARS->proof_type)
+#define verbosity_level (PROVER_VARS->verbosity_level)
+#define variable_counter (PROVER_VARS->variable_counter)
+#define clause_id_counter (PROVER_VARS->clause_id_counter)
+#define total_clause_count (PROVER_VARS->total_clause_count)
+#define input_variable_count (PROVER_VARS->input_variable_count)
+#define input_clause_count (PROVER_VARS->input_clause_count)
+#define max_live_clause_count (PROVER_VARS->max_live_clause_count)
+#define deleted_clause_count (PROVER_VARS->deleted_clause_count)
+#define proof_block_size (PROVER_VARS->proof_block_size)
+#define proof_block_count (PROVER_VARS->proof_block_count)
+#define proof_sync (PROVER_VARS->proof_sync)
+#define proof_compression (PROVER_VARS->proof_compression)
+#else
 extern proof_type_t proof_type;
 extern int verbosity_level;
 /* extern int clause_limit; */
-extern int *variable_counter;
-extern int *clause_id_counter;
-extern int total_clause_count;
-extern int input_variable_count;
-extern int input_clause_count;
-extern int max_live_clause_count;
-extern int deleted_clause_count;
+extern clause_id_t *variable_counter;
+extern clause_id_t *clause_id_counter;
+extern clause_id_t total_clause_count;
+extern clause_id_t input_variable_count;
+extern clause_id_t input_clause_count;
+extern clause_id_t max_live_clause_count;
+extern clause_id_t deleted_clause_count;
+extern int proof_block_size;
+extern int proof_block_count;
+extern bool proof_sync;
+extern proof_compress_t proof_compression;
+#endif
 
 /* Prover setup and completion */
-extern int prover_init(FILE *pfile, int *variable_counter, int *clause_counter, ilist *clauses, ilist variable_ordering, proof_type_t ptype, bool binary);
+extern int prover_init(FILE *pfile, clause_id_t *var_counter, clause_id_t *clause_counter, ilist *clauses, ilist variable_ordering, proof_type_t ptype, bool binary);
 extern void prover_done();
 
 /* Put literals in clause in canonical order */
@@ -73,28 +112,28 @@ extern ilist clean_clause(ilist clause);
 
 /* Return clause ID */
 /* For DRAT proof, antecedents can be NULL */
-extern int generate_clause(ilist literals, ilist antecedent);
+extern clause_id_t generate_clause(ilist literals, ilist antecedent);
 
 /* For FRAT, have special clauses */
-extern void insert_frat_clause(FILE *pfile, char cmd, int clause_id, ilist literals, bool binary);
+extern void insert_frat_clause(FILE *pfile, char cmd, clause_id_t clause_id, ilist literals, bool binary);
 
 extern void delete_clauses(ilist clause_ids);
 
 /* Some deletions must be deferred until top-level apply completes */
-extern void defer_delete_clause(int clause_id);
+extern void defer_delete_clause(clause_id_t clause_id);
 extern void process_deferred_deletions();
 
 
 
 /* Retrieve input clause.  NULL if invalid */
-extern ilist get_input_clause(int id);
+extern ilist get_input_clause(clause_id_t id);
 
 /*
    Fill ilist with defining clause.
    ils should be big enough for 3 elemeents.
    Return either the list of literals or TAUTOLOGY_CLAUSE
 */
-extern ilist defining_clause(ilist ils, dclause_t dtype, int nid, int vid, int hid, int lid);
+extern ilist defining_clause(ilist ils, dclause_t dtype, clause_id_t nid, int vid, clause_id_t hid, clause_id_t lid);
 
 /* Print clause */
 extern void print_clause(FILE *out, ilist clause);
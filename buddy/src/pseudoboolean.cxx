@@ -33,6 +33,7 @@
 
 #include "pseudoboolean.h"
 #include "prover.h"
+#include "kernel.h"
 
 using namespace trustbdd;
 
@@ -49,7 +50,7 @@ using namespace trustbdd;
 
 #define BUFLEN 2048
 // For formatting information
-static char ibuf[BUFLEN];
+static BDD_TLS char ibuf[BUFLEN];
 
 // Standard seed value
 #define DEFAULT_SEED 123456
@@ -71,21 +72,42 @@ static char ibuf[BUFLEN];
 /*
   Statistics gathering
  */
-static int pseudo_xor_created = 0;
-static int pseudo_xor_unique = 0;
-static int pseudo_total_length = 0;
-static int pseudo_plus_computed = 0;
-/* Accumulate upper bound on number of BDD operations from pseudo-Boolean ops */
-#if INSTRUMENT_BOUNDS
-static long unsigned wc_bdd_ops = 0;
-static long unsigned actual_bdd_ops = 0;
+typedef struct {
+    int pseudo_xor_created;
+    int pseudo_xor_unique;
+    int pseudo_total_length;
+    int pseudo_plus_computed;
+    /* Accumulate upper bound on number of BDD operations from pseudo-Boolean ops */
+    long unsigned wc_bdd_ops;
+    long unsigned actual_bdd_ops;
+    /* Numbering of the instrumented sums and Gauss steps */
+    int sum_data_count;
+    int gauss_data_count;
+    bool initialized;
+} pseudo_state_t;
+
+#if ENABLE_REENTRANT
+extern "C" void *pseudo_newstate(void) {
+    return bdd_newstate(NULL, sizeof(pseudo_state_t));
+}
+#else
+static pseudo_state_t pseudo_state;
 #endif
 
+#define PBSTATE BDDSTATE(pseudo_state_t, BDDMOD_PSEUDO, pseudo_state)
+#define pseudo_xor_created (PBSTATE->pseudo_xor_created)
+#define pseudo_xor_unique (PBSTATE->pseudo_xor_unique)
+#define pseudo_total_length (PBSTATE->pseudo_total_length)
+#define pseudo_plus_computed (PBSTATE->pseudo_plus_computed)
+#define wc_bdd_ops (PBSTATE->wc_bdd_ops)
+#define actual_bdd_ops (PBSTATE->actual_bdd_ops)
+#define sum_data_count (PBSTATE->sum_data_count)
+#define gauss_data_count (PBSTATE->gauss_data_count)
+#define initialized (PBSTATE->initialized)
+
 static int show_xor_buf(char *buf, ilist variables, int phase, int maxlen);
 static void pseudo_info_fun(int vlevel);
 
-static bool initialized = false;
-
 static void pseudo_init() {
     if (!initialized) {
 	tbdd_add_info_fun(pseudo_info_fun);
@@ -254,7 +276,7 @@ xor_constraint::xor_constraint(ilist vars, int p, tbdd &vfun) {
     pseudo_xor_created ++;
     variables = vars;
     phase = p;
-    int initial_count = total_clause_count;
+    clause_id_t initial_count = total_clause_count;
     bdd xfun = build_constraint_bdd(vars, p);
     validation = tbdd_validate(xfun, vfun);
     generated_clause_count = total_clause_count - initial_count;
@@ -264,7 +286,7 @@ xor_constraint::xor_constraint(ilist vars, int p, tbdd &vfun1, tbdd &vfun2) {
     pseudo_xor_created ++;
     variables = vars;
     phase = p;
-    int initial_count = total_clause_count;
+    clause_id_t initial_count = total_clause_count;
     bdd xfun = build_constraint_bdd(vars, p);
     validation = tbdd_validate_with_and(xfun, vfun1, vfun2);
     generated_clause_count = total_clause_count - initial_count;
@@ -275,17 +297,17 @@ xor_constraint::xor_constraint(ilist vars, int p) {
     pseudo_xor_created ++;
     variables = vars;
     phase = p;
-    int initial_count = total_clause_count;
+    clause_id_t initial_count = total_clause_count;
     validation = tbdd_from_xor(variables, phase);
     generated_clause_count = total_clause_count - initial_count;
 }
 
-int xor_constraint::validate_clause(ilist clause) {
+clause_id_t xor_constraint::validate_clause(ilist clause) {
     return tbdd_validate_clause(clause, validation);
 }
 
 void xor_constraint::show(FILE *out) {
-    fprintf(out, "Xor Constraint: Node N%d validates ", tbdd_nameid(validation));
+    fprintf(out, "Xor Constraint: Node N%" PRIcid " validates ", tbdd_nameid(validation));
     show_xor(out, variables, phase);
 }
 
@@ -478,8 +500,7 @@ public:
 
     xor_constraint *get_sum() {
 #if INSTRUMENT_SUM
-	static int sum_count = 0;
-	int added_clauses = 0;
+	clause_id_t added_clauses = 0;
 	long operations = 0;
 	int score = 0;
 #endif
@@ -535,7 +556,7 @@ public:
 	    }
 	}	
 #if INSTRUMENT_SUM
-	printf("DATA:SUM,%d,%d,%ld,%d\n", ++sum_count, score, operations, added_clauses);
+	printf("DATA:SUM,%d,%d,%ld,%" PRIcid "\n", ++sum_data_count, score, operations, added_clauses);
 #endif
 	return sum;
     }
@@ -799,7 +820,7 @@ public:
 	    printf("c   %d saved equations\n", (int) external_equations.size());
 	    for (int eid = 0; eid < external_equations.size(); eid++) {
 		int tid = eid + internal_equations.size();
-		printf("c     Pivot variable %d.  Equation: ", pivot_sequence[tid]);
+		printf("c     Pivot variable %d.  Equation: ", (int) pivot_sequence[tid]);
 		external_equations[eid]->show(stdout);
 		printf("\n");
 	    }
@@ -912,9 +933,8 @@ private:
 	int peid = piv->equation_id;
 	int pvar = piv->variable;
 #if INSTRUMENT_GAUSS
-	static int step_count = 0;
 	int score = piv->score();
-	int added_clauses = 0;
+	clause_id_t added_clauses = 0;
 	long operations = 0;
 #endif
 	pivot_selector.erase(piv->cost);
@@ -978,7 +998,7 @@ private:
 	    }
 	}
 #if INSTRUMENT_GAUSS
-	printf("DATA:GAUSS,%d,%d,%ld,%d\n", ++step_count, score, operations, added_clauses);
+	printf("DATA:GAUSS,%d,%d,%ld,%" PRIcid "\n", ++gauss_data_count, score, operations, added_clauses);
 #endif
 	imap[pvar-1].clear();
 	if (internal_variables.count(pvar) == 0)
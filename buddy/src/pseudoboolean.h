@@ -81,7 +81,7 @@ class xor_constraint {
     int phase;
     tbdd validation;
     // How many clauses were added to justify this clause?
-    int generated_clause_count;
+    clause_id_t generated_clause_count;
 
  public:
     // Empty constraint represents a tautology
@@ -117,7 +117,7 @@ class xor_constraint {
     bool is_degenerate(void) { return ilist_length(variables) == 0 && phase == 0; }
     
     // Use xor constraint to validate a clause
-    int validate_clause(ilist clause);
+    clause_id_t validate_clause(ilist clause);
 
     // Get the validation TBDD
     tbdd get_validation() { return validation; }
@@ -132,10 +132,10 @@ class xor_constraint {
     void show(FILE *out);
 
     // Get ID for BDD representation of constraint
-    int get_nameid() { return tbdd_nameid(validation); }
+    clause_id_t get_nameid() { return tbdd_nameid(validation); }
 
     // How many clauses were added to create/justify this clause?
-    int get_clause_count() { return generated_clause_count; }
+    clause_id_t get_clause_count() { return generated_clause_count; }
 
     // Generate an Xor constraint as the sum of two constraints
     friend xor_constraint *xor_plus(xor_constraint *arg1, xor_constraint *arg2);
@@ -60,68 +60,130 @@
 #undef LEVELp
 
 
-#define __USERESIZE /* FIXME */
+/* Level data. Each variable has its own unique sub-table, chained through
+   the "next" field of the nodes, so that a swap of two adjacent variables
+   only has to look at the nodes of those two variables. */
+typedef struct _levelData
+{
+   BDD *table;   /* Hash buckets of this sub-table */
+   int size;     /* Size of this sub-table */
+   int nodenum;  /* Number of nodes in this sub-table */
+   int deadnum;  /* Number of these nodes with no references */
+} levelData;
 
-   /* Current auto reord. method and number of automatic reorderings left */
-static int bddreordermethod;
-static int bddreordertimes;
+typedef struct s_ReorderState
+{
+      /* Current auto reord. method and number of automatic reorderings left */
+   int bddreordermethod;
+   int bddreordertimes;
 
-   /* Flag for disabling reordering temporarily */
-static int reorderdisabled;
+      /* Flag for disabling reordering temporarily */
+   int reorderdisabled;
 
-   /* Store for the variable relationships */
-static BddTree *vartree;
-static int blockid;
+      /* Store for the variable relationships */
+   BddTree *vartree;
+   int blockid;
 
-   /* Store for the ref.cou. of the external roots */
-static int *extroots;
-static int extrootsize;
+      /* Store for the ref.cou. of the external roots */
+   BDD *extroots;
+   BDD extrootsize;
 
-/* Level data */
-typedef struct _levelData
-{
-   int start;    /* Start of this sub-table (entry in "bddnodes") */
-   int size;     /* Size of this sub-table */
-   int maxsize;  /* Max. allowed size of sub-table */
-   int nodenum;  /* Number of nodes in this level */
-} levelData;
+   levelData *levels; /* Indexed by variable! */
 
-static levelData *levels; /* Indexed by variable! */
+      /* Interaction matrix */
+   imatrix *iactmtx;
 
-   /* Interaction matrix */
-static imatrix *iactmtx;
+      /* Reordering information for the user */
+   int verbose;
+   bddinthandler reorder_handler;
+   bddinthandler reorder_passhandler;
+   bddfilehandler reorder_filehandler;
+   bddsizehandler reorder_nodenum;
 
-   /* Reordering information for the user */
-static int verbose;
-static bddinthandler reorder_handler;
-static bddfilehandler reorder_filehandler;
-static bddsizehandler reorder_nodenum;
+      /* Number of live nodes before and after a reordering session */
+   BDD usednum_before;
+   BDD usednum_after;
 
-   /* Number of live nodes before and after a reordering session */
-static int usednum_before;
-static int usednum_after;
-	    
-   /* Kernel variables needed for reordering */
-extern int bddfreepos;
-extern int bddfreenum;
-extern int bddproduced;
+      /* Budget for sifting: wall-clock time in milliseconds (zero for no
+	 limit), the growth in percent a block may cause while it is moved,
+	 and the least gain in percent for another pass of iterated sifting */
+   int siftmaxtime;
+   int siftmaxgrowth;
+   int siftmingain;
 
-   /* Flag telling us when a node table resize is done */
-static int resizedInMakenode;
+      /* Progress of the current reordering session */
+   long reorder_starttime;
+   bddReorderStat reorderstat;
+
+#if ENABLE_TBDD
+      /* Defining clauses of rewritten and dead nodes, deleted in one batch
+	 after each swap */
+   ilist reorder_dels;
+#endif
+} ReorderState;
+
+#if ENABLE_REENTRANT
+void *bdd_reorder_newstate(void)
+{
+   return bdd_newstate(NULL, sizeof(ReorderState));
+}
+#else
+static ReorderState reorderstate;
+#endif
+
+#define REORDERSTATE BDDSTATE(ReorderState, BDDMOD_REORDER, reorderstate)
+#define bddreordermethod    (REORDERSTATE->bddreordermethod)
+#define bddreordertimes     (REORDERSTATE->bddreordertimes)
+#define reorderdisabled     (REORDERSTATE->reorderdisabled)
+#define vartree             (REORDERSTATE->vartree)
+#define blockid             (REORDERSTATE->blockid)
+#define extroots            (REORDERSTATE->extroots)
+#define extrootsize         (REORDERSTATE->extrootsize)
+#define levels              (REORDERSTATE->levels)
+#define iactmtx             (REORDERSTATE->iactmtx)
+#define verbose             (REORDERSTATE->verbose)
+#define reorder_handler     (REORDERSTATE->reorder_handler)
+#define reorder_passhandler (REORDERSTATE->reorder_passhandler)
+#define reorder_filehandler (REORDERSTATE->reorder_filehandler)
+#define reorder_nodenum     (REORDERSTATE->reorder_nodenum)
+#define usednum_before      (REORDERSTATE->usednum_before)
+#define usednum_after       (REORDERSTATE->usednum_after)
+#define siftmaxtime         (REORDERSTATE->siftmaxtime)
+#define siftmaxgrowth       (REORDERSTATE->siftmaxgrowth)
+#define siftmingain         (REORDERSTATE->siftmingain)
+#define reorder_starttime   (REORDERSTATE->reorder_starttime)
+#define reorderstat         (REORDERSTATE->reorderstat)
+#if ENABLE_TBDD
+#define reorder_dels        (REORDERSTATE->reorder_dels)
+#endif
 
    /* New node hashing function for use with reordering */
-#define NODEHASH(var,l,h) ((PAIR((l),(h))%levels[var].size)+levels[var].start)
+#define NODEHASH(var,l,h) (PAIR((l),(h))%levels[var].size)
+
+   /* Smallest sub-table size */
+#define LEVELMINSIZE 17
+
+   /* Reference counting that keeps the dead node counters up to date */
+#define REORDER_INCREF(n)\
+   { if (bddnodes[n].refcou == 0) levels[VAR(n)].deadnum--; INCREF(n); }
+#define REORDER_DECREF(n)\
+   { if (bddnodes[n].refcou == 1) levels[VAR(n)].deadnum++; DECREF(n); }
 
    /* Reordering prototypes */
 static void blockdown(BddTree *);
-static void addref_rec(int, char *);
+static void addref_rec(BDD, char *);
 static void reorder_gbc();
-static void reorder_setLevellookup(void);
-static int  reorder_makenode(int, int, int);
+static int  reorder_setLevellookup(void);
+static void reorder_tableresize(int);
+static BDD  reorder_makenode(int, BDD, BDD);
 static int  reorder_varup(int);
 static int  reorder_vardown(int);
 static int  reorder_init(void);
 static void reorder_done(void);
+#if ENABLE_TBDD
+static void reorder_dropclauses(BDD);
+static void reorder_flushclauses(void);
+#endif
 
 #define random(a) (rand() % (a))
 
@@ -144,11 +206,15 @@ void bdd_reorder_init(void)
    
    bdd_clrvarblocks();
    bdd_reorder_hook(bdd_default_reohandler);
+   bdd_reorder_passhook(NULL);
    bdd_reorder_verbose(0);
    bdd_autoreorder_times(BDD_REORDER_NONE, 0);
    reorder_nodenum = bdd_getnodenum;
    usednum_before = usednum_after = 0;
    blockid = 0;
+   siftmaxtime = 0;
+   siftmaxgrowth = 20;
+   siftmingain = 0;
 }
 
 
@@ -174,12 +240,12 @@ static BddTree *reorder_win2(BddTree *t)
       return t;
 
    if (verbose > 1)
-      printf("Win2 start: %d nodes\n", reorder_nodenum());
+      printf("Win2 start: %" PRIbdd " nodes\n", reorder_nodenum());
    fflush(stdout);
 
    while (this->next != NULL)
    {
-      int best = reorder_nodenum();
+      BDD best = reorder_nodenum();
       blockdown(this);
       
       if (best < reorder_nodenum())
@@ -199,7 +265,7 @@ static BddTree *reorder_win2(BddTree *t)
    }
    
    if (verbose > 1)
-      printf("\nWin2 end: %d nodes\n", reorder_nodenum());
+      printf("\nWin2 end: %" PRIbdd " nodes\n", reorder_nodenum());
    fflush(stdout);
 
    return first;
@@ -209,14 +275,14 @@ static BddTree *reorder_win2(BddTree *t)
 static BddTree *reorder_win2ite(BddTree *t)
 {
    BddTree *this, *first=t;
-   int lastsize;
+   BDD lastsize;
    int c=1;
    
    if (t == NULL)
       return t;
    
    if (verbose > 1)
-      printf("Win2ite start: %d nodes\n", reorder_nodenum());
+      printf("Win2ite start: %" PRIbdd " nodes\n", reorder_nodenum());
 
    do
    {
@@ -225,7 +291,7 @@ static BddTree *reorder_win2ite(BddTree *t)
       this = t;
       while (this->next != NULL)
       {
-	 int best = reorder_nodenum();
+	 BDD best = reorder_nodenum();
 
 	 blockdown(this);
 
@@ -245,7 +311,7 @@ static BddTree *reorder_win2ite(BddTree *t)
       }
 
       if (verbose > 1)
-	 printf(" %d nodes\n", reorder_nodenum());
+	 printf(" %" PRIbdd " nodes\n", reorder_nodenum());
       c++;
    }
    while (reorder_nodenum() != lastsize);
@@ -261,7 +327,7 @@ static BddTree *reorder_swapwin3(BddTree *this, BddTree **first)
 {
    int setfirst = (this->prev == NULL ? 1 : 0);
    BddTree *next = this;
-   int best = reorder_nodenum();
+   BDD best = reorder_nodenum();
    
    if (this->next->next == NULL) /* Only two blocks left -> win2 swap */
    {
@@ -282,13 +348,13 @@ static BddTree *reorder_swapwin3(BddTree *this, BddTree **first)
    else /* Real win3 swap */
    {
       int pos = 0;
-      X(printf("%d: ", reorder_nodenum()));
+      X(printf("%" PRIbdd ": ", reorder_nodenum()));
       blockdown(this);  /* B A* C (4) */
       X(printf("A"));
       pos++;
       if (best > reorder_nodenum())
       {
-	 X(printf("(%d)", reorder_nodenum()));
+	 X(printf("(%" PRIbdd ")", reorder_nodenum()));
 	 pos = 0;
 	 best = reorder_nodenum();
       }
@@ -298,7 +364,7 @@ static BddTree *reorder_swapwin3(BddTree *this, BddTree **first)
       pos++;
       if (best > reorder_nodenum())
       {
-	 X(printf("(%d)", reorder_nodenum()));
+	 X(printf("(%" PRIbdd ")", reorder_nodenum()));
 	 pos = 0;
 	 best = reorder_nodenum();
       }
@@ -309,7 +375,7 @@ static BddTree *reorder_swapwin3(BddTree *this, BddTree **first)
       pos++;
       if (best > reorder_nodenum())
       {
-	 X(printf("(%d)", reorder_nodenum()));
+	 X(printf("(%" PRIbdd ")", reorder_nodenum()));
 	 pos = 0;
 	 best = reorder_nodenum();
       }
@@ -319,7 +385,7 @@ static BddTree *reorder_swapwin3(BddTree *this, BddTree **first)
       pos++;
       if (best > reorder_nodenum())
       {
-	 X(printf("(%d)", reorder_nodenum()));
+	 X(printf("(%" PRIbdd ")", reorder_nodenum()));
 	 pos = 0;
 	 best = reorder_nodenum();
       }
@@ -330,7 +396,7 @@ static BddTree *reorder_swapwin3(BddTree *this, BddTree **first)
       pos++;
       if (best > reorder_nodenum())
       {
-	 X(printf("(%d)", reorder_nodenum()));
+	 X(printf("(%" PRIbdd ")", reorder_nodenum()));
 	 pos = 0;
 	 best = reorder_nodenum();
       }
@@ -344,7 +410,7 @@ static BddTree *reorder_swapwin3(BddTree *this, BddTree **first)
 	 next = this;
 	 if (setfirst)
 	    *first = this->prev;
-	 X(printf("a(%d)", reorder_nodenum()));
+	 X(printf("a(%" PRIbdd ")", reorder_nodenum()));
       }
       
       if (pos >= 2)  /* C A B -> C B A* */
@@ -353,7 +419,7 @@ static BddTree *reorder_swapwin3(BddTree *this, BddTree **first)
 	 next = this->prev;
 	 if (setfirst)
 	    *first = this->prev->prev;
-	 X(printf("b(%d)", reorder_nodenum()));
+	 X(printf("b(%" PRIbdd ")", reorder_nodenum()));
       }
       
       if (pos >= 3)  /* C B A -> B C* A */
@@ -363,7 +429,7 @@ static BddTree *reorder_swapwin3(BddTree *this, BddTree **first)
 	 next = this;
 	 if (setfirst)
 	    *first = this->prev;
-	 X(printf("c(%d)", reorder_nodenum()));
+	 X(printf("c(%" PRIbdd ")", reorder_nodenum()));
       }
       
       if (pos >= 4)  /* B C A -> B A C* */
@@ -372,7 +438,7 @@ static BddTree *reorder_swapwin3(BddTree *this, BddTree **first)
 	 next = this->prev;
 	 if (setfirst)
 	    *first = this->prev->prev;
-	 X(printf("d(%d)", reorder_nodenum()));
+	 X(printf("d(%" PRIbdd ")", reorder_nodenum()));
       }
       
       if (pos >= 5)  /* B A C -> A B* C */
@@ -382,7 +448,7 @@ static BddTree *reorder_swapwin3(BddTree *this, BddTree **first)
 	 next = this;
 	 if (setfirst)
 	    *first = this->prev;
-	 X(printf("e(%d)", reorder_nodenum()));
+	 X(printf("e(%" PRIbdd ")", reorder_nodenum()));
       }
       X(printf("\n"));
    }
@@ -399,7 +465,7 @@ static BddTree *reorder_win3(BddTree *t)
       return t;
 
    if (verbose > 1)
-      printf("Win3 start: %d nodes\n", reorder_nodenum());
+      printf("Win3 start: %" PRIbdd " nodes\n", reorder_nodenum());
    fflush(stdout);
 
    while (this->next != NULL)
@@ -414,7 +480,7 @@ static BddTree *reorder_win3(BddTree *t)
    }
    
    if (verbose > 1)
-      printf("\nWin3 end: %d nodes\n", reorder_nodenum());
+      printf("\nWin3 end: %" PRIbdd " nodes\n", reorder_nodenum());
    fflush(stdout);
 
    return first;
@@ -424,13 +490,13 @@ static BddTree *reorder_win3(BddTree *t)
 static BddTree *reorder_win3ite(BddTree *t)
 {
    BddTree *this=t, *first=t;
-   int lastsize;
+   BDD lastsize;
    
    if (t == NULL)
       return t;
    
    if (verbose > 1)
-      printf("Win3ite start: %d nodes\n", reorder_nodenum());
+      printf("Win3ite start: %" PRIbdd " nodes\n", reorder_nodenum());
 
    do
    {
@@ -449,12 +515,12 @@ static BddTree *reorder_win3ite(BddTree *t)
       }
 
       if (verbose > 1)
-	 printf(" %d nodes\n", reorder_nodenum());
+	 printf(" %" PRIbdd " nodes\n", reorder_nodenum());
    }
    while (reorder_nodenum() != lastsize);
 
    if (verbose > 1)
-      printf("Win3ite end: %d nodes\n", reorder_nodenum());
+      printf("Win3ite end: %" PRIbdd " nodes\n", reorder_nodenum());
    
    return first;
 }
@@ -462,21 +528,44 @@ static BddTree *reorder_win3ite(BddTree *t)
 
 /*=== Reorder by sifting =============================================*/
 
+   /* Wall-clock time in milliseconds */
+static long reorder_clock(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec*1000L + ts.tv_nsec/1000000;
+}
+
+
+   /* Has the time budget of this reordering session been used up? */
+static int reorder_timeout(void)
+{
+   return siftmaxtime > 0  &&  reorder_clock()-reorder_starttime >= siftmaxtime;
+}
+
+
+   /* Largest number of nodes allowed while moving a block */
+static BDD reorder_sift_maxallowed(BDD best)
+{
+   BDD maxAllowed = best + (BDD)(((long)best*siftmaxgrowth)/100);
+
+   if (bddmaxnodesize > 0)
+      maxAllowed = MIN(maxAllowed, bddmaxnodesize-bddmaxnodeincrease-2);
+   return maxAllowed;
+}
+
+
 /* Move a specific block up and down in the order and place at last in
    the best position
 */
 static void reorder_sift_bestpos(BddTree *blk, int middlePos)
 {
-   int best = reorder_nodenum();
-   int maxAllowed;
+   BDD best = reorder_nodenum();
+   BDD maxAllowed = reorder_sift_maxallowed(best);
    int bestpos = 0;
    int dirIsUp = 1;
    int n;
-   
-   if (bddmaxnodesize > 0)
-      maxAllowed = MIN(best/5+best, bddmaxnodesize-bddmaxnodeincrease-2);
-   else
-      maxAllowed = best/5+best;
 
       /* Determine initial direction */
    if (blk->pos > middlePos)
@@ -490,7 +579,8 @@ static void reorder_sift_bestpos(BddTree *blk, int middlePos)
       if (dirIsUp)
       {
 	 while (blk->prev != NULL  &&
-		(reorder_nodenum() <= maxAllowed || first))
+		(reorder_nodenum() <= maxAllowed || first)  &&
+		!reorder_timeout())
 	 {
 	    first = 0;
 	    blockdown(blk->prev);
@@ -506,19 +596,15 @@ static void reorder_sift_bestpos(BddTree *blk, int middlePos)
 	    {
 	       best = reorder_nodenum();
 	       bestpos = 0;
-
-	       if (bddmaxnodesize > 0)
-		  maxAllowed = MIN(best/5+best,
-				   bddmaxnodesize-bddmaxnodeincrease-2);
-	       else
-		  maxAllowed = best/5+best;
+	       maxAllowed = reorder_sift_maxallowed(best);
 	    }
 	 }
       }
       else
       {
 	 while (blk->next != NULL  &&
-		(reorder_nodenum() <= maxAllowed  ||  first))
+		(reorder_nodenum() <= maxAllowed  ||  first)  &&
+		!reorder_timeout())
 	 {
 	    first = 0;
 	    blockdown(blk);
@@ -534,12 +620,7 @@ static void reorder_sift_bestpos(BddTree *blk, int middlePos)
 	    {
 	       best = reorder_nodenum();
 	       bestpos = 0;
-	       
-	       if (bddmaxnodesize > 0)
-		  maxAllowed = MIN(best/5+best,
-				   bddmaxnodesize-bddmaxnodeincrease-2);
-	       else
-		  maxAllowed = best/5+best;
+	       maxAllowed = reorder_sift_maxallowed(best);
 	    }
 	 }
       }
@@ -578,7 +659,7 @@ static BddTree *reorder_sift_seq(BddTree *t, BddTree **seq, int num)
    if (t == NULL)
       return t;
 
-   for (n=0 ; n<num ; n++)
+   for (n=0 ; n<num  &&  !reorder_timeout() ; n++)
    {
       long c2, c1 = clock();
    
@@ -595,7 +676,7 @@ static BddTree *reorder_sift_seq(BddTree *t, BddTree **seq, int num)
       reorder_sift_bestpos(seq[n], num/2);
 
       if (verbose > 1)
-	 printf("\n> %d nodes", reorder_nodenum());
+	 printf("\n> %" PRIbdd " nodes", reorder_nodenum());
 
       c2 = clock();
       if (verbose > 1)
@@ -632,6 +713,7 @@ static BddTree *reorder_sift(BddTree *t)
    BddTree *this, **seq;
    sizePair *p;
    int n, num;
+   long c1;
 
    for (this=t,num=0 ; this!=NULL ; this=this->next)
       this->pos = num++;
@@ -644,6 +726,9 @@ static BddTree *reorder_sift(BddTree *t)
       return t;
    }
 
+   reorderstat.passbefore = reorder_nodenum();
+   c1 = reorder_clock();
+
    for (this=t,n=0 ; this!=NULL ; this=this->next,n++)
    {
       int v;
@@ -651,7 +736,7 @@ static BddTree *reorder_sift(BddTree *t)
          /* Accumulate number of nodes for each block */
       p[n].val = 0;
       for (v=this->first ; v<=this->last ; v++)
-	 p[n].val -= levels[v].nodenum;
+	 p[n].val -= levels[v].nodenum - levels[v].deadnum;
 
       p[n].block = this;
    }
@@ -668,17 +753,28 @@ static BddTree *reorder_sift(BddTree *t)
    
    free(seq);
    free(p);
+
+      /* Tell the user how this pass went */
+   reorderstat.passnum++;
+   reorderstat.passafter = reorder_nodenum();
+   reorderstat.passgain = reorderstat.passbefore == 0 ? 0 :
+      (int)((100L*(reorderstat.passbefore - reorderstat.passafter))
+	    / reorderstat.passbefore);
+   reorderstat.passtime = reorder_clock() - c1;
+   reorderstat.time = reorder_clock() - reorder_starttime;
+   if (reorder_passhandler != NULL)
+      reorder_passhandler(reorderstat.passnum);
    
    return t;
 }
 
 
-/* Do sifting iteratively until no more improvement can be found
+/* Do sifting iteratively until a pass gains less than the threshold
  */
 static BddTree *reorder_siftite(BddTree *t)
 {
    BddTree *first=t;
-   int lastsize;
+   BDD lastsize;
    int c=1;
    
    if (t == NULL)
@@ -692,7 +788,8 @@ static BddTree *reorder_siftite(BddTree *t)
       lastsize = reorder_nodenum();
       first = reorder_sift(first);
    }
-   while (reorder_nodenum() != lastsize);
+   while (reorder_nodenum() != lastsize  &&  !reorder_timeout()  &&
+	  100L*(lastsize - reorder_nodenum()) > (long)siftmingain*lastsize);
 
    return first;
 }
@@ -729,7 +826,7 @@ static BddTree *reorder_random(BddTree *t)
    free(seq);
 
    if (verbose)
-      printf("Random order: %d nodes\n", reorder_nodenum());
+      printf("Random order: %" PRIbdd " nodes\n", reorder_nodenum());
    return this;
 }
 
@@ -806,26 +903,19 @@ static void blockdown(BddTree *left)
 /*=== Garbage collection for reordering ================================*/
 
 /* Note: Node may be marked
+ *
+ * Uses the kernel mark stack instead of recursion. A node gets its first
+ * reference when it is pushed, so it is pushed only once and the stack
+ * cannot overflow.
  */
-static void addref_rec(int r, char *dep)
+static void addref_rec(BDD r, char *dep)
 {
+   BDD *sp = bddmarkstack;
+
    if (r < 2)
       return;
-   
-   if (bddnodes[r].refcou == 0)
-   {
-      bddfreenum--;
 
-         /* Detect variable dependencies for the interaction matrix */
-      dep[VAR(r) & MARKHIDE] = 1;
-
-         /* Make sure the nodenum field is updated. Used in the initial GBC */
-      levels[VAR(r) & MARKHIDE].nodenum++;
-      
-      addref_rec(LOW(r), dep);
-      addref_rec(HIGH(r), dep);
-   }
-   else
+   if (bddnodes[r].refcou > 0)
    {
       int n;
       
@@ -833,9 +923,54 @@ static void addref_rec(int r, char *dep)
 	  * for the interaction matrix */
       for (n=0 ; n<bddvarnum ; n++)
 	 dep[n] |= imatrixDepends(iactmtx, VAR(r) & MARKHIDE, n);
+      INCREF(r);
+      return;
    }
-   
-   INCREF(r);
+
+   bddnodes[r].refcou = 1;
+   *sp++ = r;
+   do
+   {
+      BDD c[2];
+      int k;
+
+      r = *--sp;
+
+      bddfreenum--;
+
+         /* Detect variable dependencies for the interaction matrix */
+      dep[VAR(r) & MARKHIDE] = 1;
+
+         /* Make sure the nodenum field is updated. Used in the initial GBC */
+      levels[VAR(r) & MARKHIDE].nodenum++;
+
+      c[0] = LOW(r);
+      c[1] = HIGH(r);
+      PREFETCH(&bddnodes[c[0]]);
+      PREFETCH(&bddnodes[c[1]]);
+
+      for (k=0 ; k<2 ; k++)
+      {
+	 if (c[k] < 2)
+	    continue;
+
+	 if (bddnodes[c[k]].refcou == 0)
+	 {
+	       /* Claim the node now so that it is pushed only once */
+	    bddnodes[c[k]].refcou = 1;
+	    *sp++ = c[k];
+	 }
+	 else
+	 {
+	    int n;
+	    
+	    for (n=0 ; n<bddvarnum ; n++)
+	       dep[n] |= imatrixDepends(iactmtx, VAR(c[k]) & MARKHIDE, n);
+	    INCREF(c[k]);
+	 }
+      }
+   }
+   while (sp > bddmarkstack);
 }
 
 
@@ -864,7 +999,7 @@ static void addDependencies(char *dep)
 static int mark_roots(void)
 {
    char *dep = NEW(char,bddvarnum);
-   int n;
+   BDD n;
 
    for (n=2,extrootsize=0 ; n<bddnodesize ; n++)
    {
@@ -879,7 +1014,7 @@ static int mark_roots(void)
       }
    }
    
-   if ((extroots=(int*)(malloc(sizeof(int)*extrootsize))) == NULL)
+   if ((extroots=(BDD*)(malloc(sizeof(BDD)*extrootsize))) == NULL)
       return bdd_error(BDD_MEMORY);
 
    iactmtx = imatrixNew(bddvarnum);
@@ -902,15 +1037,8 @@ static int mark_roots(void)
 
 	 addDependencies(dep);
       }
-
-      /* Make sure the hash field is empty. This saves a loop in the
-	 initial GBC */
-      node->hash = 0;
    }
 
-   bddnodes[0].hash = 0;
-   bddnodes[1].hash = 0;
-
    free(dep);
    return 0;
 }
@@ -922,13 +1050,11 @@ static int mark_roots(void)
 */
 static void reorder_gbc(void)
 {
-   int n;
+   BDD n;
 
    bddfreepos = 0;
    bddfreenum = 0;
 
-      /* No need to zero all hash fields - this is done in mark_roots */
-   
    for (n=bddnodesize-1 ; n>=2 ; n--)
    {
       register BddNode *node = &bddnodes[n];
@@ -936,16 +1062,20 @@ static void reorder_gbc(void)
       if (node->refcou > 0)
       {
 	 register unsigned int hash;
+	 levelData *l = &levels[VARp(node)];
 	 
 	 hash = NODEHASH(VARp(node), LOWp(node), HIGHp(node));
-	 node->next = bddnodes[hash].hash;
-	 bddnodes[hash].hash = n;
-
+	 NEXTp(node) = l->table[hash];
+	 l->table[hash] = n;
       }
       else
       {
+#if ENABLE_TBDD
+	 if (LOWp(node) != -1)
+	    reorder_dropclauses(n);
+#endif
 	 LOWp(node) = -1;
-	 node->next = bddfreepos;
+	 NEXTp(node) = bddfreepos;
 	 bddfreepos = n;
 	 bddfreenum++;
       }
@@ -953,61 +1083,71 @@ static void reorder_gbc(void)
 }
 
 
-static void reorder_setLevellookup(void)
+   /* Allocate the sub-tables with room for the nodes counted in
+    * mark_roots(). */
+static int reorder_setLevellookup(void)
 {
    int n;
 
    for (n=0 ; n<bddvarnum ; n++)
    {
-#ifdef USERESIZE
-      levels[n].maxsize = bddnodesize / bddvarnum;
-      levels[n].start = n * levels[n].maxsize;
-      levels[n].size = MIN(levels[n].maxsize, (levels[n].nodenum*5)/4);
-#else
-      levels[n].maxsize = bddnodesize / bddvarnum;
-      levels[n].start = n * levels[n].maxsize;
-      levels[n].size = levels[n].maxsize;
-#endif
-
-      if (levels[n].size >= 4)
-	 levels[n].size = bdd_prime_lte(levels[n].size);
+      levels[n].size = bdd_prime_gte(MAX(levels[n].nodenum, LEVELMINSIZE));
+      if ((levels[n].table=NEW(BDD,levels[n].size)) == NULL)
+	 return bdd_error(BDD_MEMORY);
+      memset(levels[n].table, 0, sizeof(BDD)*levels[n].size);
       
 #if 0
-      printf("L%3d: start %d, size %d, nodes %d\n", n, levels[n].start,
-	     levels[n].size, levels[n].nodenum);
+      printf("L%3d: size %d, nodes %d\n", n, levels[n].size,
+	     levels[n].nodenum);
 #endif
    }
+
+   return 0;
 }
 
 
-static void reorder_rehashAll(void)
+   /* Grow or shrink the sub-table of 'var' if its load is out of range.
+    * Only the nodes of this variable are rehashed. */
+static void reorder_tableresize(int var)
 {
-   int n;
+   levelData *l = &levels[var];
+   BDD *oldtable = l->table;
+   int oldsize = l->size;
+   int size, n;
 
-   reorder_setLevellookup();
-   bddfreepos = 0;
+   if (l->nodenum > 2*l->size)
+      size = bdd_prime_gte(l->nodenum);
+   else if (l->size > LEVELMINSIZE  &&  8*l->nodenum < l->size)
+      size = bdd_prime_gte(MAX(2*l->nodenum, LEVELMINSIZE));
+   else
+      return;
 
-   for (n=bddnodesize-1 ; n>=0 ; n--)
-      bddnodes[n].hash = 0;
-   
-   for (n=bddnodesize-1 ; n>=2 ; n--)
+      /* Keep the old table if there is no memory for a new one */
+   if ((l->table=NEW(BDD,size)) == NULL)
    {
-      register BddNode *node = &bddnodes[n];
+      l->table = oldtable;
+      return;
+   }
+   memset(l->table, 0, sizeof(BDD)*size);
+   l->size = size;
 
-      if (node->refcou > 0)
-      {
-	 register unsigned int hash;
-	 
-	 hash = NODEHASH(VARp(node), LOWp(node), HIGHp(node));
-	 node->next = bddnodes[hash].hash;
-	 bddnodes[hash].hash = n;
-      }
-      else
+   for (n=0 ; n<oldsize ; n++)
+   {
+      BDD r = oldtable[n];
+
+      while (r != 0)
       {
-	 node->next = bddfreepos;
-	 bddfreepos = n;
+	 BddNode *node = &bddnodes[r];
+	 BDD next = NEXTp(node);
+	 int hash = NODEHASH(var, LOWp(node), HIGHp(node));
+
+	 NEXTp(node) = l->table[hash];
+	 l->table[hash] = r;
+	 r = next;
       }
    }
+
+   free(oldtable);
 }
 
 
@@ -1016,13 +1156,13 @@ static void reorder_rehashAll(void)
 /* Note: rehashing must not take place during a makenode call. It is okay
    to resize the table, but *not* to rehash it.
  */
-static int reorder_makenode(int var, int low, int high)
+static BDD reorder_makenode(int var, BDD low, BDD high)
 {
    register BddNode *node;
    register unsigned int hash;
-   register int res;
+   register BDD res;
 
-#ifdef CACHESTATS
+#ifdef UNIQUESTATS
    bddcachestats.uniqueAccess++;
 #endif
    
@@ -1032,33 +1172,33 @@ static int reorder_makenode(int var, int low, int high)
       /* check whether childs are equal */
    if (low == high)
    {
-      INCREF(low);
+      REORDER_INCREF(low);
       return low;
    }
 
       /* Try to find an existing node of this kind */
    hash = NODEHASH(var, low, high);
-   res = bddnodes[hash].hash;
+   res = levels[var].table[hash];
       
    while(res != 0)
    {
       if (LOW(res) == low  &&  HIGH(res) == high)
       {
-#ifdef CACHESTATS
+#ifdef UNIQUESTATS
 	 bddcachestats.uniqueHit++;
 #endif
-	 INCREF(res);
+	 REORDER_INCREF(res);
 	 return res;
       }
-      res = bddnodes[res].next;
+      res = NEXT(res);
       
-#ifdef CACHESTATS
+#ifdef UNIQUESTATS
       bddcachestats.uniqueChain++;
 #endif
    }
    
       /* No existing node -> build one */
-#ifdef CACHESTATS
+#ifdef UNIQUESTATS
    bddcachestats.uniqueMiss++;
 #endif
 
@@ -1069,11 +1209,9 @@ static int reorder_makenode(int var, int low, int high)
 	 return 0;
       
          /* Try to allocate more nodes - call noderesize without
-	  * enabling rehashing.
-          * Note: if ever rehashing is allowed here, then remember to
-	  * update local variable "hash" */
+	  * enabling rehashing. The sub-tables do not depend on the
+	  * size of the node table, so they stay valid. */
       bdd_noderesize(0);
-      resizedInMakenode = 1;
 
          /* Panic if that is not possible */
       if (bddfreepos == 0)
@@ -1086,7 +1224,7 @@ static int reorder_makenode(int var, int low, int high)
 
       /* Build new node */
    res = bddfreepos;
-   bddfreepos = bddnodes[bddfreepos].next;
+   bddfreepos = NEXT(bddfreepos);
    levels[var].nodenum++;
    bddproduced++;
    bddfreenum--;
@@ -1097,13 +1235,18 @@ static int reorder_makenode(int var, int low, int high)
    HIGHp(node) = high;
 
       /* Insert node in hash chain */
-   node->next = bddnodes[hash].hash;
-   bddnodes[hash].hash = res;
+   NEXTp(node) = levels[var].table[hash];
+   levels[var].table[hash] = res;
 
       /* Make sure it is reference counted */
    node->refcou = 1;
-   INCREF(LOWp(node));
-   INCREF(HIGHp(node));
+   REORDER_INCREF(low);
+   REORDER_INCREF(high);
+
+#if ENABLE_TBDD
+   if (var > 0)
+      bdd_define_node(res, var);
+#endif
    
    return res;
 }
@@ -1114,39 +1257,42 @@ static int reorder_makenode(int var, int low, int high)
 /* Go through var 0 nodes. Move nodes that depends on var 1 to a separate
  * chain (toBeProcessed) and let the rest stay in the table.
  */
-static int reorder_downSimple(int var0)
+static BDD reorder_downSimple(int var0)
 {
-   int toBeProcessed = 0;
+   BDD toBeProcessed = 0;
    int var1 = bddlevel2var[bddvar2level[var0]+1];
-   int vl0 = levels[var0].start;
+   BDD *table0 = levels[var0].table;
    int size0 = levels[var0].size;
    int n;
 
    levels[var0].nodenum = 0;
+   levels[var0].deadnum = 0;
    
    for (n=0 ; n<size0 ; n++)
    {
-      int r;
+      BDD r;
 
-      r = bddnodes[n + vl0].hash;
-      bddnodes[n + vl0].hash = 0;
+      r = table0[n];
+      table0[n] = 0;
 
       while (r != 0)
       {
 	 BddNode *node = &bddnodes[r];
-	 int next = node->next;
+	 BDD next = NEXTp(node);
 
 	 if (VAR(LOWp(node)) != var1  &&  VAR(HIGHp(node)) != var1)
 	 {
  	       /* Node does not depend on next var, let it stay in the chain */
-	    node->next = bddnodes[n+vl0].hash;
-	    bddnodes[n+vl0].hash = r;
+	    NEXTp(node) = table0[n];
+	    table0[n] = r;
 	    levels[var0].nodenum++;
+	    if (node->refcou == 0)
+	       levels[var0].deadnum++;
 	 }
 	 else
 	 {
    	       /* Node depends on next var - save it for later procesing */
-	    node->next = toBeProcessed;
+	    NEXTp(node) = toBeProcessed;
 	    toBeProcessed = r;
 #ifdef SWAPCOUNT
 	    bddcachestats.swapCount++;
@@ -1167,17 +1313,18 @@ static int reorder_downSimple(int var0)
  * It is extremely important that no rehashing is done inside the makenode
  * calls, since this would destroy the toBeProcessed chain.
  */
-static void reorder_swap(int toBeProcessed, int var0)
+static void reorder_swap(BDD toBeProcessed, int var0)
 {
    int var1 = bddlevel2var[bddvar2level[var0]+1];
    
    while (toBeProcessed)
    {
       BddNode *node = &bddnodes[toBeProcessed];
-      int next = node->next;
-      int f0 = LOWp(node);
-      int f1 = HIGHp(node);
-      int f00, f01, f10, f11, hash;
+      BDD next = NEXTp(node);
+      BDD f0 = LOWp(node);
+      BDD f1 = HIGHp(node);
+      BDD f00, f01, f10, f11;
+      int hash;
       
          /* Find the cofactors for the new nodes */
       if (VAR(f0) == var1)
@@ -1201,14 +1348,28 @@ static void reorder_swap(int toBeProcessed, int var0)
       f1 = reorder_makenode(var0, f01, f11);
       node = &bddnodes[toBeProcessed];  /* Might change in makenode */
 
+#if ENABLE_TBDD
+         /* The node keeps its extension variable, since its function
+	  * does not change, but needs defining clauses over the new
+	  * childs. These are derived from the old ones, which can go */
+      if (proof_type != PROOF_NONE)
+      {
+	 clause_id_t dclause = justify_swap(toBeProcessed, var0, var1,
+				    f00, f01, f10, f11, f0, f1);
+	 reorder_dropclauses(toBeProcessed);
+	 node = &bddnodes[toBeProcessed];
+	 DCLAUSEp(node) = dclause;
+      }
+#endif
+
          /* We know that the refcou of the grandchilds of this node
 	  * is greater than one (these are f00...f11), so there is
 	  * no need to do a recursive refcou decrease. It is also
 	  * possible for the LOWp(node)/high nodes to come alive again,
 	  * so deref. of the childs is delayed until the local GBC. */
 
-      DECREF(LOWp(node));
-      DECREF(HIGHp(node));
+      REORDER_DECREF(LOWp(node));
+      REORDER_DECREF(HIGHp(node));
       
          /* Update in-place */
       VARp(node) = var1;
@@ -1216,11 +1377,13 @@ static void reorder_swap(int toBeProcessed, int var0)
       HIGHp(node) = f1;
 	    
       levels[var1].nodenum++;
+      if (node->refcou == 0)
+	 levels[var1].deadnum++;
       
          /* Rehash the node since it got new childs */
       hash = NODEHASH(VARp(node), LOWp(node), HIGHp(node));
-      node->next = bddnodes[hash].hash;
-      bddnodes[hash].hash = toBeProcessed;
+      NEXTp(node) = levels[var1].table[hash];
+      levels[var1].table[hash] = toBeProcessed;
 
       toBeProcessed = next;
    }
@@ -1229,140 +1392,44 @@ static void reorder_swap(int toBeProcessed, int var0)
 
 /* Now go through the var 1 chains. The nodes live here have survived
  * the call to reorder_swap() and may stay in the chain.
- * The dead nodes are reclaimed.
+ * The dead nodes are reclaimed. Nothing needs to be done if the dead node
+ * counter shows that there are none.
  */
 static void reorder_localGbc(int var0)
 {
    int var1 = bddlevel2var[bddvar2level[var0]+1];
-   int vl1 = levels[var1].start;
+   BDD *table1 = levels[var1].table;
    int size1 = levels[var1].size;
    int n;
 
-   for (n=0 ; n<size1 ; n++)
-   {
-      int hash = n+vl1;
-      int r = bddnodes[hash].hash;
-      bddnodes[hash].hash = 0;
-
-      while (r)
-      {
-	 BddNode *node = &bddnodes[r];
-	 int next = node->next;
-
-	 if (node->refcou > 0)
-	 {
-	    node->next = bddnodes[hash].hash;
-	    bddnodes[hash].hash = r;
-	 }
-	 else
-	 {
-	    DECREF(LOWp(node));
-	    DECREF(HIGHp(node));
-	    
-	    LOWp(node) = -1;
-	    node->next = bddfreepos; 
-	    bddfreepos = r;
-	    levels[var1].nodenum--;
-	    bddfreenum++;
-	 }
-
-	 r = next;
-      }
-   }   
-}
-
-
-
-
-#ifdef USERESIZE
-
-static void reorder_swapResize(int toBeProcessed, int var0)
-{
-   int var1 = bddlevel2var[bddvar2level[var0]+1];
+   if (levels[var1].deadnum == 0)
+      return;
    
-   while (toBeProcessed)
-   {
-      BddNode *node = &bddnodes[toBeProcessed];
-      int next = node->next;
-      int f0 = LOWp(node);
-      int f1 = HIGHp(node);
-      int f00, f01, f10, f11;
-      
-         /* Find the cofactors for the new nodes */
-      if (VAR(f0) == var1)
-      {
-	 f00 = LOW(f0);
-	 f01 = HIGH(f0);
-      }
-      else
-	 f00 = f01 = f0;
-      
-      if (VAR(f1) == var1)
-      {
-	 f10 = LOW(f1);
-	 f11 = HIGH(f1);
-      }
-      else
-	 f10 = f11 = f1;
-
-         /* Note: makenode does refcou. */
-      f0 = reorder_makenode(var0, f00, f10);
-      f1 = reorder_makenode(var0, f01, f11);
-      node = &bddnodes[toBeProcessed];  /* Might change in makenode */
-
-         /* We know that the refcou of the grandchilds of this node
-	  * is greater than one (these are f00...f11), so there is
-	  * no need to do a recursive refcou decrease. It is also
-	  * possible for the LOWp(node)/high nodes to come alive again,
-	  * so deref. of the childs is delayed until the local GBC. */
-
-      DECREF(LOWp(node));
-      DECREF(HIGHp(node));
-      
-         /* Update in-place */
-      VARp(node) = var1;
-      LOWp(node) = f0;
-      HIGHp(node) = f1;
-	    
-      levels[var1].nodenum++;
-      
-         /* Do not rehash yet since we are going to resize the hash table */
-      
-      toBeProcessed = next;
-   }
-}
-
-
-static void reorder_localGbcResize(int toBeProcessed, int var0)
-{
-   int var1 = bddlevel2var[bddvar2level[var0]+1];
-   int vl1 = levels[var1].start;
-   int size1 = levels[var1].size;
-   int n;
-
    for (n=0 ; n<size1 ; n++)
    {
-      int hash = n+vl1;
-      int r = bddnodes[hash].hash;
-      bddnodes[hash].hash = 0;
+      BDD r = table1[n];
+      table1[n] = 0;
 
       while (r)
       {
 	 BddNode *node = &bddnodes[r];
-	 int next = node->next;
+	 BDD next = NEXTp(node);
 
 	 if (node->refcou > 0)
 	 {
-	    node->next = toBeProcessed;
-	    toBeProcessed = r;
+	    NEXTp(node) = table1[n];
+	    table1[n] = r;
 	 }
 	 else
 	 {
-	    DECREF(LOWp(node));
-	    DECREF(HIGHp(node));
+#if ENABLE_TBDD
+	    reorder_dropclauses(r);
+#endif
+	    REORDER_DECREF(LOWp(node));
+	    REORDER_DECREF(HIGHp(node));
 	    
 	    LOWp(node) = -1;
-	    node->next = bddfreepos; 
+	    NEXTp(node) = bddfreepos; 
 	    bddfreepos = r;
 	    levels[var1].nodenum--;
 	    bddfreenum++;
@@ -1372,31 +1439,9 @@ static void reorder_localGbcResize(int toBeProcessed, int var0)
       }
    }
 
-      /* Resize */
-   if (levels[var1].nodenum < levels[var1].size)
-      levels[var1].size = MIN(levels[var1].maxsize, levels[var1].size/2);
-   else
-      levels[var1].size = MIN(levels[var1].maxsize, levels[var1].size*2);
-
-   if (levels[var1].size >= 4)
-      levels[var1].size = bdd_prime_lte(levels[var1].size);
-
-      /* Rehash the remaining live nodes */
-   while (toBeProcessed)
-   {
-      BddNode *node = &bddnodes[toBeProcessed];
-      int next = node->next;
-      int hash = NODEHASH(VARp(node), LOWp(node), HIGHp(node));
-	 
-      node->next = bddnodes[hash].hash;
-      bddnodes[hash].hash = toBeProcessed;
-
-      toBeProcessed = next;
-   }   
+   levels[var1].deadnum = 0;
 }
 
-#endif /* USERESIZE */
-
 
 static int reorder_varup(int var)
 {
@@ -1420,12 +1465,12 @@ static void sanitycheck(void)
       
       for (n=0 ; n<levels[v].size ; n++)
       {
-	 r = bddnodes[n+levels[v].start].hash;
+	 r = levels[v].table[n];
 	 
 	 while (r)
 	 {
 	    assert(VAR(r) == v);
-	    r = bddnodes[r].next;
+	    r = NEXT(r);
 	    cou++;
 	    vcou++;
 	 }
@@ -1457,26 +1502,18 @@ static int reorder_vardown(int var)
    if ((level=bddvar2level[var]) >= bddvarnum-1)
       return 0;
 
-   resizedInMakenode = 0;
-   
    if (imatrixDepends(iactmtx, var, bddlevel2var[level+1]))
    {
-      int toBeProcessed = reorder_downSimple(var);
-#ifdef USERESIZE
-      levelData *l = &levels[var];
-      
-      if (l->nodenum < (l->size)/3  ||
-	  l->nodenum >= (l->size*3)/2  &&  l->size < l->maxsize)
-      {
-	 reorder_swapResize(toBeProcessed, var);
-	 reorder_localGbcResize(toBeProcessed, var);
-      }
-      else
+      BDD toBeProcessed = reorder_downSimple(var);
+      reorder_swap(toBeProcessed, var);
+      reorder_localGbc(var);
+#if ENABLE_TBDD
+      reorder_flushclauses();
 #endif
-      {
-	 reorder_swap(toBeProcessed, var);
-	 reorder_localGbc(var);
-      }
+
+	 /* Only the two swapped levels have changed size */
+      reorder_tableresize(var);
+      reorder_tableresize(bddlevel2var[level+1]);
    }
    
       /* Swap the var<->level tables */
@@ -1491,9 +1528,6 @@ static int reorder_vardown(int var)
       /* Update all rename pairs */
    bdd_pairs_vardown(level);
 
-   if (resizedInMakenode)
-      reorder_rehashAll();
-
    return 0;
 }
 
@@ -1548,7 +1582,8 @@ int bdd_swapvar(int v1, int v2)
       l2 = bddvar2level[v2];
    }
 
-   reorder_init();
+   if (reorder_init() < 0)
+      return bdd_error(BDD_ORDER);
    
       /* Move v1 to v2's position */
    while (bddvar2level[v1] < l2)
@@ -1566,7 +1601,7 @@ int bdd_swapvar(int v1, int v2)
 
 void bdd_default_reohandler(int prestate)
 {
-   static long c1;
+   static BDD_TLS long c1;
 
    if (verbose > 0)
    {
@@ -1578,7 +1613,7 @@ void bdd_default_reohandler(int prestate)
       else
       {
 	 long c2 = clock();
-	 printf("End reordering. Went from %d to %d nodes (%.1f sec)\n",
+	 printf("End reordering. Went from %" PRIbdd " to %" PRIbdd " nodes (%.1f sec)\n",
 		usednum_before, usednum_after, (float)(c2-c1)/CLOCKS_PER_SEC);
       }
    }
@@ -1618,7 +1653,7 @@ void bdd_enable_reorder(void)
 int bdd_reorder_ready(void)
 {
    if (bddreordermethod == BDD_REORDER_NONE  ||  vartree == NULL  ||
-       bddreordertimes == 0  ||  reorderdisabled)
+       bddreordertimes == 0  ||  reorderdisabled  ||  ENABLE_COMPLEMENT)
       return 0;
    return 1;
 }
@@ -1647,14 +1682,24 @@ static int reorder_init(void)
 {
    int n;
 
+#if ENABLE_COMPLEMENT
+      /* The swap routines rewrite nodes in place and do not know about
+         complemented edges, so reordering is unavailable in this mode */
+   return -1;
+#endif
+
+      /* The reordering passes look at every node in the table */
+   bdd_nodes_init(bddnodesize);
+   
    if ((levels=NEW(levelData,bddvarnum)) == NULL)
       return -1;
    
    for (n=0 ; n<bddvarnum ; n++)
    {
-      levels[n].start = -1;
+      levels[n].table = NULL;
       levels[n].size = 0;
       levels[n].nodenum = 0;
+      levels[n].deadnum = 0;
    }
    
       /* First mark and recursive refcou. all roots and childs. Also do some
@@ -1663,10 +1708,18 @@ static int reorder_init(void)
       return -1;
 
       /* Initialize the hash tables */
-   reorder_setLevellookup();
+   if (reorder_setLevellookup() < 0)
+      return -1;
 
       /* Garbage collect and rehash to new scheme */
+#if ENABLE_TBDD
+   if (proof_type != PROOF_NONE  &&  (reorder_dels=ilist_new(100)) == NULL)
+      return -1;
+#endif
    reorder_gbc();
+#if ENABLE_TBDD
+   reorder_flushclauses();
+#endif
 
    return 0;
 }
@@ -1674,7 +1727,7 @@ static int reorder_init(void)
 
 static void reorder_done(void)
 {
-   int n;
+   BDD n;
    
    for (n=0 ; n<extrootsize ; n++)
       SETMARK(extroots[n]);
@@ -1702,12 +1755,52 @@ static void reorder_done(void)
 	     levels[n].size);
 #endif
    free(extroots);
+   for (n=0 ; n<bddvarnum ; n++)
+      free(levels[n].table);
    free(levels);
    imatrixDelete(iactmtx);
+#if ENABLE_TBDD
+   if (reorder_dels != NULL)
+   {
+      ilist_free(reorder_dels);
+      reorder_dels = NULL;
+   }
+#endif
    bdd_gbc();
 }
 
 
+#if ENABLE_TBDD
+   /* Record the defining clauses of node n for deletion */
+static void reorder_dropclauses(BDD n)
+{
+   clause_id_t id;
+
+   if (proof_type == PROOF_NONE  ||  VAR(n) == 0)
+      return;
+   if ((id = bdd_dclause(n, DEF_HU)) != TAUTOLOGY)
+      reorder_dels = ilist_push(reorder_dels, id);
+   if ((id = bdd_dclause(n, DEF_LU)) != TAUTOLOGY)
+      reorder_dels = ilist_push(reorder_dels, id);
+   if ((id = bdd_dclause(n, DEF_HD)) != TAUTOLOGY)
+      reorder_dels = ilist_push(reorder_dels, id);
+   if ((id = bdd_dclause(n, DEF_LD)) != TAUTOLOGY)
+      reorder_dels = ilist_push(reorder_dels, id);
+}
+
+
+static void reorder_flushclauses(void)
+{
+   if (reorder_dels == NULL  ||  ilist_length(reorder_dels) == 0)
+      return;
+   print_proof_comment(2, "Delete %d defining clauses after reordering",
+		       ilist_length(reorder_dels));
+   delete_clauses(reorder_dels);
+   reorder_dels = ilist_resize(reorder_dels, 0);
+}
+#endif
+
+
 static int varseqCmp(const void *aa, const void *bb)
 {
    int a = bddvar2level[*((const int*)aa)];
@@ -1816,6 +1909,8 @@ void bdd_reorder(int method)
       return;
 
    usednum_before = bddnodesize - bddfreenum;
+   reorder_starttime = reorder_clock();
+   memset(&reorderstat, 0, sizeof(reorderstat));
    
    top->first = 0;
    top->last = bdd_varnum()-1;
@@ -1852,7 +1947,7 @@ int bdd_reorder_gain(void)
    if (usednum_before == 0)
       return 0;
    
-   return (100*(usednum_before - usednum_after)) / usednum_before;
+   return (int)((100*(usednum_before - usednum_after)) / usednum_before);
 }
 
 
@@ -1881,16 +1976,52 @@ void reorderhandler(int prestate)
 }
 \end{verbatim} *}
 RETURN  {* The previous handler *}
-ALSO    {* bdd\_reorder, bdd\_autoreorder, bdd\_resize\_hook *}
+ALSO    {* bdd\_reorder, bdd\_autoreorder, bdd\_resize\_hook, bdd\_reorder\_passhook *}
 */
 bddinthandler bdd_reorder_hook(bddinthandler handler)
 {
-   bddinthandler tmp = reorder_handler;
+   bddinthandler tmp;
+
+   CHECKMANAGER;
+   tmp = reorder_handler;
    reorder_handler = handler;
    return tmp;
 }
 
 
+/*
+NAME    {* bdd\_reorder\_passhook *}
+SECTION {* reorder *}
+SHORT   {* sets a handler for the passes of sifting *}
+PROTO   {* bddinthandler bdd_reorder_passhook(bddinthandler handler) *}
+DESCR   {* If a handler is set, it is called after each sifting pass
+           of a reordering with the number of passes done so far. The
+	   node counts, gain and time of that pass can then be found with
+	   {\tt bdd\_reorder\_stats}. There is no pass handler by default.
+
+	   A typical handler could look like this:
+	   \begin{verbatim}
+void passhandler(int pass)
+{
+   bddReorderStat s;
+   bdd_reorder_stats(&s);
+   printf("Pass %d: %d%% gain", pass, s.passgain);
+}
+\end{verbatim} *}
+RETURN  {* The previous handler *}
+ALSO    {* bdd\_reorder\_hook, bdd\_reorder\_stats, bdd\_autoreorder\_limits *}
+*/
+bddinthandler bdd_reorder_passhook(bddinthandler handler)
+{
+   bddinthandler tmp;
+
+   CHECKMANAGER;
+   tmp = reorder_passhandler;
+   reorder_passhandler = handler;
+   return tmp;
+}
+
+
 /*
 NAME    {* bdd\_blockfile\_hook *}
 SECTION {* reorder *}
@@ -1918,7 +2049,10 @@ ALSO    {* bdd\_printorder *}
 */
 bddfilehandler bdd_blockfile_hook(bddfilehandler handler)
 {
-   bddfilehandler tmp = reorder_filehandler;
+   bddfilehandler tmp;
+
+   CHECKMANAGER;
+   tmp = reorder_filehandler;
    reorder_filehandler = handler;
    return tmp;
 }
@@ -1945,7 +2079,7 @@ DESCR   {* Enables automatic reordering using {\tt method} as the reordering
 	   Values for {\tt method} can be found under {\tt bdd\_reorder}.
 	   *}
 RETURN  {* Returns the old value of {\tt method} *}
-ALSO    {* bdd\_reorder *}
+ALSO    {* bdd\_reorder, bdd\_autoreorder\_limits *}
 */
 int bdd_autoreorder(int method)
 {
@@ -1965,6 +2099,53 @@ int bdd_autoreorder_times(int method, int num)
 }
 
 
+/*
+NAME    {* bdd\_autoreorder\_limits *}
+SECTION {* reorder *}
+SHORT   {* sets the budget and convergence threshold for sifting *}
+PROTO   {* int bdd_autoreorder_limits(int msec, int growth, int mingain) *}
+DESCR   {* Bounds the work done by sifting, both in automatic reorderings
+           and in calls to {\tt bdd\_reorder}. Once a reordering has used
+	   {\tt msec} milliseconds of wall-clock time no more blocks are
+	   moved, and each block is left at the best position found so far.
+	   A value of zero means no time limit, which is the default.
+	   While a block is moved, the number of nodes may grow at most
+	   {\tt growth} percent above the best size seen; the default
+	   is 20. Iterated sifting stops when a pass gains less than
+	   {\tt mingain} percent; the default of zero continues until a
+	   pass gains nothing. *}
+RETURN  {* Zero on success, otherwise a negative error code. *}
+ALSO    {* bdd\_autoreorder, bdd\_reorder, bdd\_reorder\_stats *}
+*/
+int bdd_autoreorder_limits(int msec, int growth, int mingain)
+{
+   if (msec < 0  ||  growth < 0  ||  mingain < 0  ||  mingain > 100)
+      return bdd_error(BDD_RANGE);
+
+   siftmaxtime = msec;
+   siftmaxgrowth = growth;
+   siftmingain = mingain;
+   return 0;
+}
+
+
+/*
+NAME    {* bdd\_reorder\_stats *}
+SECTION {* reorder *}
+SHORT   {* returns information about the sifting passes of a reordering *}
+PROTO   {* void bdd_reorder_stats(bddReorderStat *stat) *}
+DESCR   {* Writes the number of sifting passes done in the current, or
+           last, reordering together with the gain and time of the
+	   latest pass into {\tt stat}. Mostly useful from within a
+	   pass handler. *}
+ALSO    {* bddReorderStat, bdd\_reorder\_passhook *}
+*/
+void bdd_reorder_stats(bddReorderStat *s)
+{
+   *s = reorderstat;
+}
+
+
 /*
 NAME    {* bdd\_var2level *}
 SECTION {* reorder *}
@@ -2068,7 +2249,7 @@ DESCR   {* Reordering is typically done to minimize the global number of
 	   will then be called by the reordering functions to get the current
 	   size information. A typical handle could look like this:
 \begin{verbatim}
-int sizehandler(void)
+BDD sizehandler(void)
 {
    extern BDD mybdd;
    return bdd_nodecount(mybdd);
@@ -2264,7 +2445,11 @@ void bdd_setvarorder(int *neworder)
       return;
    }
    
-   reorder_init();
+   if (reorder_init() < 0)
+   {
+      bdd_error(BDD_ORDER);
+      return;
+   }
    
    for (level=0 ; level<bddvarnum ; level++)
    {
@@ -40,23 +40,9 @@
 
 #define BUFLEN 2048
 // For formatting information
-static char ibuf[BUFLEN];
+static BDD_TLS char ibuf[BUFLEN];
 
 #define FUN_MAX 10
-static tbdd_info_fun ifuns[FUN_MAX];
-static int ifun_count = 0;
-
-static tbdd_done_fun dfuns[FUN_MAX];
-static int dfun_count = 0;
-
-static int last_variable = 0;
-static int last_clause_id = 0;
-
-
-/* Unit clauses that have not been deleted */
-static ilist created_unit_clauses;
-/* Unit clauses that (should) have been deleted */
-static ilist dead_unit_clauses;
 
 /* Managing reference counts for TBDDs */
 
@@ -71,20 +57,57 @@ static ilist dead_unit_clauses;
 //#define TABLE_INIT_SIZE 1
 #define TABLE_SCALE 2
 
-/* Table of references */
-static int *rc_table = NULL;
-/* Number of allocated table entries */
-static int rc_allocated_count = 0;
-/*
-  Head of free list.  Free list threads through unused table
-  positions, terminating with value -1
-*/
-static int rc_freepos;
+typedef struct {
+    tbdd_info_fun ifuns[FUN_MAX];
+    int ifun_count;
+
+    tbdd_done_fun dfuns[FUN_MAX];
+    int dfun_count;
+
+    clause_id_t last_variable;
+    clause_id_t last_clause_id;
+
+    /* Unit clauses that have not been deleted */
+    ilist created_unit_clauses;
+    /* Unit clauses that (should) have been deleted */
+    ilist dead_unit_clauses;
+
+    /* Table of references */
+    int *rc_table;
+    /* Number of allocated table entries */
+    int rc_allocated_count;
+    /*
+      Head of free list.  Free list threads through unused table
+      positions, terminating with value -1
+    */
+    int rc_freepos;
+} tbdd_state_t;
+
+#if ENABLE_REENTRANT
+void *tbdd_newstate(void) {
+    return bdd_newstate(NULL, sizeof(tbdd_state_t));
+}
+#else
+static tbdd_state_t tbdd_state;
+#endif
+
+#define TSTATE BDDSTATE(tbdd_state_t, BDDMOD_TBDD, tbdd_state)
+#define ifuns (TSTATE->ifuns)
+#define ifun_count (TSTATE->ifun_count)
+#define dfuns (TSTATE->dfuns)
+#define dfun_count (TSTATE->dfun_count)
+#define last_variable (TSTATE->last_variable)
+#define last_clause_id (TSTATE->last_clause_id)
+#define created_unit_clauses (TSTATE->created_unit_clauses)
+#define dead_unit_clauses (TSTATE->dead_unit_clauses)
+#define rc_table (TSTATE->rc_table)
+#define rc_allocated_count (TSTATE->rc_allocated_count)
+#define rc_freepos (TSTATE->rc_freepos)
 
 /*============================================
   Local functions
 ============================================*/
-static int new_unit_clause(int id) {
+static clause_id_t new_unit_clause(clause_id_t id) {
     if (id != TAUTOLOGY)
         created_unit_clauses = ilist_push(created_unit_clauses, id);
     return id;
@@ -128,7 +151,7 @@ static void rc_grow() {
     rc_allocated_count = nsize;
 }
 
-static int rc_new_entry(int clause_id) {
+static int rc_new_entry(clause_id_t clause_id) {
     if (clause_id == TAUTOLOGY)
         return -1;
     if (rc_freepos == -1)
@@ -207,26 +230,30 @@ static int rc_decrement(int rci) {
   Returns 0 if OK, otherwise error code
 */
 
-int tbdd_init(FILE *pfile, int *variable_counter, int *clause_id_counter, ilist *input_clauses, ilist variable_ordering, proof_type_t ptype, bool binary) {
+int tbdd_init(FILE *pfile, clause_id_t *var_counter, clause_id_t *cls_counter, ilist *input_clauses, ilist variable_ordering, proof_type_t ptype, bool binary) {
+    CHECKMANAGER;
     created_unit_clauses = ilist_new(100);
     dead_unit_clauses = ilist_new(100);
     rc_init();
-    return prover_init(pfile, variable_counter, clause_id_counter, input_clauses, variable_ordering, ptype, binary);
+    return prover_init(pfile, var_counter, cls_counter, input_clauses, variable_ordering, ptype, binary);
 }
 
-int tbdd_init_lrat(FILE *pfile, int variable_count, int clause_count, ilist *input_clauses, ilist variable_ordering) {
+int tbdd_init_lrat(FILE *pfile, int variable_count, clause_id_t clause_count, ilist *input_clauses, ilist variable_ordering) {
+    CHECKMANAGER;
     last_variable = variable_count;
     last_clause_id = clause_count;
     return tbdd_init(pfile, &last_variable, &last_clause_id, input_clauses, variable_ordering, PROOF_LRAT, false);
 }
 
-int tbdd_init_lrat_binary(FILE *pfile, int variable_count, int clause_count, ilist *input_clauses, ilist variable_ordering) {
+int tbdd_init_lrat_binary(FILE *pfile, int variable_count, clause_id_t clause_count, ilist *input_clauses, ilist variable_ordering) {
+    CHECKMANAGER;
     last_variable = variable_count;
     last_clause_id = clause_count;
     return tbdd_init(pfile, &last_variable, &last_clause_id, input_clauses, variable_ordering, PROOF_LRAT, true);
 }
 
 int tbdd_init_drat(FILE *pfile, int variable_count) {
+    CHECKMANAGER;
     last_variable = variable_count;
     last_clause_id = 0;
     int result = tbdd_init(pfile, &last_variable, &last_clause_id, NULL, NULL, PROOF_DRAT, false);
@@ -235,6 +262,7 @@ int tbdd_init_drat(FILE *pfile, int variable_count) {
 }
 
 int tbdd_init_drat_binary(FILE *pfile, int variable_count) {
+    CHECKMANAGER;
     last_variable = variable_count;
     last_clause_id = 0;
     int result = tbdd_init(pfile, &last_variable, &last_clause_id, NULL, NULL, PROOF_DRAT, true);
@@ -242,30 +270,63 @@ int tbdd_init_drat_binary(FILE *pfile, int variable_count) {
     return result;
 }
 
-int tbdd_init_frat(FILE *pfile, int *variable_counter, int *clause_id_counter) {
+int tbdd_init_frat(FILE *pfile, clause_id_t *var_counter, clause_id_t *cls_counter) {
     printf("c INITIALIZING TBDD\n");
-    int result = tbdd_init(pfile, variable_counter, clause_id_counter, NULL, NULL, PROOF_FRAT, false);
+    int result = tbdd_init(pfile, var_counter, cls_counter, NULL, NULL, PROOF_FRAT, false);
     tbdd_set_clause_limit(CLAUSE_LIMIT_FRAT);
     return result;
 }
 
-int tbdd_init_frat_binary(FILE *pfile, int *variable_counter, int *clause_id_counter) {
-    int result = tbdd_init(pfile, variable_counter, clause_id_counter, NULL, NULL, PROOF_FRAT, false);
+int tbdd_init_frat_binary(FILE *pfile, clause_id_t *var_counter, clause_id_t *cls_counter) {
+    int result = tbdd_init(pfile, var_counter, cls_counter, NULL, NULL, PROOF_FRAT, true);
     tbdd_set_clause_limit(CLAUSE_LIMIT_FRAT);
     return result;
 }
 
 int tbdd_init_noproof(int variable_count) {
+    CHECKMANAGER;
     last_variable = variable_count;
     return prover_init(NULL, &last_variable, NULL, NULL, NULL, PROOF_NONE, false);
 }
 
 void tbdd_set_verbose(int level) {
+    CHECKMANAGER;
     // Temporary
     if (level > 0)
         verbosity_level = level;
 }
 
+void tbdd_set_proof_buffer(int block_size, int block_count) {
+    CHECKMANAGER;
+    if (block_size > 0)
+        proof_block_size = block_size;
+    if (block_count > 0)
+        proof_block_count = block_count;
+}
+
+void tbdd_set_proof_sync(bool sync) {
+    CHECKMANAGER;
+    proof_sync = sync;
+}
+
+int tbdd_set_proof_compression(proof_compress_t codec) {
+    CHECKMANAGER;
+    switch (codec) {
+    case PROOF_COMPRESS_NONE:
+        break;
+    case PROOF_COMPRESS_LZ:
+        break;
+    case PROOF_COMPRESS_GZIP:
+        if (!ENABLE_ZLIB)
+            return bdd_error(BDD_RANGE);
+        break;
+    default:
+        return bdd_error(BDD_RANGE);
+    }
+    proof_compression = codec;
+    return 0;
+}
+
 void tbdd_set_clause_limit(int clim) {
     if (clim <= 0)
         return;
@@ -288,17 +349,17 @@ void bdd_report() {
 void tbdd_report() {
     int i;
     if (verbosity_level >= 1) {
-        printf("c Input variables: %d\n", input_variable_count);
-        printf("c Input clauses: %d\n", input_clause_count);
-        printf("c Total clauses: %d\n", total_clause_count);
-        int unused = *clause_id_counter - total_clause_count;
-        double upct = 100.0 * (double) unused/total_clause_count;
-        printf("c Unused+non-BDD clause IDs: %d (%.1f%%)\n", unused, upct);
-        printf("c Maximum live clauses: %d\n", max_live_clause_count);
-        printf("c Deleted clauses: %d\n", deleted_clause_count);
-        printf("c Final live clauses: %d\n", total_clause_count-deleted_clause_count);
+        printf("c Input variables: %" PRIcid "\n", input_variable_count);
+        printf("c Input clauses: %" PRIcid "\n", input_clause_count);
+        printf("c Total clauses: %" PRIcid "\n", total_clause_count);
+        clause_id_t unused = *clause_id_counter - total_clause_count;
+        double upct = 100.0 * (double) unused/(double) total_clause_count;
+        printf("c Unused+non-BDD clause IDs: %" PRIcid " (%.1f%%)\n", unused, upct);
+        printf("c Maximum live clauses: %" PRIcid "\n", max_live_clause_count);
+        printf("c Deleted clauses: %" PRIcid "\n", deleted_clause_count);
+        printf("c Final live clauses: %" PRIcid "\n", total_clause_count-deleted_clause_count);
         if (variable_counter)
-            printf("c Total variables: %d\n", *variable_counter);
+            printf("c Total variables: %" PRIcid "\n", *variable_counter);
     }
     for (i = 0; i < ifun_count; i++) {
         ifuns[i](verbosity_level);
@@ -314,22 +375,22 @@ void tbdd_done() {
     int id = 0;
     ilist live_unit_clauses = ilist_new(100);
     while (ic < ilist_length(created_unit_clauses) && id < ilist_length(dead_unit_clauses)) {
-        int cc = created_unit_clauses[ic];
-        int cd = dead_unit_clauses[id];
+        clause_id_t cc = created_unit_clauses[ic];
+        clause_id_t cd = dead_unit_clauses[id];
         if (cc < cd) {
             live_unit_clauses = ilist_push(live_unit_clauses, cc);
             ic++;
         } else if (cc == cd) {
             ic++; id++;
         } else {
-            fprintf(ERROUT, "ERROR: Unit clause %d dead but never created\n", cd);
+            fprintf(ERROUT, "ERROR: Unit clause %" PRIcid " dead but never created\n", cd);
             id++;
         }
     }
     while (ic < ilist_length(created_unit_clauses))
         live_unit_clauses = ilist_push(live_unit_clauses, created_unit_clauses[ic++]);
     while (id < ilist_length(dead_unit_clauses))
-        fprintf(ERROUT, "ERROR: Unit clause %d dead but never created\n", dead_unit_clauses[id++]);
+        fprintf(ERROUT, "ERROR: Unit clause %" PRIcid " dead but never created\n", dead_unit_clauses[id++]);
 
     /* Delete outstanding unit clauses */
     if (ilist_length(live_unit_clauses) > 0) {
@@ -364,6 +425,7 @@ void tbdd_done() {
 }
 
 void tbdd_add_info_fun(tbdd_info_fun f) {
+    CHECKMANAGER;
     if (ifun_count >= FUN_MAX) {
         fprintf(ERROUT, "Limit of %d TBDD information functions.  Request ignored\n", FUN_MAX);
         return;
@@ -372,6 +434,7 @@ void tbdd_add_info_fun(tbdd_info_fun f) {
 }
 
 void tbdd_add_done_fun(tbdd_done_fun f) {
+    CHECKMANAGER;
     if (dfun_count >= FUN_MAX) {
         fprintf(ERROUT, "Limit of %d TBDD done functions.  Request ignored\n", FUN_MAX);
         return;
@@ -381,14 +444,14 @@ void tbdd_add_done_fun(tbdd_done_fun f) {
 
 
 void tbdd_print(TBDD t, FILE *out) {
-    int nid = NNAME(t.root);
-    int cid = t.clause_id;
+    clause_id_t nid = NNAME(t.root);
+    clause_id_t cid = t.clause_id;
     int rci = t.rc_index;
     int rc = rc_get(rci);
-    fprintf(out, "[N%d, Clause #%d, RCI=%d, RC=%d]", nid, cid, rci, rc);
+    fprintf(out, "[N%" PRIcid ", Clause #%" PRIcid ", RCI=%d, RC=%d]", nid, cid, rci, rc);
 }
 
-TBDD tbdd_create(BDD r, int clause_id) {
+TBDD tbdd_create(BDD r, clause_id_t clause_id) {
     TBDD res;
     res.root = bdd_addref(r);
     res.clause_id = new_unit_clause(clause_id);
@@ -436,11 +499,11 @@ void tbdd_delref(TBDD tr) {
     bdd_delref(tr.root);
     int rc = rc_decrement(tr.rc_index);
     if (rc == 0) {
-        int dbuf[1+ILIST_OVHD];
+        clause_id_t dbuf[1+ILIST_OVHD];
         ilist dlist = ilist_make(dbuf, 1);
         ilist_fill1(dlist, tr.clause_id);
         if (tr.root != bdd_false()) {
-            print_proof_comment(2, "Deleting unit clause #%d for node N%d", tr.clause_id, NNAME(tr.root));
+            print_proof_comment(2, "Deleting unit clause #%" PRIcid " for node N%" PRIcid, tr.clause_id, NNAME(tr.root));
             delete_clauses(dlist);
         }
         /* Empty clause will be marked as "dead" so that is not later deleted */
@@ -462,8 +525,8 @@ static TBDD tbdd_duplicate(TBDD tr) {
   for all assignments satisfying clause.
  */
 
-static TBDD tbdd_from_clause_with_id(ilist clause, int id) {
-    print_proof_comment(2, "Build BDD representation of clause #%d", id);
+static TBDD tbdd_from_clause_with_id(ilist clause, clause_id_t id) {
+    print_proof_comment(2, "Build BDD representation of clause #%" PRIcid, id);
     clause = clean_clause(clause);
     BDD r = BDD_build_clause(clause);
     if (proof_type == PROOF_NONE) {
@@ -471,14 +534,14 @@ static TBDD tbdd_from_clause_with_id(ilist clause, int id) {
     }
     int len = ilist_length(clause);
     int nlits = 2*len+1;
-    int abuf[nlits+ILIST_OVHD];
+    clause_id_t abuf[nlits+ILIST_OVHD];
     ilist ant = ilist_make(abuf, nlits);
     /* Clause literals are in descending order */
     ilist_reverse(clause);
     BDD nd = r;
     int i;
     for (i = 0; i < len; i++) {
-        int lit = clause[i];
+        clause_id_t lit = clause[i];
         if (lit < 0) {
             ilist_push(ant, bdd_dclause(nd, DEF_LU));
             ilist_push(ant, bdd_dclause(nd, DEF_HU));
@@ -490,35 +553,35 @@ static TBDD tbdd_from_clause_with_id(ilist clause, int id) {
         }
     }
     ilist_push(ant, id);
-    int cbuf[1+ILIST_OVHD];
+    clause_id_t cbuf[1+ILIST_OVHD];
     ilist uclause = ilist_make(cbuf, 1);
     ilist_fill1(uclause, XVAR(r));
-    print_proof_comment(2, "Validate BDD representation of Clause #%d.  Node = N%d.", id, NNAME(r));
-    int clause_id = generate_clause(uclause, ant);
+    print_proof_comment(2, "Validate BDD representation of Clause #%" PRIcid ".  Node = N%" PRIcid ".", id, NNAME(r));
+    clause_id_t clause_id = generate_clause(uclause, ant);
     return tbdd_create(r, clause_id);
 }
 
 // This seems like it should be easier to check, but it isn't.
 TBDD tbdd_from_clause(ilist clause) {
-    int dbuf[ILIST_OVHD+1];
+    clause_id_t dbuf[ILIST_OVHD+1];
     ilist dels = ilist_make(dbuf, 1);
-    int id = assert_clause(clause);
+    clause_id_t id = assert_clause(clause);
     TBDD tr = tbdd_from_clause_with_id(clause, id);
     delete_clauses(ilist_fill1(dels, id));
     return tr;
 }
 
 
-TBDD tbdd_from_clause_id(int id) {
+TBDD tbdd_from_clause_id(clause_id_t id) {
     ilist clause = get_input_clause(id);
     if (clause == NULL) {
-        fprintf(ERROUT, "Invalid input clause #%d\n", id);
+        fprintf(ERROUT, "Invalid input clause #%" PRIcid "\n", id);
         exit(1);
     }
     TBDD tr = tbdd_from_clause_with_id(clause, id);
 #if ENABLE_BTRACE
     if (bdd_trace_file)
-        fprintf(bdd_trace_file, "tc %d %d\n", tr.root, id);
+        fprintf(bdd_trace_file, "tc %" PRIbdd " %" PRIcid "\n", tr.root, id);
 #endif
     return tr;
 }
@@ -558,7 +621,7 @@ TBDD TBDD_from_xor(ilist vars, int phase) {
     int len = ilist_length(vars);
     int bits;
     int elen = 1 << len;
-    int lbuf[ILIST_OVHD+len];
+    clause_id_t lbuf[ILIST_OVHD+len];
     ilist lits = ilist_make(lbuf, len);
     ilist_resize(lits, len);
     TBDD result = TBDD_tautology();
@@ -580,7 +643,7 @@ TBDD TBDD_from_xor(ilist vars, int phase) {
     }
     if (verbosity_level >= 2) {
         ilist_format(vars, ibuf, " ^ ", BUFLEN);
-        print_proof_comment(2, "N%d is BDD representation of %s = %d",
+        print_proof_comment(2, "N%" PRIcid " is BDD representation of %s = %d",
         		    bdd_nameid(result.root), ibuf, phase);
     }
     return result;
@@ -597,22 +660,22 @@ TBDD tbdd_validate(BDD r, TBDD tr) {
     if (proof_type == PROOF_NONE) {
         return tbdd_create(r, TAUTOLOGY);
     }
-    int cbuf[1+ILIST_OVHD];
+    clause_id_t cbuf[1+ILIST_OVHD];
     ilist clause = ilist_make(cbuf, 1);
-    int abuf[2+ILIST_OVHD];
+    clause_id_t abuf[2+ILIST_OVHD];
     ilist ant = ilist_make(abuf, 2);
     pcbdd p = bdd_imptst_justify(tr.root, r);
     if (p.root != bdd_true()) {
-        fprintf(ERROUT, "Failed to prove implication N%d --> N%d\n", NNAME(tr.root), NNAME(r));
+        fprintf(ERROUT, "Failed to prove implication N%" PRIcid " --> N%" PRIcid "\n", NNAME(tr.root), NNAME(r));
         exit(1);
     }
-    print_proof_comment(2, "Validation of unit clause for N%d by implication from N%d",NNAME(r), NNAME(tr.root));
+    print_proof_comment(2, "Validation of unit clause for N%" PRIcid " by implication from N%" PRIcid,NNAME(r), NNAME(tr.root));
     ilist_fill1(clause, XVAR(r));
     ilist_fill2(ant, p.clause_id, tr.clause_id);
-    int clause_id = generate_clause(clause, ant);
+    clause_id_t clause_id = generate_clause(clause, ant);
 #if ENABLE_BTRACE
     if (bdd_trace_file)
-        fprintf(bdd_trace_file, "ti %d %d\n", r, tr.root);
+        fprintf(bdd_trace_file, "ti %" PRIbdd " %" PRIbdd "\n", r, tr.root);
 #endif
     /* Now we can handle any deletions caused by GC */
     process_deferred_deletions();
@@ -628,13 +691,13 @@ TBDD tbdd_trust(BDD r) {
     if (proof_type == PROOF_NONE) {
         return tbdd_create(r, TAUTOLOGY);
     }
-    int cbuf[1+ILIST_OVHD];
+    clause_id_t cbuf[1+ILIST_OVHD];
     ilist clause = ilist_make(cbuf, 1);
-    int abuf[0+ILIST_OVHD];
+    clause_id_t abuf[0+ILIST_OVHD];
     ilist ant = ilist_make(abuf, 0);
-    print_proof_comment(2, "Assertion of N%d",NNAME(r));
+    print_proof_comment(2, "Assertion of N%" PRIcid,NNAME(r));
     ilist_fill1(clause, XVAR(r));
-    int clause_id = generate_clause(clause, ant);
+    clause_id_t clause_id = generate_clause(clause, ant);
     return tbdd_create(r, clause_id);
 }
 
@@ -653,27 +716,121 @@ TBDD tbdd_and(TBDD tr1, TBDD tr2) {
         return tbdd_duplicate(tr1);
     pcbdd p = bdd_and_justify(tr1.root, tr2.root);
     BDD r = p.root;
-    int cbuf[1+ILIST_OVHD];
+    clause_id_t cbuf[1+ILIST_OVHD];
     ilist clause = ilist_make(cbuf, 1);
-    int abuf[3+ILIST_OVHD];
+    clause_id_t abuf[3+ILIST_OVHD];
     ilist ant = ilist_make(abuf, 3);
     if (r == bdd_false())
-        print_proof_comment(2, "Validate empty clause for node N%d = N%d & N%d", NNAME(r), NNAME(tr1.root), NNAME(tr2.root));
+        print_proof_comment(2, "Validate empty clause for node N%" PRIcid " = N%" PRIcid " & N%" PRIcid, NNAME(r), NNAME(tr1.root), NNAME(tr2.root));
     else
-        print_proof_comment(2, "Validate unit clause for node N%d = N%d & N%d", NNAME(r), NNAME(tr1.root), NNAME(tr2.root));
+        print_proof_comment(2, "Validate unit clause for node N%" PRIcid " = N%" PRIcid " & N%" PRIcid, NNAME(r), NNAME(tr1.root), NNAME(tr2.root));
     ilist_fill1(clause, XVAR(r));
     ilist_fill3(ant, tr1.clause_id, tr2.clause_id, p.clause_id);
     /* Insert proof of unit clause into t's justification */
-    int clause_id = generate_clause(clause, ant);
+    clause_id_t clause_id = generate_clause(clause, ant);
 #if ENABLE_BTRACE
     if (bdd_trace_file)
-        fprintf(bdd_trace_file, "ta %d %d %d\n", r, tr1.root, tr2.root);
+        fprintf(bdd_trace_file, "ta %" PRIbdd " %" PRIbdd " %" PRIbdd "\n", r, tr1.root, tr2.root);
 #endif
     /* Now we can handle any deletions caused by GC */
     process_deferred_deletions();
     return tbdd_create(r, clause_id);
 }
 
+/*
+  Form conjunction of two TBDDs with the variables in varset
+  existentially quantified, and prove that their conjunction
+  implies the new one.  Done in a single pass.
+ */
+TBDD tbdd_and_exist(TBDD tr1, TBDD tr2, BDD varset) {
+    if (proof_type == PROOF_NONE) {
+        BDD r = bdd_appex(tr1.root, tr2.root, bddop_and, varset);
+        return tbdd_create(r, TAUTOLOGY);
+    }
+    pcbdd p = bdd_and_exist_justify(tr1.root, tr2.root, varset);
+    BDD r = p.root;
+    clause_id_t cbuf[1+ILIST_OVHD];
+    ilist clause = ilist_make(cbuf, 1);
+    clause_id_t abuf[3+ILIST_OVHD];
+    ilist ant = ilist_make(abuf, 3);
+    if (r == bdd_false())
+        print_proof_comment(2, "Validate empty clause for node N%" PRIcid " = Exists (N%" PRIcid " & N%" PRIcid ")", NNAME(r), NNAME(tr1.root), NNAME(tr2.root));
+    else
+        print_proof_comment(2, "Validate unit clause for node N%" PRIcid " = Exists (N%" PRIcid " & N%" PRIcid ")", NNAME(r), NNAME(tr1.root), NNAME(tr2.root));
+    ilist_fill1(clause, XVAR(r));
+    ilist_fill3(ant, tr1.clause_id, tr2.clause_id, p.clause_id);
+    /* Insert proof of unit clause into t's justification */
+    clause_id_t clause_id = generate_clause(clause, ant);
+    /* Now we can handle any deletions caused by GC */
+    process_deferred_deletions();
+    return tbdd_create(r, clause_id);
+}
+
+/*
+  Form conjunction of n TBDDs and prove that their conjunction
+  implies the new one.  Up to BDD_MULTIMAX operands are conjoined in
+  one pass with a single justification.  More are done in groups.
+ */
+TBDD tbdd_and_multi(TBDD *trs, int n) {
+    BDD roots[BDD_MULTIMAX];
+    TBDD args[BDD_MULTIMAX];
+    int i, k = 0;
+    if (n > BDD_MULTIMAX) {
+        int num = (n + BDD_MULTIMAX - 1) / BDD_MULTIMAX;
+        TBDD *parts = calloc(num, sizeof(TBDD));
+        if (parts == NULL) {
+            bdd_error(BDD_MEMORY);
+            return TBDD_null();
+        }
+        for (i = 0; i < num; i++) {
+            int len = n - i*BDD_MULTIMAX;
+            parts[i] = tbdd_and_multi(trs + i*BDD_MULTIMAX, len < BDD_MULTIMAX ? len : BDD_MULTIMAX);
+        }
+        TBDD result = tbdd_and_multi(parts, num);
+        for (i = 0; i < num; i++)
+            tbdd_delref(parts[i]);
+        free(parts);
+        return result;
+    }
+    if (proof_type == PROOF_NONE) {
+        for (i = 0; i < n; i++)
+            roots[i] = trs[i].root;
+        BDD r = bdd_and_multi(roots, n);
+        return tbdd_create(r, TAUTOLOGY);
+    }
+    for (i = 0; i < n; i++) {
+        if (!tbdd_is_true(trs[i])) {
+            args[k] = trs[i];
+            roots[k++] = trs[i].root;
+        }
+    }
+    if (k == 0)
+        return TBDD_tautology();
+    if (k == 1)
+        return tbdd_duplicate(args[0]);
+    if (k == 2)
+        return tbdd_and(args[0], args[1]);
+    pcbdd p = bdd_and_multi_justify(roots, k);
+    BDD r = p.root;
+    clause_id_t cbuf[1+ILIST_OVHD];
+    ilist clause = ilist_make(cbuf, 1);
+    clause_id_t abuf[BDD_MULTIMAX+1+ILIST_OVHD];
+    ilist ant = ilist_make(abuf, BDD_MULTIMAX+1);
+    if (r == bdd_false())
+        print_proof_comment(2, "Validate empty clause for node N%" PRIcid " = conjunction of %d nodes", NNAME(r), k);
+    else
+        print_proof_comment(2, "Validate unit clause for node N%" PRIcid " = conjunction of %d nodes", NNAME(r), k);
+    ilist_fill1(clause, XVAR(r));
+    for (i = 0; i < k; i++)
+        ilist_push(ant, args[i].clause_id);
+    ilist_push(ant, p.clause_id);
+    /* Insert proof of unit clause into t's justification */
+    clause_id_t clause_id = generate_clause(clause, ant);
+    /* Now we can handle any deletions caused by GC */
+    process_deferred_deletions();
+    return tbdd_create(r, clause_id);
+}
+
 /*
   Form conjunction of TBDDs tr1 & tr2.  Use to validate
   BDD r
@@ -687,18 +844,18 @@ TBDD tbdd_validate_with_and(BDD r, TBDD tr1, TBDD tr2) {
         return tbdd_validate(r, tr1);
     pcbdd p = bdd_and_imptst_justify(tr1.root, tr2.root, r);
     if (p.root != bdd_true()) {
-        fprintf(ERROUT, "Failed to prove implication N%d & N%d --> N%d\n", NNAME(tr1.root), NNAME(tr2.root), NNAME(r));
+        fprintf(ERROUT, "Failed to prove implication N%" PRIcid " & N%" PRIcid " --> N%" PRIcid "\n", NNAME(tr1.root), NNAME(tr2.root), NNAME(r));
         exit(1);
     }
-    int cbuf[1+ILIST_OVHD];
+    clause_id_t cbuf[1+ILIST_OVHD];
     ilist clause = ilist_make(cbuf, 1);
-    int abuf[3+ILIST_OVHD];
+    clause_id_t abuf[3+ILIST_OVHD];
     ilist ant = ilist_make(abuf, 3);
-    print_proof_comment(2, "Validate unit clause for node N%d, based on N%d & N%d", NNAME(r), NNAME(tr1.root), NNAME(tr2.root));
+    print_proof_comment(2, "Validate unit clause for node N%" PRIcid ", based on N%" PRIcid " & N%" PRIcid, NNAME(r), NNAME(tr1.root), NNAME(tr2.root));
     ilist_fill1(clause, XVAR(r));
     ilist_fill3(ant, tr1.clause_id, tr2.clause_id, p.clause_id);
     /* Insert proof of unit clause into rr's justification */
-    int clause_id = generate_clause(clause, ant);
+    clause_id_t clause_id = generate_clause(clause, ant);
     /* Now we can handle any deletions caused by GC */
     process_deferred_deletions();
     return tbdd_create(r, clause_id);
@@ -719,8 +876,8 @@ static bool test_validation_path(ilist clause, TBDD tr) {
     int i;
     BDD r = tr.root;
     for (i = len-1; i >= 0; i--) {
-        int lit = clause[i];
-        int var = ABS(lit);
+        clause_id_t lit = clause[i];
+        int var = (int) ABS(lit);
         int level = bdd_var2level(var);
         if (LEVEL(r) > level)
             // Function does not depend on this variable
@@ -736,17 +893,17 @@ static bool test_validation_path(ilist clause, TBDD tr) {
     return ISZERO(r);
 }
 
-static int tbdd_validate_clause_path(ilist clause, TBDD tr) {
+static clause_id_t tbdd_validate_clause_path(ilist clause, TBDD tr) {
     int len = ilist_length(clause);
-    int abuf[1+len+ILIST_OVHD];
+    clause_id_t abuf[1+len+ILIST_OVHD];
     int i;
     BDD r = tr.root;
     ilist ant = ilist_make(abuf, 1+len);
     ilist_fill1(ant, tr.clause_id);
     for (i = len-1; i >= 0; i--) {
-        int lit = clause[i];
-        int var = ABS(lit);
-        int id;
+        clause_id_t lit = clause[i];
+        int var = (int) ABS(lit);
+        clause_id_t id;
         if (LEVEL(r) > var)
             // Function does not depend on this variable
             continue;
@@ -766,13 +923,13 @@ static int tbdd_validate_clause_path(ilist clause, TBDD tr) {
     if (verbosity_level >= 2) {
         char buf[BUFLEN];
         ilist_format(clause, buf, " ", BUFLEN);
-        print_proof_comment(2, "Validation of clause [%s] from N%d", buf, NNAME(tr.root));
+        print_proof_comment(2, "Validation of clause [%s] from N%" PRIcid, buf, NNAME(tr.root));
     }
-    int id =  generate_clause(clause, ant);
+    clause_id_t id =  generate_clause(clause, ant);
     return id;
 }
 
-int tbdd_validate_clause(ilist clause, TBDD tr) {
+clause_id_t tbdd_validate_clause(ilist clause, TBDD tr) {
     if (proof_type == PROOF_NONE)
         return TAUTOLOGY;
     clause = clean_clause(clause);
@@ -782,17 +939,17 @@ int tbdd_validate_clause(ilist clause, TBDD tr) {
         if (verbosity_level >= 2) {
             char buf[BUFLEN];
             ilist_format(clause, buf, " ", BUFLEN);
-            print_proof_comment(2, "Validation of clause [%s] from N%d requires generating intermediate BDD", buf, NNAME(tr.root));
+            print_proof_comment(2, "Validation of clause [%s] from N%" PRIcid " requires generating intermediate BDD", buf, NNAME(tr.root));
         }
         BDD cr = BDD_build_clause(clause);
         bdd_addref(cr);
         TBDD tcr = tbdd_validate(cr, tr);
         bdd_delref(cr);
-        int id = tbdd_validate_clause_path(clause, tcr);
+        clause_id_t id = tbdd_validate_clause_path(clause, tcr);
         if (id < 0) {
             char buf[BUFLEN];
             ilist_format(clause, buf, " ", BUFLEN);
-            print_proof_comment(2, "Oops.  Couldn't validate clause [%s] from N%d", buf, NNAME(tr.root));
+            print_proof_comment(2, "Oops.  Couldn't validate clause [%s] from N%" PRIcid, buf, NNAME(tr.root));
         }
         tbdd_delref(tcr);
         return id;
@@ -806,10 +963,10 @@ int tbdd_validate_clause(ilist clause, TBDD tr) {
   or when don't want to provide antecedent in FRAT proof
   Returns clause id.
  */
-int assert_clause(ilist clause) {
+clause_id_t assert_clause(ilist clause) {
     if (proof_type == PROOF_NONE)
         return TAUTOLOGY;
-    int abuf[1+ILIST_OVHD];
+    clause_id_t abuf[1+ILIST_OVHD];
     ilist ant = ilist_make(abuf, 1);
     if (verbosity_level >= 2) {
         char buf[BUFLEN];
@@ -841,7 +998,7 @@ BDD BDD_build_xor(ilist vars, int phase) {
     //    printf("]\n");
 
     for (i = 0; i < n-1; i++) {
-        var = variables[i];
+        var = (int) variables[i];
         level = bdd_var2level(var);
         BDD neven = bdd_addref(bdd_makenode(level, even, odd));
         BDD nodd = bdd_addref(bdd_makenode(level, odd, even));
@@ -850,7 +1007,7 @@ BDD BDD_build_xor(ilist vars, int phase) {
         even = neven;
         odd = nodd;
     }
-    var = variables[n-1];
+    var = (int) variables[n-1];
     level = bdd_var2level(var);
     BDD r = phase ? bdd_makenode(level, odd, even) : bdd_makenode(level, even, odd);
     bdd_delref(even);
@@ -874,7 +1031,7 @@ BDD BDD_build_clause(ilist literals) {
     int i, lit, var, level;
     for (i = 0; i < ilist_length(literals); i++) {
         bdd_addref(r);
-        lit = literals[i];
+        lit = (int) literals[i];
         var = ABS(lit);
         level = bdd_var2level(var);
         BDD nr = lit < 0 ? bdd_makenode(level, bdd_true(), r) : bdd_makenode(level, r, bdd_true());
@@ -896,7 +1053,7 @@ BDD BDD_build_cube(ilist literals) {
     int i, lit, var, level;
     for (i = 0; i < ilist_length(literals); i++) {
         bdd_addref(r);
-        lit = literals[i];
+        lit = (int) literals[i];
         var = ABS(lit);
         level = bdd_var2level(var);
         BDD nr = lit < 0 ? bdd_makenode(level, r, bdd_false()) : bdd_makenode(level, bdd_false(), r);
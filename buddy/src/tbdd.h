@@ -50,7 +50,7 @@
 #include "bdd.h"
 
 /* Value representing logical truth */
-#define TAUTOLOGY INT_MAX
+#define TAUTOLOGY CLAUSE_ID_MAX
 
 /*
    A trusted BDD is one for which a proof has
@@ -65,7 +65,7 @@
  */
 typedef struct {
     BDD root;
-    int clause_id;  /* Id of justifying clause */
+    clause_id_t clause_id;  /* Id of justifying clause */
     int rc_index;   /* Index of reference counter */
 } TBDD;
 
@@ -100,17 +100,20 @@ extern "C" {
 /* Supported proof types */
    typedef enum { PROOF_LRAT, PROOF_DRAT, PROOF_FRAT, PROOF_NONE } proof_type_t;
 
-   extern int tbdd_init(FILE *pfile, int *variable_counter, int *clause_id_counter, ilist *input_clauses, ilist variable_ordering, proof_type_t ptype, bool binary);
+/* Supported compression of proof output */
+   typedef enum { PROOF_COMPRESS_NONE, PROOF_COMPRESS_LZ, PROOF_COMPRESS_GZIP } proof_compress_t;
+
+   extern int tbdd_init(FILE *pfile, clause_id_t *var_counter, clause_id_t *cls_counter, ilist *input_clauses, ilist variable_ordering, proof_type_t ptype, bool binary);
 
 /*
    Initializers specific for the seven combinations of proof formats
  */
-extern int tbdd_init_lrat(FILE *pfile, int variable_count, int clause_count, ilist *input_clauses, ilist variable_ordering);
-extern int tbdd_init_lrat_binary(FILE *pfile, int variable_count, int clause_count, ilist *input_clauses, ilist variable_ordering);
+extern int tbdd_init_lrat(FILE *pfile, int variable_count, clause_id_t clause_count, ilist *input_clauses, ilist variable_ordering);
+extern int tbdd_init_lrat_binary(FILE *pfile, int variable_count, clause_id_t clause_count, ilist *input_clauses, ilist variable_ordering);
 extern int tbdd_init_drat(FILE *pfile, int variable_count);
 extern int tbdd_init_drat_binary(FILE *pfile, int variable_count);
-extern int tbdd_init_frat(FILE *pfile, int *variable_counter, int *clause_id_counter);
-extern int tbdd_init_frat_binary(FILE *pfile, int *variable_counter, int *clause_id_counter);
+extern int tbdd_init_frat(FILE *pfile, clause_id_t *var_counter, clause_id_t *cls_counter);
+extern int tbdd_init_frat_binary(FILE *pfile, clause_id_t *var_counter, clause_id_t *cls_counter);
 extern int tbdd_init_noproof(int variable_count);
 
 /*
@@ -156,6 +159,30 @@ extern void tbdd_set_verbose(int level);
  */
 extern void tbdd_set_clause_limit(int clim);
 
+/*
+   Set up proof output.  Must be called before initialization.
+   With a writer thread (ENABLE_ASYNCPROOF), the proof is collected in
+   blocks of block_size bytes, and at most block_count-1 full blocks
+   wait to be written before the prover has to wait.  A compressed
+   proof is collected in such blocks also without the writer thread.
+   Values <= 0 keep the defaults (1MB, 4 blocks).  With sync, the proof file is
+   synced to disk when done.
+ */
+extern void tbdd_set_proof_buffer(int block_size, int block_count);
+extern void tbdd_set_proof_sync(bool sync);
+
+/*
+   Compress the proof as it is written.  Must be called before
+   initialization.  Each block of the proof buffer is compressed
+   separately, by the writer thread if there is one, so a reader can
+   split the file at block boundaries and decompress the pieces in
+   parallel.  PROOF_COMPRESS_LZ is a built-in fast codec (see
+   examples/proofcat for a decoder), and PROOF_COMPRESS_GZIP writes a
+   file that gzip -d reads.  Gzip requires ENABLE_ZLIB.
+   Return 0 if OK, or BDD_RANGE if the codec is not available.
+ */
+extern int tbdd_set_proof_compression(proof_compress_t codec);
+
 /*============================================
  Creation and manipulation of trusted BDDs
 ============================================*/
@@ -169,7 +196,7 @@ void tbdd_print(TBDD r, FILE *out);
   Create a fresh TBDD.  Increment reference count for BDD
   and initialize reference count for TBDD
  */
-TBDD tbdd_create(BDD r, int clause_id);
+TBDD tbdd_create(BDD r, clause_id_t clause_id);
 
 /*
   Increment/decrement reference count for BDD
@@ -205,7 +232,7 @@ extern bool tbdd_is_false(TBDD tr);
  */
 
 extern TBDD tbdd_from_clause(ilist clause);  // For DRAT
-extern TBDD tbdd_from_clause_id(int id);     // For LRAT
+extern TBDD tbdd_from_clause_id(clause_id_t id);     // For LRAT
 
 /*
   Generate BDD representation of XOR.
@@ -235,6 +262,19 @@ extern TBDD tbdd_trust(BDD r);
  */
 extern TBDD tbdd_and(TBDD tr1, TBDD tr2);
 
+/*
+  Form conjunction of n TBDDs in one pass and prove
+  their conjunction implies the new one
+ */
+extern TBDD tbdd_and_multi(TBDD *trs, int n);
+
+/*
+  Form conjunction of two TBDDs with the variables in varset
+  existentially quantified, and prove their conjunction
+  implies the new one
+ */
+extern TBDD tbdd_and_exist(TBDD tr1, TBDD tr2, BDD varset);
+
 /*
   Form conjunction of TBDDs tl & tr.  Use to validate
   BDD r
@@ -246,7 +286,7 @@ extern TBDD tbdd_validate_with_and(BDD r, TBDD tl, TBDD tr);
   Use this version when generating LRAT proofs
   Returns clause id.
  */
-extern int tbdd_validate_clause(ilist clause, TBDD tr);
+extern clause_id_t tbdd_validate_clause(ilist clause, TBDD tr);
 
 /*
   Assert that a clause holds.  Proof checker
@@ -255,7 +295,7 @@ extern int tbdd_validate_clause(ilist clause, TBDD tr);
   or when don't want to provide antecedent in FRAT proof
   Returns clause id.
  */
-extern int assert_clause(ilist clause);
+extern clause_id_t assert_clause(ilist clause);
 
 /*============================================
  Useful BDD operations
@@ -289,7 +329,7 @@ class tbdd
 {
  public:
 
-    tbdd(const bdd &r, const int &id) { tb = tbdd_create(r.get_BDD(), id); }
+    tbdd(const bdd &r, const clause_id_t &id) { tb = tbdd_create(r.get_BDD(), id); }
     tbdd(const tbdd &t)               { tb = tbdd_addref(t.tb); }
     tbdd(TBDD tr)                     { tb = tr; }
     tbdd(void)                        { tb = TBDD_tautology(); }
@@ -299,7 +339,7 @@ class tbdd
     tbdd operator=(const tbdd &tr)    { if (tb.root != tr.tb.root) { tbdd_delref(tb); tb = tbdd_addref(tr.tb); } return *this; }
     // Backdoor functions provide read-only access
     bdd get_root()                     { return bdd(tb.root); }
-    int get_clause_id()                { return tb.clause_id; }
+    clause_id_t get_clause_id()        { return tb.clause_id; }
 
  private:
     TBDD tb;
@@ -310,12 +350,14 @@ class tbdd
     friend bool tbdd_is_true(tbdd &tr);
     friend bool tbdd_is_false(tbdd &tr);
     friend tbdd tbdd_and(tbdd &tl, tbdd &tr);
+    friend tbdd tbdd_and_multi(tbdd *trs, int n);
+    friend tbdd tbdd_and_exist(tbdd &tl, tbdd &tr, bdd varset);
     friend tbdd tbdd_validate(bdd r, tbdd &tr);
     friend tbdd tbdd_validate_with_and(bdd r, tbdd &tl, tbdd &tr);
     friend tbdd tbdd_trust(bdd r);
-    friend int tbdd_validate_clause(ilist clause, tbdd &tr);
+    friend clause_id_t tbdd_validate_clause(ilist clause, tbdd &tr);
     friend tbdd tbdd_from_xor(ilist variables, int phase);
-    friend int tbdd_nameid(tbdd &tr);
+    friend clause_id_t tbdd_nameid(tbdd &tr);
     friend bdd bdd_build_xor(ilist literals);
     friend bdd bdd_build_clause(ilist literals);
     friend bdd bdd_build_cube(ilist literals);
@@ -343,6 +385,19 @@ inline bool tbdd_is_false(tbdd &tr)
 inline tbdd tbdd_and(tbdd &tl, tbdd &tr)
 { return tbdd(tbdd_and(tl.tb, tr.tb)); }
 
+inline tbdd tbdd_and_multi(tbdd *trs, int n)
+{
+    TBDD *tbs = new TBDD[n > 0 ? n : 1];
+    for (int i = 0; i < n; i++)
+        tbs[i] = trs[i].tb;
+    tbdd res = tbdd(tbdd_and_multi(tbs, n));
+    delete[] tbs;
+    return res;
+}
+
+inline tbdd tbdd_and_exist(tbdd &tl, tbdd &tr, bdd varset)
+{ return tbdd(tbdd_and_exist(tl.tb, tr.tb, varset.get_BDD())); }
+
 inline tbdd tbdd_validate(bdd r, tbdd &tr)
 { return tbdd(tbdd_validate(r.get_BDD(), tr.tb)); }
 
@@ -352,13 +407,13 @@ inline tbdd tbdd_validate_with_and(bdd r, tbdd &tl, tbdd &tr)
 inline tbdd tbdd_trust(bdd r)
 { return tbdd(tbdd_trust(r.get_BDD())); }
 
-inline int tbdd_validate_clause(ilist clause, tbdd &tr)
+inline clause_id_t tbdd_validate_clause(ilist clause, tbdd &tr)
 { return tbdd_validate_clause(clause, tr.tb); }
 
 inline tbdd tbdd_from_xor(ilist variables, int phase)
 { return tbdd(TBDD_from_xor(variables, phase)); }
 
-inline int tbdd_nameid(tbdd &tr)
+inline clause_id_t tbdd_nameid(tbdd &tr)
 { return bdd_nameid(tr.tb.root); }
 
 inline bdd bdd_build_xor(ilist variables, int phase)
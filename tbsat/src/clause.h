@@ -66,9 +66,9 @@ class Clause {
 
     void show(std::ofstream &outstream);
 
-    int *data();
+    ilist data();
 
-    int& operator[](int);
+    clause_id_t& operator[](int);
 
     // Given array mapping (decremented) variable to 0/1
     // determine if clause satisfied
@@ -57,6 +57,9 @@ using namespace trustbdd;
 // Indicate Clause ID every 100 million clauses
 #define REPORT_CLAUSE (100*1000*1000)
 
+// Number of terms conjoined in one pass by tree reduction
+#define TREE_ARITY 8
+
 // Global variables and functions to aid in pseudo-random number generation
 Sequencer global_sequencer;
 
@@ -115,7 +118,9 @@ public:
     }
 
     Quantification(std::vector<int> &vars, bdd lconstraint) {
-        variables = ilist_copy_list(vars.data(), vars.size());
+        variables = ilist_new(vars.size());
+        for (int var : vars)
+            variables = ilist_push(variables, var);
         local_constraint = lconstraint;
     }
 
@@ -154,7 +159,8 @@ public:
             printf("c Imposing new constraint on variables V"); ilist_print(variables, stdout, " V"); printf("\n");
         }
         local_constraint = nlocal_constraint;
-        bdd varbdd = bdd_makeset(variables, ilist_length(variables));
+        std::vector<int> vlist(variables, variables + ilist_length(variables));
+        bdd varbdd = bdd_makeset(vlist.data(), vlist.size());
         bdd down_constraint = bdd_exist(local_constraint, varbdd);
         return down_constraint;
     }
@@ -229,7 +235,7 @@ private:
     bool is_active;
     tbdd tfun;
     xor_constraint *xor_equation;
-    int node_count;
+    BDD node_count;
 
 public:
     Term (tbdd t) {
@@ -241,10 +247,10 @@ public:
     }
 
     // Returns number of dead nodes generated
-    int deactivate() {
+    BDD deactivate() {
         tfun = tbdd_null();  // Should delete reference to previous value
         is_active = false;
-        int rval = node_count;
+        BDD rval = node_count;
         node_count = 0;
         if (xor_equation != NULL)
             delete xor_equation;
@@ -260,7 +266,7 @@ public:
 
     bdd get_root() { return tfun.get_root(); }
 
-    int get_clause_id() { return tfun.get_clause_id(); }
+    clause_id_t get_clause_id() { return tfun.get_clause_id(); }
 
     xor_constraint *get_equation() { return xor_equation; }
 
@@ -270,7 +276,7 @@ public:
 
     int get_term_id() { return term_id; }
 
-    int get_node_count() { return node_count; }
+    BDD get_node_count() { return node_count; }
 
 private:
 
@@ -284,14 +290,14 @@ private:
     int32_t max_variable;
     int verblevel;
     unsigned seed = DEFAULT_SEED;
-    proof_type_t proof_type;
+    proof_type_t prooftype;
     // Estimated total number of nodes
-    int total_count;
+    BDD total_count;
     // Estimated number of unreachable nodes
-    int dead_count;
+    BDD dead_count;
     // Counters used by proof generator
-    int variable_count;
-    int last_clause_id;
+    clause_id_t variable_count;
+    clause_id_t last_clause_id;
 
     // For generating solutions
     Solver *solver;
@@ -304,10 +310,10 @@ private:
     int and_count;
     int quant_count;
     int equation_count;
-    int max_bdd;
+    BDD max_bdd;
 
     void check_gc() {
-        int collect_min = (proof_type == PROOF_LRAT || proof_type == PROOF_NONE) ? COLLECT_MIN_LRAT : COLLECT_MIN_DRAT;
+        int collect_min = (prooftype == PROOF_LRAT || prooftype == PROOF_NONE) ? COLLECT_MIN_LRAT : COLLECT_MIN_DRAT;
         if (dead_count >= collect_min && (double) dead_count / total_count >= COLLECT_FRACTION) {
             if (verbosity_level >= 2) {
                 std::cout << "c Initiating GC.  Estimated total nodes = " << total_count << ".  Estimated dead nodes = " << dead_count << std::endl;
@@ -332,7 +338,7 @@ public:
             bool binary, Solver *sol, unsigned s) {
         verblevel = verb;
         seed = s;
-        proof_type = ptype;
+        prooftype = ptype;
         tbdd_set_verbose(verb);
         total_count = dead_count = 0;
         clause_count = cnf.clause_count();
@@ -386,6 +392,19 @@ public:
         return terms.back();
     }
 
+    Term *conjunct_multi(std::vector<Term *> &tps) {
+        std::vector<tbdd> funs;
+        for (Term *tp : tps)
+            funs.push_back(tp->get_fun());
+        tbdd nfun = tbdd_and_multi(funs.data(), funs.size());
+        add(new Term(nfun));
+        for (Term *tp : tps)
+            dead_count += tp->deactivate();
+        check_gc();
+        and_count += tps.size()-1;
+        return terms.back();
+    }
+
     Term *equantify(Term *tp, std::vector<int> &vars) {
         int *varset = vars.data();
         bdd varbdd = bdd_makeset(varset, vars.size());
@@ -412,24 +431,26 @@ public:
     // Effectively performs a tree reduction
     // Return final bdd
     tbdd tree_reduce() {
-        Term *tp1, *tp2;
+        std::vector<Term *> tps;
         while (true) {
-            while (min_active < terms.size() && !terms[min_active]->active())
-                min_active++;
-            if (min_active >= terms.size())
+            tps.clear();
+            while (tps.size() < TREE_ARITY) {
+                while (min_active < terms.size() && !terms[min_active]->active())
+                    min_active++;
+                if (min_active >= terms.size())
+                    break;
+                tps.push_back(terms[min_active++]);
+            }
+            if (tps.size() == 0)
                 // Didn't find any terms.  Formula is tautology
                 return tbdd_tautology();
-            tp1 = terms[min_active++];
-            while (min_active < terms.size() && !terms[min_active]->active())
-                min_active++;
-            if (min_active >= terms.size()) {
+            if (tps.size() == 1) {
                 // There was only one term left
-                tbdd result = tp1->get_fun();
-                dead_count +=  tp1->deactivate();
+                tbdd result = tps[0]->get_fun();
+                dead_count +=  tps[0]->deactivate();
                 return result;
             }
-            tp2 = terms[min_active++];
-            Term *tpn = conjunct(tp1, tp2);
+            Term *tpn = conjunct_multi(tps);
             if (tpn->get_root() == bdd_false()) {
                 tbdd result = tpn->get_fun();
                 return result;